@@ -120,6 +120,24 @@ size_t ExtrusionEntityCollection::items_count() const
     return count;
 }
 
+// Recursively collect pointers to the paths contained in this collection, including the paths of multi-paths and loops.
+void ExtrusionEntityCollection::collect_paths(std::vector<ExtrusionPath*> &dst)
+{
+    for (ExtrusionEntity *entity : this->entities)
+        if (ExtrusionEntityCollection *collection = dynamic_cast<ExtrusionEntityCollection*>(entity))
+            collection->collect_paths(dst);
+        else if (ExtrusionPath *path = dynamic_cast<ExtrusionPath*>(entity))
+            dst.emplace_back(path);
+        else if (ExtrusionMultiPath *multipath = dynamic_cast<ExtrusionMultiPath*>(entity))
+            for (ExtrusionPath &path : multipath->paths)
+                dst.emplace_back(&path);
+        else if (ExtrusionLoop *loop = dynamic_cast<ExtrusionLoop*>(entity))
+            for (ExtrusionPath &path : loop->paths)
+                dst.emplace_back(&path);
+        else
+            throw Slic3r::InvalidArgument("Invalid extrusion entity supplied to collect_paths()");
+}
+
 // Returns a single vector of pointers to all non-collection items contained in this one.
 ExtrusionEntityCollection ExtrusionEntityCollection::flatten(bool preserve_ordering) const
 {
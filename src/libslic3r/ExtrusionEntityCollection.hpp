@@ -132,6 +132,9 @@ public:
     Polygons polygons_covered_by_spacing(const float scaled_epsilon = 0.f) const
         { Polygons out; this->polygons_covered_by_spacing(out, scaled_epsilon); return out; }
     size_t items_count() const;
+    // Recursively collect pointers to all paths, including the paths of ExtrusionMultiPaths and ExtrusionLoops.
+    // The paths stay owned by this collection.
+    void collect_paths(std::vector<ExtrusionPath*> &dst);
     size_t size() const { return entities.size(); }
     /// Returns a flattened copy of this ExtrusionEntityCollection. That is, all of the items in its entities vector are not collections.
     /// You should be iterating over flatten().entities if you are interested in the underlying ExtrusionEntities (and don't care about hierarchy).
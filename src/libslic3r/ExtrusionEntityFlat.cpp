@@ -0,0 +1,389 @@
+#include "ExtrusionEntityFlat.hpp"
+#include "Exception.hpp"
+
+#include <cassert>
+#include <limits>
+
+namespace Slic3r {
+
+double ExtrusionEntityCollectionFlat::PathView::length() const
+{
+    double len = 0.;
+    for (const Point *p = points_begin + 1; p < points_end; ++ p)
+        len += (*p - *(p - 1)).cast<double>().norm();
+    return len;
+}
+
+void ExtrusionEntityCollectionFlat::append(const ExtrusionEntityCollection &src)
+{
+    // Count the entities, paths and points first to allocate each buffer just once.
+    struct Counter {
+        size_t entities { 0 };
+        size_t paths    { 0 };
+        size_t points   { 0 };
+        size_t fitting  { 0 };
+        void count(const ExtrusionPath &path) {
+            ++ paths;
+            points  += path.polyline.points.size();
+            fitting += path.polyline.fitting_result.size();
+        }
+        void count(const ExtrusionEntityCollection &collection) {
+            entities += collection.entities.size();
+            for (const ExtrusionEntity *entity : collection.entities)
+                if (const auto *child = dynamic_cast<const ExtrusionEntityCollection*>(entity))
+                    this->count(*child);
+                else if (const auto *path = dynamic_cast<const ExtrusionPath*>(entity))
+                    this->count(*path);
+                else if (const auto *multipath = dynamic_cast<const ExtrusionMultiPath*>(entity))
+                    for (const ExtrusionPath &path : multipath->paths)
+                        this->count(path);
+                else if (const auto *loop = dynamic_cast<const ExtrusionLoop*>(entity))
+                    for (const ExtrusionPath &path : loop->paths)
+                        this->count(path);
+        }
+    } counter;
+    counter.count(src);
+    m_entities.reserve(m_entities.size() + counter.entities);
+    m_points.reserve(m_points.size() + counter.points);
+    m_fitting.reserve(m_fitting.size() + counter.fitting);
+    size_t num_paths = this->num_paths() + counter.paths;
+    m_path_points.reserve(num_paths + 1);
+    m_path_fitting.reserve(num_paths + 1);
+    m_path_role.reserve(num_paths);
+    m_path_mm3_per_mm.reserve(num_paths);
+    m_path_width.reserve(num_paths);
+    m_path_height.reserve(num_paths);
+    m_path_inset_idx.reserve(num_paths);
+    m_path_flags.reserve(num_paths);
+
+    std::vector<std::pair<const ExtrusionEntityCollection*, size_t>> queue;
+    size_t first = m_entities.size();
+    m_entities.resize(first + src.entities.size());
+    m_roots.reserve(m_roots.size() + src.entities.size());
+    for (size_t i = 0; i < src.entities.size(); ++ i) {
+        m_roots.emplace_back(uint32_t(first + i));
+        this->append_entity(*src.entities[i], first + i, queue);
+    }
+    this->append_children(queue);
+}
+
+void ExtrusionEntityCollectionFlat::append_children(std::vector<std::pair<const ExtrusionEntityCollection*, size_t>> &queue)
+{
+    // Breadth first, so that the children of each collection are stored contiguously.
+    for (size_t iqueue = 0; iqueue < queue.size(); ++ iqueue) {
+        const ExtrusionEntityCollection &collection = *queue[iqueue].first;
+        size_t                           idx        = queue[iqueue].second;
+        size_t                           first      = m_entities.size();
+        m_entities.resize(first + collection.entities.size());
+        m_entities[idx].begin = uint32_t(first);
+        m_entities[idx].end   = uint32_t(m_entities.size());
+        for (size_t i = 0; i < collection.entities.size(); ++ i)
+            this->append_entity(*collection.entities[i], first + i, queue);
+    }
+    queue.clear();
+}
+
+void ExtrusionEntityCollectionFlat::append_entity(const ExtrusionEntity &src, size_t dst_idx, std::vector<std::pair<const ExtrusionEntityCollection*, size_t>> &queue)
+{
+    Entity &dst   = m_entities[dst_idx];
+    dst.inset_idx = src.inset_idx;
+    if (const auto *collection = dynamic_cast<const ExtrusionEntityCollection*>(&src)) {
+        dst.type  = EntityType::Collection;
+        dst.flags = uint8_t((collection->no_sort ? 1 : 0) | (! collection->no_sort && ! collection->can_reverse() ? 2 : 0));
+        queue.emplace_back(collection, dst_idx);
+        return;
+    }
+    if (dynamic_cast<const ExtrusionPathSloped*>(&src) != nullptr || dynamic_cast<const ExtrusionLoopSloped*>(&src) != nullptr)
+        throw Slic3r::InvalidArgument("Sloped extrusions are not supported by ExtrusionEntityCollectionFlat");
+    dst.begin = uint32_t(this->num_paths());
+    if (const auto *path = dynamic_cast<const ExtrusionPath*>(&src)) {
+        dst.type = dynamic_cast<const ExtrusionPathOriented*>(&src) ? EntityType::PathOriented : EntityType::Path;
+        this->append_path(*path);
+    } else if (const auto *multipath = dynamic_cast<const ExtrusionMultiPath*>(&src)) {
+        dst.type  = EntityType::MultiPath;
+        dst.flags = multipath->can_reverse();
+        for (const ExtrusionPath &path : multipath->paths)
+            this->append_path(path);
+    } else if (const auto *loop = dynamic_cast<const ExtrusionLoop*>(&src)) {
+        dst.type  = EntityType::Loop;
+        dst.flags = loop->loop_role();
+        for (const ExtrusionPath &path : loop->paths)
+            this->append_path(path);
+    } else
+        throw Slic3r::InvalidArgument("Invalid extrusion entity supplied to ExtrusionEntityCollectionFlat");
+    // m_entities is not resized while filling in an entity, dst is still valid.
+    dst.end = uint32_t(this->num_paths());
+}
+
+void ExtrusionEntityCollectionFlat::append_path(const ExtrusionPath &path)
+{
+    m_points.insert(m_points.end(), path.polyline.points.begin(), path.polyline.points.end());
+    m_fitting.insert(m_fitting.end(), path.polyline.fitting_result.begin(), path.polyline.fitting_result.end());
+    m_path_points.emplace_back(uint32_t(m_points.size()));
+    m_path_fitting.emplace_back(uint32_t(m_fitting.size()));
+    m_path_role.emplace_back(path.role());
+    m_path_mm3_per_mm.emplace_back(path.mm3_per_mm);
+    m_path_width.emplace_back(path.width);
+    m_path_height.emplace_back(path.height);
+    m_path_inset_idx.emplace_back(path.inset_idx);
+    m_path_flags.emplace_back(uint8_t((path.can_reverse() ? 1 : 0) | (path.is_force_no_extrusion() ? 2 : 0)));
+}
+
+void ExtrusionEntityCollectionFlat::clear()
+{
+    m_entities.clear();
+    m_roots.clear();
+    m_points.clear();
+    m_fitting.clear();
+    m_path_points.assign(1, 0);
+    m_path_fitting.assign(1, 0);
+    m_path_role.clear();
+    m_path_mm3_per_mm.clear();
+    m_path_width.clear();
+    m_path_height.clear();
+    m_path_inset_idx.clear();
+    m_path_flags.clear();
+}
+
+void ExtrusionEntityCollectionFlat::shrink_to_fit()
+{
+    m_entities.shrink_to_fit();
+    m_roots.shrink_to_fit();
+    m_points.shrink_to_fit();
+    m_fitting.shrink_to_fit();
+    m_path_points.shrink_to_fit();
+    m_path_fitting.shrink_to_fit();
+    m_path_role.shrink_to_fit();
+    m_path_mm3_per_mm.shrink_to_fit();
+    m_path_width.shrink_to_fit();
+    m_path_height.shrink_to_fit();
+    m_path_inset_idx.shrink_to_fit();
+    m_path_flags.shrink_to_fit();
+}
+
+ExtrusionEntityCollectionFlat::PathView ExtrusionEntityCollectionFlat::path(size_t idx) const
+{
+    return PathView {
+        m_points.data() + m_path_points[idx], m_points.data() + m_path_points[idx + 1],
+        m_fitting.data() + m_path_fitting[idx], m_fitting.data() + m_path_fitting[idx + 1],
+        m_path_role[idx], m_path_mm3_per_mm[idx], m_path_width[idx], m_path_height[idx],
+        (m_path_flags[idx] & 1) != 0, (m_path_flags[idx] & 2) != 0
+    };
+}
+
+void ExtrusionEntityCollectionFlat::make_path(size_t idx, ExtrusionPath &dst) const
+{
+    PathView view = this->path(idx);
+    dst.polyline.points.assign(view.points_begin, view.points_end);
+    dst.polyline.fitting_result.assign(view.fitting_begin, view.fitting_end);
+    dst.mm3_per_mm = view.mm3_per_mm;
+    dst.width      = view.width;
+    dst.height     = view.height;
+    dst.inset_idx  = m_path_inset_idx[idx];
+    dst.set_extrusion_role(view.role);
+    dst.set_force_no_extrusion(view.no_extrusion);
+    if (! view.can_reverse)
+        dst.set_reverse();
+}
+
+const Point& ExtrusionEntityCollectionFlat::first_point(size_t entity_idx) const
+{
+    const Entity &e = m_entities[entity_idx];
+    assert(e.begin < e.end);
+    return e.is_collection() ? this->first_point(e.begin) : m_points[m_path_points[e.begin]];
+}
+
+const Point& ExtrusionEntityCollectionFlat::last_point(size_t entity_idx) const
+{
+    const Entity &e = m_entities[entity_idx];
+    assert(e.begin < e.end);
+    return e.is_collection() ? this->last_point(e.end - 1) : m_points[m_path_points[e.end] - 1];
+}
+
+bool ExtrusionEntityCollectionFlat::can_reverse(size_t entity_idx) const
+{
+    const Entity &e = m_entities[entity_idx];
+    switch (e.type) {
+    case EntityType::Path:          return (m_path_flags[e.begin] & 1) != 0;
+    case EntityType::PathOriented:  return false;
+    case EntityType::MultiPath:     return e.flags != 0;
+    case EntityType::Loop:          return false;
+    case EntityType::Collection:    return (e.flags & 3) == 0;
+    }
+    return false;
+}
+
+std::unique_ptr<ExtrusionEntity> ExtrusionEntityCollectionFlat::materialize(size_t entity_idx) const
+{
+    const Entity &e = m_entities[entity_idx];
+    std::unique_ptr<ExtrusionEntity> out;
+    switch (e.type) {
+    case EntityType::Path:
+    {
+        auto path = std::make_unique<ExtrusionPath>();
+        this->make_path(e.begin, *path);
+        out = std::move(path);
+        break;
+    }
+    case EntityType::PathOriented:
+    {
+        auto path = std::make_unique<ExtrusionPathOriented>(m_path_role[e.begin], 0., 0.f, 0.f);
+        this->make_path(e.begin, *path);
+        out = std::move(path);
+        break;
+    }
+    case EntityType::MultiPath:
+    {
+        auto multipath = std::make_unique<ExtrusionMultiPath>();
+        multipath->paths.resize(e.size());
+        for (uint32_t i = e.begin; i < e.end; ++ i)
+            this->make_path(i, multipath->paths[i - e.begin]);
+        if (! e.flags)
+            multipath->set_reverse();
+        out = std::move(multipath);
+        break;
+    }
+    case EntityType::Loop:
+    {
+        auto loop = std::make_unique<ExtrusionLoop>(ExtrusionLoopRole(e.flags));
+        loop->paths.resize(e.size());
+        for (uint32_t i = e.begin; i < e.end; ++ i)
+            this->make_path(i, loop->paths[i - e.begin]);
+        out = std::move(loop);
+        break;
+    }
+    case EntityType::Collection:
+    {
+        auto collection = std::make_unique<ExtrusionEntityCollection>();
+        collection->no_sort = (e.flags & 1) != 0;
+        if (e.flags & 2)
+            collection->set_reverse();
+        collection->entities.reserve(e.size());
+        for (uint32_t i = e.begin; i < e.end; ++ i)
+            collection->entities.emplace_back(this->materialize(i).release());
+        out = std::move(collection);
+        break;
+    }
+    }
+    out->inset_idx = e.inset_idx;
+    return out;
+}
+
+ExtrusionEntityCollection ExtrusionEntityCollectionFlat::to_collection() const
+{
+    ExtrusionEntityCollection out;
+    out.entities.reserve(m_roots.size());
+    for (uint32_t root : m_roots)
+        out.entities.emplace_back(this->materialize(root).release());
+    return out;
+}
+
+ExtrusionRole ExtrusionEntityCollectionFlat::entity_role(size_t idx) const
+{
+    const Entity &e = m_entities[idx];
+    if (! e.is_collection())
+        return e.begin == e.end ? erNone : m_path_role[e.begin];
+    ExtrusionRole out = erNone;
+    for (uint32_t i = e.begin; i < e.end; ++ i) {
+        ExtrusionRole er = this->entity_role(i);
+        out = (out == erNone || out == er) ? er : erMixed;
+    }
+    return out;
+}
+
+ExtrusionRole ExtrusionEntityCollectionFlat::role() const
+{
+    ExtrusionRole out = erNone;
+    for (uint32_t root : m_roots) {
+        ExtrusionRole er = this->entity_role(root);
+        out = (out == erNone || out == er) ? er : erMixed;
+    }
+    return out;
+}
+
+double ExtrusionEntityCollectionFlat::length() const
+{
+    double len = 0.;
+    this->visit_paths([&len](const PathView &path) { len += path.length(); });
+    return len;
+}
+
+double ExtrusionEntityCollectionFlat::total_volume() const
+{
+    double volume = 0.;
+    this->visit_paths([&volume](const PathView &path) { volume += path.mm3_per_mm * unscale<double>(path.length()); });
+    return volume;
+}
+
+double ExtrusionEntityCollectionFlat::min_mm3_per_mm() const
+{
+    double min_mm3_per_mm = std::numeric_limits<double>::max();
+    this->visit_paths([&min_mm3_per_mm](const PathView &path) { min_mm3_per_mm = std::min(min_mm3_per_mm, path.mm3_per_mm); });
+    return min_mm3_per_mm;
+}
+
+void ExtrusionEntityCollectionFlat::collect_points(Points &dst) const
+{
+    dst.reserve(dst.size() + m_points.size());
+    this->visit_paths([&dst](const PathView &path) { dst.insert(dst.end(), path.points_begin, path.points_end); });
+}
+
+size_t ExtrusionEntityCollectionFlat::items_count() const
+{
+    size_t count = 0;
+    std::vector<uint32_t> stack(m_roots.begin(), m_roots.end());
+    while (! stack.empty()) {
+        const Entity &e = m_entities[stack.back()];
+        stack.pop_back();
+        if (e.is_collection()) {
+            for (uint32_t i = e.begin; i < e.end; ++ i)
+                stack.emplace_back(i);
+        } else
+            ++ count;
+    }
+    return count;
+}
+
+size_t ExtrusionEntityCollectionFlat::memory_used() const
+{
+    return sizeof(*this) +
+        m_entities.capacity() * sizeof(Entity) +
+        m_roots.capacity() * sizeof(uint32_t) +
+        m_points.capacity() * sizeof(Point) +
+        m_fitting.capacity() * sizeof(PathFittingData) +
+        m_path_points.capacity() * sizeof(uint32_t) +
+        m_path_fitting.capacity() * sizeof(uint32_t) +
+        m_path_role.capacity() * sizeof(ExtrusionRole) +
+        m_path_mm3_per_mm.capacity() * sizeof(double) +
+        m_path_width.capacity() * sizeof(float) +
+        m_path_height.capacity() * sizeof(float) +
+        m_path_inset_idx.capacity() * sizeof(int) +
+        m_path_flags.capacity() * sizeof(uint8_t);
+}
+
+// Lower bound, the allocator overhead of the individual allocations is not accounted for.
+size_t ExtrusionEntityCollectionFlat::memory_used(const ExtrusionEntityCollection &collection)
+{
+    auto path_buffers = [](const ExtrusionPath &path) {
+        return path.polyline.points.capacity() * sizeof(Point) + path.polyline.fitting_result.capacity() * sizeof(PathFittingData);
+    };
+    size_t out = sizeof(ExtrusionEntityCollection) + collection.entities.capacity() * sizeof(ExtrusionEntity*);
+    for (const ExtrusionEntity *entity : collection.entities) {
+        if (const auto *child = dynamic_cast<const ExtrusionEntityCollection*>(entity))
+            out += memory_used(*child);
+        else if (const auto *path = dynamic_cast<const ExtrusionPath*>(entity))
+            out += sizeof(ExtrusionPath) + path_buffers(*path);
+        else if (const auto *multipath = dynamic_cast<const ExtrusionMultiPath*>(entity)) {
+            out += sizeof(ExtrusionMultiPath) + multipath->paths.capacity() * sizeof(ExtrusionPath);
+            for (const ExtrusionPath &path : multipath->paths)
+                out += path_buffers(path);
+        } else if (const auto *loop = dynamic_cast<const ExtrusionLoop*>(entity)) {
+            out += sizeof(ExtrusionLoop) + loop->paths.capacity() * sizeof(ExtrusionPath);
+            for (const ExtrusionPath &path : loop->paths)
+                out += path_buffers(path);
+        }
+    }
+    return out;
+}
+
+} // namespace Slic3r
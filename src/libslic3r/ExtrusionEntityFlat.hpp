@@ -0,0 +1,155 @@
+#ifndef slic3r_ExtrusionEntityFlat_hpp_
+#define slic3r_ExtrusionEntityFlat_hpp_
+
+#include "libslic3r.h"
+#include "ExtrusionEntity.hpp"
+#include "ExtrusionEntityCollection.hpp"
+
+#include <memory>
+
+namespace Slic3r {
+
+// Compact, read mostly representation of a tree of extrusion entities.
+// ExtrusionEntityCollection owns its entities through pointers to the polymorphic ExtrusionEntity classes and every
+// ExtrusionPath owns its Polyline, thus a layer of infill costs a couple of allocations per path and copying it goes
+// through the virtual clone(). Here all points are stored in a single buffer, the path attributes in parallel arrays
+// and the paths, multi-paths, loops and collections are described by typed entries referencing ranges of these arrays.
+//
+// Entities are laid out breadth first, the children of a collection occupy a contiguous range of entities.
+// The paths of multi-paths and loops occupy a contiguous range of paths.
+//
+// Used by the G-code export to chain the infill of a layer: The entities are ordered by their end points stored
+// in the point buffer and only the entity being extruded is instantiated, instead of cloning all of them up front.
+class ExtrusionEntityCollectionFlat
+{
+public:
+    enum class EntityType : uint8_t {
+        Path,
+        PathOriented,
+        MultiPath,
+        Loop,
+        Collection,
+    };
+
+    struct Entity {
+        EntityType  type;
+        // ExtrusionLoopRole for loops, can_reverse for multi-paths, no_sort (bit 0) and not can_reverse (bit 1) for collections.
+        uint8_t     flags { 0 };
+        int         inset_idx { -1 };
+        // Range of paths for paths, multi-paths and loops, range of child entities for collections.
+        uint32_t    begin { 0 };
+        uint32_t    end { 0 };
+
+        bool        is_collection() const { return type == EntityType::Collection; }
+        size_t      size() const { return end - begin; }
+    };
+
+    // Lightweight view of a single path, valid until the flat collection is modified.
+    struct PathView {
+        const Point                 *points_begin;
+        const Point                 *points_end;
+        const PathFittingData       *fitting_begin;
+        const PathFittingData       *fitting_end;
+        ExtrusionRole                role;
+        double                       mm3_per_mm;
+        float                        width;
+        float                        height;
+        bool                         can_reverse;
+        bool                         no_extrusion;
+
+        size_t       size()        const { return points_end - points_begin; }
+        const Point& first_point() const { return *points_begin; }
+        const Point& last_point()  const { return *(points_end - 1); }
+        double       length()      const;
+    };
+
+    ExtrusionEntityCollectionFlat() = default;
+    explicit ExtrusionEntityCollectionFlat(const ExtrusionEntityCollection &src) { this->append(src); }
+
+    // Append the entities of src as root entities, flattening src itself.
+    // Throws InvalidArgument for entity types that are not supported (sloped paths and loops exist only during the G-code export).
+    void            append(const ExtrusionEntityCollection &src);
+    void            clear();
+    void            shrink_to_fit();
+
+    bool            empty()      const { return m_roots.empty(); }
+    // Number of root entities.
+    size_t          size()       const { return m_roots.size(); }
+    // Index of the root entity.
+    size_t          root(size_t idx) const { return m_roots[idx]; }
+    size_t          num_entities() const { return m_entities.size(); }
+    size_t          num_paths()  const { return m_path_role.size(); }
+    size_t          num_points() const { return m_points.size(); }
+
+    const Entity&   entity(size_t idx) const { return m_entities[idx]; }
+    PathView        path(size_t idx) const;
+    // Instantiate a single path, see materialize() for the other entities.
+    void            make_path(size_t idx, ExtrusionPath &dst) const;
+
+    // End points and reversibility of an entity for chaining, matching the ExtrusionEntity queries.
+    // A collection shall not be empty.
+    const Point&    first_point(size_t entity_idx) const;
+    const Point&    last_point(size_t entity_idx) const;
+    bool            is_loop(size_t entity_idx) const { return m_entities[entity_idx].type == EntityType::Loop; }
+    bool            can_reverse(size_t entity_idx) const;
+
+    // Call visitor(const PathView&) for all paths in the order they would be visited in the source collection.
+    template<typename Visitor> void visit_paths(Visitor &&visitor) const
+        { for (uint32_t root : m_roots) this->visit_paths(root, visitor); }
+    template<typename Visitor> void visit_paths(size_t entity_idx, Visitor &visitor) const {
+        const Entity &e = m_entities[entity_idx];
+        if (e.is_collection()) {
+            for (uint32_t i = e.begin; i < e.end; ++ i)
+                this->visit_paths(i, visitor);
+        } else {
+            for (uint32_t i = e.begin; i < e.end; ++ i)
+                visitor(this->path(i));
+        }
+    }
+
+    // Adapters to the ExtrusionEntity interface.
+    // Instantiate a single entity (with its children) as the polymorphic ExtrusionEntity for the code consuming it.
+    std::unique_ptr<ExtrusionEntity> materialize(size_t entity_idx) const;
+    // Rebuild the pointer based collection, the inverse of the constructor.
+    ExtrusionEntityCollection   to_collection() const;
+    ExtrusionRole               role() const;
+    double                      length() const;
+    double                      total_volume() const;
+    double                      min_mm3_per_mm() const;
+    void                        collect_points(Points &dst) const;
+    // Number of non-collection entities, see ExtrusionEntityCollection::items_count().
+    size_t                      items_count() const;
+
+    // Memory allocated by this object in bytes.
+    size_t                      memory_used() const;
+    // Estimate of memory allocated by the pointer based representation, to compare with memory_used().
+    static size_t               memory_used(const ExtrusionEntityCollection &collection);
+
+private:
+    void            append_path(const ExtrusionPath &path);
+    // Fill in entity dst_idx from src. Collections are queued, their children are appended once all the siblings are filled in.
+    void            append_entity(const ExtrusionEntity &src, size_t dst_idx, std::vector<std::pair<const ExtrusionEntityCollection*, size_t>> &queue);
+    void            append_children(std::vector<std::pair<const ExtrusionEntityCollection*, size_t>> &queue);
+    ExtrusionRole   entity_role(size_t idx) const;
+
+    std::vector<Entity>             m_entities;
+    std::vector<uint32_t>           m_roots;
+    // All points of all paths.
+    Points                          m_points;
+    // Arc fitting results of all paths, with point indices relative to the start of their path.
+    std::vector<PathFittingData>    m_fitting;
+    // Path attributes. m_path_points and m_path_fitting hold num_paths() + 1 offsets.
+    std::vector<uint32_t>           m_path_points { 0 };
+    std::vector<uint32_t>           m_path_fitting { 0 };
+    std::vector<ExtrusionRole>      m_path_role;
+    std::vector<double>             m_path_mm3_per_mm;
+    std::vector<float>              m_path_width;
+    std::vector<float>              m_path_height;
+    std::vector<int>                m_path_inset_idx;
+    // Bit 0: can_reverse, bit 1: no_extrusion.
+    std::vector<uint8_t>            m_path_flags;
+};
+
+} // namespace Slic3r
+
+#endif // slic3r_ExtrusionEntityFlat_hpp_
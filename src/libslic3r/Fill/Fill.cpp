@@ -2,6 +2,8 @@
 #include <stdio.h>
 #include <memory>
 
+#include <tbb/parallel_for.h>
+
 #include "../ClipperUtils.hpp"
 #include "../Geometry.hpp"
 #include "../Layer.hpp"
@@ -398,7 +400,10 @@ static std::vector<Lines> filter_vibrating_extrusions(const std::vector<Lines> &
     return lines_sections_out;
 }
 
-void split_solid_surface(size_t layer_id, const SurfaceFill &fill, ExPolygons &normal_infill, ExPolygons &narrow_infill)
+// Split the internal solid infill into the areas wide enough for straight line infill and the narrow areas to be filled
+// with ipConcentricInternal. Both normal_infill and narrow_infill are left empty if the surface is not split.
+// The classification is looked up in and stored into cache if not null.
+void split_solid_surface(size_t layer_id, const SurfaceFill &fill, ExPolygons &normal_infill, ExPolygons &narrow_infill, SolidSurfaceSplitCache *cache)
 {
     assert(fill.surface.surface_type == stInternalSolid);
 
@@ -431,6 +436,18 @@ void split_solid_surface(size_t layer_id, const SurfaceFill &fill, ExPolygons &n
     }
     const double aligning_angle = -base_angle + PI;
 
+    SolidSurfaceSplitCache::Key cache_key;
+    if (cache) {
+        cache_key = { fill.params.pattern, scaled_spacing, fill.params.overlap, aligning_angle, fill.expolygons };
+        cache_key.update_hash();
+        SolidSurfaceSplitCache::Value cached;
+        if (cache->find(cache_key, cached)) {
+            normal_infill = std::move(cached.normal_infill);
+            narrow_infill = std::move(cached.narrow_infill);
+            return;
+        }
+    }
+
 	for (const ExPolygon &expolygon : fill.expolygons) {
         Polygons filled_area = to_polygons(expolygon);
         polygons_rotate(filled_area, aligning_angle);
@@ -590,12 +607,16 @@ void split_solid_surface(size_t layer_id, const SurfaceFill &fill, ExPolygons &n
 
     if (narrow_fill_areas.empty()) {
         // No split needed
+        if (cache)
+            cache->insert(std::move(cache_key), {});
         return;
     }
 
     // Expand the normal infills a little bit to avoid gaps between normal and narrow infills
     normal_infill = intersection_ex(offset_ex(normal_fill_areas_ex, scaled_spacing * 0.1), fill.expolygons);
     narrow_infill = narrow_fill_areas;
+    if (cache)
+        cache->insert(std::move(cache_key), { normal_infill, narrow_infill });
 
 #ifdef DEBUG_SURFACE_SPLIT
     {
@@ -909,7 +930,7 @@ std::vector<SurfaceFill> group_fills(const Layer &layer, LockRegionParam &lock_p
 
 			ExPolygons normal_infill;
             ExPolygons narrow_infill;
-            split_solid_surface(layer.id(), surface_fills[i], normal_infill, narrow_infill);
+            split_solid_surface(layer.id(), surface_fills[i], normal_infill, narrow_infill, &layer.object()->solid_surface_split_cache());
 
 			if (narrow_infill.empty()) {
 				// BBS: has no narrow expolygon
@@ -982,7 +1003,16 @@ void Layer::make_fills(FillAdaptive::Octree* adaptive_fill_octree, FillAdaptive:
 	}
 #endif /* SLIC3R_DEBUG_SLICE_PROCESSING */
 
-    for (SurfaceFill &surface_fill : surface_fills) {
+    // The surface fills are independent of each other: each one owns its surface and expolygons, the fillers only read
+    // the octrees, the Lightning trees and the lock parameters. Layers are already filled in parallel, however a layer
+    // with many regions or large solid surfaces may take much longer than its neighbours, thus fill the surface fills
+    // of a single layer in parallel as well. Each surface fill collects its extrusions into its own vector, which are
+    // then appended to the regions in the order of surface_fills, so the result is the same as if filled sequentially.
+    std::vector<ExtrusionEntitiesPtr> surface_fill_entities(surface_fills.size());
+    auto fill_one = [this, &surface_fills, &surface_fill_entities, &bbox, resolution, &lock_param,
+                     adaptive_fill_octree, support_fill_octree, lightning_generator](size_t surface_fill_idx) {
+        SurfaceFill          &surface_fill = surface_fills[surface_fill_idx];
+        ExtrusionEntitiesPtr &out          = surface_fill_entities[surface_fill_idx];
         // Create the filler object.
         std::unique_ptr<Fill> f = std::unique_ptr<Fill>(Fill::new_from_type(surface_fill.params.pattern));
         f->set_bounding_box(bbox);
@@ -1092,10 +1122,20 @@ void Layer::make_fills(FillAdaptive::Octree* adaptive_fill_octree, FillAdaptive:
                 params.dont_adjust = true;
             }
 			// BBS: make fill
-			f->fill_surface_extrusion(&surface_fill.surface,
-				params,
-				m_regions[surface_fill.region_id]->fills.entities);
+			f->fill_surface_extrusion(&surface_fill.surface, params, out);
 		}
+    };
+    if (surface_fills.size() > 1)
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, surface_fills.size(), 1), [&fill_one](const tbb::blocked_range<size_t> &range) {
+            for (size_t surface_fill_idx = range.begin(); surface_fill_idx < range.end(); ++ surface_fill_idx)
+                fill_one(surface_fill_idx);
+        });
+    else if (! surface_fills.empty())
+        fill_one(0);
+    for (size_t surface_fill_idx = 0; surface_fill_idx < surface_fills.size(); ++ surface_fill_idx) {
+        ExtrusionEntitiesPtr &dst = m_regions[surface_fills[surface_fill_idx].region_id]->fills.entities;
+        ExtrusionEntitiesPtr &src = surface_fill_entities[surface_fill_idx];
+        dst.insert(dst.end(), src.begin(), src.end());
     }
 
     // add thin fill regions
@@ -1228,6 +1268,10 @@ void Layer::make_ironing()
 	// Here we want to collect top surfaces extruded with the same extruder.
 	// A surface will be ironed with the same extruder to not contaminate the print with another material leaking from the nozzle.
 
+	// Ironing may be regenerated without regenerating the infill, remove the ironing of the previous run.
+	for (LayerRegion *layerm : m_regions)
+		layerm->clear_ironing();
+
 	// First classify regions based on the extruder used.
 	struct IroningParams {
 		InfillPattern pattern;
@@ -1440,6 +1484,8 @@ void Layer::make_ironing()
 		            eec->entities, std::move(polylines),
 		            erIroning,
 		            flow_mm3_per_mm, extrusion_width, float(extrusion_height));
+		        // Simplified here rather than by PrintObject::simplify_extrusion_path(), which is not repeated if just the ironing changes.
+		        ironing_params.layerm->simplify_entity_collection(eec);
 		    }
 		}
 
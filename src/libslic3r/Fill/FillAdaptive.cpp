@@ -20,6 +20,10 @@
 #define BOOST_POOL_NO_MT
 #include <boost/pool/object_pool.hpp>
 
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_invoke.h>
+#include <tbb/spin_mutex.h>
+
 #include <boost/geometry.hpp>
 #include <boost/geometry/geometries/point.hpp>
 #include <boost/geometry/geometries/segment.hpp>
@@ -254,11 +258,18 @@ struct CubeProperties
     double line_xy_distance;// Defines maximal distance from a center of a cube on X and Y axis on which lines will be created
 };
 
+// Triangles to be inserted into an octree, in the coordinate system of the octree.
+using OctreeTriangles = std::vector<std::array<Vec3d, 3>>;
+
 struct Octree
 {
     // Octree will allocate its Cubes from the pool. The pool only supports deletion of the complete pool,
     // perfect for building up our octree.
     boost::object_pool<Cube>    pool;
+    // Subtrees built in parallel allocate their Cubes from their own pools.
+    std::vector<std::unique_ptr<boost::object_pool<Cube>>> subtree_pools;
+    // Protects pool and subtree_pools while the octree is being built in parallel.
+    tbb::spin_mutex             pool_mutex;
     Cube*                       root_cube { nullptr };
     Vec3d                       origin;
     std::vector<CubeProperties> cubes_properties;
@@ -266,7 +277,13 @@ struct Octree
     Octree(const Vec3d &origin, const std::vector<CubeProperties> &cubes_properties)
         : root_cube(pool.construct(origin)), origin(origin), cubes_properties(cubes_properties) {}
 
-    void insert_triangle(const Vec3d &a, const Vec3d &b, const Vec3d &c, Cube *current_cube, const BoundingBoxf3 &current_bbox, int depth);
+    void insert_triangle(const Vec3d &a, const Vec3d &b, const Vec3d &c, Cube *current_cube, const BoundingBoxf3 &current_bbox, int depth)
+        { this->insert_triangle(a, b, c, current_cube, current_bbox, depth, this->pool); }
+    void insert_triangle(const Vec3d &a, const Vec3d &b, const Vec3d &c, Cube *current_cube, const BoundingBoxf3 &current_bbox, int depth, boost::object_pool<Cube> &cube_pool);
+    // Insert triangles[indices] into the subtree of current_cube. The triangles are distributed among the children of current_cube
+    // and the children are processed in parallel while there are enough triangles, then each subtree is built by a single thread
+    // into its own pool. The resulting octree is the same as if the triangles were inserted one by one with insert_triangle().
+    void insert_triangles_parallel(const OctreeTriangles &triangles, const std::vector<uint32_t> &indices, Cube *current_cube, const BoundingBoxf3 &current_bbox, int depth);
 };
 
 void OctreeDeleter::operator()(Octree *p) {
@@ -1463,45 +1480,55 @@ static void transform_center(Cube *current_cube, const Eigen::Matrix3d &rot)
             transform_center(child, rot);
 }
 
-OctreePtr build_octree(
-    // Mesh is rotated to the coordinate system of the octree.
+// Collect the triangles of the mesh and the overhang triangles for the adaptive octree (all triangles)
+// and for the support octree (overhanging triangles only) in a single pass over the mesh.
+static void collect_octree_triangles(
     const indexed_triangle_set  &triangle_mesh,
-    // Overhang triangles extracted from fill surfaces with stInternalBridge type,
-    // rotated to the coordinate system of the octree.
-    const std::vector<Vec3d>    &overhang_triangles, 
-    coordf_t                     line_spacing,
-    bool                         support_overhangs_only)
+    const std::vector<Vec3d>    &overhang_triangles,
+    OctreeTriangles             *adaptive_triangles,
+    OctreeTriangles             *support_triangles)
+{
+    auto up_vector = Vec3d(transform_to_octree() * Vec3d(0., 0., 1.));
+    if (adaptive_triangles)
+        adaptive_triangles->reserve(triangle_mesh.indices.size() + overhang_triangles.size() / 3);
+    for (auto &tri : triangle_mesh.indices) {
+        std::array<Vec3d, 3> triangle { triangle_mesh.vertices[tri[0]].cast<double>(), triangle_mesh.vertices[tri[1]].cast<double>(), triangle_mesh.vertices[tri[2]].cast<double>() };
+        if (support_triangles && is_overhang_triangle(triangle[0], triangle[1], triangle[2], up_vector))
+            support_triangles->emplace_back(triangle);
+        if (adaptive_triangles)
+            adaptive_triangles->emplace_back(triangle);
+    }
+    for (size_t i = 0; i < overhang_triangles.size(); i += 3) {
+        std::array<Vec3d, 3> triangle { overhang_triangles[i], overhang_triangles[i + 1], overhang_triangles[i + 2] };
+        if (adaptive_triangles)
+            adaptive_triangles->emplace_back(triangle);
+        if (support_triangles)
+            support_triangles->emplace_back(triangle);
+    }
+}
+
+static OctreePtr build_octree_from_triangles(const BoundingBox3Base<Vec3f> &bbox, const OctreeTriangles &triangles, coordf_t line_spacing, bool parallel)
 {
     assert(line_spacing > 0);
     assert(! std::isnan(line_spacing));
 
-    BoundingBox3Base<Vec3f>     bbox(triangle_mesh.vertices);
     Vec3d                       cube_center      = bbox.center().cast<double>();
     std::vector<CubeProperties> cubes_properties = make_cubes_properties(double(bbox.size().maxCoeff()), line_spacing);
     auto                        octree           = OctreePtr(new Octree(cube_center, cubes_properties));
 
     if (cubes_properties.size() > 1) {
-        Octree *octree_ptr = octree.get();
-        double edge_length_half = 0.5 * cubes_properties.back().edge_length;
-        Vec3d  diag_half(edge_length_half, edge_length_half, edge_length_half);
-        int    max_depth = int(cubes_properties.size()) - 1;
-        auto process_triangle = [octree_ptr, max_depth, diag_half](const Vec3d &a, const Vec3d &b, const Vec3d &c) {
-            octree_ptr->insert_triangle(
-                a, b, c,
-                octree_ptr->root_cube,
-                BoundingBoxf3(octree_ptr->root_cube->center - diag_half, octree_ptr->root_cube->center + diag_half),
-                max_depth);
-        };
-        auto up_vector = support_overhangs_only ? Vec3d(transform_to_octree() * Vec3d(0., 0., 1.)) : Vec3d();
-        for (auto &tri : triangle_mesh.indices) {
-            Vec3d a = triangle_mesh.vertices[tri[0]].cast<double>();
-            Vec3d b = triangle_mesh.vertices[tri[1]].cast<double>();
-            Vec3d c = triangle_mesh.vertices[tri[2]].cast<double>();
-            if (! support_overhangs_only || is_overhang_triangle(a, b, c, up_vector))
-                process_triangle(a, b, c);
+        double        edge_length_half = 0.5 * cubes_properties.back().edge_length;
+        Vec3d         diag_half(edge_length_half, edge_length_half, edge_length_half);
+        BoundingBoxf3 root_bbox(octree->root_cube->center - diag_half, octree->root_cube->center + diag_half);
+        int           max_depth = int(cubes_properties.size()) - 1;
+        if (parallel) {
+            std::vector<uint32_t> indices(triangles.size());
+            std::iota(indices.begin(), indices.end(), 0);
+            octree->insert_triangles_parallel(triangles, indices, octree->root_cube, root_bbox, max_depth);
+        } else {
+            for (const std::array<Vec3d, 3> &triangle : triangles)
+                octree->insert_triangle(triangle[0], triangle[1], triangle[2], octree->root_cube, root_bbox, max_depth);
         }
-        for (size_t i = 0; i < overhang_triangles.size(); i += 3)
-            process_triangle(overhang_triangles[i], overhang_triangles[i + 1], overhang_triangles[i + 2]);
         {
             // Transform the octree to world coordinates to reduce computation when extracting infill lines.
             auto rot = transform_to_world().toRotationMatrix();
@@ -1513,7 +1540,58 @@ OctreePtr build_octree(
     return octree;
 }
 
-void Octree::insert_triangle(const Vec3d &a, const Vec3d &b, const Vec3d &c, Cube *current_cube, const BoundingBoxf3 &current_bbox, int depth)
+OctreePtr build_octree(
+    // Mesh is rotated to the coordinate system of the octree.
+    const indexed_triangle_set  &triangle_mesh,
+    // Overhang triangles extracted from fill surfaces with stInternalBridge type,
+    // rotated to the coordinate system of the octree.
+    const std::vector<Vec3d>    &overhang_triangles, 
+    coordf_t                     line_spacing,
+    bool                         support_overhangs_only,
+    bool                         parallel)
+{
+    OctreeTriangles triangles;
+    collect_octree_triangles(triangle_mesh, overhang_triangles, support_overhangs_only ? nullptr : &triangles, support_overhangs_only ? &triangles : nullptr);
+    return build_octree_from_triangles(BoundingBox3Base<Vec3f>(triangle_mesh.vertices), triangles, line_spacing, parallel);
+}
+
+std::pair<OctreePtr, OctreePtr> build_octrees(
+    const indexed_triangle_set  &triangle_mesh,
+    const std::vector<Vec3d>    &overhang_triangles,
+    coordf_t                     adaptive_line_spacing,
+    coordf_t                     support_line_spacing)
+{
+    OctreeTriangles adaptive_triangles;
+    OctreeTriangles support_triangles;
+    collect_octree_triangles(triangle_mesh, overhang_triangles,
+        adaptive_line_spacing > 0. ? &adaptive_triangles : nullptr, support_line_spacing > 0. ? &support_triangles : nullptr);
+    BoundingBox3Base<Vec3f> bbox(triangle_mesh.vertices);
+    std::pair<OctreePtr, OctreePtr> out;
+    tbb::parallel_invoke(
+        [&]() { if (adaptive_line_spacing > 0.) out.first  = build_octree_from_triangles(bbox, adaptive_triangles, adaptive_line_spacing, true); },
+        [&]() { if (support_line_spacing  > 0.) out.second = build_octree_from_triangles(bbox, support_triangles,  support_line_spacing,  true); });
+    return out;
+}
+
+// Calculate a slightly expanded bounding box of a child cube to cope with triangles touching a cube wall and other numeric errors.
+// We will rather densify the octree a bit more than necessary instead of missing a triangle.
+static inline BoundingBoxf3 child_bbox(const Cube *current_cube, const BoundingBoxf3 &current_bbox, size_t child_idx)
+{
+    const Vec3d &child_center_dir = child_centers[child_idx];
+    BoundingBoxf3 bbox;
+    for (int k = 0; k < 3; ++ k) {
+        if (child_center_dir[k] == -1.) {
+            bbox.min[k] = current_bbox.min[k];
+            bbox.max[k] = current_cube->center[k] + EPSILON;
+        } else {
+            bbox.min[k] = current_cube->center[k] - EPSILON;
+            bbox.max[k] = current_bbox.max[k];
+        }
+    }
+    return bbox;
+}
+
+void Octree::insert_triangle(const Vec3d &a, const Vec3d &b, const Vec3d &c, Cube *current_cube, const BoundingBoxf3 &current_bbox, int depth, boost::object_pool<Cube> &cube_pool)
 {
     assert(current_cube);
     assert(depth > 0);
@@ -1524,29 +1602,69 @@ void Octree::insert_triangle(const Vec3d &a, const Vec3d &b, const Vec3d &c, Cub
     // const double r2_cube = Slic3r::sqr(0.5 * this->cubes_properties[depth].height + EPSILON);
 
     for (size_t i = 0; i < 8; ++ i) {
-        const Vec3d &child_center_dir = child_centers[i];
-        // Calculate a slightly expanded bounding box of a child cube to cope with triangles touching a cube wall and other numeric errors.
-        // We will rather densify the octree a bit more than necessary instead of missing a triangle.
-        BoundingBoxf3 bbox;
-        for (int k = 0; k < 3; ++ k) {
-            if (child_center_dir[k] == -1.) {
-                bbox.min[k] = current_bbox.min[k];
-                bbox.max[k] = current_cube->center[k] + EPSILON;
-            } else {
-                bbox.min[k] = current_cube->center[k] - EPSILON;
-                bbox.max[k] = current_bbox.max[k];
-            }
-        }
-        Vec3d child_center = current_cube->center + (child_center_dir * (this->cubes_properties[depth].edge_length / 2.));
+        BoundingBoxf3 bbox = child_bbox(current_cube, current_bbox, i);
         //if (dist2_to_triangle(a, b, c, child_center) < r2_cube) {
         // dist2_to_triangle and r2_cube are commented out too.
         if (triangle_AABB_intersects(a, b, c, bbox)) {
             if (! current_cube->children[i])
-                current_cube->children[i] = this->pool.construct(child_center);
+                current_cube->children[i] = cube_pool.construct(Vec3d(current_cube->center + (child_centers[i] * (this->cubes_properties[depth].edge_length / 2.))));
             if (depth > 0)
-                this->insert_triangle(a, b, c, current_cube->children[i], bbox, depth);
+                this->insert_triangle(a, b, c, current_cube->children[i], bbox, depth, cube_pool);
+        }
+    }
+}
+
+void Octree::insert_triangles_parallel(const OctreeTriangles &triangles, const std::vector<uint32_t> &indices, Cube *current_cube, const BoundingBoxf3 &current_bbox, int depth)
+{
+    assert(current_cube);
+    assert(depth > 0);
+
+    // Below this number of triangles a subtree is built by a single thread.
+    static constexpr size_t min_triangles_parallel = 2048;
+    if (depth == 1 || indices.size() < min_triangles_parallel) {
+        boost::object_pool<Cube> *subtree_pool;
+        {
+            tbb::spin_mutex::scoped_lock lock(this->pool_mutex);
+            subtree_pool = this->subtree_pools.emplace_back(std::make_unique<boost::object_pool<Cube>>()).get();
         }
+        for (uint32_t idx : indices) {
+            const std::array<Vec3d, 3> &triangle = triangles[idx];
+            this->insert_triangle(triangle[0], triangle[1], triangle[2], current_cube, current_bbox, depth, *subtree_pool);
+        }
+        return;
     }
+
+    --depth;
+
+    std::array<BoundingBoxf3, 8> bboxes;
+    for (size_t i = 0; i < 8; ++ i)
+        bboxes[i] = child_bbox(current_cube, current_bbox, i);
+    // Bit mask of the children intersected by each triangle.
+    std::vector<uint8_t> masks(indices.size(), 0);
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, indices.size(), 1024), [&triangles, &indices, &bboxes, &masks](const tbb::blocked_range<size_t> &range) {
+        for (size_t i = range.begin(); i < range.end(); ++ i) {
+            const std::array<Vec3d, 3> &triangle = triangles[indices[i]];
+            for (size_t j = 0; j < 8; ++ j)
+                if (triangle_AABB_intersects(triangle[0], triangle[1], triangle[2], bboxes[j]))
+                    masks[i] |= uint8_t(1 << j);
+        }
+    });
+    std::array<std::vector<uint32_t>, 8> child_indices;
+    for (size_t i = 0; i < indices.size(); ++ i)
+        for (size_t j = 0; j < 8; ++ j)
+            if (masks[i] & (1 << j))
+                child_indices[j].emplace_back(indices[i]);
+    {
+        tbb::spin_mutex::scoped_lock lock(this->pool_mutex);
+        for (size_t i = 0; i < 8; ++ i)
+            if (! child_indices[i].empty() && ! current_cube->children[i])
+                current_cube->children[i] = this->pool.construct(Vec3d(current_cube->center + (child_centers[i] * (this->cubes_properties[depth].edge_length / 2.))));
+    }
+    if (depth > 0)
+        tbb::parallel_for(size_t(0), size_t(8), [this, &triangles, &child_indices, &bboxes, current_cube, depth](size_t i) {
+            if (! child_indices[i].empty())
+                this->insert_triangles_parallel(triangles, child_indices[i], current_cube->children[i], bboxes[i], depth);
+        });
 }
 
 } // namespace FillAdaptive
@@ -46,7 +46,20 @@ FillAdaptive::OctreePtr         build_octree(
     const std::vector<Vec3d>    &overhang_triangles, 
     coordf_t                     line_spacing, 
     // If true, octree is densified below internal overhangs only.
-    bool                         support_overhangs_only);
+    bool                         support_overhangs_only,
+    // Insert the triangles into the octree in parallel. The resulting octree is the same.
+    bool                         parallel = true);
+
+// Build the octrees for the adaptive cubic infill and for the support cubic infill with a single pass over the mesh,
+// the two octrees are built in parallel. Zero line spacing skips the respective octree.
+std::pair<FillAdaptive::OctreePtr, FillAdaptive::OctreePtr> build_octrees(
+    // Mesh is rotated to the coordinate system of the octree.
+    const indexed_triangle_set  &triangle_mesh,
+    // Overhang triangles extracted from fill surfaces with stInternalBridge type,
+    // rotated to the coordinate system of the octree.
+    const std::vector<Vec3d>    &overhang_triangles,
+    coordf_t                     adaptive_line_spacing,
+    coordf_t                     support_line_spacing);
 
 //
 // Some of the algorithms used by class FillAdaptive were inspired by
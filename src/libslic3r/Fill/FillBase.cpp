@@ -6,6 +6,7 @@
 #include "../EdgeGrid.hpp"
 #include "../Geometry.hpp"
 #include "../Geometry/Circle.hpp"
+#include "../Int128.hpp"
 #include "../Point.hpp"
 #include "../PrintConfig.hpp"
 #include "../Surface.hpp"
@@ -2747,4 +2748,188 @@ void multiline_fill(Polylines& polylines, const FillParams& params, float spacin
     }
 }
 
+
+// Sign of the cross product (b - a) x (c - a). Infill coordinates fit 31 bits, thus the product is evaluated
+// in 64 bits if possible, falling back to 128 bits for huge coordinates.
+static inline int infill_clipper_orient(const Point &a, const Point &b, const Point &c)
+{
+    const int64_t a11 = int64_t(b.x()) - a.x();
+    const int64_t a12 = int64_t(b.y()) - a.y();
+    const int64_t a21 = int64_t(c.x()) - a.x();
+    const int64_t a22 = int64_t(c.y()) - a.y();
+    static constexpr int64_t limit = int64_t(1) << 30;
+    if (std::abs(a11) < limit && std::abs(a12) < limit && std::abs(a21) < limit && std::abs(a22) < limit) {
+        const int64_t det = a11 * a22 - a12 * a21;
+        return det > 0 ? 1 : det < 0 ? -1 : 0;
+    }
+    return Int128::sign_determinant_2x2(a11, a12, a21, a22);
+}
+
+InfillScanlineClipper::InfillScanlineClipper(const ExPolygon &boundary) : m_boundary(&boundary)
+{
+    size_t num_points = boundary.contour.size();
+    for (const Polygon &hole : boundary.holes)
+        num_points += hole.size();
+    m_edges.reserve(num_points);
+    auto add_edges = [this](const Polygon &polygon) {
+        for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i ++)
+            if (polygon.points[j] != polygon.points[i])
+                m_edges.emplace_back(polygon.points[j], polygon.points[i]);
+    };
+    add_edges(boundary.contour);
+    for (const Polygon &hole : boundary.holes)
+        add_edges(hole);
+    if (m_edges.empty()) {
+        m_bands.assign(2, 0);
+        return;
+    }
+    m_bbox = get_extents(boundary.contour);
+
+    // Bands of the average edge height: Each edge is stored in at most 2 + its height / m_band_height bands,
+    // thus the bands hold at most 3x the number of edges in total, even for comb like surfaces with many tall edges.
+    // As the edges of a closed contour span its height at least twice, there is at most one band per two edges.
+    const coord_t height = m_bbox.max.y() - m_bbox.min.y();
+    int64_t       sum_edge_heights = 0;
+    for (const Line &edge : m_edges)
+        sum_edge_heights += std::abs(int64_t(edge.b.y()) - int64_t(edge.a.y()));
+    m_band_height = coord_t(sum_edge_heights / int64_t(m_edges.size())) + 1;
+    const size_t num_bands = size_t(height / m_band_height) + 1;
+    m_bands.assign(num_bands + 1, 0);
+    m_edge_first_band.reserve(m_edges.size());
+    for (const Line &edge : m_edges) {
+        const size_t first = this->band_idx(std::min(edge.a.y(), edge.b.y()));
+        const size_t last  = this->band_idx(std::max(edge.a.y(), edge.b.y()));
+        m_edge_first_band.emplace_back(uint32_t(first));
+        for (size_t band = first; band <= last; ++ band)
+            ++ m_bands[band + 1];
+    }
+    for (size_t band = 1; band < m_bands.size(); ++ band)
+        m_bands[band] += m_bands[band - 1];
+    m_band_edges.assign(m_bands.back(), 0);
+    std::vector<uint32_t> cursor(m_bands.begin(), m_bands.end() - 1);
+    for (uint32_t edge_idx = 0; edge_idx < uint32_t(m_edges.size()); ++ edge_idx) {
+        const Line &edge = m_edges[edge_idx];
+        for (size_t band = m_edge_first_band[edge_idx], last = this->band_idx(std::max(edge.a.y(), edge.b.y())); band <= last; ++ band)
+            m_band_edges[cursor[band] ++] = edge_idx;
+    }
+}
+
+int InfillScanlineClipper::point_location(const Point &pt) const
+{
+    if (m_edges.empty() || ! m_bbox.contains(pt))
+        return -1;
+    // Count crossings of a ray cast from pt towards +X.
+    bool         inside = false;
+    const size_t band   = this->band_idx(pt.y());
+    for (uint32_t i = m_bands[band]; i < m_bands[band + 1]; ++ i) {
+        const Line &edge   = m_edges[m_band_edges[i]];
+        const bool  up     = edge.b.y() > edge.a.y();
+        if ((edge.a.y() > pt.y()) != (edge.b.y() > pt.y())) {
+            const int orient = infill_clipper_orient(edge.a, edge.b, pt);
+            if (orient == 0)
+                return 0;
+            if (up ? orient > 0 : orient < 0)
+                inside = ! inside;
+        } else if (std::min(edge.a.y(), edge.b.y()) <= pt.y() && std::max(edge.a.y(), edge.b.y()) >= pt.y() &&
+                   std::min(edge.a.x(), edge.b.x()) <= pt.x() && std::max(edge.a.x(), edge.b.x()) >= pt.x() &&
+                   infill_clipper_orient(edge.a, edge.b, pt) == 0)
+            // On a horizontal edge or on a vertex.
+            return 0;
+    }
+    return inside ? 1 : -1;
+}
+
+bool InfillScanlineClipper::segment_crossings(const Point &a, const Point &b, std::vector<Crossing> &out) const
+{
+    const coord_t ymin = std::max(std::min(a.y(), b.y()), m_bbox.min.y());
+    const coord_t ymax = std::min(std::max(a.y(), b.y()), m_bbox.max.y());
+    const coord_t xmin = std::min(a.x(), b.x());
+    const coord_t xmax = std::max(a.x(), b.x());
+    if (ymin > ymax || xmax < m_bbox.min.x() || xmin > m_bbox.max.x())
+        return true;
+
+    const size_t first_band = this->band_idx(ymin);
+    const size_t last_band  = this->band_idx(ymax);
+    const Vec2d  ab         = (b - a).cast<double>();
+    for (size_t band = first_band; band <= last_band; ++ band)
+        for (uint32_t i = m_bands[band]; i < m_bands[band + 1]; ++ i) {
+            const uint32_t edge_idx = m_band_edges[i];
+            // An edge spanning multiple bands is visited in the first band of both the edge and the segment.
+            if (std::max<size_t>(m_edge_first_band[edge_idx], first_band) != band)
+                continue;
+            const Line &edge = m_edges[edge_idx];
+            if (std::max(edge.a.x(), edge.b.x()) < xmin || std::min(edge.a.x(), edge.b.x()) > xmax ||
+                std::max(edge.a.y(), edge.b.y()) < std::min(a.y(), b.y()) || std::min(edge.a.y(), edge.b.y()) > std::max(a.y(), b.y()))
+                continue;
+            const int oa = infill_clipper_orient(edge.a, edge.b, a);
+            const int ob = infill_clipper_orient(edge.a, edge.b, b);
+            const int oc = infill_clipper_orient(a, b, edge.a);
+            const int od = infill_clipper_orient(a, b, edge.b);
+            if (oa * ob > 0 || oc * od > 0)
+                continue;
+            if (oa != 0 && ob != 0 && oc != 0 && od != 0) {
+                // Regular crossing.
+                const Vec2d  ed = (edge.b - edge.a).cast<double>();
+                const double t  = cross2((edge.a - a).cast<double>(), ed) / cross2(ab, ed);
+                out.push_back({ t, Point(Vec2d(a.cast<double>() + t * ab)) });
+                continue;
+            }
+            // The segment touches a vertex, an end point of the segment lies on the boundary or the segment overlaps an edge.
+            return false;
+        }
+    std::sort(out.begin(), out.end(), [](const Crossing &c1, const Crossing &c2) { return c1.t < c2.t; });
+    return true;
+}
+
+void InfillScanlineClipper::clip(const Polyline &polyline, Polylines &out) const
+{
+    if (polyline.size() < 2 || m_edges.empty())
+        return;
+
+    const size_t          out_begin = out.size();
+    std::vector<Crossing> crossings;
+    const int             location  = this->point_location(polyline.points.front());
+    bool                  inside    = location > 0;
+    Polyline              piece;
+    auto                  flush     = [&out, &piece]() {
+        if (piece.size() > 2 || (piece.size() == 2 && piece.points.front() != piece.points.back()))
+            out.emplace_back(std::move(piece));
+        piece.clear();
+    };
+    if (inside)
+        piece.points.emplace_back(polyline.points.front());
+    for (size_t i = 1; i < polyline.size(); ++ i) {
+        const Point &a = polyline.points[i - 1];
+        const Point &b = polyline.points[i];
+        crossings.clear();
+        if (location == 0 || ! this->segment_crossings(a, b, crossings)) {
+            // Inside / outside state cannot be propagated over a degenerate crossing. Clipper splits the pieces at the touched vertices
+            // and keeps or drops the pieces running along the boundary depending on the edge orientation, let it clip this polyline.
+            out.erase(out.begin() + out_begin, out.end());
+            append(out, intersection_pl(polyline, *m_boundary));
+            return;
+        }
+        for (const Crossing &crossing : crossings) {
+            if (inside) {
+                piece.points.emplace_back(crossing.pt);
+                flush();
+            } else
+                piece.points.emplace_back(crossing.pt);
+            inside = ! inside;
+        }
+        if (inside)
+            piece.points.emplace_back(b);
+    }
+    if (inside)
+        flush();
+}
+
+Polylines InfillScanlineClipper::clip(const Polylines &polylines) const
+{
+    Polylines out;
+    for (const Polyline &polyline : polylines)
+        this->clip(polyline, out);
+    return out;
+}
+
 } // namespace Slic3r
@@ -226,6 +226,50 @@ public:
 };
    //Fill  Multiline 
    void multiline_fill(Polylines& polylines, const FillParams& params, float spacing);
+
+// Clips open polylines by a single ExPolygon, a replacement of intersection_pl() for the infill patterns generated over
+// the whole bounding box of a surface. Instead of building a Clipper sweep over all the pattern segments, the edges
+// of the surface are sorted into horizontal bands once, then each pattern segment is intersected with the edges
+// of the bands it spans only.
+// The polylines touching a boundary vertex, starting on the boundary or running along it are clipped by intersection_pl(),
+// thus the pieces are the same as with intersection_pl() up to the rounding of the crossing points, their order and direction.
+// The boundary has to outlive the clipper.
+class InfillScanlineClipper
+{
+public:
+    explicit InfillScanlineClipper(const ExPolygon &boundary);
+
+    void        clip(const Polyline &polyline, Polylines &out) const;
+    Polylines   clip(const Polylines &polylines) const;
+    // Point strictly inside the boundary.
+    bool        contains(const Point &pt) const { return this->point_location(pt) > 0; }
+
+private:
+    struct Crossing {
+        double  t;
+        Point   pt;
+    };
+
+    // 1 inside, 0 on the boundary, -1 outside.
+    int         point_location(const Point &pt) const;
+    size_t      band_idx(coord_t y) const { return std::min(size_t((y - m_bbox.min.y()) / m_band_height), m_bands.size() - 2); }
+    // Intersections of segment a, b with the boundary sorted along the segment, returns false if a degenerate
+    // (collinear) configuration has been found and the crossings could not be trusted to flip the inside / outside state.
+    bool        segment_crossings(const Point &a, const Point &b, std::vector<Crossing> &out) const;
+
+    const ExPolygon        *m_boundary;
+    BoundingBox             m_bbox;
+    coord_t                 m_band_height { 1 };
+    // Edges of the contour and the holes, with their first band.
+    std::vector<Line>       m_edges;
+    std::vector<uint32_t>   m_edge_first_band;
+    // Indices of edges intersecting each band, m_bands holds the offsets into m_band_edges for num_bands + 1 bands.
+    std::vector<uint32_t>   m_bands;
+    std::vector<uint32_t>   m_band_edges;
+};
+
+// Shortcut for the infill patterns clipping a pattern generated over the bounding box of expolygon.
+inline Polylines clip_infill_polylines(const Polylines &polylines, const ExPolygon &expolygon) { return InfillScanlineClipper(expolygon).clip(polylines); }
 } // namespace Slic3r
 
 #endif // slic3r_FillBase_hpp_
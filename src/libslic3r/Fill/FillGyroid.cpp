@@ -172,7 +172,7 @@ void FillGyroid::_fill_surface_single(
     coord_t expand = 10 * (scale_(this->spacing));
     bb.offset(expand); 
 
-    // generate pattern
+    // generate pattern in the coordinate system of the grid origin
     Polylines polylines = make_gyroid_waves(
         scale_(this->z),
         density_adjusted,
@@ -180,14 +180,15 @@ void FillGyroid::_fill_surface_single(
         ceil(bb.size()(0) / distance) + 1.,
         ceil(bb.size()(1) / distance) + 1.);
 
-	// shift the polyline to the grid origin
-	for (Polyline &pl : polylines)
-		pl.translate(bb.min);
-
     // Apply multiline offset if needed
     multiline_fill(polylines, params, spacing);
 
-	polylines = intersection_pl(polylines, expolygon);
+    // clip the pattern in the coordinate system of the grid origin, then shift the result back
+    ExPolygon expolygon_local = expolygon;
+    expolygon_local.translate(- bb.min);
+    polylines = clip_infill_polylines(polylines, expolygon_local);
+    for (Polyline &pl : polylines)
+        pl.translate(bb.min);
 
     if (! polylines.empty()) {
 		// Remove very small bits, but be careful to not remove infill lines connecting thin walls!
@@ -118,7 +118,8 @@ void FillPlanePath::_fill_surface_single(
     }
 
     if (polyline.size() >= 2) {
-        Polylines polylines = intersection_pl(polyline, expolygon);
+        Polylines polylines;
+        InfillScanlineClipper(expolygon).clip(polyline, polylines);
         if (!polylines.empty()) {
             Polylines chained;
             if (params.dont_connect() || params.density > 0.5) {
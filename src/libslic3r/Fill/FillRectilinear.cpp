@@ -11,6 +11,8 @@
 #include <boost/static_assert.hpp>
 #include <boost/math/constants/constants.hpp>
 
+#include <tbb/parallel_for.h>
+
 #include "../ClipperUtils.hpp"
 #include "../ExPolygon.hpp"
 #include "../Geometry.hpp"
@@ -756,160 +758,268 @@ enum DirectionMask
     DIR_BACKWARD = 2
 };
 
-static std::vector<SegmentedIntersectionLine> slice_region_by_vertical_lines(const ExPolygonWithOffset &poly_with_offset, size_t n_vlines, coord_t x0, coord_t line_spacing)
-{
-    // Allocate storage for the segments.
-    std::vector<SegmentedIntersectionLine> segs(n_vlines, SegmentedIntersectionLine());
-    for (coord_t i = 0; i < coord_t(n_vlines); ++ i) {
-        segs[i].idx = i;
-        segs[i].pos = x0 + i * line_spacing;
+// Sort the intersections of a single vertical line, specify the intersection types.
+static void sort_and_classify_intersections(const ExPolygonWithOffset &poly_with_offset, SegmentedIntersectionLine &sil)
+{
+    // Sort the intersection points using exact rational arithmetic.
+    std::sort(sil.intersections.begin(), sil.intersections.end());
+    // Assign the intersection types, remove duplicate or overlapping intersection points.
+    // When a loop vertex touches a vertical line, intersection point is generated for both segments.
+    // If such two segments are oriented equally, then one of them is removed.
+    // Otherwise the vertex is tangential to the vertical line and both segments are removed.
+    // The same rule applies, if the loop is pinched into a single point and this point touches the vertical line:
+    // The loop has a zero vertical size at the vertical line, therefore the intersection point is removed.
+    size_t j = 0;
+    for (size_t i = 0; i < sil.intersections.size(); ++ i) {
+        // What is the orientation of the segment at the intersection point?
+        SegmentIntersection       &is       = sil.intersections[i];
+        const size_t               iContour = is.iContour;
+        const Points              &contour  = poly_with_offset.contour(iContour).points;
+        const size_t               iSegment = is.iSegment;
+        const size_t               iPrev    = prev_idx_modulo(iSegment, contour);
+        const coord_t              dir      = contour[iSegment].x() - contour[iPrev].x();
+        const bool                 low      = dir > 0;
+        is.type = poly_with_offset.is_contour_outer(iContour) ?
+            (low ? SegmentIntersection::OUTER_LOW : SegmentIntersection::OUTER_HIGH) :
+            (low ? SegmentIntersection::INNER_LOW : SegmentIntersection::INNER_HIGH);
+        bool take_next = true;
+        if (j > 0) {
+            SegmentIntersection &is2 = sil.intersections[j - 1];
+            if (iContour == is2.iContour && is.pos_q == 1 && is2.pos_q == 1) {
+                // Two successive intersection points on a vertical line with the same contour, both points are end points of their respective contour segments.
+                if (is.pos_p == is2.pos_p) {
+                    // Two successive segments meet exactly at the vertical line.
+                    // Verify that the segments of sil.intersections[i] and sil.intersections[j-1] are adjoint.
+                    assert(iSegment == prev_idx_modulo(is2.iSegment, contour) || is2.iSegment == iPrev);
+                    assert(is.type == is2.type);
+                    // Two successive segments of the same direction (both to the right or both to the left)
+                    // meet exactly at the vertical line.
+                    // Remove the second intersection point.
+                    take_next = false;
+                } else if (is.type == is2.type) {
+                    // Two non successive segments of the same direction (both to the right or both to the left)
+                    // meet exactly at the vertical line. That means there is a Z shaped path, where the center segment
+                    // of the Z shaped path is aligned with this vertical line.
+                    // Remove one of the intersection points while maximizing the vertical segment length.
+                    if (low) {
+                        // Remove the second intersection point, keep the first intersection point.
+                    } else {
+                        // Remove the first intersection point, keep the second intersection point.
+                        sil.intersections[j-1] = sil.intersections[i];
+                    }
+                    take_next = false;
+                }
+            }
+        }
+        if (take_next) {
+            // Vertical line intersects a contour segment at a general position (not at one of its end points).
+            if (j < i)
+                sil.intersections[j] = sil.intersections[i];
+            ++ j;
+        }
     }
-    // For each contour
-    for (size_t iContour = 0; iContour < poly_with_offset.n_contours; ++ iContour) {
-        const Points &contour = poly_with_offset.contour(iContour).points;
-        if (contour.size() < 2)
-            continue;
-        // For each segment
-        for (size_t iSegment = 0; iSegment < contour.size(); ++ iSegment) {
-            size_t iPrev = ((iSegment == 0) ? contour.size() : iSegment) - 1;
-            const Point &p1 = contour[iPrev];
-            const Point &p2 = contour[iSegment];
-            // Which of the equally spaced vertical lines is intersected by this segment?
-            coord_t l = p1(0);
-            coord_t r = p2(0);
-            if (l > r)
-                std::swap(l, r);
-            // il, ir are the left / right indices of vertical lines intersecting a segment
-            int il = (l - x0) / line_spacing;
-            while (il * line_spacing + x0 < l)
-                ++ il;
-            il = std::max(int(0), il);
-            int ir = (r - x0 + line_spacing) / line_spacing;
-            while (ir * line_spacing + x0 > r)
-                -- ir;
-            ir = std::min(int(segs.size()) - 1, ir);
-            if (il > ir)
-                // No vertical line intersects this segment.
+    // Shrink the list of intersections, if any of the intersection was removed during the classification.
+    if (j < sil.intersections.size())
+        sil.intersections.erase(sil.intersections.begin() + j, sil.intersections.end());
+}
+
+// Contour segments intersecting at least one of the vertical lines, prepared for a sweep over the vertical lines.
+// The segments are numbered in the order of their contours and of their points, the intersection points
+// of a vertical line are produced in this order, thus the result of sorting them does not depend on the sweep.
+// The coefficients of the intersection calculation are stored as a structure of arrays, so that the intersections
+// of all the segments active at a vertical line are calculated by a branch free loop, which the compiler may vectorize.
+struct VerticalLineSweepSegments
+{
+    struct Segment {
+        // Segment from point iSegment - 1 to point iSegment of contour iContour.
+        uint32_t    iContour;
+        uint32_t    iSegment;
+        // Range of the intersected vertical lines, inclusive.
+        int32_t     vline_first;
+        int32_t     vline_last;
+        // Length of the segment projected to the x axis, denominator of the intersection position.
+        uint32_t    q;
+        // Bit 0: the first vertical line passes through the left end point, bit 1: the last vertical line passes through the right end point.
+        uint8_t     on_end_point;
+    };
+    std::vector<Segment>    segments;
+    // Intersection with a vertical line at x as a rational number: ((x - x1) * dy + y1q) / q,
+    // where dy is the y span of the segment oriented to the right.
+    std::vector<coord_t>    x1;
+    std::vector<int64_t>    dy;
+    std::vector<int64_t>    y1q;
+    // Segments sorted by their first vertical line, stable.
+    std::vector<uint32_t>   by_vline_first;
+    std::vector<uint32_t>   by_vline_first_offsets;
+    // Number of intersection points, including the ones at the segment end points, which may be filtered out.
+    size_t                  num_intersections { 0 };
+
+    size_t size() const { return segments.size(); }
+
+    VerticalLineSweepSegments(const ExPolygonWithOffset &poly_with_offset, size_t n_vlines, coord_t x0, coord_t line_spacing) {
+        // Index of the last vertical line left of x or passing through x.
+        // The division is replaced by a multiplication, the result is corrected to be exact.
+        const double inv_line_spacing = 1. / double(line_spacing);
+        auto vline_floor = [x0, line_spacing, inv_line_spacing](coord_t x) {
+            int64_t i = int64_t(double(x - x0) * inv_line_spacing);
+            if (x0 + i * line_spacing > x)
+                -- i;
+            else if (x0 + (i + 1) * line_spacing <= x)
+                ++ i;
+            return i;
+        };
+        size_t num_points = 0;
+        for (size_t iContour = 0; iContour < poly_with_offset.n_contours; ++ iContour)
+            num_points += poly_with_offset.contour(iContour).size();
+        segments.reserve(num_points);
+        x1.reserve(num_points);
+        dy.reserve(num_points);
+        y1q.reserve(num_points);
+        for (size_t iContour = 0; iContour < poly_with_offset.n_contours; ++ iContour) {
+            const Points &contour = poly_with_offset.contour(iContour).points;
+            if (contour.size() < 2)
                 continue;
-            assert(il >= 0 && size_t(il) < segs.size());
-            assert(ir >= 0 && size_t(ir) < segs.size());
-            for (int i = il; i <= ir; ++ i) {
-                coord_t this_x = segs[i].pos;
-				assert(this_x == i * line_spacing + x0);
-                SegmentIntersection is;
-                is.iContour = iContour;
-                is.iSegment = iSegment;
-                assert(l <= this_x);
-                assert(r >= this_x);
-                // Calculate the intersection position in y axis. x is known.
+            for (size_t iSegment = 0; iSegment < contour.size(); ++ iSegment) {
+                const Point &p1 = contour[(iSegment == 0 ? contour.size() : iSegment) - 1];
+                const Point &p2 = contour[iSegment];
+                if (p1.x() == p2.x())
+                    // Ignore strictly vertical segments.
+                    continue;
+                const bool    right = p2.x() > p1.x();
+                const coord_t l     = right ? p1.x() : p2.x();
+                const coord_t r     = right ? p2.x() : p1.x();
+                // Left / right indices of vertical lines intersecting the segment.
+                int64_t il = vline_floor(l);
+                int64_t ir = vline_floor(r);
+                if (x0 + il * line_spacing < l)
+                    ++ il;
+                il = std::max<int64_t>(0, il);
+                ir = std::min<int64_t>(int64_t(n_vlines) - 1, ir);
+                if (il > ir)
+                    // No vertical line intersects this segment.
+                    continue;
+                const uint32_t q = uint32_t(r - l);
+                segments.push_back({ uint32_t(iContour), uint32_t(iSegment), int32_t(il), int32_t(ir), q,
+                    uint8_t((x0 + il * line_spacing == l ? 1 : 0) | (x0 + ir * line_spacing == r ? 2 : 0)) });
+                x1.emplace_back(p1.x());
+                dy.emplace_back(right ? int64_t(p2.y() - p1.y()) : int64_t(p1.y() - p2.y()));
+                y1q.emplace_back(p1.y() * int64_t(q));
+                num_intersections += size_t(ir - il + 1);
+            }
+        }
+        // Bucket the segments by their first vertical line.
+        by_vline_first_offsets.assign(n_vlines + 1, 0);
+        for (const Segment &seg : segments)
+            ++ by_vline_first_offsets[seg.vline_first + 1];
+        for (size_t i = 1; i <= n_vlines; ++ i)
+            by_vline_first_offsets[i] += by_vline_first_offsets[i - 1];
+        by_vline_first.assign(segments.size(), 0);
+        std::vector<uint32_t> cursor(by_vline_first_offsets.begin(), by_vline_first_offsets.end() - 1);
+        for (uint32_t i = 0; i < uint32_t(segments.size()); ++ i)
+            by_vline_first[cursor[segments[i].vline_first] ++] = i;
+    }
+};
+
+// Sweep over the vertical lines of range [vline_begin, vline_end), maintain the set of segments intersecting
+// the current vertical line sorted by the segment index, calculate, sort and classify their intersections.
+static void slice_region_by_vertical_lines_sweep(
+    const ExPolygonWithOffset &poly_with_offset, const VerticalLineSweepSegments &sweep,
+    std::vector<SegmentedIntersectionLine> &segs, size_t vline_begin, size_t vline_end)
+{
+    std::vector<uint32_t> active;
+    std::vector<uint32_t> active_next;
+    std::vector<int64_t>  pos_p;
+    for (uint32_t i = 0; i < uint32_t(sweep.size()); ++ i)
+        if (size_t(sweep.segments[i].vline_first) < vline_begin && size_t(sweep.segments[i].vline_last) >= vline_begin)
+            active.emplace_back(i);
+
+    for (size_t i_vline = vline_begin; i_vline < vline_end; ++ i_vline) {
+        // Drop the segments ending left of this vertical line, merge in the segments starting at this vertical line.
+        const uint32_t *it_start  = sweep.by_vline_first.data() + sweep.by_vline_first_offsets[i_vline];
+        const uint32_t *end_start = sweep.by_vline_first.data() + sweep.by_vline_first_offsets[i_vline + 1];
+        active_next.clear();
+        for (uint32_t i : active)
+            if (size_t(sweep.segments[i].vline_last) >= i_vline) {
+                for (; it_start != end_start && *it_start < i; ++ it_start)
+                    active_next.emplace_back(*it_start);
+                active_next.emplace_back(i);
+            }
+        active_next.insert(active_next.end(), it_start, end_start);
+        active.swap(active_next);
+
+        // Calculate the intersection points of all the active segments in a batch.
+        SegmentedIntersectionLine &sil    = segs[i_vline];
+        const coord_t              this_x = sil.pos;
+        pos_p.resize(active.size());
+        {
+            const uint32_t *idx = active.data();
+            const coord_t  *x1  = sweep.x1.data();
+            const int64_t  *dy  = sweep.dy.data();
+            const int64_t  *y1q = sweep.y1q.data();
+            int64_t        *out = pos_p.data();
+            for (size_t i = 0; i < active.size(); ++ i)
+                out[i] = int64_t(this_x - x1[idx[i]]) * dy[idx[i]] + y1q[idx[i]];
+        }
+
+        sil.intersections.reserve(active.size());
+        for (size_t i = 0; i < active.size(); ++ i) {
+            const VerticalLineSweepSegments::Segment &seg = sweep.segments[active[i]];
+            SegmentIntersection is;
+            is.iContour = seg.iContour;
+            is.iSegment = seg.iSegment;
+            if (((seg.on_end_point & 1) && size_t(seg.vline_first) == i_vline) || ((seg.on_end_point & 2) && size_t(seg.vline_last) == i_vline)) {
+                // The vertical line passes through one of the end points of the segment.
+                const Points &contour = poly_with_offset.contour(is.iContour).points;
+                const size_t  iPrev   = prev_idx_modulo(is.iSegment, contour);
+                const Point  &p1      = contour[iPrev];
+                const Point  &p2      = contour[is.iSegment];
                 if (p1.x() == this_x) {
-                    if (p2.x() == this_x) {
-                        // Ignore strictly vertical segments.
-                        continue;
-                    }
                     const Point &p0 = prev_value_modulo(iPrev, contour);
-                    if (int64_t(p0.x() - p1.x()) * int64_t(p2.x() - p1.x()) > 0) {
+                    if (int64_t(p0.x() - p1.x()) * int64_t(p2.x() - p1.x()) > 0)
                         // Ignore points of a contour touching the infill line from one side.
                         continue;
-                    }
                     is.pos_p = p1.y();
-                    is.pos_q = 1;
-                } else if (p2.x() == this_x) {
-                    const Point &p3 = next_value_modulo(iSegment, contour);
-                    if (int64_t(p3.x() - p2.x()) * int64_t(p1.x() - p2.x()) > 0) {
+                } else {
+                    assert(p2.x() == this_x);
+                    const Point &p3 = next_value_modulo(is.iSegment, contour);
+                    if (int64_t(p3.x() - p2.x()) * int64_t(p1.x() - p2.x()) > 0)
                         // Ignore points of a contour touching the infill line from one side.
                         continue;
-                    }
                     is.pos_p = p2.y();
-                    is.pos_q = 1;
-                } else {
-                    // First calculate the intersection parameter 't' as a rational number with non negative denominator.
-                    if (p2.x() > p1.x()) {
-                        is.pos_p = this_x - p1.x();
-                        is.pos_q = p2.x() - p1.x();
-                    } else {
-                        is.pos_p = p1.x() - this_x;
-                        is.pos_q = p1.x() - p2.x();
-                    }
-                    assert(is.pos_q > 1);
-                    assert(is.pos_p > 0 && is.pos_p < is.pos_q);
-                    // Make an intersection point from the 't'.
-                    is.pos_p *= int64_t(p2.y() - p1.y());
-                    is.pos_p += p1.y() * int64_t(is.pos_q);
                 }
-                // +-1 to take rounding into account.
-                assert(is.pos() + 1 >= std::min(p1.y(), p2.y()));
-                assert(is.pos() <= std::max(p1.y(), p2.y()) + 1);
-                segs[i].intersections.push_back(is);
+                is.pos_q = 1;
+            } else {
+                is.pos_p = pos_p[i];
+                is.pos_q = seg.q;
+                assert(is.pos_q > 1);
             }
+            sil.intersections.emplace_back(is);
         }
+
+        sort_and_classify_intersections(poly_with_offset, sil);
     }
+}
 
-    // Sort the intersections along their segments, specify the intersection types.
-    for (size_t i_seg = 0; i_seg < segs.size(); ++ i_seg) {
-        SegmentedIntersectionLine &sil = segs[i_seg];
-        // Sort the intersection points using exact rational arithmetic.
-        std::sort(sil.intersections.begin(), sil.intersections.end());
-        // Assign the intersection types, remove duplicate or overlapping intersection points.
-        // When a loop vertex touches a vertical line, intersection point is generated for both segments.
-        // If such two segments are oriented equally, then one of them is removed.
-        // Otherwise the vertex is tangential to the vertical line and both segments are removed.
-        // The same rule applies, if the loop is pinched into a single point and this point touches the vertical line:
-        // The loop has a zero vertical size at the vertical line, therefore the intersection point is removed.
-        size_t j = 0;
-        for (size_t i = 0; i < sil.intersections.size(); ++ i) {
-            // What is the orientation of the segment at the intersection point?
-            SegmentIntersection       &is       = sil.intersections[i];
-            const size_t               iContour = is.iContour;
-            const Points              &contour  = poly_with_offset.contour(iContour).points;
-            const size_t               iSegment = is.iSegment;
-            const size_t               iPrev    = prev_idx_modulo(iSegment, contour);
-            const coord_t              dir      = contour[iSegment].x() - contour[iPrev].x();
-            const bool                 low      = dir > 0;
-            is.type = poly_with_offset.is_contour_outer(iContour) ?
-                (low ? SegmentIntersection::OUTER_LOW : SegmentIntersection::OUTER_HIGH) :
-                (low ? SegmentIntersection::INNER_LOW : SegmentIntersection::INNER_HIGH);
-            bool take_next = true;
-            if (j > 0) {
-                SegmentIntersection &is2 = sil.intersections[j - 1];
-                if (iContour == is2.iContour && is.pos_q == 1 && is2.pos_q == 1) {
-                    // Two successive intersection points on a vertical line with the same contour, both points are end points of their respective contour segments.
-                    if (is.pos_p == is2.pos_p) {
-                        // Two successive segments meet exactly at the vertical line.
-                        // Verify that the segments of sil.intersections[i] and sil.intersections[j-1] are adjoint.
-                        assert(iSegment == prev_idx_modulo(is2.iSegment, contour) || is2.iSegment == iPrev);
-                        assert(is.type == is2.type);
-                        // Two successive segments of the same direction (both to the right or both to the left)
-                        // meet exactly at the vertical line.
-                        // Remove the second intersection point.
-                        take_next = false;
-                    } else if (is.type == is2.type) {
-                        // Two non successive segments of the same direction (both to the right or both to the left)
-                        // meet exactly at the vertical line. That means there is a Z shaped path, where the center segment
-                        // of the Z shaped path is aligned with this vertical line.
-                        // Remove one of the intersection points while maximizing the vertical segment length.
-                        if (low) {
-                            // Remove the second intersection point, keep the first intersection point.
-                        } else {
-                            // Remove the first intersection point, keep the second intersection point.
-                            sil.intersections[j-1] = sil.intersections[i];
-                        }
-                        take_next = false;
-                    }
-                }
-            }
-            if (take_next) {
-                // Vertical line intersects a contour segment at a general position (not at one of its end points).
-                if (j < i)
-                    sil.intersections[j] = sil.intersections[i];
-                ++ j;
-            }
-        }
-        // Shrink the list of intersections, if any of the intersection was removed during the classification.
-        if (j < sil.intersections.size())
-            sil.intersections.erase(sil.intersections.begin() + j, sil.intersections.end());
+static std::vector<SegmentedIntersectionLine> slice_region_by_vertical_lines(const ExPolygonWithOffset &poly_with_offset, size_t n_vlines, coord_t x0, coord_t line_spacing)
+{
+    // Allocate storage for the segments.
+    std::vector<SegmentedIntersectionLine> segs(n_vlines, SegmentedIntersectionLine());
+    for (coord_t i = 0; i < coord_t(n_vlines); ++ i) {
+        segs[i].idx = i;
+        segs[i].pos = x0 + i * line_spacing;
     }
 
+    // Intersect the contours with the vertical lines by a sweep over the vertical lines.
+    // The vertical lines are independent, large regions (solid infill of wide top surfaces) are sliced in parallel,
+    // each task sweeping over a range of the vertical lines.
+    VerticalLineSweepSegments sweep(poly_with_offset, n_vlines, x0, line_spacing);
+    if (sweep.num_intersections < 8192 || n_vlines < 512)
+        slice_region_by_vertical_lines_sweep(poly_with_offset, sweep, segs, 0, n_vlines);
+    else
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, n_vlines, 256), [&poly_with_offset, &sweep, &segs](const tbb::blocked_range<size_t> &range) {
+            slice_region_by_vertical_lines_sweep(poly_with_offset, sweep, segs, range.begin(), range.end());
+        });
+
     // Verify the segments. If something is wrong, give up.
 #ifdef INFILL_DEBUG_OUTPUT
     #define INFILL_DEBUG_ASSERT(CONDITION)
@@ -3010,20 +3120,31 @@ bool FillRectilinear::fill_surface_by_multilines(const Surface *surface, FillPar
     coord_t line_width   = coord_t(scale_(this->spacing));
     coord_t line_spacing = coord_t(scale_(this->spacing) * params.multiline / params.density);
     std::pair<float, Point> rotate_vector = this->_infill_direction(surface);
-    for (const SweepParams &sweep : sweep_params) {
+    // The sweeps and the lines of a multi-line group are independent of each other.
+    // Large surfaces are swept in parallel, the lines are concatenated in the order of the sweeps.
+    const size_t           n_sweeps = sweep_params.size() * size_t(n_multilines);
+    std::vector<Polylines> sweep_lines(n_sweeps);
+    auto make_sweep = [this, &sweep_params, n_multilines, &poly_with_offset_base, &rotate_vector, line_width, line_spacing, &sweep_lines](size_t idx) {
+        const SweepParams &sweep = *(sweep_params.begin() + idx / n_multilines);
         // Rotate polygons so that we can work with vertical lines here
         float angle = rotate_vector.first + sweep.angle_base;
         //Fill Multiline
-        for (int i = 0; i < n_multilines; ++i) {
-            coord_t group_offset = i * line_spacing;
-            coord_t internal_offset = (i - (n_multilines - 1) / 2.0f) * line_width;
-            coord_t total_offset  = group_offset + internal_offset;
-            coord_t pattern_shift = scale_(sweep.pattern_shift + unscale_(total_offset));
-
-            make_fill_lines(ExPolygonWithOffset(poly_with_offset_base, -angle), rotate_vector.second.rotated(-angle), angle,
-                            line_width + coord_t(SCALED_EPSILON), line_spacing, pattern_shift, fill_lines);
-        }
-    }
+        int     i               = int(idx % n_multilines);
+        coord_t group_offset    = i * line_spacing;
+        coord_t internal_offset = (i - (n_multilines - 1) / 2.0f) * line_width;
+        coord_t total_offset    = group_offset + internal_offset;
+        coord_t pattern_shift   = scale_(sweep.pattern_shift + unscale_(total_offset));
+
+        make_fill_lines(ExPolygonWithOffset(poly_with_offset_base, -angle), rotate_vector.second.rotated(-angle), angle,
+                        line_width + coord_t(SCALED_EPSILON), line_spacing, pattern_shift, sweep_lines[idx]);
+    };
+    if (n_sweeps > 1 && n_sweeps * size_t(poly_with_offset_base.bounding_box_outer().size().cast<double>().norm() / line_spacing) >= 1024)
+        tbb::parallel_for(size_t(0), n_sweeps, make_sweep);
+    else
+        for (size_t idx = 0; idx < n_sweeps; ++ idx)
+            make_sweep(idx);
+    for (Polylines &lines : sweep_lines)
+        append(fill_lines, std::move(lines));
 
 if ((params.pattern == ip2DLattice || params.pattern == ip2DHoneycomb ) && params.multiline >1 )
     remove_overlapped(fill_lines, line_width);
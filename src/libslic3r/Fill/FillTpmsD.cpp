@@ -118,7 +118,7 @@ void FillTpmsD::_fill_surface_single(
     // align bounding box to a multiple of our grid module
     bb.merge(align_to_grid(bb.min, Point(2*M_PI*distance, 2*M_PI*distance)));
 
-    // generate pattern
+    // generate pattern in the coordinate system of the grid origin
     Polylines polylines = make_waves(
         scale_(this->z),
         density_adjusted,
@@ -126,14 +126,15 @@ void FillTpmsD::_fill_surface_single(
         ceil(bb.size()(0) / distance) + 1.,
         ceil(bb.size()(1) / distance) + 1.);
 
-	// shift the polyline to the grid origin
-	for (Polyline &pl : polylines)
-		pl.translate(bb.min);
-	
-	    // Apply multiline offset if needed
+    // Apply multiline offset if needed
     multiline_fill(polylines, params, spacing);
 
-	polylines = intersection_pl(polylines, expolygon);
+    // clip the pattern in the coordinate system of the grid origin, then shift the result back
+    ExPolygon expolygon_local = expolygon;
+    expolygon_local.translate(- bb.min);
+    polylines = clip_infill_polylines(polylines, expolygon_local);
+    for (Polyline &pl : polylines)
+        pl.translate(bb.min);
 
     if (! polylines.empty()) {
 		// Remove very small bits, but be careful to not remove infill lines connecting thin walls!
@@ -69,12 +69,25 @@ DistanceField::DistanceField(const coord_t& radius, const Polygons& current_outl
             }
         }); // end of parallel_for
     }
-    std::stable_sort(m_unsupported_points.begin(), m_unsupported_points.end(), [&radius](const UnsupportedCell &a, const UnsupportedCell &b) {
+    {
+        // Sort the cells with their hashes precalculated, the hash of a point is not cheap and the comparator is called O(n log n) times.
+        struct SortCell {
+            UnsupportedCell cell;
+            size_t          hash;
+        };
         constexpr coord_t prime_for_hash = 191;
-        return std::abs(b.dist_to_boundary - a.dist_to_boundary) > radius ?
-               a.dist_to_boundary < b.dist_to_boundary :
-               (PointHash{}(a.loc) % prime_for_hash) < (PointHash{}(b.loc) % prime_for_hash);
-        });
+        std::vector<SortCell> sort_cells;
+        sort_cells.reserve(m_unsupported_points.size());
+        for (const UnsupportedCell &cell : m_unsupported_points)
+            sort_cells.push_back({ cell, PointHash{}(cell.loc) % prime_for_hash });
+        std::stable_sort(sort_cells.begin(), sort_cells.end(), [&radius](const SortCell &a, const SortCell &b) {
+            return std::abs(b.cell.dist_to_boundary - a.cell.dist_to_boundary) > radius ?
+                   a.cell.dist_to_boundary < b.cell.dist_to_boundary :
+                   a.hash < b.hash;
+            });
+        for (size_t i = 0; i < sort_cells.size(); ++ i)
+            m_unsupported_points[i] = sort_cells[i].cell;
+    }
 
     m_unsupported_points_erased.resize(m_unsupported_points.size());
     std::fill(m_unsupported_points_erased.begin(), m_unsupported_points_erased.end(), false);
@@ -101,13 +114,10 @@ void DistanceField::update(const Point& to_node, const Point& added_leaf)
 
     BoundingBox grid;
     {
+        // Only the cells at most m_supporting_radius from the new leaf are removed below, thus only the cells
+        // around the new leaf are visited, not the cells around the whole new branch, which may be long.
         Point diagonal(m_supporting_radius, m_supporting_radius);
-        Point iextent(extent.cast<coord_t>());
         grid = BoundingBox(added_leaf - diagonal, added_leaf + diagonal);
-        grid.merge(to_node - iextent);
-        grid.merge(to_node + iextent);
-        grid.merge(added_leaf - iextent);
-        grid.merge(added_leaf + iextent);
 
         // Clip grid by m_unsupported_points_bbox. Mainly to ensure that grid.min is a non-negative value.
         grid.min.x() = std::max(grid.min.x(), m_unsupported_points_bbox.min.x());
@@ -63,6 +63,14 @@ public:
 
     Generator(PrintObject* m_object, std::vector<Polygons>& contours, std::vector<Polygons>& overhangs, const std::function<void()> &throw_on_cancel_callback, float density = 0.15);
 
+    /*!
+     * Create a generator for the given infill areas and overhangs of the layers,
+     * ordered from the bottom layer up, without a print object. The parameters
+     * are derived from the infill line width, layer height and density the same
+     * way as for the support.
+     */
+    Generator(const std::vector<Polygons>& contours, std::vector<Polygons> overhangs, coord_t infill_extrusion_width, coord_t layer_thickness, float density, const std::function<void()> &throw_on_cancel_callback);
+
 protected:
     /*!
      * Calculate the overhangs above the infill areas that need to be supported
@@ -78,7 +86,7 @@ protected:
      * Calculate the tree structure of all layers.
      */
     void generateTrees(const PrintObject &print_object, const std::function<void()> &throw_on_cancel_callback);
-    void generateTreesforSupport(std::vector<Polygons>& contours, const std::function<void()> &throw_on_cancel_callback);
+    void generateTreesforSupport(const std::vector<Polygons>& contours, const std::function<void()> &throw_on_cancel_callback);
 
     float m_infill_extrusion_width;
 
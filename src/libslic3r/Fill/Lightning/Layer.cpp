@@ -11,8 +11,6 @@
 #include "Utils.hpp"
 
 #include <tbb/parallel_for.h>
-#include <tbb/blocked_range2d.h>
-#include <mutex>
 
 namespace Slic3r::FillLightning {
 
@@ -21,10 +19,10 @@ coord_t Layer::getWeightedDistance(const Point& boundary_loc, const Point& unsup
     return coord_t((boundary_loc - unsupported_location).cast<double>().norm());
 }
 
-Point GroundingLocation::p() const
+Point GroundingLocation::p(const NodePool &nodes) const
 {
-    assert(tree_node || boundary_location);
-    return tree_node ? tree_node->getLocation() : *boundary_location;
+    assert(tree_node != NoNode || boundary_location);
+    return tree_node != NoNode ? nodes.getLocation(tree_node) : *boundary_location;
 }
 
 inline static Point to_grid_point(const Point &point, const BoundingBox &bbox)
@@ -34,11 +32,11 @@ inline static Point to_grid_point(const Point &point, const BoundingBox &bbox)
 
 void Layer::fillLocator(SparseNodeGrid &tree_node_locator, const BoundingBox& current_outlines_bbox)
 {
-    std::function<void(NodeSPtr)> add_node_to_locator_func = [&tree_node_locator, &current_outlines_bbox](const NodeSPtr &node) {
-        tree_node_locator.insert(std::make_pair(to_grid_point(node->getLocation(), current_outlines_bbox), node));
+    std::function<void(NodeIdx)> add_node_to_locator_func = [this, &tree_node_locator, &current_outlines_bbox](NodeIdx node) {
+        tree_node_locator.insert(std::make_pair(to_grid_point(nodes.getLocation(node), current_outlines_bbox), node));
     };
-    for (auto& tree : tree_roots)
-        tree->visitNodes(add_node_to_locator_func);
+    for (NodeIdx tree : tree_roots)
+        nodes.visitNodes(tree, add_node_to_locator_func);
 }
 
 void Layer::generateNewTrees
@@ -67,20 +65,20 @@ void Layer::generateNewTrees
         GroundingLocation grounding_loc = getBestGroundingLocation(
             unsupported_location, current_outlines, current_outlines_bbox, outlines_locator, supporting_radius, wall_supporting_radius, tree_node_locator);
 
-        NodeSPtr new_parent;
-        NodeSPtr new_child;
+        NodeIdx new_parent = NoNode;
+        NodeIdx new_child  = NoNode;
         this->attach(unsupported_location, grounding_loc, new_child, new_parent);
-        tree_node_locator.insert(std::make_pair(to_grid_point(new_child->getLocation(), current_outlines_bbox), new_child));
-        if (new_parent)
-            tree_node_locator.insert(std::make_pair(to_grid_point(new_parent->getLocation(), current_outlines_bbox), new_parent));
+        tree_node_locator.insert(std::make_pair(to_grid_point(nodes.getLocation(new_child), current_outlines_bbox), new_child));
+        if (new_parent != NoNode)
+            tree_node_locator.insert(std::make_pair(to_grid_point(nodes.getLocation(new_parent), current_outlines_bbox), new_parent));
         // update distance field
-        distance_field.update(grounding_loc.p(), unsupported_location);
+        distance_field.update(grounding_loc.p(nodes), unsupported_location);
     }
 
 #ifdef LIGHTNING_TREE_NODE_DEBUG_OUTPUT
     {
         static int iRun = 0;
-        export_to_svg(debug_out_path("FillLightning-TreeNodes-%d.svg", iRun++), current_outlines, this->tree_roots);
+        export_to_svg(debug_out_path("FillLightning-TreeNodes-%d.svg", iRun++), current_outlines, this->nodes, this->tree_roots);
     }
 #endif /* LIGHTNING_TREE_NODE_DEBUG_OUTPUT */
 }
@@ -123,7 +121,7 @@ GroundingLocation Layer::getBestGroundingLocation
     const coord_t supporting_radius,
     const coord_t wall_supporting_radius,
     const SparseNodeGrid& tree_node_locator,
-    const NodeSPtr& exclude_tree
+    NodeIdx exclude_tree
 )
 {
     // Closest point on current_outlines to unsupported_location:
@@ -146,7 +144,7 @@ GroundingLocation Layer::getBestGroundingLocation
 
     const auto within_dist = coord_t((node_location - unsupported_location).cast<double>().norm());
 
-    NodeSPtr sub_tree{nullptr};
+    NodeIdx  sub_tree = NoNode;
     coord_t  current_dist = getWeightedDistance(node_location, unsupported_location);
     if (current_dist >= wall_supporting_radius) { // Only reconnect tree roots to other trees if they are not already close to the outlines.
         const coord_t search_radius = std::min(current_dist, within_dist);
@@ -154,72 +152,84 @@ GroundingLocation Layer::getBestGroundingLocation
         region.min = to_grid_point(region.min, current_outlines_bbox);
         region.max = to_grid_point(region.max, current_outlines_bbox);
 
-        Point      current_dist_grid_addr{std::numeric_limits<coord_t>::lowest(), std::numeric_limits<coord_t>::lowest()};
-        std::mutex current_dist_mutex;
-        tbb::parallel_for(tbb::blocked_range2d<coord_t>(region.min.y(), region.max.y(), region.min.x(), region.max.x()), [&current_dist, current_dist_copy = current_dist, &current_dist_mutex, &sub_tree, &current_dist_grid_addr, &exclude_tree = std::as_const(exclude_tree), &outline_locator = std::as_const(outline_locator), &supporting_radius = std::as_const(supporting_radius), &tree_node_locator = std::as_const(tree_node_locator), &unsupported_location = std::as_const(unsupported_location)](const tbb::blocked_range2d<coord_t> &range) -> void {
-            for (coord_t grid_addr_y = range.rows().begin(); grid_addr_y < range.rows().end(); ++grid_addr_y)
-                for (coord_t grid_addr_x = range.cols().begin(); grid_addr_x < range.cols().end(); ++grid_addr_x) {
-                    const Point local_grid_addr{grid_addr_x, grid_addr_y};
-                    NodeSPtr    local_sub_tree{nullptr};
-                    coord_t     local_current_dist = current_dist_copy;
-                    const auto  it_range           = tree_node_locator.equal_range(local_grid_addr);
-                    for (auto it = it_range.first; it != it_range.second; ++it) {
-                        const NodeSPtr candidate_sub_tree = it->second.lock();
-                        if ((candidate_sub_tree && candidate_sub_tree != exclude_tree) &&
-                            !(exclude_tree && exclude_tree->hasOffspring(candidate_sub_tree)) &&
-                            !polygonCollidesWithLineSegment(unsupported_location, candidate_sub_tree->getLocation(), outline_locator)) {
-                            if (const coord_t candidate_dist = candidate_sub_tree->getWeightedDistance(unsupported_location, supporting_radius); candidate_dist < local_current_dist) {
-                                local_current_dist = candidate_dist;
-                                local_sub_tree     = candidate_sub_tree;
-                            }
-                        }
-                    }
-                    // To always get the same result in a parallel version as in a non-parallel version,
-                    // we need to preserve that for the same current_dist, we select the same sub_tree
-                    // as in the non-parallel version. For this purpose, inside the variable
-                    // current_dist_grid_addr is stored from with 2D grid position assigned sub_tree comes.
-                    // And when there are two sub_tree with the same current_dist, one which will be found
-                    // the first in the non-parallel version is selected.
-                    {
-                        std::lock_guard<std::mutex> lock(current_dist_mutex);
-                        if (local_current_dist < current_dist ||
-                            (local_current_dist == current_dist && (grid_addr_y < current_dist_grid_addr.y() ||
-                              (grid_addr_y == current_dist_grid_addr.y() && grid_addr_x < current_dist_grid_addr.x())))) {
-                            current_dist           = local_current_dist;
-                            sub_tree               = local_sub_tree;
-                            current_dist_grid_addr = local_grid_addr;
-                        }
-                    }
+        // Visit the cells of the region in rings around the cell of the unsupported location, from the closest ring outwards,
+        // until the nodes of the next ring are too far to be selected. The selected node is the one with the lowest weighted
+        // distance, the one in the lowest cell (by row, then by column) and first in the locator among those of the same weighted
+        // distance, the same as if all the cells of the region were searched.
+        const Point   center_grid_addr = to_grid_point(unsupported_location, current_outlines_bbox);
+        // getWeightedDistance() subtracts up to this valence boost from the distance.
+        const coord_t max_valence_boost = 4 * supporting_radius;
+        Point         current_dist_grid_addr;
+        auto          visit_cell = [&](const Point &grid_addr) {
+            const auto it_range = tree_node_locator.equal_range(grid_addr);
+            for (auto it = it_range.first; it != it_range.second; ++ it) {
+                const NodeIdx candidate_sub_tree = it->second;
+                if (candidate_sub_tree == exclude_tree)
+                    continue;
+                const coord_t candidate_dist = nodes.getWeightedDistance(candidate_sub_tree, unsupported_location, supporting_radius);
+                if (candidate_dist > current_dist ||
+                    (candidate_dist == current_dist && (sub_tree == NoNode || grid_addr.y() > current_dist_grid_addr.y() ||
+                        (grid_addr.y() == current_dist_grid_addr.y() && grid_addr.x() >= current_dist_grid_addr.x()))))
+                    continue;
+                if ((exclude_tree != NoNode && nodes.hasOffspring(exclude_tree, candidate_sub_tree)) ||
+                    polygonCollidesWithLineSegment(unsupported_location, nodes.getLocation(candidate_sub_tree), outline_locator))
+                    continue;
+                current_dist           = candidate_dist;
+                sub_tree               = candidate_sub_tree;
+                current_dist_grid_addr = grid_addr;
+            }
+        };
+        for (coord_t ring = 0;; ++ ring) {
+            // Grid addresses are rounded towards zero, thus the cell at zero address may be twice as wide as the others.
+            if (ring > 2 && double(ring - 2) * double(locator_cell_size()) - 1. - double(max_valence_boost) > double(current_dist))
+                break;
+            const BoundingBox ring_box(center_grid_addr - Point(ring, ring), center_grid_addr + Point(ring, ring));
+            const coord_t     y_min = std::max(ring_box.min.y(), region.min.y());
+            const coord_t     y_max = std::min(ring_box.max.y(), region.max.y() - 1);
+            const coord_t     x_min = std::max(ring_box.min.x(), region.min.x());
+            const coord_t     x_max = std::min(ring_box.max.x(), region.max.x() - 1);
+            for (coord_t grid_addr_y = y_min; grid_addr_y <= y_max; ++ grid_addr_y)
+                if (grid_addr_y == ring_box.min.y() || grid_addr_y == ring_box.max.y()) {
+                    for (coord_t grid_addr_x = x_min; grid_addr_x <= x_max; ++ grid_addr_x)
+                        visit_cell({ grid_addr_x, grid_addr_y });
+                } else {
+                    if (ring_box.min.x() >= x_min && ring_box.min.x() <= x_max)
+                        visit_cell({ ring_box.min.x(), grid_addr_y });
+                    if (ring_box.max.x() >= x_min && ring_box.max.x() <= x_max)
+                        visit_cell({ ring_box.max.x(), grid_addr_y });
                 }
-        }); // end of parallel_for
+            if (ring_box.min.x() <= region.min.x() && ring_box.min.y() <= region.min.y() && ring_box.max.x() >= region.max.x() - 1 && ring_box.max.y() >= region.max.y() - 1)
+                // The whole region has been searched.
+                break;
+        }
     }
 
-    return ! sub_tree ?
-        GroundingLocation{ nullptr, node_location } :
+    return sub_tree == NoNode ?
+        GroundingLocation{ NoNode, node_location } :
         GroundingLocation{ sub_tree, std::optional<Point>() };
 }
 
 bool Layer::attach(
     const Point& unsupported_location,
     const GroundingLocation& grounding_loc,
-    NodeSPtr& new_child,
-    NodeSPtr& new_root)
+    NodeIdx& new_child,
+    NodeIdx& new_root)
 {
     // Update trees & distance fields.
     if (grounding_loc.boundary_location) {
-        new_root = Node::create(grounding_loc.p(), std::make_optional(grounding_loc.p()));
-        new_child = new_root->addChild(unsupported_location);
+        new_root = nodes.create(grounding_loc.p(nodes), std::make_optional(grounding_loc.p(nodes)));
+        new_child = nodes.addChild(new_root, unsupported_location);
         tree_roots.push_back(new_root);
         return true;
     } else {
-        new_child = grounding_loc.tree_node->addChild(unsupported_location);
+        new_child = nodes.addChild(grounding_loc.tree_node, unsupported_location);
         return false;
     }
 }
 
 void Layer::reconnectRoots
 (
-    std::vector<NodeSPtr>& to_be_reconnected_tree_roots,
+    std::vector<NodeIdx>& to_be_reconnected_tree_roots,
     const Polygons& current_outlines,
     const BoundingBox& current_outlines_bbox,
     const EdgeGrid::Grid& outline_locator,
@@ -233,25 +243,25 @@ void Layer::reconnectRoots
     fillLocator(tree_node_locator, current_outlines_bbox);
 
     const coord_t within_max_dist = outline_locator.resolution() * 2;
-    for (const auto &root_ptr : to_be_reconnected_tree_roots)
+    for (const NodeIdx root_ptr : to_be_reconnected_tree_roots)
     {
         auto old_root_it = std::find(tree_roots.begin(), tree_roots.end(), root_ptr);
 
-        if (root_ptr->getLastGroundingLocation())
+        if (nodes.getLastGroundingLocation(root_ptr))
         {
-            const Point& ground_loc = *root_ptr->getLastGroundingLocation();
-            if (ground_loc != root_ptr->getLocation())
+            const Point ground_loc = *nodes.getLastGroundingLocation(root_ptr);
+            if (ground_loc != nodes.getLocation(root_ptr))
             {
                 Point new_root_pt;
                 // Find an intersection of the line segment from root_ptr->getLocation() to ground_loc, at within_max_dist from ground_loc.
-                if (lineSegmentPolygonsIntersection(root_ptr->getLocation(), ground_loc, outline_locator, new_root_pt, within_max_dist)) {
-                    auto new_root = Node::create(new_root_pt, new_root_pt);
-                    root_ptr->addChild(new_root);
-                    new_root->reroot();
+                if (lineSegmentPolygonsIntersection(nodes.getLocation(root_ptr), ground_loc, outline_locator, new_root_pt, within_max_dist)) {
+                    NodeIdx new_root = nodes.create(new_root_pt, new_root_pt);
+                    nodes.addChild(root_ptr, new_root);
+                    nodes.reroot(new_root);
 
-                    tree_node_locator.insert(std::make_pair(to_grid_point(new_root->getLocation(), current_outlines_bbox), new_root));
+                    tree_node_locator.insert(std::make_pair(to_grid_point(nodes.getLocation(new_root), current_outlines_bbox), new_root));
 
-                    *old_root_it = std::move(new_root); // replace old root with new root
+                    *old_root_it = new_root; // replace old root with new root
                     continue;
                 }
             }
@@ -261,7 +271,7 @@ void Layer::reconnectRoots
         GroundingLocation ground =
             getBestGroundingLocation
             (
-                root_ptr->getLocation(),
+                nodes.getLocation(root_ptr),
                 current_outlines,
                 current_outlines_bbox,
                 outline_locator,
@@ -272,32 +282,32 @@ void Layer::reconnectRoots
             );
         if (ground.boundary_location)
         {
-            if (*ground.boundary_location == root_ptr->getLocation())
+            if (*ground.boundary_location == nodes.getLocation(root_ptr))
                 continue; // Already on the boundary.
 
-            auto new_root = Node::create(ground.p(), ground.p());
-            auto attach_ptr = root_ptr->closestNode(new_root->getLocation());
-            attach_ptr->reroot();
+            NodeIdx new_root   = nodes.create(ground.p(nodes), ground.p(nodes));
+            NodeIdx attach_ptr = nodes.closestNode(root_ptr, nodes.getLocation(new_root));
+            nodes.reroot(attach_ptr);
 
-            new_root->addChild(attach_ptr);
-            tree_node_locator.insert(std::make_pair(to_grid_point(new_root->getLocation(), current_outlines_bbox), new_root));
+            nodes.addChild(new_root, attach_ptr);
+            tree_node_locator.insert(std::make_pair(to_grid_point(nodes.getLocation(new_root), current_outlines_bbox), new_root));
 
-            *old_root_it = std::move(new_root); // replace old root with new root
+            *old_root_it = new_root; // replace old root with new root
         }
         else
         {
-            assert(ground.tree_node);
+            assert(ground.tree_node != NoNode);
             assert(ground.tree_node != root_ptr);
-            assert(!root_ptr->hasOffspring(ground.tree_node));
-            assert(!ground.tree_node->hasOffspring(root_ptr));
+            assert(!nodes.hasOffspring(root_ptr, ground.tree_node));
+            assert(!nodes.hasOffspring(ground.tree_node, root_ptr));
 
-            auto attach_ptr = root_ptr->closestNode(ground.tree_node->getLocation());
-            attach_ptr->reroot();
+            NodeIdx attach_ptr = nodes.closestNode(root_ptr, nodes.getLocation(ground.tree_node));
+            nodes.reroot(attach_ptr);
 
-            ground.tree_node->addChild(attach_ptr);
+            nodes.addChild(ground.tree_node, attach_ptr);
 
             // remove old root
-            *old_root_it = std::move(tree_roots.back());
+            *old_root_it = tree_roots.back();
             tree_roots.pop_back();
         }
     }
@@ -433,14 +443,47 @@ static unsigned int moveInside(const Polygons& polygons, Point& from, int distan
 }
 #endif
 
+void Layer::propagateToNextLayer
+(
+    Layer& below,
+    const Polygons& next_outlines,
+    const EdgeGrid::Grid& outline_locator,
+    const coord_t prune_distance,
+    const coord_t smooth_magnitude,
+    const coord_t max_remove_colinear_dist
+) const
+{
+    struct Propagated {
+        NodePool             nodes;
+        std::vector<NodeIdx> tree_roots;
+    };
+    std::vector<Propagated> propagated(tree_roots.size());
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, tree_roots.size()), [&](const tbb::blocked_range<size_t> &range) {
+        for (size_t tree_idx = range.begin(); tree_idx < range.end(); ++ tree_idx) {
+            Propagated &out = propagated[tree_idx];
+            nodes.propagateToNextLayer(tree_roots[tree_idx], out.nodes, out.tree_roots, next_outlines, outline_locator, prune_distance, smooth_magnitude, max_remove_colinear_dist);
+        }
+    });
+
+    size_t num_nodes = below.nodes.size();
+    for (const Propagated &out : propagated)
+        num_nodes += out.nodes.size();
+    below.nodes.reserve(num_nodes);
+    for (Propagated &out : propagated) {
+        NodeIdx offset = below.nodes.append(std::move(out.nodes));
+        for (NodeIdx root : out.tree_roots)
+            below.tree_roots.push_back(root + offset);
+    }
+}
+
 Polylines Layer::convertToLines(const Polygons& limit_to_outline, const coord_t line_overlap) const
 {
     if (tree_roots.empty())
         return {};
 
     Polylines result_lines;
-    for (const auto &tree : tree_roots)
-        tree->convertToPolylines(result_lines, line_overlap);
+    for (NodeIdx tree : tree_roots)
+        nodes.convertToPolylines(tree, result_lines, line_overlap);
 
     return intersection_pl(result_lines, limit_to_outline);
 }
@@ -6,6 +6,7 @@
 
 #include "../../EdgeGrid.hpp"
 #include "../../Polygon.hpp"
+#include "TreeNode.hpp"
 
 #include <memory>
 #include <vector>
@@ -16,15 +17,13 @@
 namespace Slic3r::FillLightning
 {
 
-class Node;
-using NodeSPtr = std::shared_ptr<Node>;
-using SparseNodeGrid = std::unordered_multimap<Point, std::weak_ptr<Node>, PointHash>;
+using SparseNodeGrid = std::unordered_multimap<Point, NodeIdx, PointHash>;
 
 struct GroundingLocation
 {
-    NodeSPtr tree_node; //!< not null if the gounding location is on a tree
+    NodeIdx tree_node; //!< not NoNode if the gounding location is on a tree
     std::optional<Point> boundary_location; //!< in case the gounding location is on the boundary
-    Point p() const;
+    Point p(const NodePool &nodes) const;
 };
 
 /*!
@@ -35,7 +34,9 @@ struct GroundingLocation
 class Layer
 {
 public:
-    std::vector<NodeSPtr> tree_roots;
+    // Nodes of all the trees of this layer.
+    NodePool             nodes;
+    std::vector<NodeIdx> tree_roots;
 
     void generateNewTrees
     (
@@ -60,7 +61,7 @@ public:
         coord_t supporting_radius,
         coord_t wall_supporting_radius,
         const SparseNodeGrid& tree_node_locator,
-        const NodeSPtr& exclude_tree = nullptr
+        NodeIdx exclude_tree = NoNode
     );
 
     /*!
@@ -68,11 +69,11 @@ public:
      * \param[out] new_root The new root node if one had been made
      * \return Whether a new root was added
      */
-    bool attach(const Point& unsupported_location, const GroundingLocation& ground, NodeSPtr& new_child, NodeSPtr& new_root);
+    bool attach(const Point& unsupported_location, const GroundingLocation& ground, NodeIdx& new_child, NodeIdx& new_root);
 
     void reconnectRoots
     (
-        std::vector<NodeSPtr>& to_be_reconnected_tree_roots,
+        std::vector<NodeIdx>& to_be_reconnected_tree_roots,
         const Polygons& current_outlines,
         const BoundingBox& current_outlines_bbox,
         const EdgeGrid::Grid& outline_locator,
@@ -80,6 +81,22 @@ public:
         coord_t wall_supporting_radius
     );
 
+    /*!
+     * Initialize the trees of the next lower layer from the trees of this layer,
+     * see NodePool::propagateToNextLayer(). The trees are propagated in parallel,
+     * each into its own pool, the pools are then merged into \p below in the order
+     * of the trees of this layer, thus the result does not depend on the scheduling.
+     */
+    void propagateToNextLayer
+    (
+        Layer& below,
+        const Polygons& next_outlines,
+        const EdgeGrid::Grid& outline_locator,
+        coord_t prune_distance,
+        coord_t smooth_magnitude,
+        coord_t max_remove_colinear_dist
+    ) const;
+
     Polylines convertToLines(const Polygons& limit_to_outline, coord_t line_overlap) const;
 
     coord_t getWeightedDistance(const Point& boundary_loc, const Point& unsupported_location);
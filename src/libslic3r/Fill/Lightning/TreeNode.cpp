@@ -7,131 +7,158 @@
 
 namespace Slic3r::FillLightning {
 
-coord_t Node::getWeightedDistance(const Point& unsupported_location, const coord_t& supporting_radius) const
+coord_t NodePool::getWeightedDistance(NodeIdx node, const Point& unsupported_location, const coord_t& supporting_radius) const
 {
     constexpr coord_t min_valence_for_boost = 0;
     constexpr coord_t max_valence_for_boost = 4;
     constexpr coord_t valence_boost_multiplier = 4;
 
-    const size_t valence = (!m_is_root) + m_children.size();
+    const Node   &n             = (*this)[node];
+    const size_t valence = (!n.is_root) + n.children.size();
     const coord_t valence_boost = (min_valence_for_boost < valence && valence < max_valence_for_boost) ? valence_boost_multiplier * supporting_radius : 0;
-    const auto dist_here = coord_t((getLocation() - unsupported_location).cast<double>().norm());
+    const auto dist_here = coord_t((n.p - unsupported_location).cast<double>().norm());
     return dist_here - valence_boost;
 }
 
-bool Node::hasOffspring(const NodeSPtr& to_be_checked) const
+bool NodePool::hasOffspring(NodeIdx node, NodeIdx to_be_checked) const
 {
-    if (to_be_checked == shared_from_this())
-        return true;
-
-    for (auto& child_ptr : m_children)
-        if (child_ptr->hasOffspring(to_be_checked)) 
+    // The parent links of the nodes in a tree are kept consistent with the child links,
+    // thus instead of searching the sub-tree of node, walk from to_be_checked towards its root.
+    for (NodeIdx idx = to_be_checked;; idx = (*this)[idx].parent) {
+        if (idx == node)
             return true;
+        if ((*this)[idx].is_root || (*this)[idx].parent == NoNode)
+            return false;
+    }
+}
 
-    return false;
+NodeIdx NodePool::create(const Point& p, const std::optional<Point>& last_grounding_location /*= std::nullopt*/)
+{
+    m_nodes.emplace_back(p, last_grounding_location);
+    return NodeIdx(m_nodes.size() - 1);
 }
 
-NodeSPtr Node::addChild(const Point& child_loc)
+NodeIdx NodePool::append(NodePool &&other)
 {
-    assert(m_p != child_loc);
-    NodeSPtr child = Node::create(child_loc);
-    return addChild(child);
+    const auto offset = NodeIdx(m_nodes.size());
+    if (m_nodes.empty()) {
+        m_nodes = std::move(other.m_nodes);
+    } else {
+        m_nodes.reserve(m_nodes.size() + other.m_nodes.size());
+        for (Node &node : other.m_nodes) {
+            if (node.parent != NoNode)
+                node.parent += offset;
+            for (NodeIdx &child : node.children)
+                child += offset;
+            m_nodes.emplace_back(std::move(node));
+        }
+    }
+    other.m_nodes.clear();
+    return offset;
+}
+
+NodeIdx NodePool::addChild(NodeIdx parent, const Point& child_loc)
+{
+    assert((*this)[parent].p != child_loc);
+    NodeIdx child = this->create(child_loc);
+    return this->addChild(parent, child);
 }
 
-NodeSPtr Node::addChild(NodeSPtr& new_child)
+NodeIdx NodePool::addChild(NodeIdx parent, NodeIdx new_child)
 {
-    assert(new_child != shared_from_this());
+    assert(new_child != parent);
     //assert(p != new_child->p); // NOTE: No problem for now. Issue to solve later. Maybe even afetr final. Low prio.
-    m_children.push_back(new_child);
-    new_child->m_parent = shared_from_this();
-    new_child->m_is_root = false;
+    (*this)[parent].children.push_back(new_child);
+    Node &child = (*this)[new_child];
+    child.parent  = parent;
+    child.is_root = false;
     return new_child;
 }
 
-void Node::propagateToNextLayer(
-    std::vector<NodeSPtr>& next_trees,
+void NodePool::propagateToNextLayer(
+    NodeIdx root,
+    NodePool& next_nodes,
+    std::vector<NodeIdx>& next_trees,
     const Polygons& next_outlines,
     const EdgeGrid::Grid& outline_locator,
     const coord_t prune_distance,
     const coord_t smooth_magnitude,
     const coord_t max_remove_colinear_dist) const
 {
-    auto tree_below = deepCopy();
-    tree_below->prune(prune_distance);
-    tree_below->straighten(smooth_magnitude, max_remove_colinear_dist);
-    if (tree_below->realign(next_outlines, outline_locator, next_trees))
+    NodeIdx tree_below = this->deepCopy(root, next_nodes);
+    next_nodes.prune(tree_below, prune_distance);
+    next_nodes.straighten(tree_below, smooth_magnitude, max_remove_colinear_dist);
+    if (next_nodes.realign(tree_below, next_outlines, outline_locator, next_trees))
         next_trees.push_back(tree_below);
 }
 
 // NOTE: Depth-first, as currently implemented.
 //       Skips the root (because that has no root itself), but all initial nodes will have the root point anyway.
-void Node::visitBranches(const std::function<void(const Point&, const Point&)>& visitor) const
+void NodePool::visitBranches(NodeIdx node, const std::function<void(const Point&, const Point&)>& visitor) const
 {
-    for (const auto& node : m_children) {
-        assert(node->m_parent.lock() == shared_from_this());
-        visitor(m_p, node->m_p);
-        node->visitBranches(visitor);
+    for (NodeIdx child : (*this)[node].children) {
+        assert((*this)[child].parent == node);
+        visitor((*this)[node].p, (*this)[child].p);
+        this->visitBranches(child, visitor);
     }
 }
 
 // NOTE: Depth-first, as currently implemented.
-void Node::visitNodes(const std::function<void(NodeSPtr)>& visitor)
+void NodePool::visitNodes(NodeIdx node, const std::function<void(NodeIdx)>& visitor) const
 {
-    visitor(shared_from_this());
-    for (const auto& node : m_children) {
-        assert(node->m_parent.lock() == shared_from_this());
-        node->visitNodes(visitor);
+    visitor(node);
+    for (NodeIdx child : (*this)[node].children) {
+        assert((*this)[child].parent == node);
+        this->visitNodes(child, visitor);
     }
 }
 
-Node::Node(const Point& p, const std::optional<Point>& last_grounding_location /*= std::nullopt*/) : 
-    m_is_root(true), m_p(p), m_last_grounding_location(last_grounding_location)
-{}
-
-NodeSPtr Node::deepCopy() const
+NodeIdx NodePool::deepCopy(NodeIdx node, NodePool& dst) const
 {
-    NodeSPtr local_root = Node::create(m_p);
-    local_root->m_is_root = m_is_root;
-    if (m_is_root)
+    const Node &src        = (*this)[node];
+    NodeIdx     local_root = dst.create(src.p);
+    dst[local_root].is_root = src.is_root;
+    if (src.is_root)
     {
-        local_root->m_last_grounding_location = m_last_grounding_location.value_or(m_p);
+        dst[local_root].last_grounding_location = src.last_grounding_location.value_or(src.p);
     }
-    local_root->m_children.reserve(m_children.size());
-    for (const auto& node : m_children)
+    dst[local_root].children.reserve(src.children.size());
+    for (NodeIdx child_src : src.children)
     {
-        NodeSPtr child = node->deepCopy();
-        child->m_parent = local_root;
-        local_root->m_children.push_back(child);
+        NodeIdx child = this->deepCopy(child_src, dst);
+        dst[child].parent = local_root;
+        dst[local_root].children.push_back(child);
     }
     return local_root;
 }
 
-void Node::reroot(const NodeSPtr &new_parent)
+void NodePool::reroot(NodeIdx node, NodeIdx new_parent)
 {
-    if (! m_is_root) {
-        auto old_parent = m_parent.lock();
-        old_parent->reroot(shared_from_this());
-        m_children.push_back(old_parent);
+    if (! (*this)[node].is_root) {
+        NodeIdx old_parent = (*this)[node].parent;
+        this->reroot(old_parent, node);
+        (*this)[node].children.push_back(old_parent);
     }
 
-    if (new_parent) {
-        m_children.erase(std::remove(m_children.begin(), m_children.end(), new_parent), m_children.end());
-        m_is_root = false;
-        m_parent = new_parent;
+    Node &n = (*this)[node];
+    if (new_parent != NoNode) {
+        n.children.erase(std::remove(n.children.begin(), n.children.end(), new_parent), n.children.end());
+        n.is_root = false;
+        n.parent  = new_parent;
     } else {
-        m_is_root = true;
-        m_parent.reset();
+        n.is_root = true;
+        n.parent  = NoNode;
     }
 }
 
-NodeSPtr Node::closestNode(const Point& loc)
+NodeIdx NodePool::closestNode(NodeIdx root, const Point& loc) const
 {
-    NodeSPtr result = shared_from_this();
-    auto closest_dist2 = coord_t((m_p - loc).cast<double>().norm());
+    NodeIdx result = root;
+    auto closest_dist2 = coord_t(((*this)[root].p - loc).cast<double>().norm());
 
-    for (const auto& child : m_children) {
-        NodeSPtr candidate_node = child->closestNode(loc);
-        const auto child_dist2 = coord_t((candidate_node->m_p - loc).cast<double>().norm());
+    for (NodeIdx child : (*this)[root].children) {
+        NodeIdx candidate_node = this->closestNode(child, loc);
+        const auto child_dist2 = coord_t(((*this)[candidate_node].p - loc).cast<double>().norm());
         if (child_dist2 < closest_dist2) {
             closest_dist2 = child_dist2;
             result = candidate_node;
@@ -187,52 +214,56 @@ bool lineSegmentPolygonsIntersection(const Point& a, const Point& b, const EdgeG
     return false;
 }
 
-bool Node::realign(const Polygons& outlines, const EdgeGrid::Grid& outline_locator, std::vector<NodeSPtr>& rerooted_parts)
+bool NodePool::realign(NodeIdx node, const Polygons& outlines, const EdgeGrid::Grid& outline_locator, std::vector<NodeIdx>& rerooted_parts)
 {
     if (outlines.empty())
         return false;
 
-    if (inside(outlines, m_p)) {
+    if (inside(outlines, (*this)[node].p)) {
         // Only keep children that have an unbroken connection to here, realign will put the rest in rerooted parts due to recursion:
         Point coll;
         bool reground_me = false;
-        m_children.erase(std::remove_if(m_children.begin(), m_children.end(), [&](const NodeSPtr &child) {
-            bool connect_branch = child->realign(outlines, outline_locator, rerooted_parts);
+        auto &children = (*this)[node].children;
+        children.erase(std::remove_if(children.begin(), children.end(), [&](NodeIdx child) {
+            bool connect_branch = this->realign(child, outlines, outline_locator, rerooted_parts);
             // Find an intersection of the line segment from p to child->p, at maximum outline_locator.resolution() * 2 distance from p.
-            if (connect_branch && lineSegmentPolygonsIntersection(child->m_p, m_p, outline_locator, coll, outline_locator.resolution() * 2)) {
-                child->m_last_grounding_location.reset();
-                child->m_parent.reset();
-                child->m_is_root = true;
+            if (connect_branch && lineSegmentPolygonsIntersection((*this)[child].p, (*this)[node].p, outline_locator, coll, outline_locator.resolution() * 2)) {
+                Node &c = (*this)[child];
+                c.last_grounding_location.reset();
+                c.parent  = NoNode;
+                c.is_root = true;
                 rerooted_parts.push_back(child);
                 reground_me = true;
                 connect_branch = false;
             }
             return ! connect_branch;
-        }), m_children.end());
+        }), children.end());
         if (reground_me)
-            m_last_grounding_location.reset();
+            (*this)[node].last_grounding_location.reset();
         return true;
     }
 
     // 'Lift' any decendants out of this tree:
-    for (auto& child : m_children)
-        if (child->realign(outlines, outline_locator, rerooted_parts)) {
-            child->m_last_grounding_location = m_p;
-            child->m_parent.reset();
-            child->m_is_root = true;
+    for (NodeIdx child : (*this)[node].children)
+        if (this->realign(child, outlines, outline_locator, rerooted_parts)) {
+            Node &c = (*this)[child];
+            c.last_grounding_location = (*this)[node].p;
+            c.parent  = NoNode;
+            c.is_root = true;
             rerooted_parts.push_back(child);
         }
 
-    m_children.clear();
+    (*this)[node].children.clear();
     return false;
 }
 
-void Node::straighten(const coord_t magnitude, const coord_t max_remove_colinear_dist)
+void NodePool::straighten(NodeIdx node, const coord_t magnitude, const coord_t max_remove_colinear_dist)
 {
-    straighten(magnitude, m_p, 0, int64_t(max_remove_colinear_dist) * int64_t(max_remove_colinear_dist));
+    this->straighten(node, magnitude, (*this)[node].p, 0, int64_t(max_remove_colinear_dist) * int64_t(max_remove_colinear_dist));
 }
 
-Node::RectilinearJunction Node::straighten(
+NodePool::RectilinearJunction NodePool::straighten(
+    NodeIdx node,
     const coord_t magnitude,
     const Point& junction_above,
     const coord_t accumulated_dist,
@@ -242,35 +273,35 @@ Node::RectilinearJunction Node::straighten(
     constexpr coord_t junction_magnitude_factor_denominator = 4;
 
     const coord_t junction_magnitude = magnitude * junction_magnitude_factor_numerator / junction_magnitude_factor_denominator;
-    if (m_children.size() == 1)
+    if ((*this)[node].children.size() == 1)
     {
-        auto child_p = m_children.front();
-        auto child_dist = coord_t((m_p - child_p->m_p).cast<double>().norm());
-        RectilinearJunction junction_below = child_p->straighten(magnitude, junction_above, accumulated_dist + child_dist, max_remove_colinear_dist2);
+        NodeIdx child_p = (*this)[node].children.front();
+        auto child_dist = coord_t(((*this)[node].p - (*this)[child_p].p).cast<double>().norm());
+        RectilinearJunction junction_below = this->straighten(child_p, magnitude, junction_above, accumulated_dist + child_dist, max_remove_colinear_dist2);
         coord_t total_dist_to_junction_below = junction_below.total_recti_dist;
         const Point& a = junction_above;
         Point        b = junction_below.junction_loc;
+        Node        &n = (*this)[node];
         if (a != b) // should always be true!
         {
             Point ab = b - a;
             Point destination = (a.cast<int64_t>() + ab.cast<int64_t>() * int64_t(accumulated_dist) / std::max(int64_t(1), int64_t(total_dist_to_junction_below))).cast<coord_t>();
-            if ((destination - m_p).cast<int64_t>().squaredNorm() <= int64_t(magnitude) * int64_t(magnitude))
-                m_p = destination;
+            if ((destination - n.p).cast<int64_t>().squaredNorm() <= int64_t(magnitude) * int64_t(magnitude))
+                n.p = destination;
             else
-                m_p += ((destination - m_p).cast<double>().normalized() * magnitude).cast<coord_t>();
+                n.p += ((destination - n.p).cast<double>().normalized() * magnitude).cast<coord_t>();
         }
         { // remove nodes on linear segments
             constexpr coord_t close_enough = 10;
 
-            child_p = m_children.front(); //recursive call to straighten might have removed the child
-            const NodeSPtr& parent_node = m_parent.lock();
-            if (parent_node &&
-                (child_p->m_p - parent_node->m_p).cast<int64_t>().squaredNorm() < max_remove_colinear_dist2 &&
-                Line::distance_to_squared(m_p, parent_node->m_p, child_p->m_p) < close_enough * close_enough) {
-                child_p->m_parent = m_parent;
-                for (auto& sibling : parent_node->m_children)
+            child_p = n.children.front(); //recursive call to straighten might have removed the child
+            if (n.parent != NoNode &&
+                ((*this)[child_p].p - (*this)[n.parent].p).cast<int64_t>().squaredNorm() < max_remove_colinear_dist2 &&
+                Line::distance_to_squared(n.p, (*this)[n.parent].p, (*this)[child_p].p) < close_enough * close_enough) {
+                (*this)[child_p].parent = n.parent;
+                for (NodeIdx& sibling : (*this)[n.parent].children)
                 { // find this node among siblings
-                    if (sibling == shared_from_this())
+                    if (sibling == node)
                     {
                         sibling = child_p; // replace this node by child
                         break;
@@ -283,62 +314,66 @@ Node::RectilinearJunction Node::straighten(
     else
     {
         constexpr coord_t weight = 1000;
-        Point junction_moving_dir = ((junction_above - m_p).cast<double>().normalized() * weight).cast<coord_t>();
+        Point junction_moving_dir = ((junction_above - (*this)[node].p).cast<double>().normalized() * weight).cast<coord_t>();
         bool prevent_junction_moving = false;
-        for (auto& child_p : m_children)
+        // The recursive call to straighten might replace the child by its only child.
+        for (size_t child_idx = 0; child_idx < (*this)[node].children.size(); ++ child_idx)
         {
-            const auto child_dist = coord_t((m_p - child_p->m_p).cast<double>().norm());
-            RectilinearJunction below = child_p->straighten(magnitude, m_p, child_dist, max_remove_colinear_dist2);
+            NodeIdx    child_p    = (*this)[node].children[child_idx];
+            const auto child_dist = coord_t(((*this)[node].p - (*this)[child_p].p).cast<double>().norm());
+            RectilinearJunction below = this->straighten(child_p, magnitude, (*this)[node].p, child_dist, max_remove_colinear_dist2);
 
-            junction_moving_dir += ((below.junction_loc - m_p).cast<double>().normalized() * weight).cast<coord_t>();
+            junction_moving_dir += ((below.junction_loc - (*this)[node].p).cast<double>().normalized() * weight).cast<coord_t>();
             if (below.total_recti_dist < magnitude) // TODO: make configurable?
             {
                 prevent_junction_moving = true; // prevent flipflopping in branches due to straightening and junctoin moving clashing
             }
         }
-        if (junction_moving_dir != Point(0, 0) && ! m_children.empty() && ! m_is_root && ! prevent_junction_moving)
+        Node &n = (*this)[node];
+        if (junction_moving_dir != Point(0, 0) && ! n.children.empty() && ! n.is_root && ! prevent_junction_moving)
         {
             auto junction_moving_dir_len = coord_t(junction_moving_dir.norm());
             if (junction_moving_dir_len > junction_magnitude)
             {
                 junction_moving_dir = junction_moving_dir * junction_magnitude / junction_moving_dir_len;
             }
-            m_p += junction_moving_dir;
+            n.p += junction_moving_dir;
         }
-        return RectilinearJunction{ accumulated_dist, m_p };
+        return RectilinearJunction{ accumulated_dist, n.p };
     }
 }
 
 // Prune the tree from the extremeties (leaf-nodes) until the pruning distance is reached.
-coord_t Node::prune(const coord_t& pruning_distance)
+coord_t NodePool::prune(NodeIdx node, const coord_t& pruning_distance)
 {
     if (pruning_distance <= 0)
         return 0;
 
     coord_t max_distance_pruned = 0;
-    for (auto child_it = m_children.begin(); child_it != m_children.end(); ) {
-        auto& child = *child_it;
-        coord_t dist_pruned_child = child->prune(pruning_distance);
+    auto   &children            = (*this)[node].children;
+    for (auto child_it = children.begin(); child_it != children.end(); ) {
+        NodeIdx child = *child_it;
+        coord_t dist_pruned_child = this->prune(child, pruning_distance);
         if (dist_pruned_child >= pruning_distance)
         { // pruning is finished for child; dont modify further
             max_distance_pruned = std::max(max_distance_pruned, dist_pruned_child);
             ++child_it;
         } else {
-            const Point a = getLocation();
-            const Point b = child->getLocation();
+            const Point a = this->getLocation(node);
+            const Point b = this->getLocation(child);
             const Point ba = a - b;
             const auto ab_len = coord_t(ba.cast<double>().norm());
             if (dist_pruned_child + ab_len <= pruning_distance) { 
                 // we're still in the process of pruning
-                assert(child->m_children.empty() && "when pruning away a node all it's children must already have been pruned away");
+                assert((*this)[child].children.empty() && "when pruning away a node all it's children must already have been pruned away");
                 max_distance_pruned = std::max(max_distance_pruned, dist_pruned_child + ab_len);
-                child_it = m_children.erase(child_it);
+                child_it = children.erase(child_it);
             } else {
                 // pruning stops in between this node and the child
                 const Point n = b + (ba.cast<double>().normalized() * (pruning_distance - dist_pruned_child)).cast<coord_t>();
                 assert(std::abs((n - b).cast<double>().norm() + dist_pruned_child - pruning_distance) < 10 && "total pruned distance must be equal to the pruning_distance");
                 max_distance_pruned = std::max(max_distance_pruned, pruning_distance);
-                child->setLocation(n);
+                this->setLocation(child, n);
                 ++child_it;
             }
         }
@@ -347,36 +382,36 @@ coord_t Node::prune(const coord_t& pruning_distance)
     return max_distance_pruned;
 }
 
-void Node::convertToPolylines(Polylines &output, const coord_t line_overlap) const
+void NodePool::convertToPolylines(NodeIdx root, Polylines &output, const coord_t line_overlap) const
 {
     Polylines result;
     result.emplace_back();
-    convertToPolylines(0, result);
+    this->convertToPolylines(root, 0, result);
     removeJunctionOverlap(result, line_overlap);
-    append(output, std::move(result));
+    Slic3r::append(output, std::move(result));
 }
 
-void Node::convertToPolylines(size_t long_line_idx, Polylines &output) const
+void NodePool::convertToPolylines(NodeIdx node, size_t long_line_idx, Polylines &output) const
 {
-    if (m_children.empty()) {
-        output[long_line_idx].points.push_back(m_p);
+    const Node &n = (*this)[node];
+    if (n.children.empty()) {
+        output[long_line_idx].points.push_back(n.p);
         return;
     }
-    size_t first_child_idx = rand() % m_children.size();
-    m_children[first_child_idx]->convertToPolylines(long_line_idx, output);
-    output[long_line_idx].points.push_back(m_p);
+    size_t first_child_idx = rand() % n.children.size();
+    this->convertToPolylines(n.children[first_child_idx], long_line_idx, output);
+    output[long_line_idx].points.push_back(n.p);
 
-    for (size_t idx_offset = 1; idx_offset < m_children.size(); idx_offset++) {
-        size_t child_idx = (first_child_idx + idx_offset) % m_children.size();
-        const Node& child = *m_children[child_idx];
+    for (size_t idx_offset = 1; idx_offset < n.children.size(); idx_offset++) {
+        size_t child_idx = (first_child_idx + idx_offset) % n.children.size();
         output.emplace_back();
         size_t child_line_idx = output.size() - 1;
-        child.convertToPolylines(child_line_idx, output);
-        output[child_line_idx].points.emplace_back(m_p);
+        this->convertToPolylines(n.children[child_idx], child_line_idx, output);
+        output[child_line_idx].points.emplace_back(n.p);
     }
 }
 
-void Node::removeJunctionOverlap(Polylines &result_lines, const coord_t line_overlap) const
+void NodePool::removeJunctionOverlap(Polylines &result_lines, const coord_t line_overlap)
 {
     const coord_t reduction    = line_overlap;
     size_t        res_line_idx = 0;
@@ -413,27 +448,23 @@ void Node::removeJunctionOverlap(Polylines &result_lines, const coord_t line_ove
 }
 
 #ifdef LIGHTNING_TREE_NODE_DEBUG_OUTPUT
-void export_to_svg(const NodeSPtr &root_node, SVG &svg)
+void export_to_svg(const NodePool &nodes, NodeIdx root_node, SVG &svg)
 {
-    for (const NodeSPtr &children : root_node->m_children) {
-        svg.draw(Line(root_node->getLocation(), children->getLocation()), "red");
-        export_to_svg(children, svg);
+    for (NodeIdx child : nodes[root_node].children) {
+        svg.draw(Line(nodes.getLocation(root_node), nodes.getLocation(child)), "red");
+        export_to_svg(nodes, child, svg);
     }
 }
 
-void export_to_svg(const std::string &path, const Polygons &contour, const std::vector<NodeSPtr> &root_nodes) {
+void export_to_svg(const std::string &path, const Polygons &contour, const NodePool &nodes, const std::vector<NodeIdx> &root_nodes) {
     BoundingBox bbox = get_extents(contour);
 
     bbox.offset(SCALED_EPSILON);
     SVG svg(path, bbox);
     svg.draw_outline(contour, "blue");
 
-    for (const NodeSPtr &root_node: root_nodes) {
-        for (const NodeSPtr &children: root_node->m_children) {
-            svg.draw(Line(root_node->getLocation(), children->getLocation()), "red");
-            export_to_svg(children, svg);
-        }
-    }
+    for (NodeIdx root_node : root_nodes)
+        export_to_svg(nodes, root_node, svg);
 }
 #endif /* LIGHTNING_TREE_NODE_DEBUG_OUTPUT */
 
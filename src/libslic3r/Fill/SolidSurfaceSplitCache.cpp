@@ -0,0 +1,70 @@
+#include "SolidSurfaceSplitCache.hpp"
+
+#include <boost/functional/hash.hpp>
+
+namespace Slic3r {
+
+void SolidSurfaceSplitCache::Key::update_hash()
+{
+    size_t seed = size_t(this->pattern);
+    boost::hash_combine(seed, this->spacing);
+    boost::hash_combine(seed, this->overlap);
+    boost::hash_combine(seed, this->angle);
+    auto hash_polygon = [&seed](const Polygon &polygon) {
+        boost::hash_combine(seed, polygon.size());
+        for (const Point &pt : polygon.points) {
+            boost::hash_combine(seed, pt.x());
+            boost::hash_combine(seed, pt.y());
+        }
+    };
+    for (const ExPolygon &expolygon : this->expolygons) {
+        hash_polygon(expolygon.contour);
+        for (const Polygon &hole : expolygon.holes)
+            hash_polygon(hole);
+    }
+    this->hash = seed;
+}
+
+bool SolidSurfaceSplitCache::find(const Key &key, Value &value) const
+{
+    std::scoped_lock<std::mutex> lock(m_mutex);
+    if (auto it = m_map.find(key); it != m_map.end()) {
+        value = it->second;
+        ++ m_hits;
+        return true;
+    }
+    ++ m_misses;
+    return false;
+}
+
+void SolidSurfaceSplitCache::insert(Key &&key, const Value &value)
+{
+    size_t num_points = count_points(key.expolygons) + count_points(value.normal_infill) + count_points(value.narrow_infill);
+    std::scoped_lock<std::mutex> lock(m_mutex);
+    if (m_num_points + num_points > MaxPoints)
+        return;
+    if (m_map.emplace(std::move(key), value).second)
+        m_num_points += num_points;
+}
+
+void SolidSurfaceSplitCache::clear()
+{
+    std::scoped_lock<std::mutex> lock(m_mutex);
+    m_map.clear();
+    m_num_points = 0;
+    m_hits       = 0;
+    m_misses     = 0;
+}
+
+SolidSurfaceSplitCache::Stats SolidSurfaceSplitCache::stats() const
+{
+    std::scoped_lock<std::mutex> lock(m_mutex);
+    Stats out;
+    out.hits   = m_hits;
+    out.misses = m_misses;
+    out.size   = m_map.size();
+    out.points = m_num_points;
+    return out;
+}
+
+} // namespace Slic3r
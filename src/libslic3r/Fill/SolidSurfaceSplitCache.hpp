@@ -0,0 +1,80 @@
+#ifndef slic3r_SolidSurfaceSplitCache_hpp_
+#define slic3r_SolidSurfaceSplitCache_hpp_
+
+#include "../libslic3r.h"
+#include "../ExPolygon.hpp"
+#include "../PrintConfig.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace Slic3r {
+
+// Thread safe cache of the narrow / normal classification of internal solid infill done by split_solid_surface()
+// for the detect_narrow_internal_solid_infill option. The classification is a pure function of the surface geometry,
+// the infill pattern, the line spacing and overlap and of the infill direction. Parts with vertical walls produce
+// the same internal solid surfaces layer after layer (every other layer for the alternating patterns), and each layer
+// is classified twice, first when anchoring the bridges over sparse infill, then when generating the infill.
+// One cache is held per PrintObject, it is cleared when the infill surfaces are prepared again.
+class SolidSurfaceSplitCache
+{
+public:
+    struct Key {
+        InfillPattern   pattern;
+        coord_t         spacing;
+        double          overlap;
+        double          angle;
+        // Geometry of the surface, compared exactly on hash match.
+        ExPolygons      expolygons;
+        // Hash of all of the above, to be calculated by update_hash() once the key is filled in.
+        size_t          hash { 0 };
+
+        void update_hash();
+        bool operator==(const Key &rhs) const {
+            return hash == rhs.hash && pattern == rhs.pattern && spacing == rhs.spacing && overlap == rhs.overlap && angle == rhs.angle &&
+                   expolygons == rhs.expolygons;
+        }
+    };
+
+    // Output of split_solid_surface(): both empty if the surface is not split.
+    struct Value {
+        ExPolygons      normal_infill;
+        ExPolygons      narrow_infill;
+    };
+
+    struct Stats {
+        size_t hits   { 0 };
+        size_t misses { 0 };
+        // Number of classifications and their points currently cached.
+        size_t size   { 0 };
+        size_t points { 0 };
+    };
+
+    // Return true and fill in value if the classification of key is cached.
+    bool                find(const Key &key, Value &value) const;
+    // Store the classification of key. Once the cache holds MaxPoints, new classifications are not stored.
+    void                insert(Key &&key, const Value &value);
+
+    void                clear();
+    Stats               stats() const;
+
+    // Maximum number of points of the surfaces and their classification held by the cache.
+    static constexpr size_t MaxPoints = 16 * 1024 * 1024;
+
+private:
+    struct KeyHash {
+        size_t operator()(const Key &key) const { return key.hash; }
+    };
+
+    mutable std::mutex                              m_mutex;
+    std::unordered_map<Key, Value, KeyHash>         m_map;
+    size_t                                          m_num_points { 0 };
+    mutable std::atomic<size_t>                     m_hits   { 0 };
+    mutable std::atomic<size_t>                     m_misses { 0 };
+};
+
+} // namespace Slic3r
+
+#endif // slic3r_SolidSurfaceSplitCache_hpp_
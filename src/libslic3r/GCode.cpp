@@ -7,6 +7,7 @@
 #include "GCode.hpp"
 #include "Exception.hpp"
 #include "ExtrusionEntity.hpp"
+#include "ExtrusionEntityFlat.hpp"
 #include "EdgeGrid.hpp"
 #include "Geometry/ConvexHull.hpp"
 #include "GCode/PrintExtents.hpp"
@@ -1853,6 +1854,8 @@ void GCode::_do_export(Print& print, GCodeOutputStream &file, ThumbnailsGenerato
     // How many times will be change_layer() called?
     // change_layer() in turn increments the progress bar status.
     m_layer_count = 0;
+    m_island_order_travel_saved      = 0.;
+    m_island_order_travel_time_saved = 0.;
     if (print.config().print_sequence == PrintSequence::ByObject) {
         // Add each of the object's layers separately.
         for (auto object : print.objects()) {
@@ -2697,6 +2700,13 @@ void GCode::_do_export(Print& print, GCodeOutputStream &file, ThumbnailsGenerato
         // Modifies
         print.m_print_statistics));
     print.m_print_statistics.initial_tool = initial_extruder_id;
+    print.m_print_statistics.travel_distance_saved = m_island_order_travel_saved;
+    print.m_print_statistics.travel_time_saved     = m_island_order_travel_time_saved;
+    for (const PrintObject *object : print.objects()) {
+        SolidSurfaceSplitCache::Stats stats = object->solid_surface_split_cache().stats();
+        print.m_print_statistics.solid_surface_split_cache_hits   += stats.hits;
+        print.m_print_statistics.solid_surface_split_cache_misses += stats.misses;
+    }
     if (!is_bbl_printers) {
         file.write_format("; total filament used [g] = %.2lf\n",
             print.m_print_statistics.total_weight);
@@ -2706,6 +2716,8 @@ void GCode::_do_export(Print& print, GCodeOutputStream &file, ThumbnailsGenerato
             file.write_format("; total filament change = %i\n",
                 print.m_print_statistics.total_toolchanges);
         file.write_format("; total layers count = %i\n", m_layer_count);
+        if (print.config().optimize_island_order)
+            file.write_format("; travel saved by island ordering [mm] = %.2lf\n", m_island_order_travel_saved);
         file.write_format(
             ";%s\n",
             GCodeProcessor::reserved_tag(
@@ -3300,6 +3312,236 @@ std::vector<GCode::InstanceToPrint> GCode::sort_print_object_instances(
     return out;
 }
 
+double GCode::optimize_print_object_instances_travel(std::vector<InstanceToPrint> &instances_to_print, const Point *start_pos, size_t max_passes)
+{
+    if (instances_to_print.empty())
+        return 0.;
+
+    auto first_point = [](const ExtrusionEntitiesPtr &entities, Point &pt) {
+        for (const ExtrusionEntity *ee : entities)
+            if (! ee->is_collection() || ! static_cast<const ExtrusionEntityCollection*>(ee)->empty()) {
+                pt = ee->first_point();
+                return true;
+            }
+        return false;
+    };
+    // Island entry point approximated by the start of the first extrusion, perimeters are printed first.
+    auto island_point = [&first_point](const ObjectByExtruder::Island &island, Point &pt) {
+        for (const ObjectByExtruder::Island::Region &region : island.by_region)
+            if (first_point(region.perimeters, pt))
+                return true;
+        for (const ObjectByExtruder::Island::Region &region : island.by_region)
+            if (first_point(region.infills, pt))
+                return true;
+        return false;
+    };
+    auto distance = [](const Point &a, const Point &b) { return (b - a).cast<double>().norm(); };
+
+    // Travel through the islands of a single object, unshifted.
+    struct ObjectTravel {
+        bool                empty { true };
+        Point               entry;
+        Point               exit;
+        double              inner { 0. };
+        // Optimized order of islands, empty if the islands are to be kept as they are.
+        std::vector<size_t> island_order;
+        Point               new_entry;
+        Point               new_exit;
+        double              new_inner { 0. };
+    };
+    auto evaluate = [&distance](const Points &pts, Point &entry, Point &exit, double &inner) {
+        entry = pts.front();
+        exit  = pts.back();
+        inner = 0.;
+        for (size_t i = 1; i < pts.size(); ++ i)
+            inner += distance(pts[i - 1], pts[i]);
+    };
+    std::map<ObjectByExtruder*, ObjectTravel> objects;
+    for (const InstanceToPrint &instance : instances_to_print) {
+        auto [it, inserted] = objects.insert({ &instance.object_by_extruder, ObjectTravel() });
+        if (! inserted)
+            continue;
+        const ObjectByExtruder &object = instance.object_by_extruder;
+        ObjectTravel           &travel = it->second;
+        // Support is printed before the islands.
+        Point support_pt;
+        bool  has_support = object.support != nullptr && first_point(object.support->entities, support_pt);
+        Points              island_pts;
+        std::vector<size_t> island_idx;
+        for (size_t i = 0; i < object.islands.size(); ++ i) {
+            Point pt;
+            if (island_point(object.islands[i], pt)) {
+                island_pts.emplace_back(pt);
+                island_idx.emplace_back(i);
+            }
+        }
+        Points pts;
+        if (has_support)
+            pts.emplace_back(support_pt);
+        append(pts, island_pts);
+        if (pts.empty())
+            continue;
+        travel.empty = false;
+        evaluate(pts, travel.entry, travel.exit, travel.inner);
+        travel.new_entry = travel.entry;
+        travel.new_exit  = travel.exit;
+        travel.new_inner = travel.inner;
+        if (island_pts.size() > 1) {
+            std::vector<size_t> order = chain_points(island_pts, has_support ? &support_pt : nullptr);
+            pts.resize(has_support ? 1 : 0);
+            for (size_t i : order)
+                pts.emplace_back(island_pts[i]);
+            Point entry, exit;
+            double inner;
+            evaluate(pts, entry, exit, inner);
+            if (inner < travel.inner) {
+                // Islands without any extrusion for this extruder keep their relative order at the end.
+                std::vector<bool> used(object.islands.size(), false);
+                for (size_t i : order) {
+                    travel.island_order.emplace_back(island_idx[i]);
+                    used[island_idx[i]] = true;
+                }
+                for (size_t i = 0; i < used.size(); ++ i)
+                    if (! used[i])
+                        travel.island_order.emplace_back(i);
+                travel.new_entry = entry;
+                travel.new_exit  = exit;
+                travel.new_inner = inner;
+            }
+        }
+    }
+
+    // Tour nodes: instances with anything to print. Empty instances are moved to the end of the tour.
+    std::vector<size_t> nodes;
+    std::vector<Point>  entry, exit, new_entry, new_exit;
+    std::vector<double> inner, new_inner;
+    for (size_t i = 0; i < instances_to_print.size(); ++ i) {
+        const InstanceToPrint &instance = instances_to_print[i];
+        const ObjectTravel    &travel   = objects[&instance.object_by_extruder];
+        if (travel.empty)
+            continue;
+        const Point &shift = instance.print_object.instances()[instance.instance_id].shift;
+        nodes.emplace_back(i);
+        entry.emplace_back(travel.entry + shift);
+        exit.emplace_back(travel.exit + shift);
+        inner.emplace_back(travel.inner);
+        new_entry.emplace_back(travel.new_entry + shift);
+        new_exit.emplace_back(travel.new_exit + shift);
+        new_inner.emplace_back(travel.new_inner);
+    }
+    if (nodes.empty())
+        return 0.;
+
+    static constexpr size_t NONE = std::numeric_limits<size_t>::max();
+    // Length of a travel between two tour nodes, NONE standing for the start or the end of the tour.
+    auto edge = [&](size_t a, size_t b) {
+        if (b == NONE)
+            return 0.;
+        if (a == NONE)
+            return start_pos ? distance(*start_pos, new_entry[b]) : 0.;
+        return distance(new_exit[a], new_entry[b]);
+    };
+    double length_old = 0.;
+    for (size_t i = 0; i < nodes.size(); ++ i) {
+        if (i > 0)
+            length_old += distance(exit[i - 1], entry[i]);
+        else if (start_pos)
+            length_old += distance(*start_pos, entry[i]);
+        length_old += inner[i];
+    }
+
+    // Nearest neighbor tour.
+    std::vector<size_t> order;
+    order.reserve(nodes.size());
+    {
+        std::vector<bool> visited(nodes.size(), false);
+        size_t last = NONE;
+        if (! start_pos) {
+            // Without a start point, keep the first instance of the original order.
+            last = 0;
+            visited[0] = true;
+            order.emplace_back(0);
+        }
+        while (order.size() < nodes.size()) {
+            size_t best      = NONE;
+            double best_dist = std::numeric_limits<double>::max();
+            for (size_t i = 0; i < nodes.size(); ++ i)
+                if (! visited[i]) {
+                    double d = edge(last, i);
+                    if (d < best_dist) {
+                        best_dist = d;
+                        best      = i;
+                    }
+                }
+            visited[best] = true;
+            order.emplace_back(best);
+            last = best;
+        }
+    }
+
+    // Local search by relocating single nodes until no improvement is found or max_passes passes over the tour are done.
+    // The number of passes is fixed rather than the time spent, so that the output does not depend on the machine load.
+    // The nodes are not reversible (entry and exit differ), therefore relocation is used instead of 2-opt.
+    bool improved = true;
+    for (size_t pass = 0; improved && pass < max_passes; ++ pass) {
+        improved = false;
+        for (size_t i = 0; i < order.size(); ++ i) {
+            size_t v    = order[i];
+            size_t u    = i == 0 ? NONE : order[i - 1];
+            size_t w    = i + 1 == order.size() ? NONE : order[i + 1];
+            double best = edge(u, v) + edge(v, w) - edge(u, w) - EPSILON;
+            size_t best_j = NONE;
+            for (size_t j = 0; j <= order.size(); ++ j) {
+                if (j == i || j == i + 1)
+                    continue;
+                size_t a = j == 0 ? NONE : order[j - 1];
+                size_t b = j == order.size() ? NONE : order[j];
+                if (a == NONE && b == NONE)
+                    continue;
+                double cost = edge(a, v) + edge(v, b) - edge(a, b);
+                if (cost < best) {
+                    best   = cost;
+                    best_j = j;
+                }
+            }
+            if (best_j != NONE) {
+                order.erase(order.begin() + i);
+                order.insert(order.begin() + (best_j > i ? best_j - 1 : best_j), v);
+                improved = true;
+            }
+        }
+    }
+
+    double length_new = 0.;
+    for (size_t k = 0; k < order.size(); ++ k)
+        length_new += edge(k == 0 ? NONE : order[k - 1], order[k]) + new_inner[order[k]];
+    if (length_new >= length_old - EPSILON)
+        return 0.;
+
+    // Apply the island orders and the tour.
+    for (auto &[object_ptr, travel] : objects)
+        if (! travel.island_order.empty()) {
+            ObjectByExtruder &object = *object_ptr;
+            std::vector<ObjectByExtruder::Island> islands;
+            islands.reserve(object.islands.size());
+            for (size_t i : travel.island_order)
+                islands.emplace_back(std::move(object.islands[i]));
+            object.islands = std::move(islands);
+        }
+    std::vector<InstanceToPrint> out;
+    out.reserve(instances_to_print.size());
+    std::vector<bool> used(instances_to_print.size(), false);
+    for (size_t k : order) {
+        out.emplace_back(instances_to_print[nodes[k]]);
+        used[nodes[k]] = true;
+    }
+    for (size_t i = 0; i < instances_to_print.size(); ++ i)
+        if (! used[i])
+            out.emplace_back(instances_to_print[i]);
+    instances_to_print.swap(out);
+    return length_old - length_new;
+}
+
 namespace ProcessLayer
 {
 
@@ -4191,6 +4433,17 @@ LayerResult GCode::process_layer(
         }
         else {
             instances_to_print = sort_print_object_instances(objects_by_extruder_it->second, layers, ordering, single_object_instance_idx);
+            // Optimize the travel between the instances and the islands of this layer. Object order requested by the user
+            // is respected, as well as the sequential print.
+            if (print.config().optimize_island_order && ordering != nullptr && print.config().print_order == PrintOrder::Default) {
+                Point start_pos;
+                if (m_last_pos_defined)
+                    start_pos = m_last_pos + Point::new_scale(m_origin.x(), m_origin.y());
+                double saved = unscale<double>(optimize_print_object_instances_travel(instances_to_print, m_last_pos_defined ? &start_pos : nullptr, 10));
+                m_island_order_travel_saved += saved;
+                if (m_config.travel_speed.value > 0.)
+                    m_island_order_travel_time_saved += saved / m_config.travel_speed.value;
+            }
         }
 
         // BBS
@@ -4979,6 +5232,22 @@ std::string GCode::extrude_entity(const ExtrusionEntity &entity, std::string des
     return "";
 }
 
+std::string GCode::extrude_entity(const ExtrusionEntityCollectionFlat &entities, size_t entity_idx, bool reverse, std::string description, double speed)
+{
+    const ExtrusionEntityCollectionFlat::Entity &entity = entities.entity(entity_idx);
+    if (entity.type == ExtrusionEntityCollectionFlat::EntityType::Path || entity.type == ExtrusionEntityCollectionFlat::EntityType::PathOriented) {
+        ExtrusionPath path;
+        entities.make_path(entity.begin, path);
+        if (reverse)
+            path.reverse();
+        return this->extrude_path(std::move(path), description, speed);
+    }
+    std::unique_ptr<ExtrusionEntity> materialized = entities.materialize(entity_idx);
+    if (reverse)
+        materialized->reverse();
+    return this->extrude_entity(*materialized, description, speed);
+}
+
 std::string GCode::extrude_path(ExtrusionPath path, std::string description, double speed)
 {
     // Orca: Reset average multipath flow as this is a single line, single extrude volumetric speed path
@@ -5018,6 +5287,8 @@ std::string GCode::extrude_infill(const Print &print, const std::vector<ObjectBy
 {
     std::string 		 gcode;
     ExtrusionEntitiesPtr extrusions;
+    // The fill being chained, in a few buffers reused for all the fills instead of a clone of each of its paths.
+    ExtrusionEntityCollectionFlat fill_flat;
     const char*          extrusion_name = ironing ? "ironing" : "infill";
     for (const ObjectByExtruder::Island::Region &region : by_region)
         if (! region.infills.empty()) {
@@ -5032,8 +5303,15 @@ std::string GCode::extrude_infill(const Print &print, const std::vector<ObjectBy
                 for (const ExtrusionEntity *fill : extrusions) {
                     auto *eec = dynamic_cast<const ExtrusionEntityCollection*>(fill);
                     if (eec) {
-                        for (ExtrusionEntity *ee : eec->chained_path_from(m_last_pos).entities)
-                            gcode += this->extrude_entity(*ee, extrusion_name);
+                        fill_flat.clear();
+                        fill_flat.append(*eec);
+                        if (eec->no_sort) {
+                            for (size_t i = 0; i < fill_flat.size(); ++ i)
+                                gcode += this->extrude_entity(fill_flat, fill_flat.root(i), false, extrusion_name);
+                        } else {
+                            for (const std::pair<size_t, bool> &idx : chain_extrusion_entities(fill_flat, &m_last_pos))
+                                gcode += this->extrude_entity(fill_flat, fill_flat.root(idx.first), idx.second, extrusion_name);
+                        }
                     } else
                         gcode += this->extrude_entity(*fill, extrusion_name);
                 }
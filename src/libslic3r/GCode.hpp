@@ -37,6 +37,7 @@ namespace Slic3r {
 
 // Forward declarations.
 class GCode;
+class ExtrusionEntityCollectionFlat;
 
 namespace { struct Item; }
 struct PrintInstance;
@@ -363,6 +364,8 @@ private:
     // Orca: pass the complete collection of region perimeters to the extrude loop to check whether the wipe before external loop
     // should be executed
     std::string     extrude_entity(const ExtrusionEntity &entity, std::string description = "", double speed = -1., const ExtrusionEntitiesPtr& region_perimeters = ExtrusionEntitiesPtr());
+    // Extrude an entity of a flat collection, optionally reversed. Only the entity being extruded is instantiated.
+    std::string     extrude_entity(const ExtrusionEntityCollectionFlat &entities, size_t entity_idx, bool reverse, std::string description, double speed = -1.);
     // Orca: pass the complete collection of region perimeters to the extrude loop to check whether the wipe before external loop
     // should be executed
     std::string     extrude_loop(ExtrusionLoop loop, std::string description, double speed = -1., const ExtrusionEntitiesPtr& region_perimeters = ExtrusionEntitiesPtr(), const Point* start_point = nullptr);
@@ -446,6 +449,11 @@ private:
 		const std::vector<const PrintInstance*>     	*ordering,
 		// For sequential print, the instance of the object to be printing has to be defined.
 		const size_t                     				 single_object_instance_idx);
+    // Reorder the instances and the islands of their objects to shorten the travel between them, starting from start_pos.
+    // Instances and islands are not interleaved, so that the object labels stay valid. The original order is kept
+    // if the optimized tour is not shorter. The islands are ordered even if there is a single instance.
+    // The tour is refined by at most max_passes passes of a local search. Returns the travel length saved, in scaled coordinates.
+    static double   optimize_print_object_instances_travel(std::vector<InstanceToPrint> &instances_to_print, const Point *start_pos, size_t max_passes);
 
     std::string     extrude_perimeters(const Print& print, const std::vector<ObjectByExtruder::Island::Region>& by_region, bool is_first_layer, bool is_infill_first);
     std::string     extrude_infill(const Print& print, const std::vector<ObjectByExtruder::Island::Region>& by_region, bool ironing);
@@ -529,6 +537,9 @@ private:
     // How many times will change_layer() be called?
     // change_layer() will update the progress bar.
     unsigned int                        m_layer_count;
+    // Travel length [mm] and time [s] saved by optimize_island_order, reported through PrintStatistics.
+    double                              m_island_order_travel_saved { 0. };
+    double                              m_island_order_travel_time_saved { 0. };
     // Progress bar indicator. Increments from -1 up to layer_count.
     int                                 m_layer_index;
     // Current layer processed. In sequential printing mode, only a single copy will be printed.
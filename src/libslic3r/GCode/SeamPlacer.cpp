@@ -284,8 +284,25 @@ struct CoordinateFunctor {
   }
 };
 
+// Identifies a mesh the occlusion was computed from, together with its placement.
+struct OcclusionMeshKey {
+  ObjectID id;
+  ModelVolumeType type;
+  Transform3d trafo;
+
+  bool operator==(const OcclusionMeshKey &rhs) const {
+    return id == rhs.id && type == rhs.type && trafo.matrix() == rhs.trafo.matrix();
+  }
+};
+
 // structure to store global information about the model - occlusion hits, enforcers, blockers
+// It is cached on the PrintObject and reused by subsequent G-code exports, see SeamPlacer::update_global_model_info()
 struct GlobalModelInfo {
+  // Inputs the cached data was computed from.
+  std::vector<OcclusionMeshKey> mesh_key;
+  std::vector<std::pair<ObjectID, ObjectBase::Timestamp>> seam_painting_key;
+  bool has_occlusion = false;
+
   TriangleSetSamples mesh_samples;
   std::vector<float> mesh_samples_visibility;
   CoordinateFunctor mesh_samples_coordinate_functor;
@@ -704,6 +721,8 @@ void gather_enforcers_blockers(GlobalModelInfo &result, const PrintObject *po) {
       << "SeamPlacer: build AABB trees for raycasting enforcers/blockers: start";
 
   auto obj_transform = po->trafo_centered();
+  result.enforcers.clear();
+  result.blockers.clear();
 
   for (const ModelVolume *mv : po->model_object()->volumes) {
     if (mv->is_seam_painted()) {
@@ -995,8 +1014,68 @@ void pick_random_seam_point(const std::vector<SeamCandidate> &perimeter_points,
   perimeter.finalized = true;
 }
 
+std::vector<OcclusionMeshKey> occlusion_mesh_key(const PrintObject *po) {
+  std::vector<OcclusionMeshKey> key;
+  key.push_back({ po->model_object()->id(), ModelVolumeType::INVALID, po->trafo_centered() });
+  for (const ModelVolume *model_volume : po->model_object()->volumes) {
+    if (model_volume->type() == ModelVolumeType::MODEL_PART
+        || model_volume->type() == ModelVolumeType::NEGATIVE_VOLUME) {
+      key.push_back({ model_volume->id(), model_volume->type(), model_volume->get_matrix() });
+    }
+  }
+  return key;
+}
+
+std::vector<std::pair<ObjectID, ObjectBase::Timestamp>> seam_painting_key(const PrintObject *po) {
+  std::vector<std::pair<ObjectID, ObjectBase::Timestamp>> key;
+  for (const ModelVolume *mv : po->model_object()->volumes) {
+    key.emplace_back(mv->seam_facets.id(), mv->seam_facets.timestamp());
+  }
+  return key;
+}
+
+void GlobalModelInfoDeleter::operator()(GlobalModelInfo *p) {
+  delete p;
+}
+
 } // namespace SeamPlacerImpl
 
+// Returns the mesh derived seam data of the given object. The data is cached on the PrintObject and recalculated
+// only if the object geometry or seam painting changed since the last G-code export, or if occlusion is requested
+// for the first time. Visibility of seam candidates cached on the PrintObject is dropped whenever its inputs change.
+const SeamPlacerImpl::GlobalModelInfo& SeamPlacer::update_global_model_info(const PrintObject *po, bool need_occlusion,
+                                                                            std::function<void(void)> throw_if_canceled_func) {
+  using namespace SeamPlacerImpl;
+  GlobalModelInfoPtr &global_model_info = po->m_seam_global_model_info;
+
+  std::vector<OcclusionMeshKey> mesh_key = occlusion_mesh_key(po);
+  if (!global_model_info || !(global_model_info->mesh_key == mesh_key)) {
+    BOOST_LOG_TRIVIAL(debug)
+        << "SeamPlacer: object geometry changed, dropping cached seam data";
+    global_model_info.reset(new GlobalModelInfo { });
+    global_model_info->mesh_key = std::move(mesh_key);
+    po->m_seam_candidates_visibility.clear();
+  }
+
+  std::vector<std::pair<ObjectID, ObjectBase::Timestamp>> painting_key = seam_painting_key(po);
+  if (global_model_info->seam_painting_key != painting_key) {
+    // Painted enforcers oversample the perimeters, thus the seam candidates change.
+    po->m_seam_candidates_visibility.clear();
+    // Invalidate the key first, so that a canceled export does not leave stale enforcers / blockers marked valid.
+    global_model_info->seam_painting_key.clear();
+    gather_enforcers_blockers(*global_model_info, po);
+    global_model_info->seam_painting_key = std::move(painting_key);
+  }
+  throw_if_canceled_func();
+
+  if (need_occlusion && !global_model_info->has_occlusion) {
+    po->m_seam_candidates_visibility.clear();
+    compute_global_occlusion(*global_model_info, po, throw_if_canceled_func);
+    global_model_info->has_occlusion = true;
+  }
+  return *global_model_info;
+}
+
 // Parallel process and extract each perimeter polygon of the given print object.
 // Gather SeamCandidates of each layer into vector and build KDtree over them
 // Store results in the SeamPlacer variables m_seam_per_object
@@ -1033,12 +1112,28 @@ void SeamPlacer::calculate_candidates_visibility(const PrintObject *po,
   using namespace SeamPlacerImpl;
 
   std::vector<PrintObjectSeamData::LayerSeams> &layers = m_seam_per_object[po].layers;
+  // Visibility depends on the occlusion and on the seam candidates only, reuse the values from the last G-code export if possible.
+  std::vector<std::vector<float>> &visibility_cache = po->m_seam_candidates_visibility;
+  if (visibility_cache.size() != layers.size()) {
+    visibility_cache.assign(layers.size(), {});
+  }
   tbb::parallel_for(tbb::blocked_range<size_t>(0, layers.size()),
-                    [&layers, &global_model_info](tbb::blocked_range<size_t> r) {
+                    [&layers, &global_model_info, &visibility_cache](tbb::blocked_range<size_t> r) {
                       for (size_t layer_idx = r.begin(); layer_idx < r.end(); ++layer_idx) {
-                        for (auto &perimeter_point : layers[layer_idx].points) {
-                          perimeter_point.visibility = global_model_info.calculate_point_visibility(
-                              perimeter_point.position);
+                        std::vector<SeamCandidate> &points = layers[layer_idx].points;
+                        std::vector<float> &layer_visibility = visibility_cache[layer_idx];
+                        if (layer_visibility.size() == points.size()) {
+                          for (size_t point_idx = 0; point_idx < points.size(); ++point_idx) {
+                            points[point_idx].visibility = layer_visibility[point_idx];
+                          }
+                        } else {
+                          layer_visibility.clear();
+                          layer_visibility.reserve(points.size());
+                          for (auto &perimeter_point : points) {
+                            perimeter_point.visibility = global_model_info.calculate_point_visibility(
+                                perimeter_point.position);
+                            layer_visibility.push_back(perimeter_point.visibility);
+                          }
                         }
                       }
                     });
@@ -1423,12 +1518,8 @@ void SeamPlacer::init(const Print &print, std::function<void(void)> throw_if_can
     SeamComparator comparator { configured_seam_preference };
 
     {
-      GlobalModelInfo global_model_info { };
-      gather_enforcers_blockers(global_model_info, po);
-      throw_if_canceled_func();
-      if (configured_seam_preference == spAligned || configured_seam_preference == spNearest) {
-        compute_global_occlusion(global_model_info, po, throw_if_canceled_func);
-      }
+      bool need_occlusion = configured_seam_preference == spAligned || configured_seam_preference == spNearest;
+      const GlobalModelInfo &global_model_info = update_global_model_info(po, need_occlusion, throw_if_canceled_func);
       throw_if_canceled_func();
       BOOST_LOG_TRIVIAL(debug)
           << "SeamPlacer: gather_seam_candidates: start";
@@ -1443,7 +1534,7 @@ void SeamPlacer::init(const Print &print, std::function<void(void)> throw_if_can
         BOOST_LOG_TRIVIAL(debug)
             << "SeamPlacer: calculate_candidates_visibility : end";
       }
-    } // destruction of global_model_info (large structure, no longer needed)
+    } // global_model_info stays cached on the PrintObject for the next G-code export
     throw_if_canceled_func();
     BOOST_LOG_TRIVIAL(debug)
         << "SeamPlacer: calculate_overhangs and layer embdedding : start";
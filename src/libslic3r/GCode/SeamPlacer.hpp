@@ -32,6 +32,10 @@ namespace SeamPlacerImpl {
 struct GlobalModelInfo;
 struct SeamComparator;
 
+// Mesh derived seam data is cached on PrintObject, see PrintObject::m_seam_global_model_info.
+struct GlobalModelInfoDeleter { void operator()(GlobalModelInfo *p); };
+using  GlobalModelInfoPtr = std::unique_ptr<GlobalModelInfo, GlobalModelInfoDeleter>;
+
 enum class EnforcedBlockedSeamPoint {
   Blocked = 0,
   Neutral = 1,
@@ -145,6 +149,8 @@ public:
 
   void place_seam(const Layer *layer, ExtrusionLoop &loop, const Point &last_pos, float& overhang) const;
 private:
+  const SeamPlacerImpl::GlobalModelInfo& update_global_model_info(const PrintObject *po, bool need_occlusion,
+                                                                   std::function<void(void)> throw_if_canceled_func);
   void gather_seam_candidates(const PrintObject *po, const SeamPlacerImpl::GlobalModelInfo &global_model_info);
   void calculate_candidates_visibility(const PrintObject *po,
                                        const SeamPlacerImpl::GlobalModelInfo &global_model_info);
@@ -76,6 +76,10 @@ public:
         visit_recursive(0, 0, visitor);
     }
 
+    // Indices of the points stored at the nodes of the tree, npos at the empty nodes.
+    // The children of node i are the nodes 2 * i + 1 and 2 * i + 2.
+    const std::vector<size_t>& nodes() const { return m_nodes; }
+
     CoordinateFn coordinate;
 
 private:
@@ -96,13 +96,15 @@ public:
     // Is there any valid extrusion assigned to this LayerRegion?
     bool    has_extrusions() const { return ! this->perimeters.entities.empty() || ! this->fills.entities.empty(); }
     //BBS
-    void    simplify_infill_extrusion_entity() { simplify_entity_collection(&fills); }
+    // The ironing extrusions are simplified by Layer::make_ironing(), so that ironing may be regenerated on its own.
+    void    simplify_infill_extrusion_entity();
     void    simplify_wall_extrusion_entity() { simplify_entity_collection(&perimeters); }
+    // Remove the ironing extrusions added to fills by Layer::make_ironing().
+    void    clear_ironing();
 private:
     void    simplify_entity_collection(ExtrusionEntityCollection* entity_collection);
+    void    simplify_paths(const std::vector<ExtrusionPath*> &paths);
     void    simplify_path(ExtrusionPath* path);
-    void    simplify_multi_path(ExtrusionMultiPath* multipath);
-    void    simplify_loop(ExtrusionLoop* loop);
 
 protected:
     friend class Layer;
@@ -187,6 +189,8 @@ public:
     Polylines               generate_sparse_infill_polylines_for_anchoring(FillAdaptive::Octree *adaptive_fill_octree,
                                                                            FillAdaptive::Octree *support_fill_octree,
                                                                            FillLightning::Generator* lightning_generator) const;
+    // Generate ironing over the top surfaces classified by prepare_infill(), replacing the ironing of a previous run.
+    // Only reads the surfaces of the layer regions, thus ironing may be regenerated without regenerating the infill.
     void 					make_ironing();
 
     void                    export_region_slices_to_svg(const char *path) const;
@@ -252,8 +256,6 @@ protected:
 //BBS: method to simplify support path
     void    simplify_support_entity_collection(ExtrusionEntityCollection* entity_collection);
     void    simplify_support_path(ExtrusionPath* path);
-    void    simplify_support_multi_path(ExtrusionMultiPath* multipath);
-    void    simplify_support_loop(ExtrusionLoop* loop);
 
 private:
     // Sequential index of layer, 0-based, offsetted by number of raft layers.
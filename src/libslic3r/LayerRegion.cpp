@@ -15,6 +15,8 @@
 #include <boost/log/trivial.hpp>
 #include <boost/algorithm/clamp.hpp>
 
+#include <tbb/parallel_for.h>
+
 namespace Slic3r {
 
 Flow LayerRegion::flow(FlowRole role) const
@@ -1004,25 +1006,49 @@ void LayerRegion::export_region_fill_surfaces_to_svg_debug(const char *name) con
     this->export_region_fill_surfaces_to_svg(debug_out_path("LayerRegion-fill_surfaces-%s-%d.svg", name, idx ++).c_str());
 }
 
+void LayerRegion::simplify_infill_extrusion_entity()
+{
+    std::vector<ExtrusionPath*> paths;
+    for (ExtrusionEntity *ee : this->fills.entities)
+        if (ee->role() != erIroning)
+            // fills contains ExtrusionEntityCollection objects only.
+            static_cast<ExtrusionEntityCollection*>(ee)->collect_paths(paths);
+    this->simplify_paths(paths);
+}
+
+void LayerRegion::clear_ironing()
+{
+    auto it = std::remove_if(this->fills.entities.begin(), this->fills.entities.end(), [](ExtrusionEntity *ee) {
+        if (ee->role() != erIroning)
+            return false;
+        delete ee;
+        return true;
+    });
+    this->fills.entities.erase(it, this->fills.entities.end());
+}
+
 void LayerRegion::simplify_entity_collection(ExtrusionEntityCollection* entity_collection)
 {
-    for (size_t i = 0; i < entity_collection->entities.size(); i++) {
-        if (ExtrusionEntityCollection* collection = dynamic_cast<ExtrusionEntityCollection*>(entity_collection->entities[i]))
-            this->simplify_entity_collection(collection);
-        else if (ExtrusionPath* path = dynamic_cast<ExtrusionPath*>(entity_collection->entities[i]))
-            this->simplify_path(path);
-        else if (ExtrusionMultiPath* multipath = dynamic_cast<ExtrusionMultiPath*>(entity_collection->entities[i]))
-            this->simplify_multi_path(multipath);
-        else if (ExtrusionLoop* loop = dynamic_cast<ExtrusionLoop*>(entity_collection->entities[i]))
-            this->simplify_loop(loop);
-        else
-            throw Slic3r::InvalidArgument("Invalid extrusion entity supplied to simplify_entity_collection()");
-    }
+    std::vector<ExtrusionPath*> paths;
+    entity_collection->collect_paths(paths);
+    this->simplify_paths(paths);
+}
+
+void LayerRegion::simplify_paths(const std::vector<ExtrusionPath*> &paths)
+{
+    // Fitting arcs is expensive for long curved paths such as gyroid infill, while a layer may hold thousands of them.
+    // The paths are independent, thus they are simplified in parallel, the fitted arcs are stored on the paths
+    // and the G-code export only formats them.
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, paths.size(), 16),
+        [this, &paths](const tbb::blocked_range<size_t> &range) {
+            for (size_t i = range.begin(); i < range.end(); ++ i)
+                this->simplify_path(paths[i]);
+        });
 }
 
 void LayerRegion::simplify_path(ExtrusionPath* path)
 {
-    const auto print_config = this->layer()->object()->print()->config();
+    const PrintConfig &print_config = this->layer()->object()->print()->config();
     const bool spiral_mode = print_config.spiral_mode;
     const bool enable_arc_fitting = print_config.enable_arc_fitting;
     const auto scaled_resolution = scaled<double>(print_config.resolution.value);
@@ -1038,45 +1064,5 @@ void LayerRegion::simplify_path(ExtrusionPath* path)
     }
 }
 
-void LayerRegion::simplify_multi_path(ExtrusionMultiPath* multipath)
-{
-    const auto print_config = this->layer()->object()->print()->config();
-    const bool spiral_mode = print_config.spiral_mode;
-    const bool enable_arc_fitting = print_config.enable_arc_fitting;
-    const auto scaled_resolution = scaled<double>(print_config.resolution.value);
-
-    for (size_t i = 0; i < multipath->paths.size(); ++i) {
-        if (enable_arc_fitting &&
-            !spiral_mode) {
-            if (multipath->paths[i].role() == erInternalInfill)
-                multipath->paths[i].simplify_by_fitting_arc(SCALED_SPARSE_INFILL_RESOLUTION);
-            else
-                multipath->paths[i].simplify_by_fitting_arc(scaled_resolution);
-        } else {
-            multipath->paths[i].simplify(scaled_resolution);
-        }
-    }
-}
-
-void LayerRegion::simplify_loop(ExtrusionLoop* loop)
-{
-    const auto print_config = this->layer()->object()->print()->config();
-    const bool spiral_mode = print_config.spiral_mode;
-    const bool enable_arc_fitting = print_config.enable_arc_fitting;
-    const auto scaled_resolution = scaled<double>(print_config.resolution.value);
-
-    for (size_t i = 0; i < loop->paths.size(); ++i) {
-        if (enable_arc_fitting &&
-            !spiral_mode) {
-            if (loop->paths[i].role() == erInternalInfill)
-                loop->paths[i].simplify_by_fitting_arc(SCALED_SPARSE_INFILL_RESOLUTION);
-            else
-                loop->paths[i].simplify_by_fitting_arc(scaled_resolution);
-        } else {
-            loop->paths[i].simplify(scaled_resolution);
-        }
-    }
-}
-
 }
  
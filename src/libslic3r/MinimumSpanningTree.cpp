@@ -2,7 +2,13 @@
 
 #include <iterator>
 #include <algorithm>
+#include <numeric>
 #include "libslic3r.h"
+#include "BoundingBox.hpp"
+#include "KDTreeIndirect.hpp"
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
 
 namespace Slic3r
 {
@@ -19,12 +25,12 @@ inline double vsize2_with_unscale(const Point pt)
     return dot_with_unscale(pt, pt);
 }
 
-MinimumSpanningTree::MinimumSpanningTree(std::vector<Point> vertices) : adjacency_graph(prim(vertices))
+MinimumSpanningTree::MinimumSpanningTree(std::vector<Point> vertices) : adjacency_graph(boruvka(vertices))
 {
     //Just copy over the fields.
 }
 
-auto MinimumSpanningTree::prim(std::vector<Point> vertices) const -> AdjacencyGraph_t
+auto MinimumSpanningTree::boruvka(std::vector<Point> vertices) const -> AdjacencyGraph_t
 {
     AdjacencyGraph_t result;
     if (vertices.empty())
@@ -40,59 +46,124 @@ auto MinimumSpanningTree::prim(std::vector<Point> vertices) const -> AdjacencyGr
         result[*vertices.begin()];
         return result;
     }
-    result.reserve(vertices.size());
-    std::vector<Point> vertices_list(vertices.begin(), vertices.end());
-
-    std::unordered_map<const Point*, coordf_t> smallest_distance;    //The shortest distance to the current tree.
-    std::unordered_map<const Point*, const Point*> smallest_distance_to; //Which point the shortest distance goes towards.
-    smallest_distance.reserve(vertices_list.size());
-    smallest_distance_to.reserve(vertices_list.size());
-    for (size_t vertex_index = 1; vertex_index < vertices_list.size(); vertex_index++)
-    {
-        const auto& vert = vertices_list[vertex_index];
-        smallest_distance[&vert] = vsize2_with_unscale(vert - vertices_list[0]);
-        smallest_distance_to[&vert] = &vertices_list[0];
-    }
-
-    while (result.size() < vertices_list.size()) //All of the vertices need to be in the tree at the end.
-    {
-        //Choose the closest vertex to connect to that is not yet in the tree.
-        //This search is O(V) right now, which can be made down to O(log(V)). This reduces the overall time complexity from O(V*V) to O(V*log(E)).
-        //However that requires an implementation of a heap that supports the decreaseKey operation, which is not in the std library.
-        //TODO: Implement this?
-        using MapValue = std::pair<const Point*, coordf_t>;
-        const auto closest = std::min_element(smallest_distance.begin(), smallest_distance.end(),
-                                              [](const MapValue& a, const MapValue& b) {
-                                                  return a.second < b.second;
-                                              });
-
-        //Add this point to the graph and remove it from the candidates.
-        const Point* closest_point = closest->first;
-        const Point other_end = *smallest_distance_to[closest_point];
-        if (result.find(*closest_point) == result.end())
-        {
-            result[*closest_point] = std::vector<Edge>();
+    const size_t num_vertices = vertices.size();
+    result.reserve(num_vertices);
+
+    auto coordinate = [&vertices](size_t idx, size_t dimension) { return double(vertices[idx](dimension)); };
+    const KDTreeIndirect<2, double, decltype(coordinate)> kdtree(coordinate, num_vertices);
+
+    // Edges are ordered by their length and then by their vertex indices. As no two edges compare equal,
+    // the cheapest edges leaving the components never close a cycle.
+    struct CandidateEdge {
+        double length2 { std::numeric_limits<double>::max() };
+        size_t a       { 0 };
+        size_t b       { 0 };
+        bool operator<(const CandidateEdge &rhs) const { return length2 < rhs.length2 || (length2 == rhs.length2 && (a < rhs.a || (a == rhs.a && b < rhs.b))); }
+    };
+
+    // Components of the spanning forest as a union-find structure.
+    std::vector<size_t> parent(num_vertices);
+    std::iota(parent.begin(), parent.end(), 0);
+    auto find = [&parent](size_t i) {
+        while (parent[i] != i)
+            i = parent[i] = parent[parent[i]];
+        return i;
+    };
+
+    // Nodes of the KD tree of the vertices and the component shared by all the vertices of the subtree of a node,
+    // so that the subtrees of a single component are skipped when searching for the closest vertices of other components.
+    const std::vector<size_t> &kdtree_nodes = kdtree.nodes();
+    std::vector<size_t>        kdtree_node_of_vertex(num_vertices);
+    for (size_t i = 0; i < kdtree_nodes.size(); ++ i)
+        if (kdtree_nodes[i] != kdtree.npos)
+            kdtree_node_of_vertex[kdtree_nodes[i]] = i;
+    // Bounding boxes of the subtrees for a tighter pruning than by the splitting planes only.
+    std::vector<BoundingBoxf>  subtree_bbox(kdtree_nodes.size());
+    for (size_t i = kdtree_nodes.size(); i > 0; -- i)
+        if (size_t inode = i - 1; kdtree_nodes[inode] != kdtree.npos) {
+            BoundingBoxf &bbox = subtree_bbox[inode];
+            bbox.merge(vertices[kdtree_nodes[inode]].cast<double>());
+            for (size_t ichild : { 2 * inode + 1, 2 * inode + 2 })
+                if (ichild < kdtree_nodes.size() && kdtree_nodes[ichild] != kdtree.npos)
+                    bbox.merge(subtree_bbox[ichild]);
         }
-        result[*closest_point].push_back({*closest_point, other_end});
-        if (result.find(other_end) == result.end())
-        {
-            result[other_end] = std::vector<Edge>();
-        }
-        result[other_end].push_back({other_end, *closest_point});
-        smallest_distance.erase(closest_point); //Remove it so we don't check for these points again.
-        smallest_distance_to.erase(closest_point);
+    static constexpr const size_t NoComponent    = std::numeric_limits<size_t>::max();
+    static constexpr const size_t MixedComponent = NoComponent - 1;
+    std::vector<size_t>        subtree_component(kdtree_nodes.size(), NoComponent);
+
+    std::vector<size_t>        component(num_vertices);
+    // The distance of a vertex to the closest vertex of another component does not decrease as the components grow.
+    // Squared lower bound of the distance, the vertices not closer than the cheapest edge found so far are skipped.
+    std::vector<double>        min_length2(num_vertices, 0.);
+    std::vector<size_t>        order(num_vertices);
+    std::vector<size_t>        component_begin;
+    std::vector<CandidateEdge> cheapest;
+    for (size_t num_components = num_vertices; num_components > 1;)
+    {
+        for (size_t i = 0; i < num_vertices; ++ i)
+            component[i] = find(i);
+        for (size_t i = kdtree_nodes.size(); i > 0; -- i)
+            if (size_t inode = i - 1; kdtree_nodes[inode] != kdtree.npos) {
+                size_t c = component[kdtree_nodes[inode]];
+                for (size_t ichild : { 2 * inode + 1, 2 * inode + 2 })
+                    if (ichild < kdtree_nodes.size() && subtree_component[ichild] != NoComponent && subtree_component[ichild] != c)
+                        c = MixedComponent;
+                subtree_component[inode] = c;
+            }
+        // Group the vertices by their components, the vertices likely to be closest to another component first.
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&component, &min_length2](size_t l, size_t r) {
+            return component[l] < component[r] || (component[l] == component[r] && (min_length2[l] < min_length2[r] || (min_length2[l] == min_length2[r] && l < r)));
+        });
+        component_begin.clear();
+        for (size_t i = 0; i < num_vertices; ++ i)
+            if (i == 0 || component[order[i]] != component[order[i - 1]])
+                component_begin.emplace_back(i);
+        component_begin.emplace_back(num_vertices);
+
+        // Find the cheapest edge leaving each component by the closest vertices of the other components.
+        // The cheapest edge found so far limits the search of the next vertices of the same component.
+        cheapest.assign(num_components, CandidateEdge{});
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, num_components), [&](const tbb::blocked_range<size_t> &range) {
+            for (size_t icomponent = range.begin(); icomponent < range.end(); ++ icomponent) {
+                CandidateEdge &best = cheapest[icomponent];
+                for (size_t i = component_begin[icomponent]; i < component_begin[icomponent + 1]; ++ i) {
+                    const size_t ivertex = order[i];
+                    if (min_length2[ivertex] > best.length2)
+                        // This and the following vertices of the component are further from the other components.
+                        break;
+                    const Vec2d  pt        = vertices[ivertex].cast<double>();
+                    const double length2   = best.length2;
+                    auto visitor = [&](size_t idx, size_t dimension) -> unsigned int {
+                        const size_t inode = kdtree_node_of_vertex[idx];
+                        if (subtree_component[inode] == component[ivertex])
+                            return 0;
+                        const BoundingBoxf &bbox = subtree_bbox[inode];
+                        if ((pt - pt.cwiseMax(bbox.min).cwiseMin(bbox.max)).squaredNorm() > best.length2)
+                            return 0;
+                        if (component[idx] != component[ivertex]) {
+                            CandidateEdge edge { (vertices[idx].cast<double>() - pt).squaredNorm(), std::min(idx, ivertex), std::max(idx, ivertex) };
+                            if (edge < best)
+                                best = edge;
+                        }
+                        return kdtree.descent_mask(pt[dimension], best.length2, idx, dimension);
+                    };
+                    kdtree.visit(visitor);
+                    // Either the closest vertex of another component was found, or it is not closer than the cheapest edge before.
+                    min_length2[ivertex] = best.length2 < length2 ? best.length2 : length2;
+                }
+            }
+        });
 
-        //Update the distances of all points that are not in the graph.
-        for (std::pair<const Point*, coordf_t> point_and_distance : smallest_distance)
-        {
-            const coordf_t new_distance = vsize2_with_unscale(*closest_point - *point_and_distance.first);
-            const coordf_t old_distance = point_and_distance.second;
-            if (new_distance < old_distance) //New point is closer.
+        // Connect the components by their cheapest edges, two components may share their cheapest edge.
+        for (const CandidateEdge &edge : cheapest)
+            if (size_t ra = find(edge.a), rb = find(edge.b); ra != rb)
             {
-                smallest_distance[point_and_distance.first] = new_distance;
-                smallest_distance_to[point_and_distance.first] = closest_point;
+                parent[std::max(ra, rb)] = std::min(ra, rb);
+                result[vertices[edge.a]].push_back({ vertices[edge.a], vertices[edge.b] });
+                result[vertices[edge.b]].push_back({ vertices[edge.b], vertices[edge.a] });
+                -- num_components;
             }
-        }
     }
 
     return result;
@@ -11,9 +11,11 @@ namespace Slic3r
 {
 
 /*!
- * \brief Implements Prim's algorithm to compute Minimum Spanning Trees (MST).
+ * \brief Implements Boruvka's algorithm to compute Euclidean Minimum Spanning Trees (MST).
  *
  * The minimum spanning tree is always computed from a clique of vertices.
+ * The cheapest edges leaving the components are found by nearest neighbour
+ * queries on a KD tree, thus the clique is never enumerated.
  */
 class MinimumSpanningTree
 {
@@ -64,13 +66,14 @@ private:
     AdjacencyGraph_t adjacency_graph;
 
     /*!
-     * \brief Computes the edges of a minimum spanning tree using Prim's
-     * algorithm.
+     * \brief Computes the edges of a minimum spanning tree using Boruvka's
+     * algorithm. Ties are broken by the order of the vertices, thus the tree
+     * is deterministic for vertices in a deterministic order.
      *
      * \param vertices The vertices to span.
      * \return An adjacency graph with for each point one or more edges.
      */
-    AdjacencyGraph_t prim(std::vector<Point> vertices) const;
+    AdjacencyGraph_t boruvka(std::vector<Point> vertices) const;
 };
 
 }
@@ -136,6 +136,7 @@ bool Print::invalidate_state_by_config_options(const ConfigOptionResolver & /* n
         "hot_plate_temp_initial_layer",
         "textured_plate_temp_initial_layer",
         "gcode_add_line_number",
+        "optimize_island_order",
         "layer_change_gcode",
         "time_lapse_gcode",
         "fan_min_speed",
@@ -2996,6 +2997,10 @@ DynamicConfig PrintStatistics::config() const
     config.set_key_value("total_wipe_tower_cost",     new ConfigOptionFloat(this->total_wipe_tower_cost));
     config.set_key_value("total_wipe_tower_filament", new ConfigOptionFloat(this->total_wipe_tower_filament));
     config.set_key_value("initial_tool",              new ConfigOptionInt(static_cast<int>(this->initial_tool)));
+    config.set_key_value("travel_distance_saved",     new ConfigOptionFloat(this->travel_distance_saved));
+    config.set_key_value("travel_time_saved",         new ConfigOptionFloat(this->travel_time_saved));
+    config.set_key_value("solid_surface_split_cache_hits",   new ConfigOptionInt(int(this->solid_surface_split_cache_hits)));
+    config.set_key_value("solid_surface_split_cache_misses", new ConfigOptionInt(int(this->solid_surface_split_cache_misses)));
     return config;
 }
 
@@ -3005,7 +3010,8 @@ DynamicConfig PrintStatistics::placeholders()
     for (const std::string key : {
         "print_time", "normal_print_time", "silent_print_time",
         "used_filament", "extruded_volume", "total_cost", "total_weight",
-        "initial_tool", "total_toolchanges", "total_wipe_tower_cost", "total_wipe_tower_filament"})
+        "initial_tool", "total_toolchanges", "total_wipe_tower_cost", "total_wipe_tower_filament",
+        "travel_distance_saved", "travel_time_saved", "solid_surface_split_cache_hits", "solid_surface_split_cache_misses"})
         config.set_key_value(key, new ConfigOptionString(std::string("{") + key + "}"));
     return config;
 }
@@ -3,6 +3,7 @@
 
 #include "Fill/FillAdaptive.hpp"
 #include "Fill/FillLightning.hpp"
+#include "Fill/SolidSurfaceSplitCache.hpp"
 #include "PrintBase.hpp"
 
 #include "BoundingBox.hpp"
@@ -72,6 +73,19 @@ namespace FillLightning {
     using GeneratorPtr = std::unique_ptr<Generator, GeneratorDeleter>;
 }; // namespace FillLightning
 
+class SeamPlacer;
+namespace SeamPlacerImpl {
+    struct GlobalModelInfo;
+    struct GlobalModelInfoDeleter;
+    using GlobalModelInfoPtr = std::unique_ptr<GlobalModelInfo, GlobalModelInfoDeleter>;
+}; // namespace SeamPlacerImpl
+
+namespace TreeSupport3D {
+    class TreeModelVolumes;
+    struct TreeModelVolumesDeleter { void operator()(TreeModelVolumes *p); };
+    using TreeModelVolumesPtr = std::unique_ptr<TreeModelVolumes, TreeModelVolumesDeleter>;
+}; // namespace TreeSupport3D
+
 // Print step IDs for keeping track of the print state.
 // The Print steps are applied in this order.
 enum PrintStep {
@@ -383,6 +397,8 @@ public:
     SupportLayer* add_tree_support_layer(int id, coordf_t height, coordf_t print_z, coordf_t slice_z);
     std::shared_ptr<TreeSupportData> alloc_tree_support_preview_cache();
     void clear_tree_support_preview_cache() { m_tree_support_preview_cache.reset(); }
+    // Collision and avoidance volumes of the last organic tree support generation, reused by the next one.
+    TreeSupport3D::TreeModelVolumesPtr& tree_model_volumes() { return m_tree_model_volumes; }
 
     size_t          support_layer_count() const { return m_support_layers.size(); }
     void            clear_support_layers();
@@ -419,6 +435,9 @@ public:
     // returns 0-based indices of extruders used to print the object (without brim, support and other helper extrusions)
     std::vector<unsigned int>   object_extruders() const;
 
+    // Narrow internal solid infill classification, shared by the layers of this object. Thread safe.
+    SolidSurfaceSplitCache&     solid_surface_split_cache() const { return m_solid_surface_split_cache; }
+
     // Called by make_perimeters()
     void slice();
 
@@ -453,6 +472,8 @@ public:
   private:
     // to be called from Print only.
     friend class Print;
+    // Reads and fills in the seam placer caches during G-code export.
+    friend class SeamPlacer;
 
 	PrintObject(Print* print, ModelObject* model_object, const Transform3d& trafo, PrintInstances&& instances);
 	~PrintObject();
@@ -528,6 +549,8 @@ private:
     SupportLayerPtrs                        m_support_layers;
     // BBS
     std::shared_ptr<TreeSupportData>        m_tree_support_preview_cache;
+    // Filled in by the organic tree support generator, dropped with the slices.
+    TreeSupport3D::TreeModelVolumesPtr      m_tree_model_volumes;
 
     // this is set to true when LayerRegion->slices is split in top/internal/bottom
     // so that next call to make_perimeters() performs a union() before computing loops
@@ -535,6 +558,14 @@ private:
 
     std::pair<FillAdaptive::OctreePtr, FillAdaptive::OctreePtr> m_adaptive_fill_octrees;
     FillLightning::GeneratorPtr m_lightning_generator;
+    // Filled in by group_fills() during posPrepareInfill and posInfill, cleared when posPrepareInfill starts.
+    mutable SolidSurfaceSplitCache m_solid_surface_split_cache;
+
+    // Mesh derived data of the seam placer (occlusion samples, painted enforcers / blockers) and visibility
+    // of the seam candidates per layer. Filled in by G-code export and reused by subsequent exports
+    // as long as neither the geometry nor the seam painting changes. Mutable, as G-code export works on a const Print.
+    mutable SeamPlacerImpl::GlobalModelInfoPtr  m_seam_global_model_info;
+    mutable std::vector<std::vector<float>>     m_seam_candidates_visibility;
 
     std::vector < VolumeSlices >            firstLayerObjSliceByVolume;
     std::vector<groupedVolumeSlices>        firstLayerObjSliceByGroups;
@@ -752,6 +783,12 @@ struct PrintStatistics
     double                          total_wipe_tower_cost;
     double                          total_wipe_tower_filament;
     unsigned int                    initial_tool;
+    // Travel length [mm] and travel time [s] saved by the per layer island ordering.
+    double                          travel_distance_saved;
+    double                          travel_time_saved;
+    // Hits and misses of the narrow internal solid infill classification cache, summed over all objects.
+    size_t                          solid_surface_split_cache_hits;
+    size_t                          solid_surface_split_cache_misses;
     std::map<size_t, double>        filament_stats;
 
     // Config with the filled in print statistics.
@@ -770,6 +807,10 @@ struct PrintStatistics
         total_wipe_tower_cost  = 0.;
         total_wipe_tower_filament = 0.;
         initial_tool           = 0;
+        travel_distance_saved  = 0.;
+        travel_time_saved      = 0.;
+        solid_surface_split_cache_hits   = 0;
+        solid_surface_split_cache_misses = 0;
         filament_stats.clear();
     }
     static const std::string FilamentUsedG;
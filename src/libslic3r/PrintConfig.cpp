@@ -418,6 +418,12 @@ static t_config_enum_values s_keys_map_PerimeterGeneratorType{
 };
 CONFIG_OPTION_ENUM_DEFINE_STATIC_MAPS(PerimeterGeneratorType)
 
+static t_config_enum_values s_keys_map_TreeSupportCollisionBackend{
+    { "polygons",       int(TreeSupportCollisionBackend::Polygons) },
+    { "distance_field", int(TreeSupportCollisionBackend::DistanceField) }
+};
+CONFIG_OPTION_ENUM_DEFINE_STATIC_MAPS(TreeSupportCollisionBackend)
+
 static const t_config_enum_values s_keys_map_ZHopType = {
     { "Auto Lift",          zhtAuto },
     { "Normal Lift",        zhtNormal },
@@ -3093,6 +3099,14 @@ void PrintConfigDef::init_fff_params()
     def->mode = comAdvanced;
     def->set_default_value(new ConfigOptionBool(false));
 
+    def = this->add("optimize_island_order", coBool);
+    def->label = L("Optimize island order");
+    def->tooltip = L("Order the objects and their islands in each layer to shorten the travel moves between them. "
+                     "Objects are still printed one after another, so that labeling and excluding objects keeps working. "
+                     "This has no effect if the intra-layer order is set to follow the object list or if a prime tower is used.");
+    def->mode = comAdvanced;
+    def->set_default_value(new ConfigOptionBool(false));
+
     def = this->add("gcode_comments", coBool);
     def->label = L("Verbose G-code");
     def->tooltip = L("Enable this to get a commented G-code file, with each line explained by a descriptive text. "
@@ -5189,6 +5203,22 @@ void PrintConfigDef::init_fff_params()
     def->mode = comAdvanced;
     def->set_default_value(new ConfigOptionFloat(25));
 
+    def = this->add("tree_support_collision_backend", coEnum);
+    def->label = L("Collision calculation");
+    def->category = L("Support");
+    // TRN PrintSettings: "Organic supports" > "Collision calculation"
+    def->tooltip = L("How the areas the branches of organic tree support have to avoid around the model are calculated. "
+                     "Polygons offsets the model outlines by each of the branch radii. "
+                     "Distance field calculates the distance to the model outlines once per layer and derives the areas of all "
+                     "the branch radii from it, which is faster for complex models, at the cost of an accuracy of about 0.05 mm.");
+    def->enum_keys_map = &ConfigOptionEnum<TreeSupportCollisionBackend>::get_enum_values();
+    def->enum_values.push_back("polygons");
+    def->enum_values.push_back("distance_field");
+    def->enum_labels.push_back(L("Polygons"));
+    def->enum_labels.push_back(L("Distance field"));
+    def->mode = comDevelop;
+    def->set_default_value(new ConfigOptionEnum<TreeSupportCollisionBackend>(TreeSupportCollisionBackend::Polygons));
+
     def           = this->add("tree_support_branch_distance", coFloat);
     def->label    = L("Tree support branch distance");
     def->category = L("Support");
@@ -19,6 +19,7 @@
 #include "Fill/FillAdaptive.hpp"
 #include "Fill/FillLightning.hpp"
 #include "Format/STL.hpp"
+#include "GCode/SeamPlacer.hpp"
 #include "format.hpp"
 
 #include <float.h>
@@ -402,6 +403,8 @@ void PrintObject::prepare_infill()
     if (! this->set_started(posPrepareInfill))
         return;
     m_print->set_status(25, L("Generating infill regions"));
+    // The infill surfaces are generated anew, release the narrow solid infill classification of the previous run.
+    m_solid_surface_split_cache.clear();
     if (m_typed_slices) {
         // To improve robustness of detect_surfaces_type() when reslicing (working with typed slices), see GH issue #7442.
         // The preceding step (perimeter generator) only modifies extra_perimeters and the extra perimeters are only used by discover_vertical_shells()
@@ -558,6 +561,11 @@ void PrintObject::infill()
         );
         m_print->throw_if_canceled();
         BOOST_LOG_TRIVIAL(debug) << "Filling layers in parallel - end";
+        if (m_config.detect_narrow_internal_solid_infill) {
+            SolidSurfaceSplitCache::Stats stats = m_solid_surface_split_cache.stats();
+            BOOST_LOG_TRIVIAL(debug) << "Narrow solid infill classification cache: " << stats.hits << " hits, " << stats.misses << " misses, "
+                                     << stats.size << " surfaces, " << stats.points << " points";
+        }
         /*  we could free memory now, but this would make this step not idempotent
         ### $_->fill_surfaces->clear for map @{$_->regions}, @{$object->layers};
         */
@@ -632,6 +640,9 @@ void PrintObject::generate_support_material()
 {
     if (this->set_started(posSupportMaterial)) {
         this->clear_support_layers();
+        if (! this->has_support() || ! is_tree(m_config.support_type.value))
+            // Only used by the organic tree supports, release the memory once they are disabled.
+            m_tree_model_volumes.reset();
 
         if(!has_support() && !m_print->get_no_check_flag()) {
             // BBS: pop a warning if objects have significant amount of overhangs but support material is not enabled
@@ -783,9 +794,7 @@ std::pair<FillAdaptive::OctreePtr, FillAdaptive::OctreePtr> PrintObject::prepare
     for (size_t i = 1; i < overhangs.size(); ++ i)
         append(overhangs.front(), std::move(overhangs[i]));
 
-    return std::make_pair(
-        adaptive_line_spacing ? build_octree(mesh, overhangs.front(), adaptive_line_spacing, false) : OctreePtr(),
-        support_line_spacing  ? build_octree(mesh, overhangs.front(), support_line_spacing, true) : OctreePtr());
+    return build_octrees(mesh, overhangs.front(), adaptive_line_spacing, support_line_spacing);
 }
 
 FillLightning::GeneratorPtr PrintObject::prepare_lightning_infill_data()
@@ -1039,7 +1048,8 @@ bool PrintObject::invalidate_state_by_config_options(
             || opt_key == "tree_support_branch_angle"
             || opt_key == "tree_support_branch_angle_organic"
             || opt_key == "tree_support_angle_slow"
-            || opt_key == "tree_support_wall_count") {
+            || opt_key == "tree_support_wall_count"
+            || opt_key == "tree_support_collision_backend") {
             steps.emplace_back(posSupportMaterial);
         } else if (
                opt_key == "bottom_shell_layers"
@@ -1101,6 +1111,17 @@ bool PrintObject::invalidate_state_by_config_options(
             || opt_key == "lattice_angle_2"
             || opt_key == "infill_overhang_angle") {
             steps.emplace_back(posInfill);
+        } else if (
+               opt_key == "ironing_type"
+            || opt_key == "ironing_pattern"
+            || opt_key == "ironing_flow"
+            || opt_key == "ironing_spacing"
+            || opt_key == "ironing_inset"
+            || opt_key == "ironing_angle"
+            // Regions ironed with different speeds are not merged.
+            || opt_key == "ironing_speed") {
+            // Ironing is generated from the top surfaces classified by posPrepareInfill, it does not depend on the infill.
+            steps.emplace_back(posIroning);
         } else if (opt_key == "sparse_infill_pattern"
                    || opt_key == "symmetric_infill_y_axis"
                    || opt_key == "infill_shift_step"
@@ -1226,6 +1247,8 @@ bool PrintObject::invalidate_step(PrintObjectStep step)
     if (step == posPerimeters) {
 		invalidated |= this->invalidate_steps({ posPrepareInfill, posInfill, posIroning, posSimplifyPath, posSimplifyInfill });
         invalidated |= m_print->invalidate_steps({ psSkirtBrim });
+        // Seam candidates are sampled from the perimeters.
+        m_seam_candidates_visibility.clear();
     } else if (step == posPrepareInfill) {
         invalidated |= this->invalidate_steps({ posInfill, posIroning, posSimplifyPath, posSimplifyInfill });
     } else if (step == posInfill) {
@@ -1235,6 +1258,9 @@ bool PrintObject::invalidate_step(PrintObjectStep step)
 		invalidated |= this->invalidate_steps({ posPerimeters, posPrepareInfill, posInfill, posIroning, posSupportMaterial, posSimplifyPath, posSimplifyInfill });
         invalidated |= m_print->invalidate_steps({ psSkirtBrim });
         m_slicing_params.valid = false;
+        m_seam_candidates_visibility.clear();
+        // Tree support collisions and avoidances are calculated from the slices.
+        m_tree_model_volumes.reset();
     } else if (step == posSupportMaterial) {
         invalidated |= this->invalidate_steps({ posSimplifySupportPath });
         invalidated |= m_print->invalidate_steps({ psSkirtBrim });
@@ -1256,6 +1282,8 @@ bool PrintObject::invalidate_all_steps()
     bool result = Inherited::invalidate_all_steps() | m_print->invalidate_all_steps();
 	// Then reset some of the depending values.
 	m_slicing_params.valid = false;
+    m_seam_candidates_visibility.clear();
+    m_tree_model_volumes.reset();
 	return result;
 }
 
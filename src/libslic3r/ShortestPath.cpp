@@ -6,12 +6,16 @@
 
 #include "clipper.hpp"
 #include "ShortestPath.hpp"
+#include "ExtrusionEntityFlat.hpp"
 #include "KDTreeIndirect.hpp"
 #include "MutablePriorityQueue.hpp"
 #include "Print.hpp"
 
 #include <cmath>
 #include <cassert>
+#include <chrono>
+
+#include <tbb/parallel_for.h>
 
 namespace Slic3r {
 
@@ -998,11 +1002,129 @@ std::vector<std::pair<size_t, bool>> chain_segments_greedy2(SegmentEndPointFunc
 	return chain_segments_greedy_constrained_reversals2_<PointType, SegmentEndPointFunc, false, decltype(could_reverse_func)>(end_point_func, could_reverse_func, num_segments, start_near);
 }
 
+// Chaining of large inputs, which scales with the number of cores.
+// Segments are binned into a grid of tiles by the centers of their end points. Each tile is chained independently
+// by chain_func (one of the greedy algorithms above) and optionally improved by improve_func, the tiles are processed in parallel.
+// The tile chains are then stitched in a serpentine order of the tiles starting at the corner closest to start_near,
+// each tile chain is reversed if all its segments could reverse and if it shortens the connection to the previous tile.
+template<typename PointType, typename SegmentEndPointFunc, typename CouldReverseFunc, typename ChainFunc, typename ImproveFunc>
+std::vector<std::pair<size_t, bool>> chain_segments_tiled(SegmentEndPointFunc end_point_func, CouldReverseFunc could_reverse_func, size_t num_segments, const PointType *start_near,
+	size_t segments_per_tile, ChainFunc chain_func, ImproveFunc improve_func, size_t &num_tiles_out)
+{
+	assert(num_segments > 0);
+	auto segment_center = [&end_point_func](size_t idx) -> Vec2d {
+		return 0.5 * (end_point_func(idx, true).template cast<double>() + end_point_func(idx, false).template cast<double>());
+	};
+	Vec2d bbox_min = segment_center(0);
+	Vec2d bbox_max = bbox_min;
+	for (size_t i = 1; i < num_segments; ++ i) {
+		Vec2d c = segment_center(i);
+		bbox_min = bbox_min.cwiseMin(c);
+		bbox_max = bbox_max.cwiseMax(c);
+	}
+	Vec2d  size      = (bbox_max - bbox_min).cwiseMax(Vec2d(1., 1.));
+	size_t num_tiles = std::max<size_t>(1, num_segments / std::max<size_t>(1, segments_per_tile));
+	size_t cols      = std::clamp<size_t>(size_t(std::round(std::sqrt(double(num_tiles) * size.x() / size.y()))), 1, num_tiles);
+	size_t rows      = (num_tiles + cols - 1) / cols;
+	Vec2d  tile_size(size.x() / double(cols), size.y() / double(rows));
+
+	// Serpentine order of the tiles, starting at the corner closest to start_near.
+	bool flip_x = start_near != nullptr && double(start_near->x()) > 0.5 * (bbox_min.x() + bbox_max.x());
+	bool flip_y = start_near != nullptr && double(start_near->y()) > 0.5 * (bbox_min.y() + bbox_max.y());
+	std::vector<std::vector<size_t>> tiles(rows * cols);
+	for (size_t i = 0; i < num_segments; ++ i) {
+		Vec2d  c   = segment_center(i) - bbox_min;
+		size_t col = std::min(cols - 1, size_t(std::max(0., c.x() / tile_size.x())));
+		size_t row = std::min(rows - 1, size_t(std::max(0., c.y() / tile_size.y())));
+		if (flip_x)
+			col = cols - 1 - col;
+		if (flip_y)
+			row = rows - 1 - row;
+		if (row & 1)
+			col = cols - 1 - col;
+		tiles[row * cols + col].emplace_back(i);
+	}
+	size_t first_tile = std::find_if(tiles.begin(), tiles.end(), [](const std::vector<size_t> &tile) { return ! tile.empty(); }) - tiles.begin();
+	num_tiles_out = std::count_if(tiles.begin(), tiles.end(), [](const std::vector<size_t> &tile) { return ! tile.empty(); });
+
+	std::vector<std::vector<std::pair<size_t, bool>>> tile_chains(tiles.size());
+	tbb::parallel_for(tbb::blocked_range<size_t>(0, tiles.size(), 1),
+		[&tiles, &tile_chains, first_tile, start_near, &end_point_func, &could_reverse_func, &chain_func, &improve_func](const tbb::blocked_range<size_t> &range) {
+		for (size_t tile_idx = range.begin(); tile_idx < range.end(); ++ tile_idx) {
+			const std::vector<size_t> &tile = tiles[tile_idx];
+			if (tile.empty())
+				continue;
+			auto tile_end_point     = [&tile, &end_point_func](size_t idx, bool first_point) -> const PointType& { return end_point_func(tile[idx], first_point); };
+			auto tile_could_reverse = [&tile, &could_reverse_func](size_t idx) { return could_reverse_func(tile[idx]); };
+			const PointType *tile_start_near = tile_idx == first_tile ? start_near : nullptr;
+			std::vector<std::pair<size_t, bool>> chain = chain_func(tile_end_point, tile_could_reverse, tile.size(), tile_start_near);
+			if (tile_start_near == nullptr)
+				improve_func(chain, tile_end_point);
+			for (std::pair<size_t, bool> &segment : chain)
+				segment.first = tile[segment.first];
+			tile_chains[tile_idx] = std::move(chain);
+		}
+	});
+
+	// Stitch the tile chains.
+	std::vector<std::pair<size_t, bool>> out;
+	out.reserve(num_segments);
+	for (size_t tile_idx = first_tile; tile_idx < tile_chains.size(); ++ tile_idx) {
+		std::vector<std::pair<size_t, bool>> &chain = tile_chains[tile_idx];
+		if (chain.empty())
+			continue;
+		if (! out.empty() &&
+			std::all_of(chain.begin(), chain.end(), [&could_reverse_func](const std::pair<size_t, bool> &segment) { return could_reverse_func(segment.first); })) {
+			Vec2d last_pt  = end_point_func(out.back().first, out.back().second).template cast<double>();
+			Vec2d chain_first = end_point_func(chain.front().first, ! chain.front().second).template cast<double>();
+			Vec2d chain_last  = end_point_func(chain.back().first, chain.back().second).template cast<double>();
+			if ((chain_last - last_pt).squaredNorm() < (chain_first - last_pt).squaredNorm()) {
+				std::reverse(chain.begin(), chain.end());
+				for (std::pair<size_t, bool> &segment : chain)
+					segment.second = ! segment.second;
+			}
+		}
+		out.insert(out.end(), chain.begin(), chain.end());
+	}
+	assert(out.size() == num_segments);
+	return out;
+}
+
+// Length of travels between the chained segments, including the travel from start_near to the first segment.
+template<typename PointType, typename SegmentEndPointFunc>
+static double chain_travel_length(SegmentEndPointFunc end_point_func, const std::vector<std::pair<size_t, bool>> &chain, const PointType *start_near)
+{
+	double length = 0.;
+	for (size_t i = 0; i < chain.size(); ++ i) {
+		Vec2d first = end_point_func(chain[i].first, ! chain[i].second).template cast<double>();
+		if (i > 0)
+			length += (first - end_point_func(chain[i - 1].first, chain[i - 1].second).template cast<double>()).norm();
+		else if (start_near != nullptr)
+			length += (first - start_near->template cast<double>()).norm();
+	}
+	return length;
+}
+
 std::vector<std::pair<size_t, bool>> chain_extrusion_entities(std::vector<ExtrusionEntity*> &entities, const Point *start_near)
 {
+	return chain_extrusion_entities(entities, start_near, ChainingParams());
+}
+
+std::vector<std::pair<size_t, bool>> chain_extrusion_entities(std::vector<ExtrusionEntity*> &entities, const Point *start_near, const ChainingParams &params, ChainingStats *stats)
+{
+	auto time_start = std::chrono::steady_clock::now();
 	auto segment_end_point = [&entities](size_t idx, bool first_point) -> const Point& { return first_point ? entities[idx]->first_point() : entities[idx]->last_point(); };
 	auto could_reverse = [&entities](size_t idx) { const ExtrusionEntity *ee = entities[idx]; return ee->is_loop() || ee->can_reverse(); };
-	std::vector<std::pair<size_t, bool>> out = chain_segments_greedy_constrained_reversals<Point, decltype(segment_end_point), decltype(could_reverse)>(segment_end_point, could_reverse, entities.size(), start_near);
+	std::vector<std::pair<size_t, bool>> out;
+	size_t num_tiles = 1;
+	if (entities.size() >= std::max<size_t>(params.parallel_threshold, 2)) {
+		auto chain_func = [](auto &end_point_func, auto &could_reverse_func, size_t num_segments, const Point *start_near) {
+			return chain_segments_greedy_constrained_reversals<Point, decltype(end_point_func), decltype(could_reverse_func)>(end_point_func, could_reverse_func, num_segments, start_near);
+		};
+		auto improve_func = [](std::vector<std::pair<size_t, bool>> & /* chain */, auto & /* end_point_func */) {};
+		out = chain_segments_tiled<Point>(segment_end_point, could_reverse, entities.size(), start_near, params.segments_per_tile, chain_func, improve_func, num_tiles);
+	} else
+		out = chain_segments_greedy_constrained_reversals<Point, decltype(segment_end_point), decltype(could_reverse)>(segment_end_point, could_reverse, entities.size(), start_near);
 	for (std::pair<size_t, bool> &segment : out) {
 		ExtrusionEntity *ee = entities[segment.first];
 		if (ee->is_loop())
@@ -1011,6 +1133,34 @@ std::vector<std::pair<size_t, bool>> chain_extrusion_entities(std::vector<Extrus
 		// Is can_reverse() respected by the reversals?
 		assert(ee->can_reverse() || ! segment.second);
 	}
+	if (stats != nullptr) {
+		stats->travel_length = chain_travel_length(segment_end_point, out, start_near);
+		stats->num_tiles     = num_tiles;
+		stats->time_ms       = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - time_start).count();
+	}
+	return out;
+}
+
+std::vector<std::pair<size_t, bool>> chain_extrusion_entities(const ExtrusionEntityCollectionFlat &entities, const Point *start_near)
+{
+	// Empty collections are skipped as by chain_and_reorder_extrusion_entities().
+	std::vector<size_t> roots;
+	roots.reserve(entities.size());
+	for (size_t i = 0; i < entities.size(); ++ i)
+		if (const ExtrusionEntityCollectionFlat::Entity &e = entities.entity(entities.root(i)); e.begin < e.end)
+			roots.emplace_back(i);
+	auto segment_end_point = [&entities, &roots](size_t idx, bool first_point) -> const Point& {
+		size_t entity_idx = entities.root(roots[idx]);
+		return first_point ? entities.first_point(entity_idx) : entities.last_point(entity_idx);
+	};
+	auto could_reverse = [&entities, &roots](size_t idx) { size_t entity_idx = entities.root(roots[idx]); return entities.is_loop(entity_idx) || entities.can_reverse(entity_idx); };
+	std::vector<std::pair<size_t, bool>> out = chain_segments_greedy_constrained_reversals<Point, decltype(segment_end_point), decltype(could_reverse)>(segment_end_point, could_reverse, roots.size(), start_near);
+	for (std::pair<size_t, bool> &segment : out) {
+		if (entities.is_loop(entities.root(roots[segment.first])))
+			// Ignore reversals for loops, as the start point equals the end point.
+			segment.second = false;
+		segment.first = roots[segment.first];
+	}
 	return out;
 }
 
@@ -1551,7 +1701,8 @@ static inline void do_crossover(const std::vector<FlipEdge> &edges_in, std::vect
 // where n is the number of edges and k is the number of connection_lengths candidates after the first one
 // is found that improves the total cost.
 //FIXME there are likley better heuristics to lower the time complexity.
-static inline void reorder_by_two_exchanges_with_segment_flipping(std::vector<FlipEdge> &edges)
+// If deadline is set, the iterations stop once the deadline passes.
+static inline void reorder_by_two_exchanges_with_segment_flipping(std::vector<FlipEdge> &edges, const std::chrono::steady_clock::time_point *deadline = nullptr)
 {
 	if (edges.size() < 2)
 		return;
@@ -1562,6 +1713,8 @@ static inline void reorder_by_two_exchanges_with_segment_flipping(std::vector<Fl
 	std::vector<char>						connection_tried(edges.size(), false);
 	const size_t 							max_iterations = std::min(edges.size(), size_t(100));
 	for (size_t iter = 0; iter < max_iterations; ++ iter) {
+		if (deadline != nullptr && std::chrono::steady_clock::now() > *deadline)
+			break;
 		// Initialize connection costs and connection lengths.
 		for (size_t i = 1; i < edges.size(); ++ i) {
 			const FlipEdge   	 &e1 = edges[i - 1];
@@ -1579,6 +1732,8 @@ static inline void reorder_by_two_exchanges_with_segment_flipping(std::vector<Fl
 		size_t crossover2_pos_final = std::numeric_limits<size_t>::max();
 		size_t crossover_flip_final = 0;
         for (const std::pair<double, size_t>& first_crossover_candidate : connection_lengths) {
+			if (deadline != nullptr && std::chrono::steady_clock::now() > *deadline)
+				break;
             size_t longest_connection_idx = first_crossover_candidate.second;
 			connection_tried[longest_connection_idx] = true;
 			// Find the second crossover connection with the lowest total chain cost.
@@ -1880,7 +2035,7 @@ static inline void reorder_by_three_exchanges_with_segment_flipping2(std::vector
 // Flip the sequences of polylines to lower the total length of connecting lines.
 // Used by the infill generator if the infill is not connected with perimeter lines
 // and to order the brim lines.
-static inline void improve_ordering_by_two_exchanges_with_segment_flipping(Polylines &polylines, bool fixed_start)
+static inline void improve_ordering_by_two_exchanges_with_segment_flipping(Polylines &polylines, bool fixed_start, const std::chrono::steady_clock::time_point *deadline = nullptr)
 {
 #ifndef NDEBUG
 	auto cost = [&polylines]() {
@@ -1903,7 +2058,7 @@ static inline void improve_ordering_by_two_exchanges_with_segment_flipping(Polyl
     std::transform(polylines.begin(), polylines.end(), std::back_inserter(edges), 
     	[&polylines](const Polyline &pl){ return FlipEdge(pl.first_point().cast<double>(), pl.last_point().cast<double>(), &pl - polylines.data()); });
 #if 1
-	reorder_by_two_exchanges_with_segment_flipping(edges);
+	reorder_by_two_exchanges_with_segment_flipping(edges, deadline);
 #else
 	// reorder_by_three_exchanges_with_segment_flipping(edges);
 	reorder_by_three_exchanges_with_segment_flipping2(edges);
@@ -1932,8 +2087,32 @@ static inline void improve_ordering_by_two_exchanges_with_segment_flipping(Polyl
 #endif /* NDEBUG */
 }
 
+// Same as improve_ordering_by_two_exchanges_with_segment_flipping(), working on a chain of segments given by their end points.
+template<typename SegmentEndPointFunc>
+static void improve_chain_by_two_exchanges_with_segment_flipping(std::vector<std::pair<size_t, bool>> &chain, SegmentEndPointFunc end_point_func,
+	const std::chrono::steady_clock::time_point *deadline)
+{
+	if (chain.size() < 2)
+		return;
+	std::vector<FlipEdge> edges;
+	edges.reserve(chain.size());
+	for (const std::pair<size_t, bool> &segment : chain)
+		edges.emplace_back(end_point_func(segment.first, ! segment.second).template cast<double>(), end_point_func(segment.first, segment.second).template cast<double>(), segment.first);
+	reorder_by_two_exchanges_with_segment_flipping(edges, deadline);
+	for (size_t i = 0; i < edges.size(); ++ i) {
+		const FlipEdge &edge = edges[i];
+		// Reversed if the edge starts at the last point of the segment.
+		chain[i] = std::make_pair(edge.source_index, edge.p1 != end_point_func(edge.source_index, true).template cast<double>());
+	}
+}
+
 // Used to optimize order of infill lines and brim lines.
 Polylines chain_polylines(Polylines &&polylines, const Point *start_near)
+{
+	return chain_polylines(std::move(polylines), start_near, ChainingParams());
+}
+
+Polylines chain_polylines(Polylines &&polylines, const Point *start_near, const ChainingParams &params, ChainingStats *stats)
 {
 #ifdef DEBUG_SVG_OUTPUT
 	static int iRun = 0;
@@ -1941,21 +2120,48 @@ Polylines chain_polylines(Polylines &&polylines, const Point *start_near)
 	svg_draw_polyline_chain("chain_polylines-initial", iRun, polylines);
 #endif /* DEBUG_SVG_OUTPUT */
 
+	auto time_start = std::chrono::steady_clock::now();
+	auto deadline   = time_start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double, std::milli>(params.improve_time_budget_ms));
+	const std::chrono::steady_clock::time_point *improve_deadline = params.improve_time_budget_ms > 0. ? &deadline : nullptr;
 	Polylines out;
+	size_t    num_tiles = 1;
 	if (! polylines.empty()) {
 		auto segment_end_point = [&polylines](size_t idx, bool first_point) -> const Point& { return first_point ? polylines[idx].first_point() : polylines[idx].last_point(); };
-		std::vector<std::pair<size_t, bool>> ordered = chain_segments_greedy2<Point, decltype(segment_end_point)>(segment_end_point, polylines.size(), start_near);
+		std::vector<std::pair<size_t, bool>> ordered;
+		bool tiled = polylines.size() >= std::max<size_t>(params.parallel_threshold, 2);
+		if (tiled) {
+			auto could_reverse = [](size_t /* idx */) { return true; };
+			auto chain_func = [](auto &end_point_func, auto & /* could_reverse_func */, size_t num_segments, const Point *start_near) {
+				return chain_segments_greedy2<Point, decltype(end_point_func)>(end_point_func, num_segments, start_near);
+			};
+			auto improve_func = [&params, improve_deadline](std::vector<std::pair<size_t, bool>> &chain, auto &end_point_func) {
+				if (params.improve)
+					improve_chain_by_two_exchanges_with_segment_flipping(chain, end_point_func, improve_deadline);
+			};
+			ordered = chain_segments_tiled<Point>(segment_end_point, could_reverse, polylines.size(), start_near, params.segments_per_tile, chain_func, improve_func, num_tiles);
+		} else
+			ordered = chain_segments_greedy2<Point, decltype(segment_end_point)>(segment_end_point, polylines.size(), start_near);
 		out.reserve(polylines.size()); 
 		for (auto &segment_and_reversal : ordered) {
 			out.emplace_back(std::move(polylines[segment_and_reversal.first]));
 			if (segment_and_reversal.second)
 				out.back().reverse();
 		}
-		if (out.size() > 1 && start_near == nullptr) {
-			improve_ordering_by_two_exchanges_with_segment_flipping(out, start_near != nullptr);
+		if (! tiled && params.improve && out.size() > 1 && start_near == nullptr) {
+			improve_ordering_by_two_exchanges_with_segment_flipping(out, start_near != nullptr, improve_deadline);
 			//improve_ordering_by_segment_flipping(out, start_near != nullptr);
 		}
 	}
+	if (stats != nullptr) {
+		stats->travel_length = 0.;
+		for (size_t i = 0; i < out.size(); ++ i)
+			if (i > 0)
+				stats->travel_length += (out[i].first_point() - out[i - 1].last_point()).cast<double>().norm();
+			else if (start_near != nullptr)
+				stats->travel_length += (out[i].first_point() - *start_near).cast<double>().norm();
+		stats->num_tiles = num_tiles;
+		stats->time_ms   = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - time_start).count();
+	}
 
 #ifdef DEBUG_SVG_OUTPUT
 	svg_draw_polyline_chain("chain_polylines-final", iRun, out);
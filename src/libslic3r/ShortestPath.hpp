@@ -5,6 +5,7 @@
 #include "ExtrusionEntity.hpp"
 #include "Point.hpp"
 
+#include <limits>
 #include <utility>
 #include <vector>
 
@@ -15,18 +16,49 @@ namespace Slic3r {
 		using PolyNodes = std::vector<PolyNode*, PointsAllocator<PolyNode*>>;
 	}
 
+// Parameters of chaining of large inputs by chain_extrusion_entities() and chain_polylines().
+// Inputs with at least parallel_threshold segments are binned into spatial tiles of about segments_per_tile segments,
+// the tiles are chained in parallel by the greedy algorithm and the tile chains are stitched in a serpentine order.
+// The tiled chain differs from the serial one, thus tiling is off by default and it is enabled by the callers,
+// which were measured to benefit. The overloads without ChainingParams always chain serially.
+struct ChainingParams {
+    size_t parallel_threshold     { std::numeric_limits<size_t>::max() };
+    size_t segments_per_tile      { 2000 };
+    // Improve the chain by exchanging pairs of connections while flipping segments (2-opt).
+    // Only applied by chain_polylines() and only if the chain start is not fixed by start_near.
+    bool   improve                { true };
+    // Wall time budget of the improvement in milliseconds, zero for unlimited.
+    double improve_time_budget_ms { 0. };
+};
+
+// Filled in by chain_extrusion_entities() and chain_polylines() for comparison of the chaining strategies.
+struct ChainingStats {
+    // Sum of the travel lengths between the chained segments (and from start_near to the first segment), scaled.
+    double travel_length { 0. };
+    // Number of spatial tiles chained in parallel, 1 if chained by the serial greedy algorithm.
+    size_t num_tiles     { 0 };
+    // Wall time of the chaining in milliseconds.
+    double time_ms       { 0. };
+};
+
 std::vector<size_t> 				 chain_points(const Points &points, Point *start_near = nullptr);
 std::vector<size_t> 				 chain_expolygons(const ExPolygons &input_exploy);
 
 std::vector<std::pair<size_t, bool>> chain_extrusion_entities(std::vector<ExtrusionEntity*> &entities, const Point *start_near = nullptr);
+std::vector<std::pair<size_t, bool>> chain_extrusion_entities(std::vector<ExtrusionEntity*> &entities, const Point *start_near, const ChainingParams &params, ChainingStats *stats = nullptr);
 void                                 reorder_extrusion_entities(std::vector<ExtrusionEntity*> &entities, const std::vector<std::pair<size_t, bool>> &chain);
 void                                 chain_and_reorder_extrusion_entities(std::vector<ExtrusionEntity*> &entities, const Point *start_near = nullptr);
+// Chain the root entities of a flat collection the same way chain_extrusion_entities() chains the entities.
+// Returns pairs of the root index and whether to reverse the root entity, empty collections are left out.
+class ExtrusionEntityCollectionFlat;
+std::vector<std::pair<size_t, bool>> chain_extrusion_entities(const ExtrusionEntityCollectionFlat &entities, const Point *start_near = nullptr);
 
 std::vector<std::pair<size_t, bool>> chain_extrusion_paths(std::vector<ExtrusionPath> &extrusion_paths, const Point *start_near = nullptr);
 void                                 reorder_extrusion_paths(std::vector<ExtrusionPath> &extrusion_paths, std::vector<std::pair<size_t, bool>> &chain);
 void                                 chain_and_reorder_extrusion_paths(std::vector<ExtrusionPath> &extrusion_paths, const Point *start_near = nullptr);
 
 Polylines 							 chain_polylines(Polylines &&src, const Point *start_near = nullptr);
+Polylines 							 chain_polylines(Polylines &&src, const Point *start_near, const ChainingParams &params, ChainingStats *stats = nullptr);
 inline Polylines 					 chain_polylines(const Polylines& src, const Point* start_near = nullptr) { Polylines tmp(src); return chain_polylines(std::move(tmp), start_near); }
 template<typename T> inline void reorder_by_shortest_traverse(std::vector<T> &polylines_out)
 {
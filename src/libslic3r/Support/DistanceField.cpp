@@ -0,0 +1,331 @@
+#include "DistanceField.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Slic3r {
+namespace TreeSupport3D {
+
+DistanceField::DistanceField(const BoundingBox &bbox, coord_t pixel_size) : m_pixel_size(pixel_size)
+{
+    assert(bbox.defined);
+    assert(pixel_size > 0);
+    auto floor_div = [pixel_size](coord_t v) { return coord_t(std::floor(double(v) / double(pixel_size))); };
+    // Snap to the grid, with a border of one pixel all around, which contours() considers to be infinitely far.
+    const coord_t col_min = floor_div(bbox.min.x()) - 1;
+    const coord_t row_min = floor_div(bbox.min.y()) - 1;
+    const coord_t col_max = floor_div(bbox.max.x()) + 2;
+    const coord_t row_max = floor_div(bbox.max.y()) + 2;
+    m_origin = Point(col_min * pixel_size, row_min * pixel_size);
+    m_cols   = int(col_max - col_min + 1);
+    m_rows   = int(row_max - row_min + 1);
+    m_data.assign(size_t(m_rows) * size_t(m_cols), Infinity);
+}
+
+BoundingBox DistanceField::bounding_box() const
+{
+    return this->empty() ? BoundingBox() :
+        BoundingBox(m_origin, m_origin + Point(coord_t(m_cols - 1) * m_pixel_size, coord_t(m_rows - 1) * m_pixel_size));
+}
+
+float DistanceField::at(const Point &pt) const
+{
+    if (this->empty())
+        return Infinity;
+    const auto col = int(std::round(double(pt.x() - m_origin.x()) / double(m_pixel_size)));
+    const auto row = int(std::round(double(pt.y() - m_origin.y()) / double(m_pixel_size)));
+    return col < 0 || col >= m_cols || row < 0 || row >= m_rows ? Infinity : m_data[size_t(row) * m_cols + col];
+}
+
+// One dimensional squared Euclidean distance transform of a sampled function f, see
+// Felzenszwalb, Huttenlocher: Distance Transforms of Sampled Functions, Theory of Computing, 2012.
+// Samples of f equal to DistanceField::Infinity are ignored. If all samples are infinite, d is filled with infinity.
+// v and z are work buffers of at least n and n + 1 elements.
+static void distance_transform_1d(const float *f, int n, float *d, int *v, double *z)
+{
+    int k = -1;
+    for (int q = 0; q < n; ++ q) {
+        if (f[q] == DistanceField::Infinity)
+            continue;
+        if (k < 0) {
+            k    = 0;
+            v[0] = q;
+            z[0] = - std::numeric_limits<double>::max();
+            z[1] = std::numeric_limits<double>::max();
+            continue;
+        }
+        for (;;) {
+            // Intersection of the parabola rooted at q with the lowest parabola of the lower envelope.
+            const int    p = v[k];
+            const double s = ((double(f[q]) + double(q) * double(q)) - (double(f[p]) + double(p) * double(p))) / (2. * double(q - p));
+            if (s <= z[k]) {
+                // The lowest parabola is hidden below the new one. z[0] is minus infinity, thus k stays non-negative.
+                -- k;
+            } else {
+                ++ k;
+                v[k]     = q;
+                z[k]     = s;
+                z[k + 1] = std::numeric_limits<double>::max();
+                break;
+            }
+        }
+    }
+    if (k < 0) {
+        std::fill(d, d + n, DistanceField::Infinity);
+        return;
+    }
+    k = 0;
+    for (int q = 0; q < n; ++ q) {
+        while (z[k + 1] < double(q))
+            ++ k;
+        const double dq = double(q - v[k]);
+        d[q] = float(dq * dq + double(f[v[k]]));
+    }
+}
+
+void DistanceField::calculate(const Polygons &polygons)
+{
+    assert(! this->empty());
+    std::fill(m_data.begin(), m_data.end(), Infinity);
+
+    // Vertices in pixel coordinates, pixel centers being at integer coordinates.
+    const double inv_pixel_size = 1. / double(m_pixel_size);
+    auto to_pixels = [this, inv_pixel_size](const Point &pt) {
+        return Vec2d(double(pt.x() - m_origin.x()) * inv_pixel_size, double(pt.y() - m_origin.y()) * inv_pixel_size);
+    };
+
+    // 1) Fill the pixels with centers inside the polygons, scanning rows through the pixel centers.
+    std::vector<std::vector<double>> intersections(m_rows);
+    for (const Polygon &polygon : polygons)
+        for (size_t i = 0; i < polygon.size(); ++ i) {
+            const Vec2d a = to_pixels(polygon.points[i]);
+            const Vec2d b = to_pixels(polygon.points[i + 1 == polygon.size() ? 0 : i + 1]);
+            if (a.y() == b.y())
+                continue;
+            // Rows with centers in <ymin, ymax).
+            const int row_begin = std::max(0,      int(std::ceil(std::min(a.y(), b.y()))));
+            const int row_end   = std::min(m_rows, int(std::ceil(std::max(a.y(), b.y()))));
+            const double dxdy   = (b.x() - a.x()) / (b.y() - a.y());
+            for (int row = row_begin; row < row_end; ++ row)
+                intersections[row].emplace_back(a.x() + (double(row) - a.y()) * dxdy);
+        }
+    for (int row = 0; row < m_rows; ++ row) {
+        std::vector<double> &xs = intersections[row];
+        assert(xs.size() % 2 == 0);
+        std::sort(xs.begin(), xs.end());
+        float *data = m_data.data() + size_t(row) * m_cols;
+        for (size_t i = 0; i + 1 < xs.size(); i += 2) {
+            const int col_begin = std::max(0,      int(std::ceil(xs[i])));
+            const int col_end   = std::min(m_cols, int(std::floor(xs[i + 1])) + 1);
+            if (col_begin < col_end)
+                std::fill(data + col_begin, data + col_end, 0.f);
+        }
+    }
+
+    // 2) Mark the pixels crossed by the edges, so that features thinner than a pixel are not lost.
+    for (const Polygon &polygon : polygons)
+        for (size_t i = 0; i < polygon.size(); ++ i) {
+            const Vec2d a     = to_pixels(polygon.points[i]);
+            const Vec2d b     = to_pixels(polygon.points[i + 1 == polygon.size() ? 0 : i + 1]);
+            // Sample the edge twice per pixel.
+            const int   steps = std::max(1, int(std::ceil(2. * (b - a).norm())));
+            for (int step = 0; step <= steps; ++ step) {
+                const Vec2d p   = a + (b - a) * (double(step) / double(steps));
+                const int   col = int(std::round(p.x()));
+                const int   row = int(std::round(p.y()));
+                if (col >= 0 && col < m_cols && row >= 0 && row < m_rows)
+                    m_data[size_t(row) * m_cols + col] = 0.f;
+            }
+        }
+
+    // 3) Distance transform of the columns, then squared distance transform of the rows.
+    // The columns are binary, thus the distance to the closest zero pixel of a column is calculated by sweeping the rows up and down,
+    // which accesses the rows sequentially.
+    for (int row = 1; row < m_rows; ++ row) {
+        const float *below = m_data.data() + size_t(row - 1) * m_cols;
+        float       *data  = m_data.data() + size_t(row) * m_cols;
+        for (int col = 0; col < m_cols; ++ col)
+            if (data[col] != 0.f && below[col] != Infinity)
+                data[col] = below[col] + 1.f;
+    }
+    for (int row = m_rows - 2; row >= 0; -- row) {
+        const float *above = m_data.data() + size_t(row + 1) * m_cols;
+        float       *data  = m_data.data() + size_t(row) * m_cols;
+        for (int col = 0; col < m_cols; ++ col)
+            if (above[col] != Infinity)
+                data[col] = std::min(data[col], above[col] + 1.f);
+    }
+    std::vector<float>  f(m_cols);
+    std::vector<int>    v(m_cols);
+    std::vector<double> z(m_cols + 1);
+    for (int row = 0; row < m_rows; ++ row) {
+        float *data = m_data.data() + size_t(row) * m_cols;
+        for (int col = 0; col < m_cols; ++ col)
+            f[col] = data[col] == Infinity ? Infinity : data[col] * data[col];
+        distance_transform_1d(f.data(), m_cols, data, v.data(), z.data());
+        for (int col = 0; col < m_cols; ++ col)
+            if (data[col] != Infinity)
+                data[col] = float(std::sqrt(double(data[col])) * double(m_pixel_size));
+    }
+}
+
+void DistanceField::min(const DistanceField &rhs, float offset)
+{
+    assert(rhs.m_pixel_size == m_pixel_size);
+    if (this->empty() || rhs.empty())
+        return;
+    assert((rhs.m_origin.x() - m_origin.x()) % m_pixel_size == 0);
+    assert((rhs.m_origin.y() - m_origin.y()) % m_pixel_size == 0);
+    // Position of the rhs pixel (0, 0) in this field.
+    const int dcol      = int((rhs.m_origin.x() - m_origin.x()) / m_pixel_size);
+    const int drow      = int((rhs.m_origin.y() - m_origin.y()) / m_pixel_size);
+    const int col_begin = std::max(0, dcol);
+    const int col_end   = std::min(m_cols, dcol + rhs.m_cols);
+    const int row_begin = std::max(0, drow);
+    const int row_end   = std::min(m_rows, drow + rhs.m_rows);
+    for (int row = row_begin; row < row_end; ++ row) {
+        float       *dst = m_data.data() + size_t(row) * m_cols;
+        const float *src = rhs.m_data.data() + size_t(row - drow) * rhs.m_cols - dcol;
+        for (int col = col_begin; col < col_end; ++ col)
+            if (src[col] != Infinity)
+                dst[col] = std::min(dst[col], src[col] - offset);
+    }
+}
+
+std::vector<Polygons> DistanceField::contours(const std::vector<float> &levels) const
+{
+    assert(std::is_sorted(levels.begin(), levels.end()));
+    std::vector<Polygons> out(levels.size());
+    if (levels.empty() || this->empty())
+        return out;
+
+    // Marching squares over the cells spanned by the pixel centers. A contour segment is emitted for each cell crossing a level,
+    // oriented with the region inside on its left, starting at the point where the contour crosses one edge of the cell.
+    // A segment is linked with its successor through the edge it ends at, which is shared with the neighbor cell.
+    // The cells are processed row by row, thus the segments crossing the top and right edges of a cell are remembered
+    // until the cell above and the cell to the right look them up at their bottom and left edges.
+    struct LevelContours {
+        std::vector<Point>  points;
+        std::vector<int>    next;
+        // Segment crossing the top edge of the cell of a column in the previous row.
+        std::vector<int>    top_edge;
+        // Segment crossing the right edge of the previous cell in this row.
+        int                 right_edge { -1 };
+    };
+    std::vector<LevelContours> level_contours(levels.size());
+    for (LevelContours &lc : level_contours)
+        lc.top_edge.assign(m_cols, -1);
+
+    // The border pixels are considered infinitely far, so that all the contours are closed.
+    auto value = [this](int row, int col) {
+        return row == 0 || col == 0 || row + 1 == m_rows || col + 1 == m_cols ? Infinity : m_data[size_t(row) * m_cols + col];
+    };
+    const float level_min = levels.front();
+    const float level_max = levels.back();
+    for (int row = 0; row + 1 < m_rows; ++ row)
+        for (int col = 0; col + 1 < m_cols; ++ col) {
+            // Corners counter-clockwise, starting with the lower left one.
+            float vals[4];
+            if (row == 0 || col == 0 || row + 2 >= m_rows || col + 2 >= m_cols) {
+                vals[0] = value(row, col);
+                vals[1] = value(row, col + 1);
+                vals[2] = value(row + 1, col + 1);
+                vals[3] = value(row + 1, col);
+            } else {
+                const float *below = m_data.data() + size_t(row) * m_cols + col;
+                const float *above = below + m_cols;
+                vals[0] = below[0];
+                vals[1] = below[1];
+                vals[2] = above[1];
+                vals[3] = above[0];
+            }
+            const float vmin = std::min(std::min(vals[0], vals[1]), std::min(vals[2], vals[3]));
+            const float vmax = std::max(std::max(vals[0], vals[1]), std::max(vals[2], vals[3]));
+            if (vmax <= level_min || vmin > level_max)
+                // Inside or outside of all the levels.
+                continue;
+            // Levels with some corners inside (value <= level) and some outside.
+            for (auto it_level = std::lower_bound(levels.begin(), levels.end(), vmin); it_level != levels.end() && *it_level < vmax; ++ it_level) {
+                const float    level     = *it_level;
+                LevelContours &lc        = level_contours[it_level - levels.begin()];
+                const bool     inside[4] = { vals[0] <= level, vals[1] <= level, vals[2] <= level, vals[3] <= level };
+                // Edge i connects corner i with corner i + 1: bottom, right, top, left.
+                auto edge_point = [this, row, col, &vals, level](int edge) -> Point {
+                    static constexpr const int corners[5][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 }, { 0, 0 } };
+                    const float  va = vals[edge];
+                    const float  vb = vals[(edge + 1) % 4];
+                    const double t  = std::clamp(double(level - va) / double(vb - va), 0., 1.);
+                    const double x  = double(corners[edge][0]) + t * double(corners[edge + 1][0] - corners[edge][0]);
+                    const double y  = double(corners[edge][1]) + t * double(corners[edge + 1][1] - corners[edge][1]);
+                    return m_origin + Point(coord_t(std::round((double(col) + x) * double(m_pixel_size))),
+                                            coord_t(std::round((double(row) + y) * double(m_pixel_size))));
+                };
+                // Segments crossing the bottom and left edges, looked up before the segments of this cell replace them.
+                const int bottom_segment = lc.top_edge[col];
+                const int left_segment   = lc.right_edge;
+                auto emit = [&lc, &edge_point, bottom_segment, left_segment, col](int edge_from, int edge_to) {
+                    const int segment = int(lc.points.size());
+                    lc.points.emplace_back(edge_point(edge_from));
+                    lc.next.emplace_back(-1);
+                    switch (edge_from) {
+                    case 0:  assert(bottom_segment != -1); lc.next[bottom_segment] = segment; break;
+                    case 1:  lc.right_edge = segment; break;
+                    case 2:  lc.top_edge[col] = segment; break;
+                    default: assert(left_segment != -1); lc.next[left_segment] = segment; break;
+                    }
+                    switch (edge_to) {
+                    case 0:  assert(bottom_segment != -1); lc.next[segment] = bottom_segment; break;
+                    case 1:  lc.right_edge = segment; break;
+                    case 2:  lc.top_edge[col] = segment; break;
+                    default: assert(left_segment != -1); lc.next[segment] = left_segment; break;
+                    }
+                };
+                if (inside[0] == inside[2] && inside[1] == inside[3]) {
+                    // Saddle, resolved by the value at the cell center.
+                    assert(inside[0] != inside[1]);
+                    const bool center_inside = 0.25 * (double(vals[0]) + double(vals[1]) + double(vals[2]) + double(vals[3])) <= double(level);
+                    for (int corner = 0; corner < 4; ++ corner)
+                        if (inside[corner] == center_inside) {
+                            // Connected: cut off the outside corners. Separated: wrap the inside corners.
+                        } else if (center_inside)
+                            emit((corner + 3) % 4, corner);
+                        else
+                            emit(corner, (corner + 3) % 4);
+                } else {
+                    // Start at the edge leaving the inside region, end at the edge entering it, walking the corners counter-clockwise.
+                    int edge_from = -1;
+                    int edge_to   = -1;
+                    for (int corner = 0; corner < 4; ++ corner) {
+                        const int next = (corner + 1) % 4;
+                        if (inside[corner] && ! inside[next])
+                            edge_from = corner;
+                        else if (! inside[corner] && inside[next])
+                            edge_to = corner;
+                    }
+                    assert(edge_from != -1 && edge_to != -1);
+                    emit(edge_from, edge_to);
+                }
+            }
+        }
+
+    // Chain the segments into closed contours.
+    for (size_t level_idx = 0; level_idx < levels.size(); ++ level_idx) {
+        LevelContours &lc       = level_contours[level_idx];
+        Polygons      &polygons = out[level_idx];
+        std::vector<bool> visited(lc.points.size(), false);
+        for (size_t i = 0; i < lc.points.size(); ++ i)
+            if (! visited[i]) {
+                Polygon polygon;
+                for (int j = int(i); j != -1 && ! visited[j]; j = lc.next[j]) {
+                    visited[j] = true;
+                    polygon.points.emplace_back(lc.points[j]);
+                }
+                if (polygon.size() >= 3)
+                    polygons.emplace_back(std::move(polygon));
+            }
+    }
+    return out;
+}
+
+} // namespace TreeSupport3D
+} // namespace Slic3r
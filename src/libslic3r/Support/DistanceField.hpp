@@ -0,0 +1,57 @@
+#ifndef slic3r_DistanceField_hpp_
+#define slic3r_DistanceField_hpp_
+
+#include "../libslic3r.h"
+#include "../BoundingBox.hpp"
+#include "../Polygon.hpp"
+
+#include <limits>
+#include <vector>
+
+namespace Slic3r {
+namespace TreeSupport3D {
+
+// Euclidean distance to a set of polygons sampled at the centers of the pixels of a regular grid, zero inside the polygons.
+// Used by the distance field collision backend of the organic tree supports: Once the distance field of a layer is known,
+// the offset of the layer by any radius is just a threshold of the field, extracted as polygons by marching squares.
+// Fields with the same pixel size are aligned to the same grid, thus they may be combined pixel by pixel.
+// The distances are exact to the pixel centers of the rasterized polygons, thus they are accurate to about half a pixel.
+class DistanceField
+{
+public:
+    DistanceField() = default;
+    // Field covering bbox, all the distances are infinite.
+    DistanceField(const BoundingBox &bbox, coord_t pixel_size);
+
+    // Distance of the pixel centers to polygons, zero inside the polygons (even-odd fill rule)
+    // and in the pixels crossed by the polygon edges, so that thin features are not lost.
+    void                    calculate(const Polygons &polygons);
+    // this = min(this, rhs - offset) over the pixels of both fields. Both fields need to have the same pixel size.
+    void                    min(const DistanceField &rhs, float offset);
+    // Contours of the regions closer than or equal to each of the levels, levels sorted in ascending order.
+    // Contours are counter-clockwise, holes clockwise. The regions have to stay inside the field.
+    std::vector<Polygons>   contours(const std::vector<float> &levels) const;
+
+    bool                    empty()         const { return m_data.empty(); }
+    coord_t                 pixel_size()    const { return m_pixel_size; }
+    // Bounding box of the pixel centers.
+    BoundingBox             bounding_box()  const;
+    // Distance at the pixel center closest to pt, infinite outside of the field.
+    float                   at(const Point &pt) const;
+
+    static constexpr const float Infinity = std::numeric_limits<float>::max();
+
+private:
+    // Center of pixel (0, 0). Pixel (row, col) is centered at m_origin + (col, row) * m_pixel_size.
+    Point                   m_origin        { Point::Zero() };
+    coord_t                 m_pixel_size    { 0 };
+    int                     m_rows          { 0 };
+    int                     m_cols          { 0 };
+    // Row major, row index increasing with y.
+    std::vector<float>      m_data;
+};
+
+} // namespace TreeSupport3D
+} // namespace Slic3r
+
+#endif // slic3r_DistanceField_hpp_
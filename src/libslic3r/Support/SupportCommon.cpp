@@ -16,6 +16,7 @@
 #include <tbb/parallel_for.h>
 
 #include "SupportCommon.hpp"
+#include "SupportFillCache.hpp"
 #include "SupportLayer.hpp"
 #include "SupportParameters.hpp"
 
@@ -484,13 +485,14 @@ static inline void fill_expolygon_generate_paths(
     const FillParams        &fill_params,
     float                    density,
     ExtrusionRole            role,
-    const Flow              &flow)
+    const Flow              &flow,
+    SupportFillCache        *fill_cache)
 {
     Surface surface(stInternal, std::move(expolygon));
     Polylines polylines;
     try {
         assert(!fill_params.use_arachne);
-        polylines = filler->fill_surface(&surface, fill_params);
+        polylines = fill_surface_cached(fill_cache, filler, surface, fill_params);
     } catch (InfillFailedException &) {
     }
     extrusion_entities_append_paths(
@@ -507,10 +509,11 @@ static inline void fill_expolygons_generate_paths(
     const FillParams        &fill_params,
     float                    density,
     ExtrusionRole            role,
-    const Flow              &flow)
+    const Flow              &flow,
+    SupportFillCache        *fill_cache = nullptr)
 {
     for (ExPolygon &expoly : expolygons)
-        fill_expolygon_generate_paths(dst, std::move(expoly), filler, fill_params, density, role, flow);
+        fill_expolygon_generate_paths(dst, std::move(expoly), filler, fill_params, density, role, flow, fill_cache);
 }
 
 static inline void fill_expolygons_generate_paths(
@@ -519,12 +522,13 @@ static inline void fill_expolygons_generate_paths(
     Fill                    *filler,
     float                    density,
     ExtrusionRole            role,
-    const Flow              &flow)
+    const Flow              &flow,
+    SupportFillCache        *fill_cache = nullptr)
 {
     FillParams fill_params;
     fill_params.density     = density;
     fill_params.dont_adjust = true;
-    fill_expolygons_generate_paths(dst, std::move(expolygons), filler, fill_params, density, role, flow);
+    fill_expolygons_generate_paths(dst, std::move(expolygons), filler, fill_params, density, role, flow, fill_cache);
 }
 
 static Polylines draw_perimeters(const ExPolygon &expoly, double clip_length)
@@ -782,7 +786,8 @@ void fill_expolygons_with_sheath_generate_paths(
     const Flow              &flow,
     const SupportParameters& support_params,
     bool                     with_sheath,
-    bool                     no_sort)
+    bool                     no_sort,
+    SupportFillCache        *fill_cache)
 {
     if (polygons.empty())
         return;
@@ -794,7 +799,7 @@ void fill_expolygons_with_sheath_generate_paths(
         }
     }
     else {
-        fill_expolygons_generate_paths(dst, closing_ex(polygons, float(SCALED_EPSILON)), filler, density, role, flow);
+        fill_expolygons_generate_paths(dst, closing_ex(polygons, float(SCALED_EPSILON)), filler, density, role, flow, fill_cache);
         return;
     }
 
@@ -816,7 +821,7 @@ void fill_expolygons_with_sheath_generate_paths(
         ExtrusionEntitiesPtr &out = no_sort ? eec->entities : dst;
         extrusion_entities_append_paths(out, draw_perimeters(expoly, clip_length), ExtrusionRole::erSupportMaterial, flow.mm3_per_mm(), flow.width(), flow.height());
         // Fill in the rest.
-        fill_expolygons_generate_paths(out, offset_ex(expoly, float(-0.4 * spacing)), filler, fill_params, density, role, flow);
+        fill_expolygons_generate_paths(out, offset_ex(expoly, float(-0.4 * spacing)), filler, fill_params, density, role, flow, fill_cache);
         if (no_sort && ! eec->empty())
             dst.emplace_back(eec.release());
     }
@@ -1501,6 +1506,9 @@ void generate_support_toolpaths(
 
     BoundingBox bbox_object(Point(-scale_(1.), -scale_(1.0)), Point(scale_(1.), scale_(1.)));
 
+    // Rafts and the trunks of the supports produce the same support areas layer after layer, fill them once.
+    SupportFillCache fill_cache;
+
 //    const coordf_t link_max_length_factor = 3.;
     const coordf_t link_max_length_factor = 0.;
 
@@ -1509,7 +1517,7 @@ void generate_support_toolpaths(
 
     tbb::parallel_for(tbb::blocked_range<size_t>(0, n_raft_layers),
         [&support_layers, &raft_layers, &intermediate_layers, &config, &support_params, &slicing_params,
-            &bbox_object, link_max_length_factor]
+            &bbox_object, &fill_cache, link_max_length_factor]
             (const tbb::blocked_range<size_t>& range) {
         for (size_t support_layer_id = range.begin(); support_layer_id < range.end(); ++ support_layer_id)
         {
@@ -1553,7 +1561,7 @@ void generate_support_toolpaths(
                         filler, float(support_params.support_density),
                         // Extrusion parameters
                         ExtrusionRole::erSupportMaterial, flow,
-                        support_params, support_params.with_sheath, false);
+                        support_params, support_params.with_sheath, false, &fill_cache);
                 }
                 if (! tree_polygons.empty())
                     tree_supports_generate_paths(support_layer.support_fills.entities, tree_polygons, flow, support_params);
@@ -1588,7 +1596,7 @@ void generate_support_toolpaths(
                 // Extrusion parameters
                 (support_layer_id < slicing_params.base_raft_layers) ? ExtrusionRole::erSupportMaterial : ExtrusionRole::erSupportMaterialInterface, flow,
                 // sheath at first layer
-                support_params, support_layer_id == 0, support_layer_id == 0);
+                support_params, support_layer_id == 0, support_layer_id == 0, &fill_cache);
         }
     });
 
@@ -1620,7 +1628,7 @@ void generate_support_toolpaths(
 
     tbb::parallel_for(tbb::blocked_range<size_t>(n_raft_layers, support_layers.size()),
         [&config, &slicing_params, &support_params, &support_layers, &bottom_contacts, &top_contacts, &intermediate_layers, &interface_layers, &base_interface_layers, &layer_caches, &loop_interface_processor,
-            &bbox_object, &angles, n_raft_layers, link_max_length_factor]
+            &bbox_object, &angles, &fill_cache, n_raft_layers, link_max_length_factor]
             (const tbb::blocked_range<size_t>& range) {
         // Indices of the 1st layer in their respective container at the support layer height.
         size_t idx_layer_bottom_contact   = size_t(-1);
@@ -1765,7 +1773,7 @@ void generate_support_toolpaths(
                         // Filler and its parameters
                         filler, float(density),
                         // Extrusion parameters
-                        interface_as_base ? ExtrusionRole::erSupportMaterial : ExtrusionRole::erSupportMaterialInterface, interface_flow);
+                        interface_as_base ? ExtrusionRole::erSupportMaterial : ExtrusionRole::erSupportMaterialInterface, interface_flow, &fill_cache);
                 }
             };
             const bool top_interfaces = config.support_interface_top_layers.value != 0;
@@ -1793,7 +1801,7 @@ void generate_support_toolpaths(
                     // Filler and its parameters
                     filler, float(support_params.interface_density),
                     // Extrusion parameters
-                    ExtrusionRole::erSupportMaterial, interface_flow);
+                    ExtrusionRole::erSupportMaterial, interface_flow, &fill_cache);
             }
 
             // Base support or flange.
@@ -1841,7 +1849,7 @@ void generate_support_toolpaths(
                         filler, density,
                         // Extrusion parameters
                         ExtrusionRole::erSupportMaterial, flow,
-                        support_params, sheath, no_sort);
+                        support_params, sheath, no_sort, &fill_cache);
             }
 
             // Merge base_interface_layers to base_layers to avoid unneccessary retractions
@@ -1895,7 +1903,7 @@ void generate_support_toolpaths(
 
     // Now modulate the support layer height in parallel.
     tbb::parallel_for(tbb::blocked_range<size_t>(n_raft_layers, support_layers.size()),
-        [&support_layers, &layer_caches, &support_params, &bbox_object]
+        [&support_layers, &layer_caches, &support_params, &bbox_object, &fill_cache]
             (const tbb::blocked_range<size_t>& range) {
         for (size_t support_layer_id = range.begin(); support_layer_id < range.end(); ++ support_layer_id) {
             SupportLayer &support_layer = *support_layers[support_layer_id];
@@ -1937,11 +1945,16 @@ void generate_support_toolpaths(
                     // Filler and its parameters
                     f.get(), 1.f,
                     // Extrusion parameters
-                    ExtrusionRole::erIroning, support_params.ironing_flow);
+                    ExtrusionRole::erIroning, support_params.ironing_flow, &fill_cache);
             }
         }
     });
 
+    {
+        SupportFillCache::Stats stats = fill_cache.stats();
+        BOOST_LOG_TRIVIAL(debug) << "Support infill cache: " << stats.hits << " hits, " << stats.misses << " misses";
+    }
+
 #ifndef NDEBUG
     struct Test {
         static bool verify_nonempty(const ExtrusionEntityCollection *collection) {
@@ -2066,4 +2079,16 @@ sub clip_with_shape {
 }
 */
 
+static std::atomic<SupportPhaseTimes*> s_support_phase_times { nullptr };
+
+void set_support_phase_times(SupportPhaseTimes *times)
+{
+    s_support_phase_times = times;
+}
+
+SupportPhaseTimes* support_phase_times()
+{
+    return s_support_phase_times;
+}
+
 } // namespace Slic3r
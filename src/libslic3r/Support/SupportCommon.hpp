@@ -7,10 +7,14 @@
 #include "SupportLayer.hpp"
 #include "SupportParameters.hpp"
 
+#include <atomic>
+#include <chrono>
+
 namespace Slic3r {
 
 class PrintObject;
 class SupportLayer;
+class SupportFillCache;
 
 // Remove bridges from support contact areas.
 // To be called if PrintObjectConfig::dont_support_bridges.
@@ -53,7 +57,8 @@ SupportGeneratorLayersPtr generate_raft_base(
 void tree_supports_generate_paths(ExtrusionEntitiesPtr &dst, const Polygons &polygons, const Flow &flow, const SupportParameters &support_params);
 
 void fill_expolygons_with_sheath_generate_paths(
-    ExtrusionEntitiesPtr &dst, const Polygons &polygons, Fill *filler, float density, ExtrusionRole role, const Flow &flow, const SupportParameters& support_params, bool with_sheath, bool no_sort);
+    ExtrusionEntitiesPtr &dst, const Polygons &polygons, Fill *filler, float density, ExtrusionRole role, const Flow &flow, const SupportParameters& support_params, bool with_sheath, bool no_sort,
+    SupportFillCache *fill_cache = nullptr);
 
 // returns sorted layers
 SupportGeneratorLayersPtr generate_support_layers(
@@ -79,6 +84,54 @@ void generate_support_toolpaths(
 	const SupportGeneratorLayersPtr   	&interface_layers,
     const SupportGeneratorLayersPtr   	&base_interface_layers);
 
+// Phases of the support generation, timed by the support generation benchmark.
+enum class SupportPhase {
+    // Overhang detection and placement of the support contacts.
+    ContactDetection,
+    // Collision and avoidance areas of the tree supports.
+    Avoidance,
+    // Propagation of the tree branches downwards, base layers of the normal supports.
+    Drop,
+    // Support areas of the branches, interface and raft layers.
+    Draw,
+    // Extrusions of the support layers.
+    Toolpaths,
+    Count
+};
+
+// Wall time spent in the phases of the support generation, accumulated over the print objects while installed.
+struct SupportPhaseTimes
+{
+    SupportPhaseTimes() { this->clear(); }
+    void   clear() { for (std::atomic<int64_t> &t : nanoseconds) t = 0; }
+    double milliseconds(SupportPhase phase) const { return 1e-6 * double(nanoseconds[size_t(phase)]); }
+
+    std::atomic<int64_t> nanoseconds[size_t(SupportPhase::Count)];
+};
+
+// Install the recorder of the support generation phases, nullptr to remove it. None is installed by default.
+void set_support_phase_times(SupportPhaseTimes *times);
+SupportPhaseTimes* support_phase_times();
+
+// Adds its life time to a phase of the installed recorder, no-op if there is none.
+class SupportPhaseTimer
+{
+public:
+    explicit SupportPhaseTimer(SupportPhase phase) : m_phase(phase), m_times(support_phase_times()) {
+        if (m_times)
+            m_start = std::chrono::steady_clock::now();
+    }
+    ~SupportPhaseTimer() {
+        if (m_times)
+            m_times->nanoseconds[size_t(m_phase)] += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count();
+    }
+
+private:
+    SupportPhase                          m_phase;
+    SupportPhaseTimes                    *m_times;
+    std::chrono::steady_clock::time_point m_start;
+};
+
 // FN_HIGHER_EQUAL: the provided object pointer has a Z value >= of an internal threshold.
 // Find the first item with Z value >= of an internal threshold of fn_higher_equal.
 // If no vec item with Z value >= of an internal threshold of fn_higher_equal is found, return vec.size()
@@ -0,0 +1,179 @@
+#include "SupportFillCache.hpp"
+
+#include "../Surface.hpp"
+#include "../Fill/FillBase.hpp"
+#include "../Fill/FillRectilinear.hpp"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <typeindex>
+#include <unordered_map>
+
+#include <boost/functional/hash.hpp>
+
+namespace Slic3r {
+
+namespace {
+
+// Parameters of the fill, which the rectilinear fills depend on. The layer index itself is not a part of the key,
+// Fill::_infill_direction() only adds the layer angle, derived from rotate_angle, to the angle if the layer index is set.
+struct Key {
+    std::type_index filler;
+    float           angle;
+    float           rotate_angle;
+    bool            has_layer_id;
+    coordf_t        spacing;
+    coordf_t        overlap;
+    coord_t         link_max_length;
+    BoundingBox     bounding_box;
+    float           density;
+    float           anchor_length;
+    float           anchor_length_max;
+    int             multiline;
+    bool            monotonic;
+    bool            dont_sort;
+    InfillPattern   pattern;
+    float           horiz_move;
+    bool            symmetric_infill_y_axis;
+    coord_t         symmetric_y_axis;
+    double          bridge_angle;
+    // Geometry of the surface, compared exactly on hash match.
+    ExPolygon       expolygon;
+    // Hash of all of the above.
+    size_t          hash { 0 };
+
+    Key(const Fill &filler, const Surface &surface, const FillParams &params) :
+        filler(typeid(filler)), angle(filler.angle), rotate_angle(filler.rotate_angle), has_layer_id(filler.layer_id != size_t(-1)), spacing(filler.spacing), overlap(filler.overlap), link_max_length(filler.link_max_length),
+        bounding_box(filler.bounding_box), density(params.density), anchor_length(params.anchor_length), anchor_length_max(params.anchor_length_max),
+        multiline(params.multiline), monotonic(params.monotonic), dont_sort(params.dont_sort), pattern(params.pattern),
+        horiz_move(params.horiz_move), symmetric_infill_y_axis(params.symmetric_infill_y_axis), symmetric_y_axis(params.symmetric_y_axis), bridge_angle(surface.bridge_angle), expolygon(surface.expolygon)
+    {
+        size_t seed = this->filler.hash_code();
+        boost::hash_combine(seed, this->angle);
+        boost::hash_combine(seed, this->rotate_angle);
+        boost::hash_combine(seed, this->has_layer_id);
+        boost::hash_combine(seed, this->spacing);
+        boost::hash_combine(seed, this->overlap);
+        boost::hash_combine(seed, this->link_max_length);
+        boost::hash_combine(seed, this->bounding_box.min.x());
+        boost::hash_combine(seed, this->bounding_box.min.y());
+        boost::hash_combine(seed, this->bounding_box.max.x());
+        boost::hash_combine(seed, this->bounding_box.max.y());
+        boost::hash_combine(seed, this->density);
+        boost::hash_combine(seed, this->anchor_length);
+        boost::hash_combine(seed, this->anchor_length_max);
+        boost::hash_combine(seed, this->multiline);
+        boost::hash_combine(seed, this->monotonic);
+        boost::hash_combine(seed, this->dont_sort);
+        boost::hash_combine(seed, int(this->pattern));
+        boost::hash_combine(seed, this->horiz_move);
+        boost::hash_combine(seed, this->symmetric_infill_y_axis);
+        boost::hash_combine(seed, this->symmetric_y_axis);
+        boost::hash_combine(seed, this->bridge_angle);
+        auto hash_polygon = [&seed](const Polygon &polygon) {
+            boost::hash_combine(seed, polygon.size());
+            for (const Point &pt : polygon.points) {
+                boost::hash_combine(seed, pt.x());
+                boost::hash_combine(seed, pt.y());
+            }
+        };
+        hash_polygon(this->expolygon.contour);
+        for (const Polygon &hole : this->expolygon.holes)
+            hash_polygon(hole);
+        this->hash = seed;
+    }
+
+    bool operator==(const Key &rhs) const {
+        return hash == rhs.hash && filler == rhs.filler && angle == rhs.angle && rotate_angle == rhs.rotate_angle && has_layer_id == rhs.has_layer_id && spacing == rhs.spacing && overlap == rhs.overlap &&
+               link_max_length == rhs.link_max_length && bounding_box.min == rhs.bounding_box.min && bounding_box.max == rhs.bounding_box.max &&
+               density == rhs.density && anchor_length == rhs.anchor_length && anchor_length_max == rhs.anchor_length_max && multiline == rhs.multiline &&
+               monotonic == rhs.monotonic && dont_sort == rhs.dont_sort && pattern == rhs.pattern && horiz_move == rhs.horiz_move &&
+               symmetric_infill_y_axis == rhs.symmetric_infill_y_axis && symmetric_y_axis == rhs.symmetric_y_axis && bridge_angle == rhs.bridge_angle &&
+               expolygon == rhs.expolygon;
+    }
+};
+
+struct KeyHash {
+    size_t operator()(const Key &key) const { return key.hash; }
+};
+
+using FillPtr = std::shared_ptr<const Polylines>;
+
+// Only the fills, which are a pure function of the key, are cached. FillRectilinear adjusts its spacing to the surface
+// being filled unless dont_adjust is set. The locked zag parameters are not a part of the key.
+bool cacheable(const Fill &filler, const FillParams &params)
+{
+    const std::type_index type(typeid(filler));
+    return (type == typeid(FillRectilinear) || type == typeid(FillSupportBase)) && params.dont_adjust && ! params.use_arachne && ! params.locked_zag;
+}
+
+} // anonymous namespace
+
+struct SupportFillCache::Map : std::unordered_map<Key, FillPtr, KeyHash> {};
+
+SupportFillCache::SupportFillCache() : m_map(std::make_unique<Map>()) {}
+SupportFillCache::~SupportFillCache() = default;
+
+Polylines SupportFillCache::fill_surface(Fill *filler, const Surface &surface, const FillParams &params)
+{
+    if (! cacheable(*filler, params))
+        return filler->fill_surface(&surface, params);
+
+    Key key(*filler, surface, params);
+    {
+        std::scoped_lock<std::mutex> lock(m_mutex);
+        if (auto it = m_map->find(key); it != m_map->end()) {
+            FillPtr polylines = it->second;
+            ++ m_hits;
+            return *polylines;
+        }
+    }
+    ++ m_misses;
+
+    // Fill outside of the lock, other threads are filling other support layers at the same time.
+    // Two threads may fill the same surface concurrently, the first one to finish is cached.
+    Polylines polylines  = filler->fill_surface(&surface, params);
+    size_t    num_points = count_points(key.expolygon);
+    for (const Polyline &polyline : polylines)
+        num_points += polyline.size();
+
+    if (num_points <= MaxPoints) {
+        auto cached = std::make_shared<const Polylines>(polylines);
+        std::scoped_lock<std::mutex> lock(m_mutex);
+        if (m_num_points + num_points <= MaxPoints && m_map->emplace(std::move(key), std::move(cached)).second)
+            m_num_points += num_points;
+    }
+    return polylines;
+}
+
+void SupportFillCache::clear()
+{
+    std::scoped_lock<std::mutex> lock(m_mutex);
+    m_map->clear();
+    m_num_points = 0;
+}
+
+SupportFillCache::Stats SupportFillCache::stats() const
+{
+    std::scoped_lock<std::mutex> lock(m_mutex);
+    Stats out;
+    out.hits   = m_hits;
+    out.misses = m_misses;
+    out.size   = m_map->size();
+    out.points = m_num_points;
+    return out;
+}
+
+void SupportFillCache::reset_stats()
+{
+    m_hits   = 0;
+    m_misses = 0;
+}
+
+Polylines fill_surface_cached(SupportFillCache *cache, Fill *filler, const Surface &surface, const FillParams &params)
+{
+    return cache ? cache->fill_surface(filler, surface, params) : filler->fill_surface(&surface, params);
+}
+
+} // namespace Slic3r
@@ -0,0 +1,64 @@
+#ifndef slic3r_SupportFillCache_hpp_
+#define slic3r_SupportFillCache_hpp_
+
+#include "../libslic3r.h"
+#include "../Polyline.hpp"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+namespace Slic3r {
+
+class Fill;
+struct FillParams;
+class Surface;
+
+// Thread safe cache of the support base, interface and raft infill, owned by a single support toolpath generation pass. Rafts and the trunks of tree supports
+// produce the same support areas layer after layer, and all instances of the same support area are filled with the same lines
+// as long as the infill pattern, its angle, spacing and density stay the same. The support infill is aligned to a fixed
+// bounding box, thus a cached infill is reused for surfaces at the same place only.
+// Only the rectilinear fills (ipRectilinear, ipSupportBase) are cached, the other fills are generated by the filler directly.
+// The cache is bounded by the total number of points held.
+class SupportFillCache
+{
+public:
+    struct Stats {
+        size_t hits   { 0 };
+        size_t misses { 0 };
+        // Number of fills and their points currently cached.
+        size_t size   { 0 };
+        size_t points { 0 };
+    };
+
+    SupportFillCache();
+    ~SupportFillCache();
+
+    // Same as filler->fill_surface(&surface, params), reusing the infill of the same surface filled with the same parameters before.
+    // InfillFailedException is passed to the caller and nothing is cached.
+    Polylines           fill_surface(Fill *filler, const Surface &surface, const FillParams &params);
+
+    // Release all cached fills.
+    void                clear();
+    Stats               stats() const;
+    void                reset_stats();
+
+    // Maximum number of points of the surfaces and their infill held by the cache. Once reached, new fills are not cached.
+    static constexpr size_t MaxPoints = 8 * 1024 * 1024;
+
+private:
+    struct Map;
+
+    mutable std::mutex          m_mutex;
+    std::unique_ptr<Map>        m_map;
+    size_t                      m_num_points { 0 };
+    std::atomic<size_t>         m_hits       { 0 };
+    std::atomic<size_t>         m_misses     { 0 };
+};
+
+// filler->fill_surface(&surface, params) through the cache, if there is one.
+Polylines fill_surface_cached(SupportFillCache *cache, Fill *filler, const Surface &surface, const FillParams &params);
+
+} // namespace Slic3r
+
+#endif // slic3r_SupportFillCache_hpp_
@@ -11,6 +11,7 @@
 
 #include <cmath>
 #include <memory>
+#include <optional>
 #include <boost/log/trivial.hpp>
 #include <boost/container/static_vector.hpp>
 
@@ -385,6 +386,7 @@ void PrintObjectSupportMaterial::generate(PrintObject &object)
 
     BOOST_LOG_TRIVIAL(info) << "Support generator - Creating top contacts";
 
+    std::optional<SupportPhaseTimer> phase_timer(std::in_place, SupportPhase::ContactDetection);
     // Per object layer projection of the object below the layer into print bed.
     std::vector<Polygons> buildplate_covered = this->buildplate_covered(object);
 
@@ -433,6 +435,7 @@ void PrintObjectSupportMaterial::generate(PrintObject &object)
 #endif /* SLIC3R_DEBUG */
 
     BOOST_LOG_TRIVIAL(info) << "Support generator - Creating intermediate layers - indices";
+    phase_timer.emplace(SupportPhase::Drop);
 
     // Allocate empty layers between the top / bottom support contact layers
     // as placeholders for the base and intermediate support layers.
@@ -464,6 +467,7 @@ void PrintObjectSupportMaterial::generate(PrintObject &object)
 #endif /* SLIC3R_DEBUG */
 
     BOOST_LOG_TRIVIAL(info) << "Support generator - Trimming top contacts by bottom contacts";
+    phase_timer.emplace(SupportPhase::Draw);
 
     // Because the top and bottom contacts are thick slabs, they may overlap causing over extrusion 
     // and unwanted strong bonds to the object.
@@ -552,7 +556,9 @@ void PrintObjectSupportMaterial::generate(PrintObject &object)
 #endif /* SLIC3R_DEBUG */
 
     // Generate the actual toolpaths and save them into each layer.
+    phase_timer.emplace(SupportPhase::Toolpaths);
     generate_support_toolpaths(object.support_layers(), *m_object_config, m_support_params, m_slicing_params, raft_layers, bottom_contacts, top_contacts, intermediate_layers, interface_layers, base_interface_layers);
+    phase_timer.reset();
 
 #ifdef SLIC3R_DEBUG
     {
@@ -1297,23 +1303,29 @@ namespace SupportMaterialInternal {
 std::vector<Polygons> PrintObjectSupportMaterial::buildplate_covered(const PrintObject &object) const
 {
     // Build support on a build plate only? If so, then collect and union all the surfaces below the current layer.
-    // Unfortunately this is an inherently serial process.
     const bool            buildplate_only = this->build_plate_only();
     std::vector<Polygons> buildplate_covered;
     if (buildplate_only) {
         BOOST_LOG_TRIVIAL(debug) << "PrintObjectSupportMaterial::buildplate_covered() - start";
-        buildplate_covered.assign(object.layers().size(), Polygons());
-        //FIXME prefix sum algorithm, parallelize it! Parallelization will also likely be more numerically stable.
-        for (size_t layer_id = 1; layer_id < object.layers().size(); ++ layer_id) {
-            const Layer &lower_layer = *object.layers()[layer_id-1];
+        const size_t num_layers = object.layers().size();
+        buildplate_covered.assign(num_layers, Polygons());
+        // Apply the safety offset to the newly added polygons, so they will connect
+        // with the polygons collected before,
+        // but don't apply the safety offset during the union operation as it would
+        // inflate the polygons over and over.
+        std::vector<Polygons> slices_offsetted(num_layers);
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, num_layers),
+            [&object, &slices_offsetted](const tbb::blocked_range<size_t> &range) {
+                for (size_t layer_id = range.begin(); layer_id < range.end(); ++ layer_id)
+                    slices_offsetted[layer_id] = offset(object.layers()[layer_id]->lslices, scale_(0.01));
+            });
+        // The union is accumulated serially. A block wise parallel prefix union is not bit identical to the serial one,
+        // the intersection points are rounded differently depending on the order of the unions.
+        Polygons covered;
+        for (size_t layer_id = 0; layer_id < num_layers; ++ layer_id) {
+            buildplate_covered[layer_id] = covered;
             // Merge the new slices with the preceding slices.
-            // Apply the safety offset to the newly added polygons, so they will connect
-            // with the polygons collected before,
-            // but don't apply the safety offset during the union operation as it would
-            // inflate the polygons over and over.
-            Polygons &covered = buildplate_covered[layer_id];
-            covered = buildplate_covered[layer_id - 1];
-            polygons_append(covered, offset(lower_layer.lslices, scale_(0.01)));
+            polygons_append(covered, slices_offsetted[layer_id]);
             covered = union_(covered);
         }
         BOOST_LOG_TRIVIAL(debug) << "PrintObjectSupportMaterial::buildplate_covered() - end";
@@ -2507,7 +2519,8 @@ static inline SupportGeneratorLayer* detect_bottom_contacts(
 
 // Returns polygons to print + polygons to propagate downwards.
 // Called twice: First for normal supports, possibly trimmed by "on build plate only", second for support enforcers not trimmed by "on build plate only".
-static inline std::pair<Polygons, Polygons> project_support_to_grid(const Layer &layer, const SupportGridParams &grid_params, const Polygons &overhangs, Polygons *layer_buildplate_covered
+// trimming is either the layer slices expanded by SCALED_EPSILON or the "build plate only" polygons of the layer.
+static inline std::pair<Polygons, Polygons> project_support_to_grid(const Layer &layer, const SupportGridParams &grid_params, const Polygons &overhangs, const Polygons &trimming
 #ifdef SLIC3R_DEBUG 
     , size_t iRun, size_t layer_id, const char *debug_name
 #endif /* SLIC3R_DEBUG */
@@ -2515,7 +2528,6 @@ static inline std::pair<Polygons, Polygons> project_support_to_grid(const Layer
 {
     // Remove the areas that touched from the projection that will continue on next, lower, top surfaces.
 //            Polygons trimming = union_(to_polygons(layer.slices), touching, true);
-    Polygons trimming = layer_buildplate_covered ? std::move(*layer_buildplate_covered) : offset(layer.lslices, float(SCALED_EPSILON));
     Polygons overhangs_projection = diff(overhangs, trimming);
 
 #ifdef SLIC3R_DEBUG
@@ -2612,6 +2624,26 @@ SupportGeneratorLayersPtr PrintObjectSupportMaterial::bottom_contact_layers_and_
     // we'll use them to clip our support and detect where does it stick
     SupportGeneratorLayersPtr bottom_contacts;
 
+    // The contact areas to be projected downwards do not depend on the projection from the layers above, they are merged in parallel.
+    // Consume the contact_polygons. The contact polygons are already expanded into a grid form, and they are a tiny bit smaller
+    // than the grid cells.
+    // The overhang surfaces are touching the object and they are not expanded away from the object.
+    // Use a slight positive offset to overlap the touching regions.
+    std::vector<Polygons> contact_projections(top_contacts.size());
+    std::vector<Polygons> enforcer_projections(top_contacts.size());
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, top_contacts.size()),
+        [&top_contacts, &contact_projections, &enforcer_projections](const tbb::blocked_range<size_t> &range) {
+            for (size_t contact_idx = range.begin(); contact_idx < range.end(); ++ contact_idx) {
+                SupportGeneratorLayer &top_contact  = *top_contacts[contact_idx];
+                Polygons               polygons_new = std::move(*top_contact.contact_polygons);
+                polygons_append(polygons_new, expand(*top_contact.overhang_polygons, float(SCALED_EPSILON)));
+                contact_projections[contact_idx] = union_(polygons_new);
+                if (top_contact.enforcer_polygons)
+                    enforcer_projections[contact_idx] = std::move(*top_contact.enforcer_polygons);
+            }
+        });
+    const bool has_enforcers = std::any_of(enforcer_projections.begin(), enforcer_projections.end(), [](const Polygons &polygons) { return ! polygons.empty(); });
+
     // There is some support to be built, if there are non-empty top surfaces detected.
     // Sum of unsupported contact areas above the current layer.print_z.
     Polygons  overhangs_projection;
@@ -2620,110 +2652,113 @@ SupportGeneratorLayersPtr PrintObjectSupportMaterial::bottom_contact_layers_and_
     Polygons  enforcers_projection;
     // Last top contact layer visited when collecting the projection of contact areas.
     int       contact_idx = int(top_contacts.size()) - 1;
-    for (int layer_id = int(object.total_layer_count()) - 2; layer_id >= 0; -- layer_id) {
-        BOOST_LOG_TRIVIAL(trace) << "Support generator - bottom_contact_layers - layer " << layer_id;
-        const Layer &layer = *object.get_layer(layer_id);
-        // Collect projections of all contact areas above or at the same level as this top surface.
+    // Object layer slices expanded by SCALED_EPSILON to trim the projection with, prepared in parallel for a block of layers
+    // at a time, as they do not depend on the projection either. Only the projection itself is propagated layer by layer,
+    // as it is snapped to the support grid at each layer.
+    const int             layer_block_size = 64;
+    std::vector<Polygons> layer_trimming(layer_block_size);
+    const bool            need_layer_trimming = ! buildplate_only || has_enforcers;
+    const coordf_t        top_contact_z = top_contacts.back()->print_z;
+    for (int layer_block_end = int(object.total_layer_count()) - 1; layer_block_end > 0; layer_block_end -= layer_block_size) {
+        const int layer_block_begin = std::max(0, layer_block_end - layer_block_size);
+        if (need_layer_trimming)
+            tbb::parallel_for(tbb::blocked_range<int>(layer_block_begin, layer_block_end),
+                [&object, &layer_trimming, layer_block_begin, top_contact_z](const tbb::blocked_range<int> &range) {
+                    for (int layer_id = range.begin(); layer_id < range.end(); ++ layer_id) {
+                        const Layer &layer = *object.get_layer(layer_id);
+                        // No contact area will be projected to the layers above the top most contact layer.
+                        layer_trimming[layer_id - layer_block_begin] = layer.print_z - EPSILON < top_contact_z ?
+                            offset(layer.lslices, float(SCALED_EPSILON)) : Polygons();
+                    }
+                });
+        for (int layer_id = layer_block_end - 1; layer_id >= layer_block_begin; -- layer_id) {
+            BOOST_LOG_TRIVIAL(trace) << "Support generator - bottom_contact_layers - layer " << layer_id;
+            const Layer &layer = *object.get_layer(layer_id);
+            // Collect projections of all contact areas above or at the same level as this top surface.
 #ifdef SLIC3R_DEBUG
-        Polygons polygons_new;
-        Polygons enforcers_new;
-#endif // SLIC3R_DEBUG
-        for (; contact_idx >= 0 && top_contacts[contact_idx]->print_z > layer.print_z - EPSILON; -- contact_idx) {
-            SupportGeneratorLayer &top_contact = *top_contacts[contact_idx];
-#ifndef SLIC3R_DEBUG
             Polygons polygons_new;
-            Polygons enforcers_new;
 #endif // SLIC3R_DEBUG
-            // Contact surfaces are expanded away from the object, trimmed by the object.
-            // Use a slight positive offset to overlap the touching regions.
-#if 0
-            // Merge and collect the contact polygons. The contact polygons are inflated, but not extended into a grid form.
-            polygons_append(polygons_new,  offset(*top_contact.contact_polygons,  SCALED_EPSILON));
-            if (top_contact.enforcer_polygons)
-                polygons_append(enforcers_new, offset(*top_contact.enforcer_polygons, SCALED_EPSILON));
-#else
-            // Consume the contact_polygons. The contact polygons are already expanded into a grid form, and they are a tiny bit smaller
-            // than the grid cells.
-            polygons_append(polygons_new,  std::move(*top_contact.contact_polygons));
-            if (top_contact.enforcer_polygons)
-                polygons_append(enforcers_new, std::move(*top_contact.enforcer_polygons));
-#endif
-            // These are the overhang surfaces. They are touching the object and they are not expanded away from the object.
-            // Use a slight positive offset to overlap the touching regions.
-            polygons_append(polygons_new, expand(*top_contact.overhang_polygons, float(SCALED_EPSILON)));
-            polygons_append(overhangs_projection, union_(polygons_new));
-            polygons_append(enforcers_projection, enforcers_new);
-        }
-        if (overhangs_projection.empty() && enforcers_projection.empty())
-            continue;
+            for (; contact_idx >= 0 && top_contacts[contact_idx]->print_z > layer.print_z - EPSILON; -- contact_idx) {
+#ifdef SLIC3R_DEBUG
+                polygons_append(polygons_new, contact_projections[contact_idx]);
+#endif // SLIC3R_DEBUG
+                polygons_append(overhangs_projection, std::move(contact_projections[contact_idx]));
+                polygons_append(enforcers_projection, std::move(enforcer_projections[contact_idx]));
+            }
+            if (overhangs_projection.empty() && enforcers_projection.empty())
+                continue;
 
-        // Overhangs_projection will be filled in asynchronously, move it away.
-        Polygons overhangs_projection_raw = union_(std::move(overhangs_projection));
-        Polygons enforcers_projection_raw = union_(std::move(enforcers_projection));
+            // Overhangs_projection will be filled in asynchronously, move it away.
+            Polygons overhangs_projection_raw = union_(std::move(overhangs_projection));
+            Polygons enforcers_projection_raw = union_(std::move(enforcers_projection));
 
-        tbb::task_group task_group;
-        const Polygons &overhangs_for_bottom_contacts = buildplate_only ? enforcers_projection_raw : overhangs_projection_raw;
-        if (! overhangs_for_bottom_contacts.empty())
-            // Find the bottom contact layers above the top surfaces of this layer.
-            task_group.run([this, &object, &layer, &top_contacts, contact_idx, &layer_storage, &layer_support_areas, &bottom_contacts, &overhangs_for_bottom_contacts
-    #ifdef SLIC3R_DEBUG
-                , iRun, &polygons_new
-    #endif // SLIC3R_DEBUG
-                ] {
-                    // Find the bottom contact layers above the top surfaces of this layer.
-                    SupportGeneratorLayer *layer_new = detect_bottom_contacts(
-                        m_slicing_params, m_support_params, object, layer, top_contacts, contact_idx, layer_storage, layer_support_areas, overhangs_for_bottom_contacts
+            tbb::task_group task_group;
+            const Polygons &overhangs_for_bottom_contacts = buildplate_only ? enforcers_projection_raw : overhangs_projection_raw;
+            if (! overhangs_for_bottom_contacts.empty())
+                // Find the bottom contact layers above the top surfaces of this layer.
+                task_group.run([this, &object, &layer, &top_contacts, contact_idx, &layer_storage, &layer_support_areas, &bottom_contacts, &overhangs_for_bottom_contacts
+        #ifdef SLIC3R_DEBUG
+                    , iRun, &polygons_new
+        #endif // SLIC3R_DEBUG
+                    ] {
+                        // Find the bottom contact layers above the top surfaces of this layer.
+                        SupportGeneratorLayer *layer_new = detect_bottom_contacts(
+                            m_slicing_params, m_support_params, object, layer, top_contacts, contact_idx, layer_storage, layer_support_areas, overhangs_for_bottom_contacts
 #ifdef SLIC3R_DEBUG
-                        , iRun, polygons_new
+                            , iRun, polygons_new
 #endif // SLIC3R_DEBUG
-                    );
-                    if (layer_new)
-                        bottom_contacts.push_back(layer_new);
-                });
-
-        Polygons &layer_support_area = layer_support_areas[layer_id];
-        Polygons *layer_buildplate_covered = buildplate_covered.empty() ? nullptr : &buildplate_covered[layer_id];
-        // Filtering the propagated support columns to two extrusions, overlapping by maximum 20%.
+                        );
+                        if (layer_new)
+                            bottom_contacts.push_back(layer_new);
+                    });
+
+            Polygons &layer_support_area = layer_support_areas[layer_id];
+            Polygons &layer_slices_trimming = layer_trimming[layer_id - layer_block_begin];
+            Polygons &trimming = buildplate_only ? buildplate_covered[layer_id] : layer_slices_trimming;
+            // Filtering the propagated support columns to two extrusions, overlapping by maximum 20%.
 //        float column_propagation_filtering_radius = scaled<float>(0.8 * 0.5 * (m_support_params.support_material_flow.spacing() + m_support_params.support_material_flow.width()));
-        task_group.run([&grid_params, &overhangs_projection, &overhangs_projection_raw, &layer, &layer_support_area, layer_buildplate_covered /* , column_propagation_filtering_radius */
+            task_group.run([&grid_params, &overhangs_projection, &overhangs_projection_raw, &layer, &layer_support_area, &trimming /* , column_propagation_filtering_radius */
 #ifdef SLIC3R_DEBUG 
-            , iRun, layer_id
+                , iRun, layer_id
 #endif /* SLIC3R_DEBUG */
-            ] {
-                // buildplate_covered[layer_id] will be consumed here.
-                std::tie(layer_support_area, overhangs_projection) = project_support_to_grid(layer, grid_params, overhangs_projection_raw, layer_buildplate_covered
+                ] {
+                    std::tie(layer_support_area, overhangs_projection) = project_support_to_grid(layer, grid_params, overhangs_projection_raw, trimming
 #ifdef SLIC3R_DEBUG 
-                    , iRun, layer_id, "general"
+                        , iRun, layer_id, "general"
 #endif /* SLIC3R_DEBUG */
-                );
-                // When propagating support areas downwards, stop propagating the support column if it becomes too thin to be printable.
-                //overhangs_projection = opening(overhangs_projection, column_propagation_filtering_radius);
-            });
+                    );
+                    // When propagating support areas downwards, stop propagating the support column if it becomes too thin to be printable.
+                    //overhangs_projection = opening(overhangs_projection, column_propagation_filtering_radius);
+                });
 
-        Polygons layer_support_area_enforcers;
-        if (! enforcers_projection.empty())
-            // Project the enforcers polygons downwards, don't trim them with the "buildplate only" polygons.
-            task_group.run([&grid_params, &enforcers_projection, &enforcers_projection_raw, &layer, &layer_support_area_enforcers
+            Polygons layer_support_area_enforcers;
+            if (! enforcers_projection.empty())
+                // Project the enforcers polygons downwards, don't trim them with the "buildplate only" polygons.
+                task_group.run([&grid_params, &enforcers_projection, &enforcers_projection_raw, &layer, &layer_support_area_enforcers, &layer_slices_trimming
 #ifdef SLIC3R_DEBUG 
-                , iRun, layer_id
+                    , iRun, layer_id
 #endif /* SLIC3R_DEBUG */
-            ]{
-                std::tie(layer_support_area_enforcers, enforcers_projection) = project_support_to_grid(layer, grid_params, enforcers_projection_raw, nullptr
+                ]{
+                    std::tie(layer_support_area_enforcers, enforcers_projection) = project_support_to_grid(layer, grid_params, enforcers_projection_raw, layer_slices_trimming
 #ifdef SLIC3R_DEBUG 
-                    , iRun, layer_id, "enforcers"
+                        , iRun, layer_id, "enforcers"
 #endif /* SLIC3R_DEBUG */
-                );
-            });
+                    );
+                });
 
-        task_group.wait();
+            task_group.wait();
+            // buildplate_covered[layer_id] is consumed.
+            trimming = Polygons();
+            layer_slices_trimming = Polygons();
 
-        if (! layer_support_area_enforcers.empty()) {
-            if (layer_support_area.empty())
-                layer_support_area = std::move(layer_support_area_enforcers);
-            else
-                layer_support_area = union_(layer_support_area, layer_support_area_enforcers);
-        }
-    } // over all layers downwards
+            if (! layer_support_area_enforcers.empty()) {
+                if (layer_support_area.empty())
+                    layer_support_area = std::move(layer_support_area_enforcers);
+                else
+                    layer_support_area = union_(layer_support_area, layer_support_area_enforcers);
+            }
+        } // over all layers downwards of a block
+    } // over all blocks of layers downwards
 
     std::reverse(bottom_contacts.begin(), bottom_contacts.end());
     trim_support_layers_by_object(object, bottom_contacts, m_slicing_params.gap_support_object, m_slicing_params.gap_object_support, m_support_params.gap_xy);
@@ -36,9 +36,11 @@ public:
 	// with extrusion paths and islands filled in for each support layer.
 	void 		generate(PrintObject &object);
 
-private:
+	// Per object layer projection of the object below the layer into print bed, empty if the support is not limited to the build plate.
 	std::vector<Polygons> buildplate_covered(const PrintObject &object) const;
 
+private:
+
 	// Generate top contact layers supporting overhangs.
 	// For a soluble interface material synchronize the layer heights with the object, otherwise leave the layer height undefined.
 	// If supports over bed surface only are requested, don't generate contact layers over an object.
@@ -138,6 +138,23 @@ float estimate_curled_up_height(
     return curled_up_height;
 }
 
+// External perimeter of a layer region, pointing into the perimeters of the region.
+struct ExternalPerimeter
+{
+    const ExtrusionEntity *extrusion;
+    float                  flow_width;
+};
+
+// Collects the external perimeters in the order of ExtrusionEntityCollection::flatten(), without copying the extrusions.
+static void collect_external_perimeters(const ExtrusionEntityCollection &collection, float flow_width, std::vector<ExternalPerimeter> &out)
+{
+    for (const ExtrusionEntity *entity : collection.entities)
+        if (entity->is_collection())
+            collect_external_perimeters(*static_cast<const ExtrusionEntityCollection*>(entity), flow_width, out);
+        else if (entity->role() == Slic3r::erExternalPerimeter)
+            out.push_back({ entity, flow_width });
+}
+
 void estimate_malformations(LayerPtrs &layers, const Params &params)
 {
 #ifdef DEBUG_FILES
@@ -145,53 +162,86 @@ void estimate_malformations(LayerPtrs &layers, const Params &params)
     FILE *full_file  = boost::nowide::fopen(debug_out_path("object_full.obj").c_str(), "w");
 #endif
 
-    LD prev_layer_lines{};
+    // The external perimeters of the layers and the boundaries of the layers below them do not depend on each other,
+    // they are collected in parallel and each AABB tree of the boundaries is built just once.
+    std::vector<std::vector<ExternalPerimeter>>       layer_perimeters(layers.size());
+    std::vector<AABBTreeLines::LinesDistancer<Linef>> prev_layer_boundaries(layers.size());
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, layers.size()), [&](const tbb::blocked_range<size_t> &range) {
+        for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
+            const Layer *l = layers[layer_idx];
+            for (const LayerRegion *layer_region : l->regions())
+                collect_external_perimeters(layer_region->perimeters, get_flow_width(layer_region, erExternalPerimeter), layer_perimeters[layer_idx]);
+            if (l->lower_layer != nullptr)
+                prev_layer_boundaries[layer_idx] = AABBTreeLines::LinesDistancer<Linef>{to_unscaled_linesf(l->lower_layer->lslices)};
+        }
+    });
 
-    for (Layer *l : layers) {
-        l->curled_lines.clear();
-        std::vector<Linef> boundary_lines = l->lower_layer != nullptr ? to_unscaled_linesf(l->lower_layer->lslices) : std::vector<Linef>();
-        AABBTreeLines::LinesDistancer<Linef> prev_layer_boundary{std::move(boundary_lines)};
-        std::vector<ExtrusionLine>           current_layer_lines;
-        for (const LayerRegion *layer_region : l->regions()) {
-            for (const ExtrusionEntity *extrusion : layer_region->perimeters.flatten().entities) {
-                if (extrusion->role() != Slic3r::erExternalPerimeter)
-                    continue;
+    // Lines of a layer measured against the lines of the previous layer.
+    struct AnnotatedLine
+    {
+        ExtrusionLine line;
+        float         curvature;
+        float         flow_width;
+        float         middle_distance;
+        size_t        bottom_line_idx;
+    };
 
+    LD                         prev_layer_lines{};
+    std::vector<float>         prev_layer_curled_heights;
+    std::vector<float>         current_layer_curled_heights;
+    std::vector<ExtrusionLine> current_layer_lines;
+
+    // The lines of a layer are split at the intersections with the lines of the previous layer and their curled heights build up
+    // on the previous layer, thus the layers are processed in a sequence, while the external perimeters of a layer are processed in parallel.
+    for (size_t layer_idx = 0; layer_idx < layers.size(); ++ layer_idx) {
+        Layer                                      *l                   = layers[layer_idx];
+        const std::vector<ExternalPerimeter>       &perimeters          = layer_perimeters[layer_idx];
+        const AABBTreeLines::LinesDistancer<Linef> &prev_layer_boundary = prev_layer_boundaries[layer_idx];
+        std::vector<std::vector<AnnotatedLine>>     annotated_lines(perimeters.size());
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, perimeters.size()), [&](const tbb::blocked_range<size_t> &range) {
+            for (size_t perimeter_idx = range.begin(); perimeter_idx < range.end(); ++ perimeter_idx) {
+                const ExternalPerimeter &perimeter = perimeters[perimeter_idx];
                 Points extrusion_pts;
-                extrusion->collect_points(extrusion_pts);
-                float flow_width       = get_flow_width(layer_region, extrusion->role());
+                perimeter.extrusion->collect_points(extrusion_pts);
                 auto  annotated_points = estimate_points_properties<true, true, false, false>(extrusion_pts,
-                                                                                                                 prev_layer_lines,
-                                                                                                                 flow_width,
-                                                                                                                 params.bridge_distance);
+                                                                                             prev_layer_lines,
+                                                                                             perimeter.flow_width,
+                                                                                             params.bridge_distance);
+                std::vector<AnnotatedLine> &lines_out = annotated_lines[perimeter_idx];
+                lines_out.reserve(annotated_points.size());
                 for (size_t i = 0; i < annotated_points.size(); ++i) {
                     const ExtendedPoint &a = i > 0 ? annotated_points[i - 1] : annotated_points[i];
                     const ExtendedPoint &b = annotated_points[i];
                     ExtrusionLine line_out{a.position.cast<float>(), b.position.cast<float>(), float((a.position - b.position).norm()),
-                                           extrusion};
+                                           perimeter.extrusion};
 
                     Vec2f middle                               = 0.5 * (line_out.a + line_out.b);
                     auto [middle_distance, bottom_line_idx, x] = prev_layer_lines.distance_from_lines_extra<false>(middle);
-                    ExtrusionLine bottom_line                  = prev_layer_lines.get_lines().empty() ? ExtrusionLine{} :
-                                                                                                        prev_layer_lines.get_line(bottom_line_idx);
 
                     // correctify the distance sign using slice polygons
-                    float sign = (prev_layer_boundary.distance_from_lines<true>(middle.cast<double>()) + 0.5f * flow_width) < 0.0f ? -1.0f :
-                                                                                                                                     1.0f;
-
-                    line_out.curled_up_height = estimate_curled_up_height(middle_distance * sign * params.curled_distance_expansion, 0.5 * (a.curvature + b.curvature),
-                                                                          l->height, flow_width, bottom_line.curled_up_height, params);
+                    float sign = (prev_layer_boundary.distance_from_lines<true>(middle.cast<double>()) + 0.5f * perimeter.flow_width) < 0.0f ? -1.0f :
+                                                                                                                                             1.0f;
 
-                    current_layer_lines.push_back(line_out);
+                    lines_out.push_back({ line_out, float(0.5 * (a.curvature + b.curvature)), perimeter.flow_width, middle_distance * sign, bottom_line_idx });
                 }
             }
-        }
+        });
 
-        for (const ExtrusionLine &line : current_layer_lines) {
-            if (line.curled_up_height > params.curling_tolerance_limit) {
-                l->curled_lines.push_back(CurledLine{Point::new_scale(line.a), Point::new_scale(line.b), line.curled_up_height});
+        l->curled_lines.clear();
+        current_layer_lines.clear();
+        current_layer_curled_heights.clear();
+        for (std::vector<AnnotatedLine> &lines : annotated_lines)
+            for (AnnotatedLine &annotated : lines) {
+                float bottom_line_curled_height = prev_layer_curled_heights.empty() ? 0.0f : prev_layer_curled_heights[annotated.bottom_line_idx];
+                annotated.line.curled_up_height = estimate_curled_up_height(annotated.middle_distance * params.curled_distance_expansion, annotated.curvature,
+                                                                            l->height, annotated.flow_width, bottom_line_curled_height, params);
+                if (annotated.line.curled_up_height > params.curling_tolerance_limit)
+                    l->curled_lines.push_back(CurledLine{Point::new_scale(annotated.line.a), Point::new_scale(annotated.line.b), annotated.line.curled_up_height});
+                current_layer_curled_heights.push_back(annotated.line.curled_up_height);
+                current_layer_lines.push_back(annotated.line);
             }
-        }
+        // The boundary is not needed anymore.
+        prev_layer_boundaries[layer_idx] = {};
 
 #ifdef DEBUG_FILES
         for (const ExtrusionLine &line : current_layer_lines) {
@@ -206,7 +256,9 @@ void estimate_malformations(LayerPtrs &layers, const Params &params)
         }
 #endif
 
-        prev_layer_lines = LD{current_layer_lines};
+        prev_layer_lines = LD{std::move(current_layer_lines)};
+        current_layer_lines = {};
+        std::swap(prev_layer_curled_heights, current_layer_curled_heights);
     }
 
 #ifdef DEBUG_FILES
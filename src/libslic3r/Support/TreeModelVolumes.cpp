@@ -8,9 +8,11 @@
 
 #include "TreeModelVolumes.hpp"
 #include "TreeSupportCommon.hpp"
+#include "DistanceField.hpp"
 
 #include "../BuildVolume.hpp"
 #include "../ClipperUtils.hpp"
+#include "../Exception.hpp"
 #include "../Flow.hpp"
 #include "../Layer.hpp"
 #include "../Point.hpp"
@@ -19,11 +21,13 @@
 #include "../Utils.hpp"
 #include "../format.hpp"
 
+#include <map>
 #include <string_view>
 
 #include <boost/log/trivial.hpp>
 
 #include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
 #include <tbb/task_group.h>
 
 namespace Slic3r::TreeSupport3D
@@ -103,6 +107,7 @@ TreeModelVolumes::TreeModelVolumes(
         m_radius_0 = config.getRadius(0);
         m_raft_layers = config.raft_layers;
         m_current_outline_idx = 0;
+        m_collision_distance_field = mesh_settings.support_tree_collision_backend == TreeSupportCollisionBackend::DistanceField;
 
         m_layer_outlines.emplace_back(mesh_settings, std::vector<Polygons>{});
         std::vector<Polygons> &outlines = m_layer_outlines.front().second;
@@ -154,6 +159,60 @@ TreeModelVolumes::TreeModelVolumes(
 #endif
 }
 
+void TreeModelVolumesDeleter::operator()(TreeModelVolumes *p) { delete p; }
+
+void TreeModelVolumes::reuse_caches(TreeModelVolumes &&rhs)
+{
+    assert(! m_precalculated);
+    auto same_outlines = [](const auto &lhs, const auto &rhs) {
+        if (lhs.size() != rhs.size())
+            return false;
+        for (size_t i = 0; i < lhs.size(); ++ i) {
+            const TreeSupportMeshGroupSettings &l = lhs[i].first;
+            const TreeSupportMeshGroupSettings &r = rhs[i].first;
+            if (l.layer_height != r.layer_height || l.support_top_distance != r.support_top_distance ||
+                l.support_bottom_distance != r.support_bottom_distance || l.support_xy_distance != r.support_xy_distance ||
+                lhs[i].second != rhs[i].second)
+                return false;
+        }
+        return true;
+    };
+    const bool reuse_collision =
+        m_current_outline_idx        == rhs.m_current_outline_idx &&
+        m_current_min_xy_dist        == rhs.m_current_min_xy_dist &&
+        m_current_min_xy_dist_delta  == rhs.m_current_min_xy_dist_delta &&
+        m_support_rests_on_model     == rhs.m_support_rests_on_model &&
+        m_collision_distance_field   == rhs.m_collision_distance_field &&
+        m_min_resolution             == rhs.m_min_resolution &&
+        m_machine_border             == rhs.m_machine_border &&
+        m_anti_overhang              == rhs.m_anti_overhang &&
+        same_outlines(m_layer_outlines, rhs.m_layer_outlines);
+    // Avoidances are calculated per radius, thus they do not depend on the radii the branches will take, which may
+    // change with the tip or branch diameters. The holefree collisions are offsetted to m_increase_until_radius.
+    const bool reuse_avoidance = reuse_collision &&
+        m_max_move                   == rhs.m_max_move &&
+        m_max_move_slow              == rhs.m_max_move_slow &&
+        m_increase_until_radius      == rhs.m_increase_until_radius;
+
+    if (reuse_collision) {
+        m_collision_cache                   = std::move(rhs.m_collision_cache);
+        m_placeable_areas_cache             = std::move(rhs.m_placeable_areas_cache);
+        m_wall_restrictions_cache           = std::move(rhs.m_wall_restrictions_cache);
+        m_wall_restrictions_cache_min       = std::move(rhs.m_wall_restrictions_cache_min);
+    }
+    if (reuse_avoidance) {
+        m_collision_cache_holefree          = std::move(rhs.m_collision_cache_holefree);
+        m_avoidance_cache                   = std::move(rhs.m_avoidance_cache);
+        m_avoidance_cache_slow              = std::move(rhs.m_avoidance_cache_slow);
+        m_avoidance_cache_to_model          = std::move(rhs.m_avoidance_cache_to_model);
+        m_avoidance_cache_to_model_slow     = std::move(rhs.m_avoidance_cache_to_model_slow);
+        m_avoidance_cache_holefree          = std::move(rhs.m_avoidance_cache_holefree);
+        m_avoidance_cache_holefree_to_model = std::move(rhs.m_avoidance_cache_holefree_to_model);
+    }
+    BOOST_LOG_TRIVIAL(debug) << "Tree support: " << (reuse_avoidance ? "reusing collisions and avoidances" : reuse_collision ? "reusing collisions" : "nothing to reuse") <<
+        " of the previous support generation.";
+}
+
 void TreeModelVolumes::precalculate(const PrintObject& print_object, const coord_t max_layer, std::function<void()> throw_on_cancel)
 {
     auto t_start = std::chrono::high_resolution_clock::now();
@@ -179,6 +238,14 @@ void TreeModelVolumes::precalculate(const PrintObject& print_object, const coord
         for (coord_t radius_eval = m_radius_0; radius_eval <= config.branch_radius; radius_eval = ceilRadius(radius_eval + 1))
             if (! std::binary_search(possible_tip_radiis.begin(), possible_tip_radiis.end(), radius_eval))
                 m_ignorable_radii.emplace_back(radius_eval);
+        // Tabulate the radii ceilRadius() rounds up to, now that the ignorable radii are known.
+        // The radii grow exponentially, thus the table is short.
+        m_ceil_radii.clear();
+        for (coord_t radius = m_radius_0; ; radius = ceilRadius(radius + 1)) {
+            m_ceil_radii.emplace_back(radius);
+            if (radius > scaled<coord_t>(1000.))
+                break;
+        }
     }
 
     if (throw_on_cancel)
@@ -401,11 +468,23 @@ const Polygons& TreeModelVolumes::getWallRestriction(const coord_t orig_radius,
 
 void TreeModelVolumes::calculateCollision(const std::vector<RadiusLayerPair> &keys, std::function<void()> throw_on_cancel)
 {
-    tbb::parallel_for(tbb::blocked_range<size_t>(0, keys.size()),
+    std::vector<RadiusLayerPair> polygon_keys;
+    if (m_collision_distance_field) {
+        // All the radii share the distance fields, thus they are calculated together.
+        // Radius zero calculates the placeable areas as well, which are not derived from the distance fields.
+        std::vector<RadiusLayerPair> distance_field_keys;
+        for (const RadiusLayerPair &key : keys)
+            (key.first == 0 ? polygon_keys : distance_field_keys).emplace_back(key);
+        if (! distance_field_keys.empty())
+            calculateCollisionDistanceField(distance_field_keys, throw_on_cancel);
+    } else
+        polygon_keys = keys;
+
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, polygon_keys.size()),
         [&](const tbb::blocked_range<size_t> &range) {
         for (size_t ikey = range.begin(); ikey != range.end(); ++ ikey) {
-            const LayerIndex radius        = keys[ikey].first;
-            const size_t     max_layer_idx = keys[ikey].second;
+            const LayerIndex radius        = polygon_keys[ikey].first;
+            const size_t     max_layer_idx = polygon_keys[ikey].second;
             // recursive call to parallel_for.
             calculateCollision(radius, max_layer_idx, throw_on_cancel);
         }
@@ -416,6 +495,11 @@ void TreeModelVolumes::calculateCollision(const std::vector<RadiusLayerPair> &ke
 void TreeModelVolumes::calculateCollision(const coord_t radius, const LayerIndex max_layer_idx, std::function<void()> throw_on_cancel)
 {
 //    assert(radius == this->ceilRadius(radius));
+    if (m_collision_distance_field && radius > 0) {
+        calculateCollisionDistanceField({ { radius, max_layer_idx } }, throw_on_cancel);
+        return;
+    }
+    RadiusLayerPolygonCache::ComputeTimer timer = m_collision_cache.compute_timer();
 
     // Process the outlines from least layers to most layers so that the final union will run over the longest vector.
     std::vector<size_t> layer_outline_indices(m_layer_outlines.size(), 0);
@@ -424,8 +508,12 @@ void TreeModelVolumes::calculateCollision(const coord_t radius, const LayerIndex
         [this](size_t i, size_t j) { return m_layer_outlines[i].second.size() < m_layer_outlines[j].second.size(); });
 
     // Layer range for which the collisions will be calculated.
+    const LayerIndex            start_layer = m_collision_cache.getMaxCalculatedLayer(radius) + 1;
+    if (start_layer > max_layer_idx)
+        // Already calculated, for example by a previous support generation.
+        return;
     LayerPolygonCache           data;
-    data.allocate(m_collision_cache.getMaxCalculatedLayer(radius) + 1, max_layer_idx + 1);
+    data.allocate(start_layer, max_layer_idx + 1);
 
     const bool                  calculate_placable = m_support_rests_on_model && radius == 0;
     LayerPolygonCache           data_placeable;
@@ -469,7 +557,7 @@ void TreeModelVolumes::calculateCollision(const coord_t radius, const LayerIndex
             });
 
             // 2) Sum over top / bottom ranges.
-            const bool processing_last_mesh = outline_idx == layer_outline_indices.size();
+            const bool processing_last_mesh = outline_idx == layer_outline_indices.back();
             tbb::parallel_for(tbb::blocked_range<LayerIndex>(data.begin(), data.end()),
                 [&collision_areas_offsetted, &outlines, &machine_border = m_machine_border, &anti_overhang = m_anti_overhang, radius, 
                     xy_distance, z_distance_bottom_layers, z_distance_top_layers, min_resolution = m_min_resolution, &data, processing_last_mesh, &throw_on_cancel]
@@ -579,19 +667,180 @@ void TreeModelVolumes::calculateCollision(const coord_t radius, const LayerIndex
         m_placeable_areas_cache.insert(std::move(data_placeable), radius);
 }
 
+// Pixel size of the distance fields the collisions are extracted from, the collisions are accurate to about half a pixel.
+static constexpr const double collision_distance_field_pixel_size = 0.1;
+// The pixel size is doubled until the distance fields held by a single thread fit into this number of pixels:
+// The fields of the layers in the z distance of a layer plus the collision field of the layer, each spanning all the layers of the object.
+static constexpr const double collision_distance_field_max_pixels = 4096. * 4096.;
+
+void TreeModelVolumes::calculateCollisionDistanceField(const std::vector<RadiusLayerPair> &keys, std::function<void()> throw_on_cancel)
+{
+    RadiusLayerPolygonCache::ComputeTimer timer = m_collision_cache.compute_timer();
+
+    // Radii to calculate sorted by radius, skipping the layers already calculated, for example by a previous support generation.
+    struct RadiusData {
+        coord_t             radius;
+        LayerPolygonCache   data;
+    };
+    std::vector<RadiusData> radii;
+    {
+        std::map<coord_t, LayerIndex> max_layers;
+        for (const RadiusLayerPair &key : keys) {
+            assert(key.first > 0);
+            LayerIndex &max_layer = max_layers.try_emplace(key.first, key.second).first->second;
+            max_layer = std::max(max_layer, key.second);
+        }
+        for (const auto [radius, max_layer_idx] : max_layers)
+            if (const LayerIndex start_layer = m_collision_cache.getMaxCalculatedLayer(radius) + 1; start_layer <= max_layer_idx) {
+                radii.push_back({ radius, {} });
+                radii.back().data.allocate(start_layer, max_layer_idx + 1);
+            }
+    }
+    if (radii.empty())
+        // Already calculated.
+        return;
+    const coord_t max_radius  = radii.back().radius;
+    LayerIndex    layer_begin = std::numeric_limits<LayerIndex>::max();
+    LayerIndex    layer_end   = 0;
+    for (const RadiusData &r : radii) {
+        layer_begin = std::min(layer_begin, r.data.begin());
+        layer_end   = std::max(layer_end,   r.data.end());
+    }
+
+    for (size_t outline_idx = 0; outline_idx < m_layer_outlines.size(); ++ outline_idx)
+        if (const std::vector<Polygons> &outlines = m_layer_outlines[outline_idx].second; ! outlines.empty()) {
+            // Same distances as in calculateCollision().
+            const TreeSupportMeshGroupSettings  &settings = m_layer_outlines[outline_idx].first;
+            const coord_t       layer_height              = settings.layer_height;
+            const int           z_distance_bottom_layers  = int(round(double(settings.support_bottom_distance) / double(layer_height)));
+            const int           z_distance_top_layers     = int(round(double(settings.support_top_distance) / double(layer_height)));
+            const coord_t       xy_distance               = outline_idx == m_current_outline_idx ? m_current_min_xy_dist : settings.support_xy_distance;
+            const LayerIndex    num_layers                = LayerIndex(outlines.size());
+            // The layers above the outlines still collide with the top most outlines in the z distance below them.
+            const LayerIndex    begin                     = std::min(layer_begin, num_layers + z_distance_bottom_layers);
+            const LayerIndex    end                       = std::min(layer_end, num_layers + z_distance_bottom_layers);
+
+            // Size the pixels so that the distance field of any layer is not excessively large.
+            BoundingBox bbox;
+            for (LayerIndex layer_idx = std::max<LayerIndex>(0, begin - z_distance_bottom_layers); layer_idx < std::min(num_layers, end + z_distance_top_layers); ++ layer_idx)
+                bbox.merge(get_extents(outlines[layer_idx]));
+            bbox.merge(get_extents(m_machine_border));
+            if (! bbox.defined)
+                // Nothing to collide with.
+                continue;
+            coord_t pixel_size = scaled<coord_t>(collision_distance_field_pixel_size);
+            // The distance fields of the layers extend beyond the outlines by this margin, so that the collisions of all the radii fit inside.
+            auto    margin     = [max_radius, xy_distance](coord_t pixel_size) { return max_radius + xy_distance + 2 * pixel_size; };
+            const double max_pixels = collision_distance_field_max_pixels / double(z_distance_bottom_layers + z_distance_top_layers + 2);
+            while ((double(bbox.size().x() + 2 * margin(pixel_size)) / double(pixel_size)) * (double(bbox.size().y() + 2 * margin(pixel_size)) / double(pixel_size)) > max_pixels)
+                pixel_size *= 2;
+
+            auto layer_distance_field = [&outlines, &machine_border = std::as_const(m_machine_border), pixel_size, margin = margin(pixel_size)](LayerIndex layer_idx) {
+                Polygons        collision_areas_with_border;
+                const Polygons &collision_areas = machine_border.empty() ? outlines[layer_idx] :
+                    (collision_areas_with_border = union_(machine_border, outlines[layer_idx]));
+                DistanceField   out;
+                if (! collision_areas.empty()) {
+                    BoundingBox bbox = get_extents(collision_areas);
+                    bbox.offset(margin);
+                    out = DistanceField(bbox, pixel_size);
+                    out.calculate(collision_areas);
+                }
+                return out;
+            };
+
+            tbb::parallel_for(tbb::blocked_range<LayerIndex>(begin, end, 8),
+                [&radii, &layer_distance_field, num_layers, xy_distance, z_distance_bottom_layers, z_distance_top_layers, pixel_size,
+                 min_resolution = m_min_resolution, &throw_on_cancel]
+                (const tbb::blocked_range<LayerIndex> &range) {
+                // Distance fields of the layers in the z distance of the current layer, shifted along with the current layer.
+                std::map<LayerIndex, DistanceField> layer_fields;
+                std::vector<float>                  levels;
+                std::vector<size_t>                 level_radii;
+                for (LayerIndex layer_idx = range.begin(); layer_idx != range.end(); ++ layer_idx) {
+                    const LayerIndex first_layer = std::max<LayerIndex>(0, layer_idx - z_distance_bottom_layers);
+                    const LayerIndex last_layer  = std::min<LayerIndex>(num_layers - 1, layer_idx + z_distance_top_layers);
+                    const LayerIndex last_below  = std::min<LayerIndex>(num_layers - 1, layer_idx);
+                    layer_fields.erase(layer_fields.begin(), layer_fields.lower_bound(first_layer));
+                    BoundingBox bbox;
+                    for (LayerIndex i = first_layer; i <= last_layer; ++ i) {
+                        auto it = layer_fields.find(i);
+                        if (it == layer_fields.end())
+                            it = layer_fields.emplace(i, layer_distance_field(i)).first;
+                        if (! it->second.empty())
+                            bbox.merge(it->second.bounding_box());
+                    }
+                    if (! bbox.defined)
+                        // Nothing to collide with in the z distance of this layer.
+                        continue;
+                    // The collision of radius r is the area closer than r to any of the layer outlines offsetted by the xy distance
+                    // below, and by a shrinking xy distance above, see calculateCollision().
+                    DistanceField collision(bbox, pixel_size);
+                    for (LayerIndex i = first_layer; i <= last_below; ++ i)
+                        collision.min(layer_fields[i], float(xy_distance));
+                    for (int i = 1; i <= z_distance_top_layers && layer_idx + i < num_layers; ++ i) {
+                        const coord_t required_range_x =
+                            (xy_distance - ((i - (z_distance_top_layers == 1 ? 0.5 : 0)) * xy_distance / z_distance_top_layers));
+                        collision.min(layer_fields[layer_idx + i], float(required_range_x));
+                    }
+                    levels.clear();
+                    level_radii.clear();
+                    for (size_t i = 0; i < radii.size(); ++ i)
+                        if (radii[i].data.has(layer_idx)) {
+                            levels.emplace_back(float(radii[i].radius));
+                            level_radii.emplace_back(i);
+                        }
+                    std::vector<Polygons> contours = collision.contours(levels);
+                    for (size_t i = 0; i < level_radii.size(); ++ i) {
+                        // Marching squares produce a vertex per pixel, simplify the contours down to the accuracy of the field.
+                        Polygons  collisions = polygons_simplify(contours[i], std::max(min_resolution, pixel_size / 4), polygons_strictly_simple);
+                        Polygons &dst        = radii[level_radii[i]].data[layer_idx];
+                        dst = dst.empty() ? std::move(collisions) : union_(dst, collisions);
+                    }
+                    if (throw_on_cancel)
+                        throw_on_cancel();
+                }
+            });
+        }
+
+    // Support blockers collide with all the meshes, see calculateCollision().
+    for (RadiusData &r : radii)
+        tbb::parallel_for(tbb::blocked_range<LayerIndex>(r.data.begin(), std::max(r.data.begin(), std::min(r.data.end(), LayerIndex(m_anti_overhang.size())))),
+            [&r, &anti_overhang = std::as_const(m_anti_overhang), min_resolution = m_min_resolution, &throw_on_cancel](const tbb::blocked_range<LayerIndex> &range) {
+            for (LayerIndex layer_idx = range.begin(); layer_idx != range.end(); ++ layer_idx)
+                if (! anti_overhang[layer_idx].empty()) {
+                    Polygons &dst = r.data[layer_idx];
+                    dst = polygons_simplify(union_(dst, offset(union_ex(anti_overhang[layer_idx]), r.radius, ClipperLib::jtMiter, 1.2)), min_resolution, polygons_strictly_simple);
+                    if (throw_on_cancel)
+                        throw_on_cancel();
+                }
+        });
+
+    if (throw_on_cancel)
+        throw_on_cancel();
+    for (RadiusData &r : radii)
+        m_collision_cache.insert(std::move(r.data), r.radius);
+}
+
 void TreeModelVolumes::calculateCollisionHolefree(const std::vector<RadiusLayerPair> &keys, std::function<void()> throw_on_cancel)
 {
+    RadiusLayerPolygonCache::ComputeTimer timer = m_collision_cache_holefree.compute_timer();
     LayerIndex max_layer = 0;
     for (long long unsigned int i = 0; i < keys.size(); i++)
         max_layer = std::max(max_layer, keys[i].second);
+    // Skip the layers already calculated, for example by a previous support generation.
+    std::vector<LayerIndex> start_layers;
+    start_layers.reserve(keys.size());
+    for (RadiusLayerPair key : keys)
+        start_layers.emplace_back(m_collision_cache_holefree.getMaxCalculatedLayer(key.first) + 1);
 
     tbb::parallel_for(tbb::blocked_range<LayerIndex>(0, max_layer + 1, keys.size()),
         [&](const tbb::blocked_range<LayerIndex> &range) {
         std::vector<std::pair<RadiusLayerPair, Polygons>> data;
         data.reserve(range.size() * keys.size());
         for (LayerIndex layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
-            for (RadiusLayerPair key : keys)
-                if (layer_idx <= key.second) {
+            for (size_t key_idx = 0; key_idx < keys.size(); ++ key_idx)
+                if (const RadiusLayerPair key = keys[key_idx]; layer_idx >= start_layers[key_idx] && layer_idx <= key.second) {
                     // Logically increase the collision by m_increase_until_radius
                     coord_t radius = key.first;
                     assert(radius == this->ceilRadius(radius));
@@ -654,6 +903,7 @@ void TreeModelVolumes::calculateAvoidance(const std::vector<RadiusLayerPair> &ke
         [this, &avoidance_tasks, &throw_on_cancel](const tbb::blocked_range<size_t> &range) {
         for (size_t task_idx = range.begin(); task_idx < range.end(); ++ task_idx) {
             const AvoidanceTask &task = avoidance_tasks[task_idx];
+            RadiusLayerPolygonCache::ComputeTimer timer = avoidance_cache(task.type, task.to_model).compute_timer();
             assert(! task.holefree() || task.radius < m_increase_until_radius + m_current_min_xy_dist_delta);
             if (task.to_model)
                 // ensuring Placeableareas are calculated
@@ -724,6 +974,7 @@ void TreeModelVolumes::calculatePlaceables(const std::vector<RadiusLayerPair> &k
 
 void TreeModelVolumes::calculatePlaceables(const coord_t radius, const LayerIndex max_required_layer, std::function<void()> throw_on_cancel)
 {
+    RadiusLayerPolygonCache::ComputeTimer timer = m_placeable_areas_cache.compute_timer();
     LayerIndex start_layer = 1 + m_placeable_areas_cache.getMaxCalculatedLayer(radius);
     if (start_layer > max_required_layer) {
         BOOST_LOG_TRIVIAL(debug) << "Requested calculation for value already calculated ?";
@@ -802,7 +1053,10 @@ void TreeModelVolumes::calculateWallRestrictions(const std::vector<RadiusLayerPa
         for (size_t key_idx = range.begin(); key_idx < range.end(); ++ key_idx) {
             const coord_t    radius             = keys[key_idx].first;
             const LayerIndex max_required_layer = keys[key_idx].second;
-            const coord_t    min_layer_bottom   = std::max(1, m_wall_restrictions_cache.getMaxCalculatedLayer(radius));
+            RadiusLayerPolygonCache::ComputeTimer timer = m_wall_restrictions_cache.compute_timer();
+            const coord_t    min_layer_bottom   = std::max(1, m_wall_restrictions_cache.getMaxCalculatedLayer(radius) + 1);
+            if (min_layer_bottom > max_required_layer)
+                continue;
             const size_t     buffer_size        = max_required_layer + 1 - min_layer_bottom;
             std::vector<Polygons> data(buffer_size, Polygons{});
             std::vector<Polygons> data_min;
@@ -835,6 +1089,8 @@ coord_t TreeModelVolumes::ceilRadius(const coord_t radius) const
 {
     if (radius == 0)
         return 0;
+    if (! m_ceil_radii.empty() && radius <= m_ceil_radii.back())
+        return *std::lower_bound(m_ceil_radii.begin(), m_ceil_radii.end(), radius);
 
     coord_t out = m_radius_0;
     if (radius > m_radius_0) {
@@ -860,26 +1116,238 @@ coord_t TreeModelVolumes::ceilRadius(const coord_t radius) const
     return out;
 }
 
-void TreeModelVolumes::RadiusLayerPolygonCache::allocate_layers(size_t num_layers)
+TreeModelVolumes::RadiusLayerPolygonCache& TreeModelVolumes::RadiusLayerPolygonCache::operator=(RadiusLayerPolygonCache &&rhs)
 {
-    if (num_layers > m_data.size()) {
-        if (num_layers > m_data.capacity())
-            reserve_power_of_2(m_data, num_layers);
-        m_data.resize(num_layers, {});
+    this->clear();
+    for (size_t i = 0; i < MaxChunks; ++ i)
+        m_chunks[i].store(rhs.m_chunks[i].exchange(nullptr));
+    m_num_layers.store(rhs.m_num_layers.exchange(0));
+    for (size_t i = 0; i < m_counters.size(); ++ i) {
+        m_counters[i].hits.store(rhs.m_counters[i].hits.exchange(0));
+        m_counters[i].misses.store(rhs.m_counters[i].misses.exchange(0));
     }
+    m_compute_time_ns.store(rhs.m_compute_time_ns.exchange(0));
+    return *this;
+}
+
+const TreeModelVolumes::RadiusLayerPolygonCache::Block* TreeModelVolumes::RadiusLayerPolygonCache::layer_data(LayerIndex layer_idx) const
+{
+    if (layer_idx < 0 || size_t(layer_idx) >= ChunkSize * MaxChunks)
+        return nullptr;
+    const Chunk *chunk = m_chunks[size_t(layer_idx) / ChunkSize].load(std::memory_order_acquire);
+    return chunk ? &chunk->layers[size_t(layer_idx) % ChunkSize] : nullptr;
+}
+
+TreeModelVolumes::RadiusLayerPolygonCache::Block& TreeModelVolumes::RadiusLayerPolygonCache::allocate_layer_data(LayerIndex layer_idx)
+{
+    assert(layer_idx >= 0);
+    if (size_t(layer_idx) >= ChunkSize * MaxChunks)
+        throw Slic3r::RuntimeError("Tree support: Too many layers.");
+    std::atomic<Chunk*> &slot  = m_chunks[size_t(layer_idx) / ChunkSize];
+    Chunk               *chunk = slot.load(std::memory_order_acquire);
+    if (chunk == nullptr) {
+        // Value initialized, all the entries are null.
+        auto *new_chunk = new Chunk();
+        if (slot.compare_exchange_strong(chunk, new_chunk, std::memory_order_acq_rel))
+            chunk = new_chunk;
+        else
+            // Allocated by another thread in the meantime.
+            delete new_chunk;
+    }
+    return chunk->layers[size_t(layer_idx) % ChunkSize];
+}
+
+void TreeModelVolumes::RadiusLayerPolygonCache::insert(LayerIndex layer_idx, coord_t radius, Polygons &&polygons)
+{
+    Block &layer = this->allocate_layer_data(layer_idx);
+    {
+        std::scoped_lock<std::mutex> lock(m_mutexes[size_t(layer_idx) % m_mutexes.size()]);
+        std::atomic<Entry*> *free_slot = nullptr;
+        for (Block *block = &layer; free_slot == nullptr;) {
+            for (std::atomic<Entry*> &slot : block->entries) {
+                // All writers of this layer hold the lock.
+                const Entry *entry = slot.load(std::memory_order_relaxed);
+                if (entry == nullptr) {
+                    free_slot = &slot;
+                    break;
+                }
+                if (entry->radius == radius)
+                    // Already calculated by another thread, keep the one that may already be referenced.
+                    return;
+            }
+            if (free_slot == nullptr) {
+                Block *next = block->next.load(std::memory_order_relaxed);
+                if (next == nullptr) {
+                    // Value initialized, all the entries are null.
+                    next = new Block();
+                    block->next.store(next, std::memory_order_release);
+                }
+                block = next;
+            }
+        }
+        free_slot->store(new Entry{ radius, std::move(polygons) }, std::memory_order_release);
+    }
+    for (LayerIndex num_layers = m_num_layers.load(std::memory_order_relaxed);
+         num_layers <= layer_idx && ! m_num_layers.compare_exchange_weak(num_layers, layer_idx + 1, std::memory_order_release););
+}
+
+// Call fn on the entries of a layer in the order of their insertion until fn returns true.
+template<typename Block, typename Fn>
+static inline bool radius_layer_cache_find(const Block &layer, Fn &&fn)
+{
+    for (const Block *block = &layer; block; block = block->next.load(std::memory_order_acquire))
+        for (const auto &slot : block->entries)
+            if (const auto *entry = slot.load(std::memory_order_acquire); entry == nullptr)
+                return false;
+            else if (fn(*entry))
+                return true;
+    return false;
+}
+
+TreeModelVolumes::RadiusLayerPolygonCache::Counters& TreeModelVolumes::RadiusLayerPolygonCache::counters() const
+{
+    // Thread index is -1 outside of a TBB arena, mapped to the last slot.
+    return m_counters[size_t(tbb::this_task_arena::current_thread_index()) % m_counters.size()];
+}
+
+std::optional<std::reference_wrapper<const Polygons>> TreeModelVolumes::RadiusLayerPolygonCache::getArea(const TreeModelVolumes::RadiusLayerPair &key) const
+{
+    const Polygons *out = nullptr;
+    if (const Block *layer = this->layer_data(key.second); layer)
+        radius_layer_cache_find(*layer, [&key, &out](const Entry &entry) {
+            if (entry.radius != key.first)
+                return false;
+            out = &entry.polygons;
+            return true;
+        });
+    Counters &c = this->counters();
+    if (out == nullptr) {
+        c.misses.fetch_add(1, std::memory_order_relaxed);
+        return std::optional<std::reference_wrapper<const Polygons>>{};
+    }
+    c.hits.fetch_add(1, std::memory_order_relaxed);
+    return std::optional<std::reference_wrapper<const Polygons>>{ *out };
+}
+
+std::optional<std::pair<coord_t, std::reference_wrapper<const Polygons>>> TreeModelVolumes::RadiusLayerPolygonCache::get_lower_bound_area(const TreeModelVolumes::RadiusLayerPair &key) const
+{
+    const Entry *out = nullptr;
+    if (const Block *layer = this->layer_data(key.second); layer)
+        radius_layer_cache_find(*layer, [&key, &out](const Entry &entry) {
+            if (entry.radius <= key.first && (out == nullptr || entry.radius > out->radius))
+                out = &entry;
+            return false;
+        });
+    Counters &c = this->counters();
+    if (out == nullptr) {
+        c.misses.fetch_add(1, std::memory_order_relaxed);
+        return {};
+    }
+    c.hits.fetch_add(1, std::memory_order_relaxed);
+    return std::make_pair(out->radius, std::reference_wrapper<const Polygons>(out->polygons));
+}
+
+LayerIndex TreeModelVolumes::RadiusLayerPolygonCache::getMaxCalculatedLayer(coord_t radius) const
+{
+    auto layer_idx = m_num_layers.load(std::memory_order_acquire) - 1;
+    for (; layer_idx > 0; -- layer_idx)
+        if (const Block *layer = this->layer_data(layer_idx);
+            layer && radius_layer_cache_find(*layer, [radius](const Entry &entry) { return entry.radius == radius; }))
+            break;
+    // The placeable on model areas do not exist on layer 0, as there can not be model below it. As such it may be possible that layer 1 is available, but layer 0 does not exist.
+    return layer_idx == 0 ? -1 : layer_idx;
 }
 
 // For debugging purposes, sorted by layer index, then by radius.
 std::vector<std::pair<TreeModelVolumes::RadiusLayerPair, std::reference_wrapper<const Polygons>>> TreeModelVolumes::RadiusLayerPolygonCache::sorted() const
 {
     std::vector<std::pair<RadiusLayerPair, std::reference_wrapper<const Polygons>>> out;
-    for (auto &layer : m_data) {
-        auto layer_idx = LayerIndex(&layer - m_data.data());
-        for (auto &radius_polygons : layer)
-            out.emplace_back(std::make_pair(radius_polygons.first, layer_idx), radius_polygons.second);
+    for (LayerIndex layer_idx = 0; layer_idx < m_num_layers.load(std::memory_order_acquire); ++ layer_idx)
+        if (const Block *layer = this->layer_data(layer_idx); layer) {
+            size_t begin = out.size();
+            radius_layer_cache_find(*layer, [&out, layer_idx](const Entry &entry) {
+                out.emplace_back(std::make_pair(entry.radius, layer_idx), entry.polygons);
+                return false;
+            });
+            std::sort(out.begin() + begin, out.end(), [](auto &l, auto &r){ return l.first.first < r.first.first; });
+        }
+    return out;
+}
+
+void TreeModelVolumes::RadiusLayerPolygonCache::clear()
+{
+    for (std::atomic<Chunk*> &slot : m_chunks)
+        if (Chunk *chunk = slot.exchange(nullptr); chunk) {
+            for (Block &layer : chunk->layers) {
+                for (Block *block = &layer; block;) {
+                    for (std::atomic<Entry*> &entry : block->entries)
+                        delete entry.load();
+                    Block *next = block->next.load();
+                    if (block != &layer)
+                        delete block;
+                    block = next;
+                }
+            }
+            delete chunk;
+        }
+    m_num_layers = 0;
+}
+
+void TreeModelVolumes::RadiusLayerPolygonCache::clear_all_but_radius0()
+{
+    for (LayerIndex layer_idx = 0; layer_idx < m_num_layers.load(); ++ layer_idx)
+        if (Chunk *chunk = m_chunks[size_t(layer_idx) / ChunkSize].load(); chunk) {
+            Block &layer = chunk->layers[size_t(layer_idx) % ChunkSize];
+            // Keep the entry of the smallest radius, release the others.
+            Entry *keep = nullptr;
+            for (Block *block = &layer; block;) {
+                for (std::atomic<Entry*> &slot : block->entries)
+                    if (Entry *entry = slot.exchange(nullptr); entry) {
+                        if (keep == nullptr || entry->radius < keep->radius)
+                            std::swap(keep, entry);
+                        delete entry;
+                    }
+                Block *next = block->next.exchange(nullptr);
+                if (block != &layer)
+                    delete block;
+                block = next;
+            }
+            layer.entries.front() = keep;
+        }
+}
+
+TreeModelVolumes::RadiusLayerPolygonCache::Stats TreeModelVolumes::RadiusLayerPolygonCache::stats() const
+{
+    Stats out;
+    for (const Counters &c : m_counters) {
+        out.hits   += c.hits.load(std::memory_order_relaxed);
+        out.misses += c.misses.load(std::memory_order_relaxed);
     }
-    assert(std::is_sorted(out.begin(), out.end(), [](auto &l, auto &r){ return l.first.second < r.first.second || (l.first.second == r.first.second) && l.first.first < r.first.first; }));
+    for (LayerIndex layer_idx = 0; layer_idx < m_num_layers.load(std::memory_order_acquire); ++ layer_idx)
+        if (const Block *layer = this->layer_data(layer_idx); layer)
+            radius_layer_cache_find(*layer, [&out](const Entry &) { ++ out.size; return false; });
+    out.compute_time_ms = 1e-6 * double(m_compute_time_ns.load(std::memory_order_relaxed));
     return out;
 }
 
+void TreeModelVolumes::log_cache_stats() const
+{
+    auto log = [](const RadiusLayerPolygonCache &cache, std::string_view name) {
+        RadiusLayerPolygonCache::Stats stats = cache.stats();
+        BOOST_LOG_TRIVIAL(debug) << "Tree support " << name << " cache: " << stats.hits << " hits, " << stats.misses << " misses, " <<
+            stats.size << " regions, calculated in " << stats.compute_time_ms << " ms";
+    };
+    log(m_collision_cache,                    "collision");
+    log(m_collision_cache_holefree,           "collision holefree");
+    log(m_avoidance_cache,                    "avoidance");
+    log(m_avoidance_cache_slow,               "avoidance slow");
+    log(m_avoidance_cache_to_model,           "avoidance to model");
+    log(m_avoidance_cache_to_model_slow,      "avoidance to model slow");
+    log(m_placeable_areas_cache,              "placeable areas");
+    log(m_avoidance_cache_holefree,           "avoidance holefree");
+    log(m_avoidance_cache_holefree_to_model,  "avoidance holefree to model");
+    log(m_wall_restrictions_cache,            "wall restrictions");
+    log(m_wall_restrictions_cache_min,        "wall restrictions min");
+}
+
 } // namespace Slic3r::TreeSupport3D
@@ -9,7 +9,11 @@
 #ifndef slic3r_TreeModelVolumes_hpp
 #define slic3r_TreeModelVolumes_hpp
 
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <mutex>
+#include <optional>
 #include <unordered_map>
 
 #include <boost/functional/hash.hpp>
@@ -70,6 +74,12 @@ public:
         m_wall_restrictions_cache_min.clear();
     }
 
+    // Take over the caches of volumes calculated for a previous support generation of the same object, as long as
+    // their inputs did not change: The collisions, placeable areas and wall restrictions depend on the object outlines,
+    // support blockers and on the z / xy distances, the avoidances in addition on the maximum branch moves.
+    // To be called before precalculate(), which then calculates just the radii and layers not cached yet.
+    void reuse_caches(TreeModelVolumes &&rhs);
+
     enum class AvoidanceType : int8_t
     {
         Slow,
@@ -167,6 +177,9 @@ public:
             this->ceilRadius(radius + m_current_min_xy_dist_delta) - m_current_min_xy_dist_delta;
     }
 
+    // Log the hits, misses and compute times of the collision and avoidance caches.
+    void log_cache_stats() const;
+
     Polygon m_bed_area;
 
 private:
@@ -197,74 +210,71 @@ private:
      * \brief Convenience typedef for the keys to the caches
      */
     using RadiusLayerPair             = std::pair<coord_t, LayerIndex>;
+    // Cache of one layer collision regions by layer and radius, queried from the parallel loops of the tree support generator.
+    // Lookups do not lock: layers are allocated in chunks that never move, the regions of a layer are published through
+    // atomic pointers in the order of insertion and they stay in place until the cache is cleared, thus references
+    // to the Polygons returned are stable to insertion. Insertions into the same layer are serialized by a mutex
+    // picked from a small pool by the layer index.
     class RadiusLayerPolygonCache {
-        // Map from radius to Polygons. Cache of one layer collision regions.
-        using LayerData = std::map<coord_t, Polygons>;
-        // Vector of layers, at each layer map of radius to Polygons.
-        // Reference to Polygons returned shall be stable to insertion.
-        using Layers = std::vector<LayerData>;
     public:
+        struct Stats {
+            size_t hits            { 0 };
+            size_t misses          { 0 };
+            // Number of regions cached.
+            size_t size            { 0 };
+            // Time spent calculating the regions inserted into this cache.
+            double compute_time_ms { 0. };
+        };
+
+        // Adds the time from its construction to its destruction to the compute time of the cache.
+        class ComputeTimer {
+        public:
+            explicit ComputeTimer(RadiusLayerPolygonCache &cache) : m_cache(cache), m_start(std::chrono::steady_clock::now()) {}
+            ~ComputeTimer() {
+                m_cache.m_compute_time_ns.fetch_add(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count(), std::memory_order_relaxed);
+            }
+            ComputeTimer(const ComputeTimer&) = delete;
+            ComputeTimer& operator=(const ComputeTimer&) = delete;
+        private:
+            RadiusLayerPolygonCache                 &m_cache;
+            std::chrono::steady_clock::time_point    m_start;
+        };
+
         RadiusLayerPolygonCache() = default;
-        RadiusLayerPolygonCache(RadiusLayerPolygonCache &&rhs) : m_data(std::move(rhs.m_data)) {}
-        RadiusLayerPolygonCache& operator=(RadiusLayerPolygonCache &&rhs) { m_data = std::move(rhs.m_data); return *this; }
+        RadiusLayerPolygonCache(RadiusLayerPolygonCache &&rhs) { *this = std::move(rhs); }
+        RadiusLayerPolygonCache& operator=(RadiusLayerPolygonCache &&rhs);
+        ~RadiusLayerPolygonCache() { this->clear(); }
 
         RadiusLayerPolygonCache(const RadiusLayerPolygonCache&) = delete;
         RadiusLayerPolygonCache& operator=(const RadiusLayerPolygonCache&) = delete;
 
         void insert(std::vector<std::pair<RadiusLayerPair, Polygons>> &&in) {
-            std::lock_guard<std::mutex> guard(m_mutex);
             for (auto &d : in)
-                this->get_allocate_layer_data(d.first.second).emplace(d.first.first, std::move(d.second));
+                this->insert(d.first.second, d.first.first, std::move(d.second));
         }
         // by layer
         void insert(std::vector<std::pair<coord_t, Polygons>> &&in, coord_t radius) {
-            std::lock_guard<std::mutex> guard(m_mutex);
             for (auto &d : in)
-                this->get_allocate_layer_data(d.first).emplace(radius, std::move(d.second));
+                this->insert(LayerIndex(d.first), radius, std::move(d.second));
         }
         void insert(std::vector<Polygons> &&in, coord_t first_layer_idx, coord_t radius) {
-            std::lock_guard<std::mutex> guard(m_mutex);
-            allocate_layers(first_layer_idx + in.size());
             for (auto &d : in)
-                m_data[first_layer_idx ++].emplace(radius, std::move(d));
+                this->insert(LayerIndex(first_layer_idx ++), radius, std::move(d));
         }
         void insert(LayerPolygonCache &&in, coord_t radius) {
-            std::lock_guard<std::mutex> guard(m_mutex);
             LayerIndex i = in.begin();
-            allocate_layers(i + LayerIndex(in.size()));
             for (auto &d : in.polygons_mutable())
-                m_data[i ++].emplace(radius, std::move(d));
+                this->insert(i ++, radius, std::move(d));
         }
         /*!
          * \brief Checks a cache for a given RadiusLayerPair and returns it if it is found
          * \param key RadiusLayerPair of the requested areas. The radius will be calculated up to the provided layer.
          * \return A wrapped optional reference of the requested area (if it was found, an empty optional if nothing was found)
          */
-        std::optional<std::reference_wrapper<const Polygons>> getArea(const TreeModelVolumes::RadiusLayerPair &key) const {
-            std::lock_guard<std::mutex> guard(m_mutex);
-            if (key.second >= LayerIndex(m_data.size()))
-                return std::optional<std::reference_wrapper<const Polygons>>{};
-            const auto &layer = m_data[key.second];
-            auto it = layer.find(key.first);
-            return it == layer.end() ? 
-                std::optional<std::reference_wrapper<const Polygons>>{} : std::optional<std::reference_wrapper<const Polygons>>{ it->second };
-        }
+        std::optional<std::reference_wrapper<const Polygons>> getArea(const TreeModelVolumes::RadiusLayerPair &key) const;
         // Get a collision area at a given layer for a radius that is a lower or equial to the key radius.
-        std::optional<std::pair<coord_t, std::reference_wrapper<const Polygons>>> get_lower_bound_area(const TreeModelVolumes::RadiusLayerPair &key) const {
-            std::lock_guard<std::mutex> guard(m_mutex);
-            if (key.second >= LayerIndex(m_data.size()))
-                return {};
-            const auto &layer = m_data[key.second];
-            if (layer.empty())
-                return {};
-            auto it = layer.lower_bound(key.first);
-            if (it == layer.end() || it->first != key.first) {
-                if (it == layer.begin())
-                    return {};
-                -- it;
-            }
-            return std::make_pair(it->first, std::reference_wrapper<const Polygons>(it->second));
-        }
+        std::optional<std::pair<coord_t, std::reference_wrapper<const Polygons>>> get_lower_bound_area(const TreeModelVolumes::RadiusLayerPair &key) const;
         /*!
          * \brief Get the highest already calculated layer in the cache.
          * \param radius The radius for which the highest already calculated layer has to be found.
@@ -272,38 +282,51 @@ private:
          *
          * \return A wrapped optional reference of the requested area (if it was found, an empty optional if nothing was found)
          */
-        LayerIndex getMaxCalculatedLayer(coord_t radius) const {
-            std::lock_guard<std::mutex> guard(m_mutex);
-            auto layer_idx = LayerIndex(m_data.size()) - 1;
-            for (; layer_idx > 0; -- layer_idx)
-                if (const auto &layer = m_data[layer_idx]; layer.find(radius) != layer.end())
-                    break;
-            // The placeable on model areas do not exist on layer 0, as there can not be model below it. As such it may be possible that layer 1 is available, but layer 0 does not exist.
-            return layer_idx == 0 ? -1 : layer_idx;
-        }
+        LayerIndex getMaxCalculatedLayer(coord_t radius) const;
 
         // For debugging purposes, sorted by layer index, then by radius.
         [[nodiscard]] std::vector<std::pair<RadiusLayerPair, std::reference_wrapper<const Polygons>>> sorted() const;
 
-        void clear() { m_data.clear(); }
-        void clear_all_but_radius0() { 
-            for (LayerData &l : m_data) {
-                auto begin = l.begin();
-                auto end = l.end();
-                if (begin != end && ++ begin != end)
-                    l.erase(begin, end);
-            }
-        }
+        // Not thread safe, the cache shall not be accessed by other threads while being cleared.
+        void clear();
+        void clear_all_but_radius0();
 
-    private:
-        LayerData&          get_allocate_layer_data(LayerIndex layer_idx) {
-            allocate_layers(layer_idx + 1);
-            return m_data[layer_idx];
-        }
-        void                allocate_layers(size_t num_layers);
+        ComputeTimer        compute_timer() { return ComputeTimer(*this); }
+        Stats               stats() const;
 
-        Layers              m_data;
-        mutable std::mutex  m_mutex;
+    private:
+        struct Entry {
+            coord_t                 radius;
+            Polygons                polygons;
+        };
+        // Entries of a layer, unused slots are null. Slots are filled in order, further blocks are linked once a block is full.
+        static constexpr size_t BlockSize = 8;
+        struct Block {
+            std::array<std::atomic<Entry*>, BlockSize>  entries;
+            std::atomic<Block*>                         next;
+        };
+        static constexpr size_t ChunkSize = 64;
+        static constexpr size_t MaxChunks = 1024;
+        struct Chunk {
+            std::array<Block, ChunkSize>                layers;
+        };
+        // Hit / miss counters per worker thread, so that the lookups from multiple threads do not write into the same cache line.
+        struct alignas(64) Counters {
+            std::atomic<size_t>                         hits   { 0 };
+            std::atomic<size_t>                         misses { 0 };
+        };
+
+        const Block*        layer_data(LayerIndex layer_idx) const;
+        Block&              allocate_layer_data(LayerIndex layer_idx);
+        void                insert(LayerIndex layer_idx, coord_t radius, Polygons &&polygons);
+        Counters&           counters() const;
+
+        std::array<std::atomic<Chunk*>, MaxChunks>  m_chunks {};
+        // One more than the highest layer index inserted.
+        std::atomic<LayerIndex>                     m_num_layers { 0 };
+        std::array<std::mutex, 64>                  m_mutexes;
+        mutable std::array<Counters, 64>            m_counters;
+        std::atomic<int64_t>                        m_compute_time_ns { 0 };
     };
 
 
@@ -337,6 +360,15 @@ private:
      */
     void calculateCollision(const std::vector<RadiusLayerPair> &keys, std::function<void()> throw_on_cancel);
     void calculateCollision(const coord_t radius, const LayerIndex max_layer_idx, std::function<void()> throw_on_cancel);
+    /*!
+     * \brief Creates the same areas as calculateCollision() by thresholding distance fields of the layer outlines.
+     *
+     * One distance field is calculated per layer and shared by all the requested radii, whose collisions are then extracted
+     * in a single pass of marching squares. The results are accurate to about half a pixel and rounded at the corners, where
+     * the polygon offsets are mitered. Radius zero and the placeable areas are left to calculateCollision().
+     * \param keys RadiusLayerPairs of all requested areas. Every radius will be calculated up to the provided layer.
+     */
+    void calculateCollisionDistanceField(const std::vector<RadiusLayerPair> &keys, std::function<void()> throw_on_cancel);
     /*!
      * \brief Creates the areas that have to be avoided by the tree's branches to prevent collision with the model on this layer. Holes are removed.
      *
@@ -446,6 +478,10 @@ private:
      * \brief Does at least one mesh allow support to rest on a model.
      */
     bool m_support_rests_on_model;
+    /*!
+     * \brief Are the collisions of non-zero radii calculated from distance fields instead of polygon offsets.
+     */
+    bool m_collision_distance_field { false };
 #ifdef SLIC3R_TREESUPPORTS_PROGRESS
     /*!
      * \brief The progress of the precalculate function for communicating it to the progress bar.
@@ -484,6 +520,11 @@ private:
      * \brief Radii that can be ignored by ceilRadius as they will never be requested, sorted.
      */
     std::vector<coord_t> m_ignorable_radii;
+    /*!
+     * \brief Radii ceilRadius rounds up to, sorted. Tabulated by precalculate() once the ignorable radii are known, ceilRadius
+     * looks the radius up in the table instead of stepping through the radii one by one for each cache lookup.
+     */
+    std::vector<coord_t> m_ceil_radii;
 
     /*!
      * \brief Smallest radius a branch can have. This is the radius of a SupportElement with DTT=0.
@@ -10,6 +10,7 @@
 #include "Print.hpp"
 #include "ShortestPath.hpp"
 #include "SupportCommon.hpp"
+#include "SupportFillCache.hpp"
 #include "SVG.hpp"
 #include "TreeSupportCommon.hpp"
 #include "TreeSupport.hpp"
@@ -1174,12 +1175,13 @@ static inline BoundingBox fill_expolygon_generate_paths(
     Fill                    *filler,
     const FillParams        &fill_params,
     ExtrusionRole            role,
-    const Flow              &flow)
+    const Flow              &flow,
+    SupportFillCache        *fill_cache)
 {
     Surface surface(stInternal, std::move(expolygon));
     Polylines polylines;
     try {
-        polylines = filler->fill_surface(&surface, fill_params);
+        polylines = fill_surface_cached(fill_cache, filler, surface, fill_params);
     } catch (InfillFailedException &) {
     }
 
@@ -1201,11 +1203,12 @@ static inline std::vector<BoundingBox> fill_expolygons_generate_paths(
     Fill                   *filler,
     const FillParams       &fill_params,
     ExtrusionRole           role,
-    const Flow             &flow)
+    const Flow             &flow,
+    SupportFillCache       *fill_cache)
 {
     std::vector<BoundingBox> fill_boxes;
     for (ExPolygon& expoly : expolygons) {
-        auto box = fill_expolygon_generate_paths(dst, expoly, filler, fill_params, role, flow);
+        auto box = fill_expolygon_generate_paths(dst, expoly, filler, fill_params, role, flow, fill_cache);
         fill_boxes.emplace_back(box);
     }
     return fill_boxes;
@@ -1253,7 +1256,7 @@ static void make_perimeter_and_inner_brim(ExtrusionEntitiesPtr &dst, const ExPol
     _make_loops(dst, support_area_new, role, wall_count, flow);
 }
 
-static void make_perimeter_and_infill(ExtrusionEntitiesPtr& dst, const ExPolygon& support_area, size_t wall_count, const Flow& flow, ExtrusionRole role, Fill* filler_support, double support_density, bool infill_first=true)
+static void make_perimeter_and_infill(ExtrusionEntitiesPtr& dst, const ExPolygon& support_area, size_t wall_count, const Flow& flow, ExtrusionRole role, Fill* filler_support, double support_density, SupportFillCache *fill_cache, bool infill_first=true)
 {
     Polygons   loops;
     ExPolygons support_area_new = offset_ex(support_area, -0.5f * float(flow.scaled_spacing()), jtSquare);
@@ -1263,7 +1266,7 @@ static void make_perimeter_and_infill(ExtrusionEntitiesPtr& dst, const ExPolygon
     fill_params.density = support_density;
     fill_params.dont_adjust = true;
     ExPolygons to_infill = offset_ex(support_area, -float(wall_count) * float(flow.scaled_spacing()), jtSquare);
-    std::vector<BoundingBox> fill_boxes = fill_expolygons_generate_paths(dst, to_infill, filler_support, fill_params, role, flow);
+    std::vector<BoundingBox> fill_boxes = fill_expolygons_generate_paths(dst, to_infill, filler_support, fill_params, role, flow, fill_cache);
 
     // allow wall_count to be zero, which means only draw infill
     if (wall_count == 0) {
@@ -1340,6 +1343,9 @@ void TreeSupport::generate_toolpaths()
     if (m_object->support_layers().empty())
         return;
 
+    // Rafts and the trunks of the supports produce the same support areas layer after layer, fill them once.
+    SupportFillCache fill_cache;
+
     // calculate fill areas for raft layers
     ExPolygons raft_areas;
     if (m_object->layer_count() > 0) {
@@ -1385,7 +1391,7 @@ void TreeSupport::generate_toolpaths()
             raft_areas1 = offset_ex(raft_areas1, -flow.scaled_spacing() / 2.);
         }
         fill_expolygons_generate_paths(ts_layer->support_fills.entities, raft_areas1,
-            filler_raft, fill_params, erSupportMaterial, support_flow);
+            filler_raft, fill_params, erSupportMaterial, support_flow, &fill_cache);
     }
 
     // subtract the non-raft support bases, otherwise we'll get support base on top of raft interfaces which is not stable
@@ -1419,11 +1425,11 @@ void TreeSupport::generate_toolpaths()
         fill_params.dont_adjust = true;
 
         fill_expolygons_generate_paths(ts_layer->support_fills.entities, raft_interface_areas,
-            filler_interface, fill_params, erSupportMaterialInterface, support_flow);
+            filler_interface, fill_params, erSupportMaterialInterface, support_flow, &fill_cache);
 
         fill_params.density = object_config.raft_first_layer_density * 0.01;
         fill_expolygons_generate_paths(ts_layer->support_fills.entities, raft_base_areas,
-            filler_interface, fill_params, erSupportMaterial, support_flow);
+            filler_interface, fill_params, erSupportMaterial, support_flow, &fill_cache);
     }
 
     // layers between raft and object
@@ -1434,7 +1440,7 @@ void TreeSupport::generate_toolpaths()
         filler_raft->angle = PI / 2;
         filler_raft->spacing = support_flow.spacing();
         for (auto& poly : first_non_raft_base)
-            make_perimeter_and_infill(ts_layer->support_fills.entities, poly, std::min(size_t(1), wall_count), support_flow, erSupportMaterial, filler_raft, interface_density, false);
+            make_perimeter_and_infill(ts_layer->support_fills.entities, poly, std::min(size_t(1), wall_count), support_flow, erSupportMaterial, filler_raft, interface_density, &fill_cache, false);
     }
 
     if (m_object->support_layer_count() <= m_raft_layers)
@@ -1495,7 +1501,7 @@ void TreeSupport::generate_toolpaths()
                         // generate a perimeter first to support interface better
                         ExtrusionEntityCollection* temp_support_fills = new ExtrusionEntityCollection();
                         make_perimeter_and_infill(temp_support_fills->entities, poly, 1, interface_flow, erSupportMaterial,
-                            filler_Roof1stLayer.get(), interface_density, false);
+                            filler_Roof1stLayer.get(), interface_density, &fill_cache, false);
                         temp_support_fills->no_sort = true; // make sure loops are first
                         if (!temp_support_fills->entities.empty())
                             ts_layer->support_fills.entities.push_back(temp_support_fills);
@@ -1506,7 +1512,7 @@ void TreeSupport::generate_toolpaths()
                         fill_params.density = bottom_interface_density;
                         filler_interface->spacing = interface_flow.spacing();
                         fill_expolygons_generate_paths(ts_layer->support_fills.entities, polys,
-                            filler_interface.get(), fill_params, erSupportMaterialInterface, interface_flow);
+                            filler_interface.get(), fill_params, erSupportMaterialInterface, interface_flow, &fill_cache);
                     } else if (area_group.type == SupportLayer::RoofType) {
                         // roof_areas
                         fill_params.density       = interface_density;
@@ -1519,7 +1525,7 @@ void TreeSupport::generate_toolpaths()
                             filler_interface->layer_id = area_group.interface_id;
 
                         fill_expolygons_generate_paths(ts_layer->support_fills.entities, polys, filler_interface.get(), fill_params, erSupportMaterialInterface,
-                                                       interface_flow);
+                                                       interface_flow, &fill_cache);
                     }
                     else {
                         // base_areas
@@ -1536,7 +1542,7 @@ void TreeSupport::generate_toolpaths()
                         if (layer_id == 0) {
                             float density = float(m_object_config->raft_first_layer_density.value * 0.01);
                             fill_expolygons_with_sheath_generate_paths(ts_layer->support_fills.entities, loops, filler_support.get(), density, erSupportMaterial, flow,
-                                                                       m_support_params, true, false);
+                                                                       m_support_params, true, false, &fill_cache);
                         }
                         else {
                             if (need_infill && m_support_params.base_fill_pattern != ipLightning) {
@@ -1545,7 +1551,7 @@ void TreeSupport::generate_toolpaths()
                                 // Don't need extra walls if we have infill. Extra walls may overlap with the infills.
                                 size_t min_wall_count = offset(poly, -scale_(support_spacing * 1.5)).empty() ? 1 : 0;
                                 make_perimeter_and_infill(ts_layer->support_fills.entities, poly, std::max(min_wall_count, wall_count), flow,
-                                    erSupportMaterial, filler_support.get(), support_density);
+                                    erSupportMaterial, filler_support.get(), support_density, &fill_cache);
                             }
                             else {
                                 SupportParameters support_params = m_support_params;
@@ -1663,13 +1669,18 @@ void TreeSupport::generate()
         generate_tree_support_3D(*m_object, this, this->throw_on_cancel);
         return;
     }
+    // Only the organic tree supports reuse the collisions and avoidances of the previous support generation.
+    m_object->tree_model_volumes().reset();
 
     profiler.stage_start(STAGE_total);
 
     // Generate overhang areas
     profiler.stage_start(STAGE_DETECT_OVERHANGS);
     m_object->print()->set_status(55, _u8L("Generating support"));
-    detect_overhangs();
+    {
+        SupportPhaseTimer timer(SupportPhase::ContactDetection);
+        detect_overhangs();
+    }
     profiler.stage_finish(STAGE_DETECT_OVERHANGS);
 
     create_tree_support_layers();
@@ -1682,7 +1693,10 @@ void TreeSupport::generate()
     std::vector<TreeSupport3D::SupportElements> move_bounds(m_highest_overhang_layer + 1);
     profiler.stage_start(STAGE_GENERATE_CONTACT_NODES);
     m_object->print()->set_status(56, _u8L("Support: generate contact points"));
-    generate_contact_points();
+    {
+        SupportPhaseTimer timer(SupportPhase::ContactDetection);
+        generate_contact_points();
+    }
     profiler.stage_finish(STAGE_GENERATE_CONTACT_NODES);
 
     m_ts_data->layer_heights = plan_layer_heights();
@@ -1693,19 +1707,28 @@ void TreeSupport::generate()
     drop_nodes();
     profiler.stage_finish(STAGE_DROP_DOWN_NODES);
 
-    smooth_nodes();// , tree_support_3d_config);
+    {
+        SupportPhaseTimer timer(SupportPhase::Drop);
+        smooth_nodes();// , tree_support_3d_config);
+    }
 
     //Generate support areas.
     profiler.stage_start(STAGE_DRAW_CIRCLES);
     m_object->print()->set_status(65, _u8L("Generating support"));
-    draw_circles();
+    {
+        SupportPhaseTimer timer(SupportPhase::Draw);
+        draw_circles();
+    }
     profiler.stage_finish(STAGE_DRAW_CIRCLES);
 
 
 
     profiler.stage_start(STAGE_GENERATE_TOOLPATHS);
     m_object->print()->set_status(70, _u8L("Generating support"));
-    generate_toolpaths();
+    {
+        SupportPhaseTimer timer(SupportPhase::Toolpaths);
+        generate_toolpaths();
+    }
     profiler.stage_finish(STAGE_GENERATE_TOOLPATHS);
 
     profiler.stage_finish(STAGE_total);
@@ -2449,6 +2472,7 @@ void TreeSupport::drop_nodes()
     // precalculate avoidance of all possible radii.
     // This will cause computing more (radius, layer_nr) pairs, but it's worth to do so since we are doning this in parallel.
     if (1) {
+        SupportPhaseTimer timer(SupportPhase::Avoidance);
         typedef std::chrono::high_resolution_clock clock_;
         typedef std::chrono::duration<double, std::ratio<1> > second_;
         std::chrono::time_point<clock_> t0{ clock_::now() };
@@ -2488,6 +2512,7 @@ void TreeSupport::drop_nodes()
             << ", takes " << duration << " secs.";
     }
 
+    SupportPhaseTimer timer(SupportPhase::Drop);
     m_spanning_trees.resize(contact_nodes.size());
     //m_mst_line_x_layer_contour_caches.resize(contact_nodes.size());
 
@@ -2536,68 +2561,89 @@ void TreeSupport::drop_nodes()
 
         //Group together all nodes for each part.
         const ExPolygons& parts = m_ts_data->m_layer_outlines_below[obj_layer_nr];
-        std::vector<std::unordered_map<Point, SupportNode*, PointHash>> nodes_per_part(1 + parts.size()); //All nodes that aren't inside a part get grouped together in the 0th part.
-        for (SupportNode* p_node : layer_contact_nodes)
-        {
-            const SupportNode& node = *p_node;
-
-            if (support_on_buildplate_only && !node.to_buildplate) //Can't rest on model and unable to reach the build plate. Then we must drop the node and leave parts unsupported.
-            {
-                unsupported_branch_leaves.push_front({ layer_nr, p_node });
-                continue;
-            }
-            if (node.to_buildplate || parts.empty()) //It's outside, so make it go towards the build plate.
-            {
-                nodes_per_part[0][node.position] = p_node;
-                continue;
-            }
+        // Part of each node, found in parallel. All nodes that aren't inside a part get grouped together in the 0th part, -1 for the unsupported nodes.
+        std::vector<int> part_of_node(layer_contact_nodes.size());
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, layer_contact_nodes.size()), [&](const tbb::blocked_range<size_t> &range) {
+            for (size_t node_idx = range.begin(); node_idx < range.end(); ++ node_idx) {
+                const SupportNode& node = *layer_contact_nodes[node_idx];
 
-            /* Find which part this node is located in and group the nodes in
-             * the same part together. Since nodes have a radius and the
-             * avoidance areas are offset by that radius, the set of parts may
-             * be different per node. Here we consider a node to be inside the
-             * part that is closest. The node may be inside a bigger part that
-             * is actually two parts merged together due to an offset. In that
-             * case we may incorrectly keep two nodes separate, but at least
-             * every node falls into some group.
-             */
-            coordf_t closest_part_distance2 = std::numeric_limits<coordf_t>::max();
-            size_t closest_part = -1;
-            for (size_t part_index = 0; part_index < parts.size(); part_index++)
-            {
-                //constexpr bool border_result = true;
-                if (is_inside_ex(parts[part_index], node.position)) //If it's inside, the distance is 0 and this part is considered the best.
+                if (support_on_buildplate_only && !node.to_buildplate) //Can't rest on model and unable to reach the build plate. Then we must drop the node and leave parts unsupported.
                 {
-                    closest_part = part_index;
-                    closest_part_distance2 = 0;
-                    break;
+                    part_of_node[node_idx] = -1;
+                    continue;
+                }
+                if (node.to_buildplate || parts.empty()) //It's outside, so make it go towards the build plate.
+                {
+                    part_of_node[node_idx] = 0;
+                    continue;
                 }
 
-                Point closest_point = *parts[part_index].contour.closest_point(node.position);
-                const coordf_t distance2 = vsize2_with_unscale(node.position - closest_point);
-                if (distance2 < closest_part_distance2)
+                /* Find which part this node is located in and group the nodes in
+                 * the same part together. Since nodes have a radius and the
+                 * avoidance areas are offset by that radius, the set of parts may
+                 * be different per node. Here we consider a node to be inside the
+                 * part that is closest. The node may be inside a bigger part that
+                 * is actually two parts merged together due to an offset. In that
+                 * case we may incorrectly keep two nodes separate, but at least
+                 * every node falls into some group.
+                 */
+                coordf_t closest_part_distance2 = std::numeric_limits<coordf_t>::max();
+                size_t closest_part = -1;
+                for (size_t part_index = 0; part_index < parts.size(); part_index++)
                 {
-                    closest_part_distance2 = distance2;
-                    closest_part = part_index;
+                    //constexpr bool border_result = true;
+                    if (is_inside_ex(parts[part_index], node.position)) //If it's inside, the distance is 0 and this part is considered the best.
+                    {
+                        closest_part = part_index;
+                        closest_part_distance2 = 0;
+                        break;
+                    }
+
+                    Point closest_point = *parts[part_index].contour.closest_point(node.position);
+                    const coordf_t distance2 = vsize2_with_unscale(node.position - closest_point);
+                    if (distance2 < closest_part_distance2)
+                    {
+                        closest_part_distance2 = distance2;
+                        closest_part = part_index;
+                    }
                 }
+                //Put it in the best one.
+                part_of_node[node_idx] = int(closest_part + 1); //Index + 1 because the 0th index is the outside part.
             }
-            //Put it in the best one.
-            nodes_per_part[closest_part + 1][node.position] = p_node; //Index + 1 because the 0th index is the outside part.
-        }
+        });
+        std::vector<std::unordered_map<Point, SupportNode*, PointHash>> nodes_per_part(1 + parts.size());
+        for (size_t node_idx = 0; node_idx < layer_contact_nodes.size(); ++ node_idx)
+            if (part_of_node[node_idx] < 0)
+                unsupported_branch_leaves.push_front({ layer_nr, layer_contact_nodes[node_idx] });
+            else
+                nodes_per_part[part_of_node[node_idx]][layer_contact_nodes[node_idx]->position] = layer_contact_nodes[node_idx];
+        // Nodes of each part in the order of the layer, so that the result does not depend on the thread scheduling.
+        // Of the nodes sharing a position, only the last one is kept.
+        std::vector<std::vector<SupportNode*>> nodes_vec_per_part(nodes_per_part.size());
+        for (size_t node_idx = 0; node_idx < layer_contact_nodes.size(); ++ node_idx)
+            if (int part = part_of_node[node_idx]; part >= 0 && nodes_per_part[part][layer_contact_nodes[node_idx]->position] == layer_contact_nodes[node_idx])
+                nodes_vec_per_part[part].emplace_back(layer_contact_nodes[node_idx]);
+
+        // Initialize the radii and the move distances of the circle nodes before they are read by their neighbours in parallel.
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, layer_contact_nodes.size()), [&](const tbb::blocked_range<size_t> &range) {
+            for (size_t node_idx = range.begin(); node_idx < range.end(); ++ node_idx)
+                if (part_of_node[node_idx] >= 0 && layer_contact_nodes[node_idx]->type != ePolygon)
+                    get_max_move_dist(layer_contact_nodes[node_idx]);
+        });
 
         //Create a MST for every part.
         profiler.tic();
         //std::vector<MinimumSpanningTree>& spanning_trees = m_spanning_trees[layer_nr];
-        std::vector<MinimumSpanningTree> spanning_trees;
-        for (const std::unordered_map<Point, SupportNode*, PointHash>& group : nodes_per_part)
-        {
-            std::vector<Point> points_to_buildplate;
-            for (const std::pair<const Point, SupportNode*>& entry : group)
-            {
-                points_to_buildplate.emplace_back(entry.first); //Just the position of the node.
+        std::vector<MinimumSpanningTree> spanning_trees(nodes_per_part.size());
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, nodes_per_part.size()), [&](const tbb::blocked_range<size_t> &range) {
+            for (size_t group_index = range.begin(); group_index < range.end(); ++ group_index) {
+                std::vector<Point> points_to_buildplate;
+                points_to_buildplate.reserve(nodes_vec_per_part[group_index].size());
+                for (const SupportNode *p_node : nodes_vec_per_part[group_index])
+                    points_to_buildplate.emplace_back(p_node->position); //Just the position of the node.
+                spanning_trees[group_index] = MinimumSpanningTree(std::move(points_to_buildplate));
             }
-            spanning_trees.emplace_back(points_to_buildplate);
-        }
+        });
         profiler.stage_add(STAGE_MinimumSpanningTree);
 
 #ifdef SUPPORT_TREE_DEBUG_TO_SVG
@@ -2609,51 +2655,84 @@ void TreeSupport::drop_nodes()
         {
             auto& nodes_this_part = nodes_per_part[group_index];
             const MinimumSpanningTree& mst = spanning_trees[group_index];
+            const std::vector<SupportNode*>& nodes_vec = nodes_vec_per_part[group_index];
+
             //In the first pass, merge all nodes that are close together.
-            std::vector<std::pair<const Point, SupportNode*>> nodes_vec(nodes_this_part.begin(), nodes_this_part.end());
-            tbb::parallel_for_each(nodes_vec.begin(), nodes_vec.end(), [&](const std::pair<const Point, SupportNode*>& entry) {
-                SupportNode* p_node = entry.second;
-                SupportNode& node = *p_node;
-                if (!p_node->valid)
-                {
-                    return; //Delete this node (don't create a new node for it on the next layer).
-                }
-                const std::vector<Point>& neighbours = mst.adjacent_nodes(node.position);
-                if (node.type == ePolygon) {
-                    // Remove all circle neighbours that are completely inside the polygon and merge them into this node.
-                    for (const Point &neighbour : neighbours) {
-                        SupportNode *    neighbour_node          = nodes_this_part[neighbour];
-                        if (neighbour_node->valid == false) continue;
-                        if (neighbour_node->type == ePolygon) continue;
-                        coord_t    neighbour_radius = scale_(neighbour_node->radius);
-                        Point     pt_north = neighbour + Point(0, neighbour_radius), pt_south = neighbour - Point(0, neighbour_radius),
-                              pt_west = neighbour - Point(neighbour_radius, 0), pt_east = neighbour + Point(neighbour_radius, 0);
-                        if (is_inside_ex(node.overhang, neighbour) && is_inside_ex(node.overhang, pt_north) && is_inside_ex(node.overhang, pt_south)
-                            && is_inside_ex(node.overhang, pt_west) && is_inside_ex(node.overhang, pt_east)){
-                            node.distance_to_top           = std::max(node.distance_to_top, neighbour_node->distance_to_top);
-                            node.support_roof_layers_below = std::max(node.support_roof_layers_below, neighbour_node->support_roof_layers_below);
-                            node.dist_mm_to_top            = std::max(node.dist_mm_to_top, neighbour_node->dist_mm_to_top);
-                            node.merged_neighbours.push_front(neighbour_node);
-                            node.merged_neighbours.insert(node.merged_neighbours.end(), neighbour_node->merged_neighbours.begin(), neighbour_node->merged_neighbours.end());
-                            neighbour_node->valid = false;
+            // The merge candidates of each node are searched for in parallel, then the merges are applied in the order of the nodes.
+            struct MergeCandidates {
+                // Neighbours to be merged into this node.
+                std::vector<SupportNode*> neighbours;
+                // The two last nodes of a part collapse into a new node.
+                bool                      collapse { false };
+                Point                     next_position;
+                bool                      to_buildplate { false };
+            };
+            std::vector<MergeCandidates> merge_candidates(nodes_vec.size());
+            tbb::parallel_for(tbb::blocked_range<size_t>(0, nodes_vec.size()), [&](const tbb::blocked_range<size_t> &range) {
+                for (size_t node_idx = range.begin(); node_idx < range.end(); ++ node_idx) {
+                    SupportNode* p_node = nodes_vec[node_idx];
+                    const SupportNode& node = *p_node;
+                    MergeCandidates& candidates = merge_candidates[node_idx];
+                    if (!p_node->valid)
+                        continue; //Delete this node (don't create a new node for it on the next layer).
+                    const std::vector<Point>& neighbours = mst.adjacent_nodes(node.position);
+                    if (node.type == ePolygon) {
+                        // Remove all circle neighbours that are completely inside the polygon and merge them into this node.
+                        for (const Point &neighbour : neighbours) {
+                            SupportNode *    neighbour_node          = nodes_this_part.at(neighbour);
+                            if (neighbour_node->type == ePolygon) continue;
+                            coord_t    neighbour_radius = scale_(neighbour_node->radius);
+                            Point     pt_north = neighbour + Point(0, neighbour_radius), pt_south = neighbour - Point(0, neighbour_radius),
+                                  pt_west = neighbour - Point(neighbour_radius, 0), pt_east = neighbour + Point(neighbour_radius, 0);
+                            if (is_inside_ex(node.overhang, neighbour) && is_inside_ex(node.overhang, pt_north) && is_inside_ex(node.overhang, pt_south)
+                                && is_inside_ex(node.overhang, pt_west) && is_inside_ex(node.overhang, pt_east))
+                                candidates.neighbours.emplace_back(neighbour_node);
                         }
+                    } else if (neighbours.size() == 1 && vsize2_with_unscale(neighbours[0] - node.position) < get_max_move_dist(p_node, 2) &&
+                               mst.adjacent_nodes(neighbours[0]).size() == 1 &&
+                               nodes_this_part.at(neighbours[0])->type!=ePolygon) // We have just two nodes left, and they're very close, and the only neighbor is not ePolygon
+                    {
+                        //Insert a completely new node and let both original nodes fade.
+                        Point next_position = (node.position + neighbours[0]) / 2; //Average position of the two nodes.
+                        coordf_t next_radius = calc_radius(node.dist_mm_to_top+height_next);
+                        auto avoid_layer = get_avoidance(next_radius, obj_layer_nr_next);
+                        if (group_index == 0)
+                        {
+                            //Avoid collisions.
+                            const coordf_t max_move_between_samples = max_move_distance + radius_sample_resolution + EPSILON; //100 micron extra for rounding errors.
+                            move_out_expolys(avoid_layer, next_position, radius_sample_resolution + EPSILON, max_move_between_samples);
+                        }
+                        candidates.neighbours.emplace_back(nodes_this_part.at(neighbours[0]));
+                        candidates.collapse      = true;
+                        candidates.next_position = next_position;
+                        candidates.to_buildplate = !is_inside_ex(get_collision(0, obj_layer_nr_next), next_position);
                     }
-                } else if (neighbours.size() == 1 && vsize2_with_unscale(neighbours[0] - node.position) < get_max_move_dist(p_node, 2) &&
-                           mst.adjacent_nodes(neighbours[0]).size() == 1 &&
-                           nodes_this_part[neighbours[0]]->type!=ePolygon) // We have just two nodes left, and they're very close, and the only neighbor is not ePolygon
-                {
-                    //Insert a completely new node and let both original nodes fade.
-                    Point next_position = (node.position + neighbours[0]) / 2; //Average position of the two nodes.
-                    coordf_t next_radius = calc_radius(node.dist_mm_to_top+height_next);
-                    auto avoid_layer = get_avoidance(next_radius, obj_layer_nr_next);
-                    if (group_index == 0)
+                    else if (neighbours.size() > 1) //Don't merge leaf nodes because we would then incur movement greater than the maximum move distance.
                     {
-                        //Avoid collisions.
-                        const coordf_t max_move_between_samples = max_move_distance + radius_sample_resolution + EPSILON; //100 micron extra for rounding errors.
-                        move_out_expolys(avoid_layer, next_position, radius_sample_resolution + EPSILON, max_move_between_samples);
+                        //Remove all neighbours that are too close and merge them into this node.
+                        for (const Point& neighbour : neighbours)
+                        {
+                            if (vsize2_with_unscale(neighbour - node.position) < get_max_move_dist(&node,2))
+                            {
+                                SupportNode* neighbour_node = nodes_this_part.at(neighbour);
+                                if (neighbour_node->type == ePolygon) continue;
+                                // only allow bigger node to merge smaller nodes. See STUDIO-6326
+                                if(node.dist_mm_to_top < neighbour_node->dist_mm_to_top) continue;
+                                candidates.neighbours.emplace_back(neighbour_node);
+                            }
+                        }
                     }
-
-                    SupportNode* neighbour = nodes_this_part[neighbours[0]];
+                }
+            });
+            for (size_t node_idx = 0; node_idx < nodes_vec.size(); ++ node_idx) {
+                SupportNode* p_node = nodes_vec[node_idx];
+                SupportNode& node = *p_node;
+                const MergeCandidates& candidates = merge_candidates[node_idx];
+                // A node merged into one of the nodes before is neither merged nor moved.
+                if (!p_node->valid)
+                    continue;
+                if (candidates.collapse) {
+                    SupportNode* neighbour = candidates.neighbours.front();
                     SupportNode* node_parent;
                     if (p_node->parent && neighbour->parent)
                         node_parent = (node.dist_mm_to_top >= neighbour->dist_mm_to_top) ? p_node : neighbour;
@@ -2661,46 +2740,37 @@ void TreeSupport::drop_nodes()
                         node_parent = p_node->parent ? p_node : neighbour;
                     // Make sure the next pass doesn't drop down either of these (since that already happened).
                     node_parent->merged_neighbours.push_front(node_parent == p_node ? neighbour : p_node);
-                    const bool to_buildplate = !is_inside_ex(get_collision(0, obj_layer_nr_next), next_position);
-                    SupportNode* next_node = m_ts_data->create_node(next_position, node_parent->distance_to_top + 1, obj_layer_nr_next, node_parent->support_roof_layers_below - 1, to_buildplate, node_parent,
+                    SupportNode* next_node = m_ts_data->create_node(candidates.next_position, node_parent->distance_to_top + 1, obj_layer_nr_next, node_parent->support_roof_layers_below - 1, candidates.to_buildplate, node_parent,
                         print_z_next, height_next);
                     get_max_move_dist(next_node);
-                    m_ts_data->m_mutex.lock();
                     contact_nodes[layer_nr_next].push_back(next_node);
                     neighbour->valid = false;
                     p_node->valid = false;
-                    m_ts_data->m_mutex.unlock();
+                    continue;
                 }
-                else if (neighbours.size() > 1) //Don't merge leaf nodes because we would then incur movement greater than the maximum move distance.
-                {
-                    //Remove all neighbours that are too close and merge them into this node.
-                    for (const Point& neighbour : neighbours)
-                    {
-                        if (vsize2_with_unscale(neighbour - node.position) < get_max_move_dist(&node,2))
-                        {
-                            SupportNode* neighbour_node = nodes_this_part[neighbour];
-                            if (neighbour_node->type == ePolygon) continue;
-                            // only allow bigger node to merge smaller nodes. See STUDIO-6326
-                            if(node.dist_mm_to_top < neighbour_node->dist_mm_to_top) continue;
-
-                            m_ts_data->m_mutex.lock();
-                            if (p_node->valid)
-                            {  // since we are processing all nodes in parallel, p_node may have been deleted by another thread. In this case, we should not delete neighbour_node.
-                                node.merged_neighbours.push_front(neighbour_node);
-                                node.merged_neighbours.insert(node.merged_neighbours.end(), neighbour_node->merged_neighbours.begin(), neighbour_node->merged_neighbours.end());
-                                neighbour_node->valid = false;
-                            }
-                            m_ts_data->m_mutex.unlock();
-                        }
+                for (SupportNode* neighbour_node : candidates.neighbours) {
+                    if (!neighbour_node->valid) continue;
+                    if (node.type == ePolygon) {
+                        node.distance_to_top           = std::max(node.distance_to_top, neighbour_node->distance_to_top);
+                        node.support_roof_layers_below = std::max(node.support_roof_layers_below, neighbour_node->support_roof_layers_below);
+                        node.dist_mm_to_top            = std::max(node.dist_mm_to_top, neighbour_node->dist_mm_to_top);
                     }
+                    node.merged_neighbours.push_front(neighbour_node);
+                    node.merged_neighbours.insert(node.merged_neighbours.end(), neighbour_node->merged_neighbours.begin(), neighbour_node->merged_neighbours.end());
+                    neighbour_node->valid = false;
                 }
             }
-            );
 
             //In the second pass, move all middle nodes.
-            tbb::parallel_for_each(nodes_vec.begin(), nodes_vec.end(), [&](const std::pair<const Point, SupportNode*>& entry) {
-
-                SupportNode* p_node = entry.second;
+            // The nodes are moved in parallel, their results are collected per node and applied in the order of the nodes,
+            // so that the validity of the neighbours does not change while they are being read.
+            struct DroppedNode {
+                std::vector<SupportNode*> next_nodes;
+                bool                      unsupported { false };
+                bool                      invalidate  { false };
+            };
+            std::vector<DroppedNode> dropped_nodes(nodes_vec.size());
+            auto drop_node = [&](SupportNode* p_node, DroppedNode& dropped) {
                 const SupportNode& node = *p_node;
                 if (!p_node->valid)
                 {
@@ -2717,10 +2787,7 @@ void TreeSupport::drop_nodes()
                                                                           to_buildplate, p_node, print_z_next, height_next);
                         next_node->max_move_dist = 0;
                         next_node->overhang = std::move(overhang);
-                        m_ts_data->m_mutex.lock();
-                        contact_nodes[layer_nr_next].emplace_back(next_node);
-                        m_ts_data->m_mutex.unlock();
-
+                        dropped.next_nodes.emplace_back(next_node);
                     }
                     return;
                 }
@@ -2728,7 +2795,6 @@ void TreeSupport::drop_nodes()
                 //If the branch falls completely inside a collision area (the entire branch would be removed by the X/Y offset), delete it.
                 if (group_index > 0 && is_inside_ex(get_collision(0, obj_layer_nr), node.position))
                 {
-                    std::scoped_lock lock(m_ts_data->m_mutex);
                     const coordf_t branch_radius_node = get_radius(p_node);
                     Point to_outside = projection_onto(get_collision(0, obj_layer_nr), node.position);
                     double dist2_to_outside = vsize2_with_unscale(node.position - to_outside);
@@ -2736,17 +2802,17 @@ void TreeSupport::drop_nodes()
                     {
                         if (support_on_buildplate_only)
                         {
-                            unsupported_branch_leaves.push_front({ layer_nr, p_node });
+                            dropped.unsupported = true;
                         }
                         else {
-                            p_node->valid = false;
+                            dropped.invalidate = true;
                         }
                         return;
                     }
                     // if the link between parent and current is cut by contours, mark current as bottom contact node
                     if (p_node->parent && intersection_ln({p_node->position, p_node->parent->position}, layer_contours).empty()==false)
                     {
-                        p_node->valid = false;
+                        dropped.invalidate = true;
                         return;
                     }
                 }
@@ -2765,7 +2831,7 @@ void TreeSupport::drop_nodes()
                     Point sum_direction(0, 0);
                     for (const Point &neighbour : neighbours) {
                         // do not move to the neighbor to be deleted
-                        SupportNode *neighbour_node = nodes_this_part[neighbour];
+                        SupportNode *neighbour_node = nodes_this_part.at(neighbour);
                         if (!neighbour_node->valid) continue;
 
                         Point direction = neighbour - node.position;
@@ -2867,11 +2933,20 @@ void TreeSupport::drop_nodes()
                 double dist_to_outer   = unscale_(direction_to_outer.cast<double>().norm());
                 next_node->radius      = std::max(node.radius, std::min(next_node->radius, dist_to_outer));
                 get_max_move_dist(next_node);
-                m_ts_data->m_mutex.lock();
-                contact_nodes[layer_nr_next].push_back(next_node);
-                m_ts_data->m_mutex.unlock();
+                dropped.next_nodes.emplace_back(next_node);
+            };
+            tbb::parallel_for(tbb::blocked_range<size_t>(0, nodes_vec.size()), [&](const tbb::blocked_range<size_t> &range) {
+                for (size_t node_idx = range.begin(); node_idx < range.end(); ++ node_idx)
+                    drop_node(nodes_vec[node_idx], dropped_nodes[node_idx]);
+            });
+            for (size_t node_idx = 0; node_idx < nodes_vec.size(); ++ node_idx) {
+                DroppedNode& dropped = dropped_nodes[node_idx];
+                if (dropped.unsupported)
+                    unsupported_branch_leaves.push_front({ layer_nr, nodes_vec[node_idx] });
+                if (dropped.invalidate)
+                    nodes_vec[node_idx]->valid = false;
+                append(contact_nodes[layer_nr_next], std::move(dropped.next_nodes));
             }
-            );
         }
 
 #ifdef SUPPORT_TREE_DEBUG_TO_SVG
@@ -27,6 +27,7 @@
 #include <cassert>
 #include <chrono>
 #include <fstream>
+#include <numeric>
 #include <optional>
 #include <stdio.h>
 #include <string>
@@ -1722,42 +1723,6 @@ static Point move_inside_if_outside(const Polygons &polygons, Point from, int di
     return area(check_layer_data) > _tiny_area_threshold ? std::optional<SupportElementState>(current_elem) : std::optional<SupportElementState>();
 }
 
-struct SupportElementInfluenceAreas {
-    // All influence areas: both to build plate and model.
-    Polygons                        influence_areas;
-    // Influence areas just to build plate.
-    Polygons                        to_bp_areas;
-    // Influence areas just to model.
-    Polygons                        to_model_areas;
-
-    void clear() {
-        this->influence_areas.clear();
-        this->to_bp_areas.clear();
-        this->to_model_areas.clear();
-    }
-};
-
-struct SupportElementMerging {
-    SupportElementState                     state;
-    /*!
-     * \brief All elements in the layer above the current one that are supported by this element
-     */
-    SupportElement::ParentIndices           parents;
-
-    SupportElementInfluenceAreas            areas;
-    // Bounding box of all influence areas.
-    Eigen::AlignedBox<coord_t, 2>           bbox_data;
-
-    const Eigen::AlignedBox<coord_t, 2>&    bbox() const { return bbox_data;}
-    const Point                             centroid() const { return (bbox_data.min() + bbox_data.max()) / 2; }
-    void                                    set_bbox(const BoundingBox& abbox)
-        { Point eps { coord_t(SCALED_EPSILON), coord_t(SCALED_EPSILON) }; bbox_data = { abbox.min - eps, abbox.max + eps }; }
-
-    // Called by the AABBTree builder to get an index into the vector of source elements.
-    // Not needed, thus zero is returned.
-    static size_t                           idx() { return 0; }
-};
-
 /*!
  * \brief Increases influence areas as far as required.
  *
@@ -2094,7 +2059,7 @@ static void increase_areas_one_layer(
     return out;
 }
 
-static bool merge_influence_areas_two_elements(
+bool merge_influence_areas_two_elements(
     const TreeModelVolumes &volumes, const TreeSupportSettings &config, const LayerIndex layer_idx,
     SupportElementMerging &dst, SupportElementMerging &src)
 {
@@ -2253,106 +2218,23 @@ static bool merge_influence_areas_two_elements(
     return true;
 }
 
-/*!
- * \brief Merges Influence Areas if possible.
- *
- * Branches which do overlap have to be merged. This helper merges all elements in input with the elements into reduced_new_layer.
- * Elements in input_aabb are merged together if possible, while elements reduced_new_layer_aabb are not checked against each other.
- *
- * \param reduced_aabb[in,out] The already processed elements.
- * \param input_aabb[in] Not yet processed elements
- * \param to_bp_areas[in] The Elements of the current Layer that will reach the buildplate. Value is the influence area where the center of a circle of support may be placed.
- * \param to_model_areas[in] The Elements of the current Layer that do not have to reach the buildplate. Also contains main as every element that can reach the buildplate is not forced to.
- * Value is the influence area where the center of a circle of support may be placed.
- * \param influence_areas[in] The influence areas without avoidance removed.
- * \param insert_bp_areas[out] Elements to be inserted into the main dictionary after the Helper terminates.
- * \param insert_model_areas[out] Elements to be inserted into the secondary dictionary after the Helper terminates.
- * \param insert_influence[out] Elements to be inserted into the dictionary containing the largest possibly valid influence area (ignoring if the area may not be there because of avoidance)
- * \param erase[out] Elements that should be deleted from the above dictionaries.
- * \param layer_idx[in] The Index of the current Layer.
- */
-
-static SupportElementMerging* merge_influence_areas_leaves(
-    const TreeModelVolumes &volumes, const TreeSupportSettings &config, const LayerIndex layer_idx,
-    SupportElementMerging * const dst_begin, SupportElementMerging *dst_end)
-{
-    // Merging at the lowest level of the AABB tree. Checking one against each other, O(n^2).
-    assert(dst_begin < dst_end);
-    for (SupportElementMerging *i = dst_begin; i + 1 < dst_end;) {
-        for (SupportElementMerging *j = i + 1; j != dst_end;)
-            if (merge_influence_areas_two_elements(volumes, config, layer_idx, *i, *j)) {
-                // i was merged with j, j is empty.
-                if (j != -- dst_end)
-                    *j = std::move(*dst_end);
-                goto merged;
-            } else
-                ++ j;
-        // not merged
-        ++ i;
-    merged:
-        ;
-    }
-    return dst_end;
-}
-
-static SupportElementMerging* merge_influence_areas_two_sets(
-    const TreeModelVolumes &volumes, const TreeSupportSettings &config, const LayerIndex layer_idx,
-    SupportElementMerging * const dst_begin, SupportElementMerging *       dst_end,
-    SupportElementMerging *       src_begin, SupportElementMerging * const src_end)
-{
-    // Merging src into dst.
-    // Areas of src should not overlap with areas of another elements of src.
-    // Areas of dst should not overlap with areas of another elements of dst.
-    // The memory from dst_begin to src_end is reserved for the merging operation,
-    // src follows dst.
-    assert(src_begin < src_end);
-    assert(dst_begin < dst_end);
-    assert(dst_end <= src_begin);
-    for (SupportElementMerging *src = src_begin; src != src_end; ++ src) {
-        SupportElementMerging         *dst      = dst_begin;
-        SupportElementMerging         *merged   = nullptr;
-        for (; dst != dst_end; ++ dst)
-            if (merge_influence_areas_two_elements(volumes, config, layer_idx, *dst, *src)) {
-                merged = dst ++;
-                if (src != src_begin)
-                    // Compactify src.
-                    *src = std::move(*src_begin);
-                ++ src_begin;
-                break;
-            }
-        for (; dst != dst_end;)
-            if (merge_influence_areas_two_elements(volumes, config, layer_idx, *merged, *dst)) {
-                // Compactify dst.
-                if (dst != -- dst_end)
-                    *dst = std::move(*dst_end);
-            } else
-                ++ dst;
-    }
-    // Compactify src elements that were not merged with dst to the end of dst.
-    assert(dst_end <= src_begin);
-    if (dst_end == src_begin)
-        dst_end = src_end;
-    else
-        while (src_begin != src_end)
-            *dst_end ++ = std::move(*src_begin ++);
-
-    return dst_end;
-}
-
 /*!
  * \brief Merges Influence Areas at one layer if possible.
  *
- * Branches which do overlap have to be merged. This manages the helper and uses a divide and conquer approach to parallelize this problem. This parallelization can at most accelerate the merging by a factor of 2.
+ * Branches which do overlap have to be merged. The elements are bucketed into a regular grid by the centers of their bounding boxes.
+ * The cells are large enough for two elements, which may be merged, to lie in the same or in neighbor cells, see the bounding box test
+ * of merge_influence_areas_two_elements(). The grid is processed in four phases of disjoint 2x2 blocks of cells, the blocks of a phase
+ * are merged in parallel. Each pair of neighbor cells is merged in exactly one block of one phase, thus the result does not depend
+ * on the number of threads. The few elements too large for the grid cells are merged sequentially at the end of each phase.
+ * As the merged elements grow, the merging is repeated in rounds while some elements merged, testing just the pairs with an element
+ * modified by the previous round.
  *
- * \param to_bp_areas[in] The Elements of the current Layer that will reach the buildplate.
- *  Value is the influence area where the center of a circle of support may be placed.
- * \param to_model_areas[in] The Elements of the current Layer that do not have to reach the buildplate. Also contains main as every element that can reach the buildplate is not forced to.
- *  Value is the influence area where the center of a circle of support may be placed.
- * \param influence_areas[in] The Elements of the current Layer without avoidances removed. This is the largest possible influence area for this layer.
- *  Value is the influence area where the center of a circle of support may be placed.
+ * \param volumes[in] The collisions and avoidances.
+ * \param config[in] The tree support settings.
  * \param layer_idx[in] The current layer.
+ * \param influence_areas[in,out] The Elements of the current Layer. Elements merged into other elements are removed.
  */
-static void merge_influence_areas(
+void merge_influence_areas(
     const TreeModelVolumes             &volumes,
     const TreeSupportSettings          &config,
     const LayerIndex                    layer_idx,
@@ -2360,86 +2242,164 @@ static void merge_influence_areas(
     std::function<void()>               throw_on_cancel)
 {
     const size_t input_size = influence_areas.size();
-    if (input_size == 0)
+    if (input_size < 2)
         return;
 
-    // Merging by divide & conquer.
-    // The majority of time is consumed by Clipper polygon operations, intersection is accelerated by bounding boxes.
-    // Sorting input into an AABB tree helps to perform most of the intersections at first iterations,
-    // thus reducing computation when merging larger subtrees.
-    // The actual merge logic is found in merge_influence_areas_two_sets.
-
-    // Build an AABB tree over the influence areas.
-    //FIXME A full tree does not need to be built, the lowest level branches will be always bucketed.
-    // However the additional time consumed is negligible.
-    AABBTreeIndirect::Tree<2, coord_t> tree;
-    // Sort influence_areas in place.
-    tree.build_modify_input(influence_areas);
+    // Elements merged into another element, to be removed at the end.
+    std::vector<uint8_t> merged_away(input_size, false);
+    // Elements modified by the previous round and by the current round. Pairs of unmodified elements were already tested.
+    std::vector<uint8_t> modified_prev(input_size, true);
+    std::vector<uint8_t> modified(input_size, false);
+    // Merge src into dst if possible. Called for each pair of elements by a single thread only.
+    auto try_merge = [&volumes, &config, layer_idx, &influence_areas, &merged_away, &modified_prev, &modified](size_t dst, size_t src) {
+        if (! merged_away[dst] && ! merged_away[src] && (modified_prev[dst] || modified[dst] || modified_prev[src] || modified[src]) &&
+            merge_influence_areas_two_elements(volumes, config, layer_idx, influence_areas[dst], influence_areas[src])) {
+            merged_away[src] = true;
+            modified[dst]    = true;
+        }
+    };
 
-    throw_on_cancel();
+    std::vector<Point>                      centers(input_size);
+    std::vector<coord_t>                    reaches(input_size);
+    std::vector<size_t>                     oversized;
+    // Pairs of (cell index, element index), sorted.
+    std::vector<std::pair<size_t, size_t>>  cell_elements;
+    std::vector<size_t>                     cell_begin;
+    for (bool merged = true; merged;) {
+        // Two elements may be merged if the bounding box of the one with the smaller radius offsetted by the difference of their radii
+        // intersects the bounding box of the other. Thus the distance of the centers of their bounding boxes is at most
+        // the sum of their reaches, the reach being half of the bounding box plus the radius above the smallest radius of all elements.
+        coord_t radius_min = std::numeric_limits<coord_t>::max();
+        for (size_t i = 0; i < input_size; ++ i)
+            if (! merged_away[i])
+                radius_min = std::min(radius_min, support_element_radius(config, influence_areas[i].state));
+        BoundingBox centers_bbox;
+        for (size_t i = 0; i < input_size; ++ i)
+            if (! merged_away[i]) {
+                const Eigen::AlignedBox<coord_t, 2> &bbox = influence_areas[i].bbox();
+                centers[i] = influence_areas[i].centroid();
+                reaches[i] = std::max(bbox.sizes().x(), bbox.sizes().y()) / 2 + support_element_radius(config, influence_areas[i].state) - radius_min + 1;
+                centers_bbox.merge(centers[i]);
+            }
+        // Size the cells by the reach of most elements, the rest is merged with all other elements sequentially.
+        std::vector<coord_t> sorted_reaches;
+        for (size_t i = 0; i < input_size; ++ i)
+            if (! merged_away[i])
+                sorted_reaches.emplace_back(reaches[i]);
+        const size_t num_elements = sorted_reaches.size();
+        auto it_reach = sorted_reaches.begin() + (num_elements * 9) / 10;
+        std::nth_element(sorted_reaches.begin(), it_reach, sorted_reaches.end());
+        coord_t cell_size = 2 * *it_reach;
+        // Not more cells than about four per element.
+        const Point grid_size = centers_bbox.size();
+        size_t      num_cols, num_rows;
+        for (;;) {
+            num_cols = size_t(grid_size.x() / cell_size) + 1;
+            num_rows = size_t(grid_size.y() / cell_size) + 1;
+            if (num_cols * num_rows <= 4 * num_elements + 16)
+                break;
+            cell_size *= 2;
+        }
+        // Bucket the elements into the cells, ordered by their index inside each cell.
+        oversized.clear();
+        cell_elements.clear();
+        for (size_t i = 0; i < input_size; ++ i)
+            if (! merged_away[i]) {
+                if (2 * reaches[i] > cell_size)
+                    oversized.emplace_back(i);
+                else
+                    cell_elements.emplace_back(
+                        size_t((centers[i].y() - centers_bbox.min.y()) / cell_size) * num_cols + size_t((centers[i].x() - centers_bbox.min.x()) / cell_size), i);
+            }
+        std::sort(cell_elements.begin(), cell_elements.end());
+        cell_begin.assign(num_cols * num_rows + 1, 0);
+        for (const std::pair<size_t, size_t> &ce : cell_elements)
+            ++ cell_begin[ce.first + 1];
+        std::partial_sum(cell_begin.begin(), cell_begin.end(), cell_begin.begin());
+        auto cell = [&cell_elements, &cell_begin, num_cols, num_rows](size_t col, size_t row) {
+            return col < num_cols && row < num_rows ?
+                std::make_pair(cell_elements.begin() + cell_begin[row * num_cols + col], cell_elements.begin() + cell_begin[row * num_cols + col + 1]) :
+                std::make_pair(cell_elements.end(), cell_elements.end());
+        };
 
-    // Prepare the initial buckets as ranges of influence areas. The initial buckets contain power of 2 influence areas to follow
-    // the branching of the AABB tree.
-    // Vectors of ranges of influence areas, following the branching of the AABB tree:
-    std::vector<std::pair<SupportElementMerging*, SupportElementMerging*>> buckets;
-    // Initial number of buckets for 1st round of merging.
-    size_t num_buckets_initial;
-    {
-        // How many buckets per first merge iteration?
-        const size_t num_threads     = tbb::this_task_arena::max_concurrency();
-        // 4 buckets per thread if possible,
-        const size_t num_buckets_min = (input_size + 2) / 4;
-        // 2 buckets per thread otherwise.
-        const size_t num_buckets_max = input_size / 2;
-        num_buckets_initial          = num_buckets_min >= num_threads ? num_buckets_min : num_buckets_max;
-        const size_t bucket_size     = num_buckets_min >= num_threads ? 4 : 2;
-        // Fill in the buckets.
-        SupportElementMerging *it = influence_areas.data();
-        // Reserve one more bucket to keep a single influence area which will not be merged in the first iteration.
-        buckets.reserve(num_buckets_initial + 1);
-        for (size_t i = 0; i < num_buckets_initial; ++ i, it += bucket_size)
-            buckets.emplace_back(std::make_pair(it, it + bucket_size));
-        SupportElementMerging *it_end = influence_areas.data() + influence_areas.size();
-        if (buckets.back().second >= it_end) {
-            // Last bucket is less than size 4, but bigger than size 1.
-            buckets.back().second = std::min(buckets.back().second, it_end);
-        } else {
-            // Last bucket is size 1, it will not be merged in the first iteration.
-            assert(it + 1 == it_end);
-            buckets.emplace_back(std::make_pair(it, it_end));
+        for (size_t phase = 0; phase < 4; ++ phase) {
+            // Blocks of 2x2 cells starting at even / odd columns and rows.
+            const size_t col0 = phase & 1;
+            const size_t row0 = phase >> 1;
+            const size_t num_block_cols = (num_cols - col0 + 1) / 2;
+            const size_t num_block_rows = (num_rows - row0 + 1) / 2;
+            tbb::parallel_for(tbb::blocked_range<size_t>(0, num_block_cols * num_block_rows),
+                [&cell, &try_merge, col0, row0, num_block_cols, phase, &throw_on_cancel](const tbb::blocked_range<size_t> &range) {
+                for (size_t block_idx = range.begin(); block_idx < range.end(); ++ block_idx) {
+                    const size_t col = col0 + 2 * (block_idx % num_block_cols);
+                    const size_t row = row0 + 2 * (block_idx / num_block_cols);
+                    // Cells of the block: a b
+                    //                     c d
+                    const auto a = cell(col, row);
+                    const auto b = cell(col + 1, row);
+                    const auto c = cell(col, row + 1);
+                    const auto d = cell(col + 1, row + 1);
+                    auto merge_cell = [&try_merge](const auto &cell) {
+                        for (auto i = cell.first; i != cell.second; ++ i)
+                            for (auto j = i + 1; j != cell.second; ++ j)
+                                try_merge(i->second, j->second);
+                    };
+                    auto merge_cells = [&try_merge](const auto &dst, const auto &src) {
+                        for (auto i = dst.first; i != dst.second; ++ i)
+                            for (auto j = src.first; j != src.second; ++ j)
+                                try_merge(i->second, j->second);
+                    };
+                    if (phase == 0) {
+                        // Each cell is in exactly one block of the first phase.
+                        merge_cell(a);
+                        merge_cell(b);
+                        merge_cell(c);
+                        merge_cell(d);
+                    }
+                    // Pairs of neighbor cells with the lower left cell of the pair, or the upper left cell of an anti-diagonal pair,
+                    // being the lower left cell of the block.
+                    merge_cells(a, b);
+                    merge_cells(a, c);
+                    merge_cells(a, d);
+                    merge_cells(b, c);
+                    throw_on_cancel();
+                }
+            });
         }
-    }
 
-    // 1st merge iteration, merge one with each other.
-    tbb::parallel_for(tbb::blocked_range<size_t>(0, num_buckets_initial),
-        [&](const tbb::blocked_range<size_t> &range) {
-        for (size_t idx = range.begin(); idx < range.end(); ++ idx) {
-            // Merge bucket_count adjacent to each other, merging uneven bucket numbers into even buckets
-            buckets[idx].second = merge_influence_areas_leaves(volumes, config, layer_idx, buckets[idx].first, buckets[idx].second);
+        // Merge the elements too large for the cells with each other and with the elements of the cells within their reach.
+        for (size_t i = 0; i < oversized.size(); ++ i) {
+            const size_t dst = oversized[i];
+            for (size_t j = i + 1; j < oversized.size(); ++ j)
+                try_merge(dst, oversized[j]);
+            const coord_t reach    = reaches[dst] + cell_size / 2;
+            const Point   pt_min   = centers[dst] - Point(reach, reach) - centers_bbox.min;
+            const Point   pt_max   = centers[dst] + Point(reach, reach) - centers_bbox.min;
+            const size_t  col_min  = size_t(std::max<coord_t>(0, pt_min.x() / cell_size));
+            const size_t  row_min  = size_t(std::max<coord_t>(0, pt_min.y() / cell_size));
+            const size_t  col_max  = std::min(num_cols - 1, size_t(std::max<coord_t>(0, pt_max.x() / cell_size)));
+            const size_t  row_max  = std::min(num_rows - 1, size_t(std::max<coord_t>(0, pt_max.y() / cell_size)));
+            for (size_t row = row_min; row <= row_max; ++ row)
+                for (size_t col = col_min; col <= col_max; ++ col)
+                    for (auto [it, it_end] = cell(col, row); it != it_end; ++ it)
+                        try_merge(dst, it->second);
             throw_on_cancel();
         }
-    });
 
-    // Further merge iterations, merging one AABB subtree with another one, hopefully minimizing intersections between the elements
-    // of each of the subtree.
-    while (buckets.size() > 1) {
-        tbb::parallel_for(tbb::blocked_range<size_t>(0, buckets.size() / 2),
-            [&](const tbb::blocked_range<size_t> &range) {
-            for (size_t idx = range.begin(); idx < range.end(); ++ idx) {
-                const size_t bucket_pair_idx = idx * 2;
-                // Merge bucket_count adjacent to each other, merging uneven bucket numbers into even buckets
-                buckets[bucket_pair_idx].second = merge_influence_areas_two_sets(volumes, config, layer_idx,
-                    buckets[bucket_pair_idx].first, buckets[bucket_pair_idx].second,
-                    buckets[bucket_pair_idx + 1].first, buckets[bucket_pair_idx + 1].second);
-                throw_on_cancel();
-            }
-        });
-        // Remove odd buckets, which were merged into even buckets.
-        size_t new_size = (buckets.size() + 1) / 2;
-        for (size_t i = 1; i < new_size; ++ i)
-            buckets[i] = std::move(buckets[i * 2]);
-        buckets.erase(buckets.begin() + new_size, buckets.end());
+        merged = std::find(modified.begin(), modified.end(), true) != modified.end();
+        modified_prev.swap(modified);
+        std::fill(modified.begin(), modified.end(), false);
     }
+
+    // Remove the elements merged into other elements, keeping the order of the rest.
+    size_t num_kept = 0;
+    for (size_t i = 0; i < input_size; ++ i)
+        if (! merged_away[i]) {
+            if (num_kept != i)
+                influence_areas[num_kept] = std::move(influence_areas[i]);
+            ++ num_kept;
+        }
+    influence_areas.erase(influence_areas.begin() + num_kept, influence_areas.end());
 }
 
 /*!
@@ -2468,7 +2428,7 @@ static void create_layer_pathing(const TreeModelVolumes &volumes, const TreeSupp
     // This is done by first increasing the influence area by the allowed movement distance, and merging them with other influence areas if possible
     for (int layer_idx = int(move_bounds.size()) - 1; layer_idx > 0; -- layer_idx)
         if (SupportElements &prev_layer = move_bounds[layer_idx]; ! prev_layer.empty()) {
-            // merging is expensive and only parallelized to a max speedup of 2. As such it may be useful in some cases to only merge every few layers to improve performance.
+            // merging is expensive. As such it may be useful in some cases to only merge every few layers to improve performance.
             bool had_new_element = new_element;
             const bool merge_this_layer = had_new_element || size_t(last_merge_layer_idx - layer_idx) >= merge_every_x_layers;
             if (had_new_element)
@@ -2915,8 +2875,7 @@ static std::pair<int, int> discretize_circle(const Vec3f &center, const Vec3f &n
     return { begin, int(pts.size()) };
 }
 
-// Returns Z span of the generated mesh.
-static std::pair<float, float> extrude_branch(
+std::pair<float, float> extrude_branch(
     const std::vector<const SupportElement*>&path,
     const TreeSupportSettings               &config,
     const SlicingParameters                 &slicing_params,
@@ -3012,6 +2971,228 @@ static std::pair<float, float> extrude_branch(
     return std::make_pair(zmin, zmax);
 }
 
+// Spheres (p1, r1), (p2, r2) and the spheres linearly interpolated between them sliced by a horizontal plane at z, coordinates unscaled.
+// The sphere at parameter t <0, 1> is sliced to a circle centered at c1 + dc t of squared radius q(t) = A t^2 + B t + C.
+// The union of the circles, thus the slice, is convex.
+struct SweptSphereSlice
+{
+    SweptSphereSlice(const Vec3d &p1, const double r1, const Vec3d &p2, const double r2, const double z) :
+        c1(p1.head<2>()), dc((p2 - p1).head<2>())
+    {
+        // q(t) = (r1 + dr t)^2 - (w0 - dz t)^2
+        const double dr = r2 - r1;
+        const double dz = p2.z() - p1.z();
+        const double w0 = z - p1.z();
+        A = sqr(dr) - sqr(dz);
+        B = 2. * (r1 * dr + w0 * dz);
+        C = sqr(r1) - sqr(w0);
+        // The circles vanish at the roots of q(t).
+        num_roots = solve_quadratic(A, B, C, roots);
+    }
+
+    double q(const double t) const { return (A * t + B) * t + C; }
+
+    // Radius of the largest circle of the slice, not positive if the plane misses the spheres.
+    double max_radius() const {
+        double out = std::max(q(0.), q(1.));
+        if (A < 0.)
+            if (double t = - B / (2. * A); t > 0. && t < 1.)
+                out = std::max(out, q(t));
+        return out > 0. ? std::sqrt(out) : out;
+    }
+
+    // Point of the slice furthest in direction dir, thus a point of its convex hull.
+    Vec2d furthest_point(const Vec2d &dir) const {
+        // Maximize f(t) = (c1 + dc t) . dir + sqrt(q(t)) over the ends of the segment, the ends of the range of t with q(t) >= 0
+        // and the roots of f'(t) = 0, which imply (q'(t))^2 = 4 b^2 q(t) with b = dc . dir, a quadratic equation in t.
+        const double b = dc.dot(dir);
+        double candidates[6] = { 0., 1., roots[0], roots[1] };
+        int    num_candidates = 2 + num_roots;
+        num_candidates += solve_quadratic(4. * A * (A - sqr(b)), 4. * B * (A - sqr(b)), sqr(B) - 4. * sqr(b) * C, candidates + num_candidates);
+        double f_max = - std::numeric_limits<double>::max();
+        Vec2d  out   = c1;
+        for (int i = 0; i < num_candidates; ++ i) {
+            const double t   = candidates[i];
+            const double q_t = q(t);
+            if (q_t >= 0.) {
+                const Vec2d  pt = c1 + dc * t + dir * std::sqrt(q_t);
+                const double f  = pt.dot(dir);
+                if (f > f_max) {
+                    f_max = f;
+                    out   = pt;
+                }
+            }
+        }
+        return out;
+    }
+
+    // Roots of a t^2 + b t + c = 0 inside (0, 1).
+    static int solve_quadratic(const double a, const double b, const double c, double *out) {
+        int n = 0;
+        if (std::abs(a) < EPSILON) {
+            if (std::abs(b) > EPSILON)
+                if (double t = - c / b; t > 0. && t < 1.)
+                    out[n ++] = t;
+        } else if (double d = sqr(b) - 4. * a * c; d >= 0.) {
+            d = std::sqrt(d);
+            for (double t : { (- b - d) / (2. * a), (- b + d) / (2. * a) })
+                if (t > 0. && t < 1.)
+                    out[n ++] = t;
+        }
+        return n;
+    }
+
+    Vec2d   c1;
+    Vec2d   dc;
+    double  A, B, C;
+    double  roots[2];
+    int     num_roots;
+};
+
+std::vector<Polygons> slice_branch(
+    const std::vector<const SupportElement*> &path,
+    const TreeSupportSettings                &config,
+    const SlicingParameters                  &slicing_params,
+    const LayerIndex                          layer_begin,
+    const LayerIndex                          layer_end)
+{
+    assert(path.size() >= 2);
+    // Same tolerance as extrude_branch().
+    static constexpr const double eps = 0.015;
+    std::vector<Vec3d>  centers;
+    std::vector<double> radii;
+    centers.reserve(path.size());
+    radii.reserve(path.size());
+    for (const SupportElement *element : path) {
+        centers.emplace_back(to_3d(unscaled<double>(element->state.result_on_layer), layer_z(slicing_params, config, element->state.layer_idx)));
+        radii.emplace_back(unscaled<double>(support_element_radius(config, *element)));
+    }
+
+    // The spheres swept along a straight segment with a linearly changing radius produce convex slices, thus the slices
+    // of each segment are independent, though they overlap heavily. Merge the runs of segments, which are straight and change
+    // the radius linearly up to the tolerance of the final simplification of the support areas, to reduce the number
+    // of the overlapping slices. Most of the trunks are straight.
+    const double tolerance = std::max(eps, std::min(0.03, unscaled<double>(config.resolution)));
+    auto deviates = [&centers, &radii, tolerance](size_t ibegin, size_t iend) {
+        const Vec3d  &p1 = centers[ibegin];
+        const Vec3d  &p2 = centers[iend];
+        const double  dz = p2.z() - p1.z();
+        for (size_t i = ibegin + 1; i < iend; ++ i) {
+            const double t = dz > 0. ? (centers[i].z() - p1.z()) / dz : 0.5;
+            if ((p1.head<2>() + t * (p2 - p1).head<2>() - centers[i].head<2>()).squaredNorm() > sqr(tolerance) ||
+                std::abs(radii[ibegin] + t * (radii[iend] - radii[ibegin]) - radii[i]) > tolerance)
+                return true;
+        }
+        return false;
+    };
+    // Pairs of (layer, index of the first element of a segment), the segment ending at the start of the next segment.
+    std::vector<std::pair<LayerIndex, size_t>> layer_segments;
+    std::vector<size_t>                        segment_end(path.size(), 0);
+    for (size_t ibegin = 0; ibegin + 1 < path.size();) {
+        size_t iend = ibegin + 1;
+        while (iend + 1 < path.size() && ! deviates(ibegin, iend + 1))
+            ++ iend;
+        segment_end[ibegin] = iend;
+        for (LayerIndex layer_idx = std::max(layer_begin, layer_idx_floor(slicing_params, config, std::min(centers[ibegin].z() - radii[ibegin], centers[iend].z() - radii[iend])));
+             layer_idx < std::min(layer_end, layer_idx_ceil(slicing_params, config, std::max(centers[ibegin].z() + radii[ibegin], centers[iend].z() + radii[iend])) + 1); ++ layer_idx)
+            layer_segments.emplace_back(layer_idx, ibegin);
+        ibegin = iend;
+    }
+    std::sort(layer_segments.begin(), layer_segments.end());
+
+    std::vector<Polygons>         out(std::max(0, layer_end - layer_begin));
+    std::vector<SweptSphereSlice> slices;
+    std::vector<Vec2d>            directions;
+    // Furthest points of the slices in the directions, and their distances along the directions.
+    std::vector<Vec2d>            points;
+    std::vector<double>           distances;
+    std::vector<size_t>           order;
+    std::vector<size_t>           kept;
+    for (auto it = layer_segments.begin(); it != layer_segments.end();) {
+        const LayerIndex layer_idx = it->first;
+        const double     print_z   = layer_z(slicing_params, config, layer_idx);
+        const double     bottom_z  = layer_idx > 0 ? layer_z(slicing_params, config, layer_idx - 1) : 0.;
+        const double     z         = 0.5 * (bottom_z + print_z);
+        slices.clear();
+        double radius_max = 0;
+        for (; it != layer_segments.end() && it->first == layer_idx; ++ it) {
+            const Vec3d  &p1 = centers[it->second];
+            const Vec3d  &p2 = centers[segment_end[it->second]];
+            const double  r1 = radii[it->second];
+            const double  r2 = radii[segment_end[it->second]];
+            // Shrink the spheres for their tangent cone to pass through the circles of the elements as the tube of extrude_branch() does,
+            // otherwise the tips, where the radius changes quickly, would get wider.
+            const double  length = (p2 - p1).norm();
+            const double  scale  = length / std::sqrt(sqr(length) + sqr(r2 - r1));
+            SweptSphereSlice slice{ p1, r1 * scale, p2, r2 * scale, z };
+            if (double radius = slice.max_radius(); radius > 0.) {
+                slices.emplace_back(slice);
+                radius_max = std::max(radius_max, radius);
+            }
+        }
+        if (slices.empty())
+            continue;
+        // Discretize all slices of a layer in the same directions with the step of discretize_circle().
+        const int nsteps = std::max(3, int(ceil(2. * M_PI / (2. * acos(1. - std::min(1., eps / radius_max))))));
+        directions.clear();
+        for (int i = 0; i < nsteps; ++ i)
+            directions.emplace_back(cos(2. * M_PI * i / nsteps), sin(2. * M_PI * i / nsteps));
+        points.clear();
+        distances.clear();
+        for (const SweptSphereSlice &slice : slices)
+            for (const Vec2d &dir : directions) {
+                points.emplace_back(slice.furthest_point(dir));
+                distances.emplace_back(points.back().dot(dir));
+            }
+        // Drop the slices inside another slice, which are most of the slices of a curved branch.
+        // A slice is inside another slice up to the discretization error if it is not further in any of the directions.
+        order.assign(slices.size(), 0);
+        std::iota(order.begin(), order.end(), 0);
+        auto size = [&distances, nsteps](size_t islice) { return std::accumulate(distances.begin() + islice * nsteps, distances.begin() + (islice + 1) * nsteps, 0.); };
+        std::sort(order.begin(), order.end(), [&size](size_t l, size_t r) { return size(l) > size(r); });
+        kept.clear();
+        Polygons &dst = out[layer_idx - layer_begin];
+        for (size_t islice : order) {
+            auto inside = [&distances, nsteps, islice](size_t ikept) {
+                for (int i = 0; i < nsteps; ++ i)
+                    if (distances[islice * nsteps + i] > distances[ikept * nsteps + i])
+                        return false;
+                return true;
+            };
+            if (std::any_of(kept.begin(), kept.end(), inside))
+                continue;
+            kept.emplace_back(islice);
+            Polygon polygon;
+            polygon.points.reserve(nsteps);
+            for (int i = 0; i < nsteps; ++ i) {
+                const Vec2d &pt = points[islice * nsteps + i];
+                polygon.points.emplace_back(scaled<coord_t>(pt.x()), scaled<coord_t>(pt.y()));
+            }
+            polygon.remove_duplicate_points();
+            if (polygon.size() >= 3)
+                dst.emplace_back(std::move(polygon));
+        }
+    }
+    return out;
+}
+
+// Z span of the spheres of a branch.
+static std::pair<float, float> branch_z_span(
+    const std::vector<const SupportElement*> &path,
+    const TreeSupportSettings                &config,
+    const SlicingParameters                  &slicing_params)
+{
+    auto zmin = std::numeric_limits<float>::max();
+    auto zmax = std::numeric_limits<float>::lowest();
+    for (const SupportElement *element : path) {
+        const auto z      = float(layer_z(slicing_params, config, element->state.layer_idx));
+        const auto radius = unscaled<float>(support_element_radius(config, *element));
+        zmin = std::min(zmin, z - radius);
+        zmax = std::max(zmax, z + radius);
+    }
+    return { zmin, zmax };
+}
+
 
 #ifdef TREE_SUPPORT_ORGANIC_NUDGE_NEW
 
@@ -3378,15 +3559,29 @@ static void generate_support_areas(Print &print, TreeSupport* tree_support, cons
 #endif // SLIC3R_TREESUPPORT_PROGRESS
         PrintObject &print_object = *print.get_object(processing.second.front());
         // Generator for model collision, avoidance and internal guide volumes.
-        TreeModelVolumes volumes{ print_object, build_volume, config.maximum_move_distance, config.maximum_move_distance_slow, processing.second.front(),
+        TreeModelVolumesPtr volumes_ptr{ new TreeModelVolumes{ print_object, build_volume, config.maximum_move_distance, config.maximum_move_distance_slow, processing.second.front(),
 #ifdef SLIC3R_TREESUPPORTS_PROGRESS
             m_progress_multiplier, m_progress_offset,
 #endif // SLIC3R_TREESUPPORTS_PROGRESS
-            /* additional_excluded_areas */{} };
+            /* additional_excluded_areas */{} } };
+        // Reuse the collisions and avoidances calculated by the previous support generation of this object, if still valid.
+        // They are dropped together with the slices, see PrintObject::invalidate_step().
+        if (TreeModelVolumesPtr &previous = print_object.tree_model_volumes(); previous) {
+            volumes_ptr->reuse_caches(std::move(*previous));
+            previous.reset();
+        }
+        TreeModelVolumes &volumes = *volumes_ptr;
+        // Hand the caches over to the PrintObject only once the support generation finished, as a canceled calculation
+        // may leave gaps in the caches. With the supports disabled only the raft is generated, nothing worth keeping.
+        auto keep_volumes = [&print_object, &volumes_ptr]() {
+            if (print_object.has_support())
+                print_object.tree_model_volumes() = std::move(volumes_ptr);
+        };
 
         //FIXME generating overhangs just for the first mesh of the group.
         assert(processing.second.size() == 1);
 
+        std::optional<SupportPhaseTimer> contact_timer(std::in_place, SupportPhase::ContactDetection);
 #if 1
         // use smart overhang detection
         std::vector<Polygons>        overhangs;
@@ -3421,14 +3616,19 @@ static void generate_support_areas(Print &print, TreeSupport* tree_support, cons
 #else
         std::vector<Polygons>        overhangs = generate_overhangs(config, *print.get_object(processing.second.front()), throw_on_cancel);
 #endif
+        contact_timer.reset();
         // ### Precalculate avoidances, collision etc.
+        std::optional<SupportPhaseTimer> avoidance_timer(std::in_place, SupportPhase::Avoidance);
         size_t num_support_layers = precalculate(print, overhangs, processing.first, processing.second, volumes, throw_on_cancel);
+        avoidance_timer.reset();
         bool   has_support = num_support_layers > 0;
         bool   has_raft    = config.raft_layers.size() > 0;
         num_support_layers = std::max(num_support_layers, config.raft_layers.size());
 
-        if (num_support_layers == 0)
+        if (num_support_layers == 0) {
+            keep_volumes();
             continue;
+        }
 
         SupportParameters            support_params(print_object);
         support_params.with_sheath = true;
@@ -3475,9 +3675,11 @@ static void generate_support_areas(Print &print, TreeSupport* tree_support, cons
             std::vector<SupportElements> move_bounds(num_support_layers);
 
             // ### Place tips of the support tree
+            contact_timer.emplace(SupportPhase::ContactDetection);
             for (size_t mesh_idx : processing.second)
                 generate_initial_areas(*print.get_object(mesh_idx), volumes, config, overhangs, 
                     move_bounds, interface_placer, throw_on_cancel);
+            contact_timer.reset();
             auto t_gen = std::chrono::high_resolution_clock::now();
 
 #ifdef TREESUPPORT_DEBUG_SVG
@@ -3495,15 +3697,18 @@ static void generate_support_areas(Print &print, TreeSupport* tree_support, cons
 
             // ### Propagate the influence areas downwards. This is an inherently serial operation.
             print.set_status(60, _L("Generating support"));
+            std::optional<SupportPhaseTimer> drop_timer(std::in_place, SupportPhase::Drop);
             create_layer_pathing(volumes, config, move_bounds, throw_on_cancel);
             auto t_path = std::chrono::high_resolution_clock::now();
 
             // ### Set a point in each influence area
             create_nodes_from_area(volumes, config, move_bounds, throw_on_cancel);
             auto t_place = std::chrono::high_resolution_clock::now();
+            drop_timer.reset();
 
             // ### draw these points as circles
             // this new function give correct result when raft is also enabled
+            SupportPhaseTimer branches_timer(SupportPhase::Draw);
             organic_draw_branches(
                 *print.get_object(processing.second.front()), volumes, config, move_bounds,
                 bottom_contacts, top_contacts, interface_placer, intermediate_layers, layer_storage,
@@ -3530,17 +3735,21 @@ static void generate_support_areas(Print &print, TreeSupport* tree_support, cons
                 "Influence area creation: " << dur_path << "ms "
                 "Placement of Points in InfluenceAreas: " << dur_place << "ms "
                 "Drawing result as support " << dur_draw << " ms";
+            volumes.log_cache_stats();
     //        if (config.branch_radius==2121)
     //            BOOST_LOG_TRIVIAL(error) << "Why ask questions when you already know the answer twice.\n (This is not a real bug, please dont report it.)";
             
             move_bounds.clear();
         } else if (generate_raft_contact(print_object, config, interface_placer) >= 0) {
             remove_undefined_layers();
-        } else
+        } else {
             // No raft.
+            keep_volumes();
             continue;
+        }
 
         // Produce the support G-code.
+        std::optional<SupportPhaseTimer> draw_timer(std::in_place, SupportPhase::Draw);
         SupportGeneratorLayersPtr raft_layers = generate_raft_base(print_object, support_params, print_object.slicing_parameters(), top_contacts, interface_layers, base_interface_layers, intermediate_layers, layer_storage);
         SupportGeneratorLayersPtr layers_sorted = generate_support_layers(print_object, raft_layers, bottom_contacts, top_contacts, intermediate_layers, interface_layers, base_interface_layers);
 
@@ -3549,10 +3758,15 @@ static void generate_support_areas(Print &print, TreeSupport* tree_support, cons
             if (layer) layer->polygons = intersection(layer->polygons, volumes.m_bed_area);
         });
 
+        draw_timer.reset();
+
         // Don't fill in the tree supports, make them hollow with just a single sheath line.
         print.set_status(69, _L("Generating support"));
-        generate_support_toolpaths(print_object.support_layers(), print_object.config(), support_params, print_object.slicing_parameters(),
-            raft_layers, bottom_contacts, top_contacts, intermediate_layers, interface_layers, base_interface_layers);
+        {
+            SupportPhaseTimer timer(SupportPhase::Toolpaths);
+            generate_support_toolpaths(print_object.support_layers(), print_object.config(), support_params, print_object.slicing_parameters(),
+                raft_layers, bottom_contacts, top_contacts, intermediate_layers, interface_layers, base_interface_layers);
+        }
         
         auto t_end = std::chrono::high_resolution_clock::now();
         BOOST_LOG_TRIVIAL(info) << "Total time of organic tree support: " << 0.001 * std::chrono::duration_cast<std::chrono::microseconds>(t_end - t_start).count() << " ms";
@@ -3586,13 +3800,14 @@ static void generate_support_areas(Print &print, TreeSupport* tree_support, cons
         }
 #endif /* SLIC3R_DEBUG */
 
+        keep_volumes();
         ++ counter;
     }
 
 //   storage.support.generated = true;
 }
 
-// Organic specific: Smooth branches and produce one cummulative mesh to be sliced.
+// Organic specific: Smooth branches and slice them.
 void organic_draw_branches(
     PrintObject                     &print_object,
     TreeModelVolumes                &volumes, 
@@ -3656,8 +3871,8 @@ void organic_draw_branches(
 
     organic_smooth_branches_avoid_collisions(print_object, volumes, config, move_bounds, elements_with_link_down, linear_data_layers, throw_on_cancel);
 
-    // Reduce memory footprint. After this point only finalize_interface_and_support_areas() will use volumes and from that only collisions with zero radius will be used.
-    volumes.clear_all_but_object_collision();
+    // After this point only finalize_interface_and_support_areas() will use volumes and from that only collisions with zero radius will be used.
+    // The other caches are not released, they are kept with the PrintObject to be reused by the next support generation.
 
     // Unmark all nodes.
     for (SupportElements &elements : move_bounds)
@@ -3773,33 +3988,24 @@ void organic_draw_branches(
     }
 
     const SlicingParameters &slicing_params = print_object.slicing_parameters();
-    MeshSlicingParams mesh_slicing_params;
-    mesh_slicing_params.mode = MeshSlicingParams::SlicingMode::Positive;
 
     tbb::parallel_for(tbb::blocked_range<size_t>(0, trees.size(), 1),
-        [&trees, &volumes, &config, &slicing_params, &move_bounds, &mesh_slicing_params, &throw_on_cancel](const tbb::blocked_range<size_t> &range) {
-            indexed_triangle_set    partial_mesh;
-            std::vector<float>      slice_z;
+        [&trees, &volumes, &config, &slicing_params, &throw_on_cancel](const tbb::blocked_range<size_t> &range) {
             std::vector<Polygons>   bottom_contacts;
             for (size_t tree_id = range.begin(); tree_id < range.end(); ++ tree_id) {
                 Tree &tree = trees[tree_id];
                 for (const Branch &branch : tree.branches) {
-                    // Triangulate the tube.
-                    partial_mesh.clear();
-                    std::pair<float, float> zspan = extrude_branch(branch.path, config, slicing_params, move_bounds, partial_mesh);
+                    std::pair<float, float> zspan = branch_z_span(branch.path, config, slicing_params);
                     LayerIndex layer_begin = branch.has_root ?
                         branch.path.front()->state.layer_idx : 
                         std::min(branch.path.front()->state.layer_idx, layer_idx_ceil(slicing_params, config, zspan.first));
                     LayerIndex layer_end   = (branch.has_tip ?
                         branch.path.back()->state.layer_idx :
                         std::max(branch.path.back()->state.layer_idx, layer_idx_floor(slicing_params, config, zspan.second))) + 1;
-                    slice_z.clear();
-                    for (LayerIndex layer_idx = layer_begin; layer_idx < layer_end; ++ layer_idx) {
-                        const double print_z  = layer_z(slicing_params, config, layer_idx);
-                        const double bottom_z = layer_idx > 0 ? layer_z(slicing_params, config, layer_idx - 1) : 0.;
-                        slice_z.emplace_back(float(0.5 * (bottom_z + print_z)));
-                    }
-                    std::vector<Polygons> slices = slice_mesh(partial_mesh, slice_z, mesh_slicing_params, throw_on_cancel);
+                    // Slice the branch layer by layer without triangulating it. The slices of the segments overlap,
+                    // they are merged by the clipping with the collision below.
+                    std::vector<Polygons> slices = slice_branch(branch.path, config, slicing_params, layer_begin, layer_end);
+                    throw_on_cancel();
                     bottom_contacts.clear();
                     //FIXME parallelize?
                     for (LayerIndex i = 0; i < LayerIndex(slices.size()); ++i) {
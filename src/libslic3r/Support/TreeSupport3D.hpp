@@ -19,6 +19,8 @@
 
 #include <boost/container/small_vector.hpp>
 
+struct indexed_triangle_set;
+
 
 // #define TREE_SUPPORT_SHOW_ERRORS
 
@@ -292,7 +294,80 @@ using SupportElements = std::deque<SupportElement>;
     return support_element_collision_radius(settings, elem.state);
 }
 
-// Organic specific: Smooth branches and produce one cummulative mesh to be sliced.
+struct SupportElementInfluenceAreas {
+    // All influence areas: both to build plate and model.
+    Polygons                        influence_areas;
+    // Influence areas just to build plate.
+    Polygons                        to_bp_areas;
+    // Influence areas just to model.
+    Polygons                        to_model_areas;
+
+    void clear() {
+        this->influence_areas.clear();
+        this->to_bp_areas.clear();
+        this->to_model_areas.clear();
+    }
+};
+
+struct SupportElementMerging {
+    SupportElementState                     state;
+    /*!
+     * \brief All elements in the layer above the current one that are supported by this element
+     */
+    SupportElement::ParentIndices           parents;
+
+    SupportElementInfluenceAreas            areas;
+    // Bounding box of all influence areas.
+    Eigen::AlignedBox<coord_t, 2>           bbox_data;
+
+    const Eigen::AlignedBox<coord_t, 2>&    bbox() const { return bbox_data;}
+    const Point                             centroid() const { return (bbox_data.min() + bbox_data.max()) / 2; }
+    void                                    set_bbox(const BoundingBox& abbox)
+        { Point eps { coord_t(SCALED_EPSILON), coord_t(SCALED_EPSILON) }; bbox_data = { abbox.min - eps, abbox.max + eps }; }
+
+    // Called by the AABBTree builder to get an index into the vector of source elements.
+    // Not needed, thus zero is returned.
+    static size_t                           idx() { return 0; }
+};
+
+// Merge src into dst if their influence areas overlap enough, leaving src empty. Returns false if the elements cannot be merged.
+bool merge_influence_areas_two_elements(
+    const TreeModelVolumes              &volumes,
+    const TreeSupportSettings           &config,
+    const LayerIndex                     layer_idx,
+    SupportElementMerging               &dst,
+    SupportElementMerging               &src);
+
+// Merge the influence areas of one layer, which overlap, in parallel. The result does not depend on the number of threads.
+void merge_influence_areas(
+    const TreeModelVolumes              &volumes,
+    const TreeSupportSettings           &config,
+    const LayerIndex                     layer_idx,
+    std::vector<SupportElementMerging>  &influence_areas,
+    std::function<void()>                throw_on_cancel);
+
+// Organic specific: Triangulate a branch as a tube through circles at its elements closed by half spheres.
+// Returns Z span of the generated mesh.
+std::pair<float, float> extrude_branch(
+    const std::vector<const SupportElement*>&path,
+    const TreeSupportSettings               &config,
+    const SlicingParameters                 &slicing_params,
+    const std::vector<SupportElements>      &move_bounds,
+    indexed_triangle_set                    &result);
+
+// Organic specific: Slice a branch, the spheres at its elements swept along the path, at the middle of layers <layer_begin, layer_end).
+// Calculated analytically layer by layer, equivalent to slicing the mesh of extrude_branch() up to the rounding of the bends:
+// The slices are at most 0.1 mm larger than the mesh slices, except for the top two layers of the half sphere closing the tip,
+// which extrude_branch() approximates with few rings, there the slices are up to 0.25 mm larger.
+// Each layer contains overlapping convex polygons, one for each segment of the path reaching the layer, to be merged with the non-zero fill rule.
+std::vector<Polygons> slice_branch(
+    const std::vector<const SupportElement*> &path,
+    const TreeSupportSettings                &config,
+    const SlicingParameters                  &slicing_params,
+    LayerIndex                                layer_begin,
+    LayerIndex                                layer_end);
+
+// Organic specific: Smooth branches and slice them.
 void organic_draw_branches(
     PrintObject                     &print_object,
     TreeModelVolumes                &volumes, 
@@ -0,0 +1,48 @@
+#include "benchmark_allocations.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<size_t> g_num_allocations { 0 };
+std::atomic<size_t> g_allocated_bytes { 0 };
+std::atomic<size_t> g_peak_allocated_bytes { 0 };
+
+// The size of an allocation is stored in front of it, keeping the alignment of malloc().
+constexpr size_t HeaderSize = alignof(std::max_align_t);
+
+} // anonymous namespace
+
+void* operator new(std::size_t size)
+{
+    ++ g_num_allocations;
+    if (void *ptr = std::malloc(size + HeaderSize)) {
+        *static_cast<size_t*>(ptr) = size;
+        size_t allocated = g_allocated_bytes += size;
+        for (size_t peak = g_peak_allocated_bytes; allocated > peak && ! g_peak_allocated_bytes.compare_exchange_weak(peak, allocated););
+        return static_cast<char*>(ptr) + HeaderSize;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept
+{
+    if (ptr) {
+        void *block = static_cast<char*>(ptr) - HeaderSize;
+        g_allocated_bytes -= *static_cast<size_t*>(block);
+        std::free(block);
+    }
+}
+
+void operator delete(void *ptr, std::size_t) noexcept { operator delete(ptr); }
+
+namespace Slic3r::Benchmark {
+
+size_t num_allocations()            { return g_num_allocations; }
+size_t allocated_bytes()            { return g_allocated_bytes; }
+size_t peak_allocated_bytes()       { return g_peak_allocated_bytes; }
+void   reset_peak_allocated_bytes() { g_peak_allocated_bytes = size_t(g_allocated_bytes); }
+
+} // namespace Slic3r::Benchmark
@@ -0,0 +1,20 @@
+#ifndef slic3r_benchmark_allocations_hpp_
+#define slic3r_benchmark_allocations_hpp_
+
+#include <cstddef>
+
+// Counters of the global operator new, which is replaced by the benchmarks executable.
+// Over-aligned allocations are not counted.
+namespace Slic3r::Benchmark {
+
+// Number of allocations since the start of the process.
+size_t num_allocations();
+// Bytes allocated and not freed yet.
+size_t allocated_bytes();
+// Maximum of allocated_bytes() since the last reset_peak_allocated_bytes().
+size_t peak_allocated_bytes();
+void   reset_peak_allocated_bytes();
+
+} // namespace Slic3r::Benchmark
+
+#endif // slic3r_benchmark_allocations_hpp_
@@ -0,0 +1,353 @@
+// Infill generation benchmark, built as a separate executable fff_print_benchmarks, as it replaces the global operator new
+// to count allocations (see benchmark_allocations.cpp). Not run by default, execute with "[FillBenchmark]":
+//
+//     fff_print_benchmarks "[FillBenchmark]"
+//
+// The fill surfaces of all layers of a set of sample prints are recorded, then every infill pattern is generated over
+// the recorded sparse surfaces at several densities and the solid patterns over the recorded solid surfaces.
+// A table is printed to stdout and the results are written as JSON for regression tracking to the file named by
+// SLIC3R_FILL_BENCHMARK_JSON (fill_benchmark.json by default). SLIC3R_FILL_BENCHMARK_REPEATS sets the number of runs
+// of each pattern, of which the fastest one is reported.
+
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#include "nlohmann/json.hpp"
+
+#include "libslic3r/ClipperUtils.hpp"
+#include "libslic3r/ExtrusionEntityCollection.hpp"
+#include "libslic3r/Fill/Fill.hpp"
+#include "libslic3r/Fill/FillAdaptive.hpp"
+#include "libslic3r/Fill/FillLightning.hpp"
+#include "libslic3r/Fill/Lightning/Generator.hpp"
+#include "libslic3r/Format/OBJ.hpp"
+#include "libslic3r/Geometry.hpp"
+#include "libslic3r/Model.hpp"
+#include "libslic3r/Print.hpp"
+#include "libslic3r/Tesselate.hpp"
+#include "libslic3r/libslic3r.h"
+
+#include "benchmark_allocations.hpp"
+#include "test_data.hpp"
+
+using namespace Slic3r;
+
+namespace {
+
+// Fill surfaces of a single region of a single layer of a sample print.
+struct RecordedRegion {
+    const LayerRegion *layerm;
+    ExPolygons         sparse;
+    ExPolygons         solid;
+    Flow               sparse_flow;
+    Flow               solid_flow;
+};
+
+struct RecordedLayer {
+    const Layer                 *layer;
+    std::vector<RecordedRegion>  regions;
+};
+
+// The print is kept alive with its model, the fillers reference the print and object configs,
+// the octrees are built over the model object mesh.
+struct Sample {
+    std::string                 name;
+    Model                       model;
+    std::unique_ptr<Print>      print;
+    const PrintObject          *object { nullptr };
+    std::vector<RecordedLayer>  layers;
+};
+
+std::unique_ptr<Sample> record_sample(const std::string &name, TriangleMesh &&mesh)
+{
+    auto sample   = std::make_unique<Sample>();
+    sample->name  = name;
+    sample->print = std::make_unique<Print>();
+    Test::init_print({ std::move(mesh) }, *sample->print, sample->model, {
+        { "layer_height",          0.2 },
+        { "wall_loops",            2 },
+        { "top_shell_layers",      3 },
+        { "bottom_shell_layers",   3 },
+        { "sparse_infill_density", "20%" },
+        { "sparse_infill_pattern", "zig-zag" }
+    });
+    sample->print->process();
+    sample->object = sample->print->objects().front();
+    for (const Layer *layer : sample->object->layers()) {
+        RecordedLayer &rl = sample->layers.emplace_back();
+        rl.layer = layer;
+        for (const LayerRegion *layerm : layer->regions()) {
+            RecordedRegion &rr = rl.regions.emplace_back();
+            rr.layerm = layerm;
+            for (const Surface &surface : layerm->fill_surfaces.surfaces)
+                if (surface.surface_type == stInternal)
+                    rr.sparse.emplace_back(surface.expolygon);
+                else if (surface.surface_type == stInternalSolid || surface.surface_type == stTop || surface.surface_type == stBottom)
+                    rr.solid.emplace_back(surface.expolygon);
+            rr.sparse_flow = layerm->flow(frInfill);
+            rr.solid_flow  = layerm->flow(frSolidInfill);
+        }
+    }
+    return sample;
+}
+
+TriangleMesh load_sample_mesh(const std::string &obj_filename)
+{
+    TriangleMesh mesh;
+    ObjInfo      obj_info;
+    std::string  message;
+    std::string  path = std::string(TEST_DATA_DIR) + "/" + obj_filename;
+    REQUIRE(load_obj(path.c_str(), &mesh, obj_info, message));
+    return mesh;
+}
+
+Polygons sparse_area(const RecordedLayer &layer)
+{
+    Polygons out;
+    for (const RecordedRegion &region : layer.regions)
+        append(out, to_polygons(region.sparse));
+    return out;
+}
+
+// Lightning trees over the recorded sparse surfaces, the overhangs are calculated the same way as by the Lightning
+// generator of a print object.
+FillLightning::GeneratorPtr build_lightning(const Sample &sample, float density)
+{
+    const coord_t layer_thickness = scaled<coord_t>(sample.object->config().layer_height.value);
+    const coord_t infill_width    = sample.layers.front().regions.front().sparse_flow.scaled_width();
+    std::vector<Polygons> contours(sample.layers.size());
+    std::vector<Polygons> overhangs(sample.layers.size());
+    Polygons              area_above;
+    for (int layer_id = int(sample.layers.size()) - 1; layer_id >= 0; -- layer_id) {
+        contours[layer_id]  = sparse_area(sample.layers[layer_id]);
+        overhangs[layer_id] = diff(offset(contours[layer_id], - float(layer_thickness)), area_above);
+        area_above          = contours[layer_id];
+    }
+    return FillLightning::GeneratorPtr(new FillLightning::Generator(contours, std::move(overhangs), infill_width, layer_thickness, density, []{}));
+}
+
+// Adaptive cubic and support cubic octrees over the model object mesh, densified below the solid surfaces
+// resting on the sparse infill.
+std::pair<FillAdaptive::OctreePtr, FillAdaptive::OctreePtr> build_octrees(const Sample &sample, float density)
+{
+    indexed_triangle_set mesh      = sample.object->model_object()->raw_indexed_triangle_set();
+    auto                 to_octree = FillAdaptive::transform_to_octree().toRotationMatrix();
+    its_transform(mesh, to_octree * sample.object->trafo_centered(), true);
+    std::vector<Vec3d> overhangs;
+    for (size_t layer_id = 1; layer_id < sample.layers.size(); ++ layer_id) {
+        Polygons below = sparse_area(sample.layers[layer_id - 1]);
+        for (const RecordedRegion &region : sample.layers[layer_id].regions)
+            for (const ExPolygon &expolygon : intersection_ex(region.solid, below))
+                append(overhangs, triangulate_expolygon_3d(expolygon, sample.layers[layer_id].layer->bottom_z()));
+    }
+    for (Vec3d &p : overhangs)
+        p = (to_octree * p).eval();
+    const double line_spacing = sample.layers.front().regions.front().sparse_flow.spacing() / (density * 0.333333333);
+    return FillAdaptive::build_octrees(mesh, overhangs, line_spacing, line_spacing);
+}
+
+struct FillResult {
+    size_t surfaces    { 0 };
+    size_t polylines   { 0 };
+    size_t points      { 0 };
+    double length      { 0. };
+    size_t allocations { 0 };
+    double time_ms     { 0. };
+};
+
+// Fill all the recorded surfaces of the sample the same way Layer::make_fills() does.
+FillResult fill_sample(const Sample &sample, InfillPattern pattern, float density, bool solid,
+    FillAdaptive::Octree *adaptive_octree, FillAdaptive::Octree *support_octree, FillLightning::Generator *lightning)
+{
+    FillResult                 result;
+    const BoundingBox          bbox       = sample.object->bounding_box();
+    const double               resolution = sample.print->config().resolution.value;
+    ExtrusionEntityCollection  extrusions;
+    size_t                     num_allocations = Benchmark::num_allocations();
+    auto                       t0 = std::chrono::high_resolution_clock::now();
+    for (const RecordedLayer &layer : sample.layers)
+        for (const RecordedRegion &region : layer.regions) {
+            const ExPolygons &expolygons = solid ? region.solid : region.sparse;
+            if (expolygons.empty())
+                continue;
+            const PrintRegionConfig &region_config = region.layerm->region().config();
+            const Flow               flow          = solid ? region.solid_flow : region.sparse_flow;
+            std::unique_ptr<Fill>    f(Fill::new_from_type(pattern));
+            f->set_bounding_box(bbox);
+            f->layer_id            = layer.layer->id();
+            f->z                   = layer.layer->print_z;
+            f->angle               = float(Geometry::deg2rad(solid ? region_config.solid_infill_direction.value : region_config.infill_direction.value));
+            f->adapt_fill_octree   = pattern == ipSupportCubic ? support_octree : adaptive_octree;
+            f->print_config        = &sample.print->config();
+            f->print_object_config = &sample.object->config();
+            if (pattern == ipLightning)
+                dynamic_cast<FillLightning::Filler*>(f.get())->generator = lightning;
+            f->link_max_length     = density > 0.8f ? coord_t(scale_(3. * flow.spacing())) : 0;
+            f->loop_clipping       = coord_t(scale_(region_config.seam_gap.get_abs_value(flow.nozzle_diameter())));
+
+            FillParams params;
+            params.density         = density;
+            params.multiline       = solid ? 1 : int(region_config.fill_multiline);
+            params.resolution      = resolution;
+            params.use_arachne     = pattern == ipConcentric || pattern == ipConcentricInternal;
+            params.layer_height    = layer.layer->height;
+            params.lattice_angle_1 = region_config.lattice_angle_1;
+            params.lattice_angle_2 = region_config.lattice_angle_2;
+            params.infill_overhang_angle = region_config.infill_overhang_angle;
+            params.flow            = flow;
+            params.extrusion_role  = solid ? erSolidInfill : erInternalInfill;
+            params.using_internal_flow = ! solid;
+            params.config          = &region_config;
+            params.pattern         = pattern;
+            if (solid) {
+                params.anchor_length     = 1000.f;
+                params.anchor_length_max = 1000.f;
+            } else {
+                params.anchor_length     = float(region_config.infill_anchor);
+                if (region_config.infill_anchor.percent)
+                    params.anchor_length = float(params.anchor_length * 0.01 * flow.spacing());
+                params.anchor_length_max = float(region_config.infill_anchor_max);
+                if (region_config.infill_anchor_max.percent)
+                    params.anchor_length_max = float(params.anchor_length_max * 0.01 * flow.spacing());
+                params.anchor_length = std::min(params.anchor_length, params.anchor_length_max);
+            }
+            if (pattern == ipLockedZag) {
+                LockRegionParam lock_param;
+                lock_param.skin_density_params[float(0.01 * region_config.skin_infill_density)]         = expolygons;
+                lock_param.skeleton_density_params[float(0.01 * region_config.skeleton_infill_density)] = expolygons;
+                lock_param.skin_flow_params[flow]     = expolygons;
+                lock_param.skeleton_flow_params[flow] = expolygons;
+                params.locked_zag        = true;
+                params.infill_lock_depth = scale_(region_config.infill_lock_depth);
+                params.skin_infill_depth = scale_(region_config.skin_infill_depth);
+                f->set_lock_region_param(lock_param);
+            }
+            if (pattern == ipCrossZag || pattern == ipLockedZag || pattern == ipZigZag)
+                params.symmetric_infill_y_axis = region_config.symmetric_infill_y_axis;
+            if (pattern == ipGrid)
+                params.can_reverse = false;
+
+            Surface surface(solid ? stInternalSolid : stInternal, ExPolygon());
+            for (const ExPolygon &expolygon : expolygons) {
+                if (pattern == ipConcentricInternal)
+                    f->no_overlap_expolygons = { expolygon };
+                f->spacing        = flow.spacing();
+                surface.expolygon = expolygon;
+                f->fill_surface_extrusion(&surface, params, extrusions.entities);
+                ++ result.surfaces;
+            }
+        }
+    auto t1 = std::chrono::high_resolution_clock::now();
+    result.allocations = Benchmark::num_allocations() - num_allocations;
+    result.time_ms     = std::chrono::duration<double, std::milli>(t1 - t0).count();
+
+    Polylines polylines;
+    extrusions.collect_polylines(polylines);
+    result.polylines = polylines.size();
+    for (const Polyline &polyline : polylines) {
+        result.points += polyline.size();
+        result.length += unscaled<double>(polyline.length());
+    }
+    return result;
+}
+
+std::string pattern_name(InfillPattern pattern)
+{
+    if (pattern == ipConcentricInternal)
+        return "concentricinternal";
+    for (const auto &kvp : ConfigOptionEnum<InfillPattern>::get_enum_values())
+        if (kvp.second == int(pattern))
+            return kvp.first;
+    return std::to_string(int(pattern));
+}
+
+size_t env_size_t(const char *name, size_t default_value)
+{
+    const char *v = std::getenv(name);
+    return v == nullptr ? default_value : size_t(std::max(1, std::atoi(v)));
+}
+
+} // anonymous namespace
+
+TEST_CASE("Fill: Infill generation benchmark over recorded layer surfaces", "[FillBenchmark][.]") {
+    const size_t      repeats   = env_size_t("SLIC3R_FILL_BENCHMARK_REPEATS", 1);
+    const char       *json_env  = std::getenv("SLIC3R_FILL_BENCHMARK_JSON");
+    const std::string json_path = json_env == nullptr ? "fill_benchmark.json" : json_env;
+
+    std::vector<std::unique_ptr<Sample>> samples;
+    samples.emplace_back(record_sample("extruder_idler", load_sample_mesh("extruder_idler.obj")));
+    samples.emplace_back(record_sample("frog_legs",      load_sample_mesh("frog_legs.obj")));
+    samples.emplace_back(record_sample("ipadstand",      Test::mesh(Test::TestMesh::ipadstand)));
+
+    const std::vector<float>         sparse_densities { 0.1f, 0.2f, 0.4f };
+    const std::vector<InfillPattern> solid_patterns {
+        ipConcentric, ipRectilinear, ipMonotonic, ipMonotonicLine, ipAlignedRectilinear,
+        ipHilbertCurve, ipArchimedeanChords, ipOctagramSpiral, ipConcentricInternal };
+
+    nlohmann::json rows = nlohmann::json::array();
+    size_t         total_polylines = 0;
+    std::cout << std::left << std::setw(16) << "sample" << std::setw(20) << "pattern" << std::right << std::setw(8) << "density"
+              << std::setw(10) << "surfaces" << std::setw(11) << "polylines" << std::setw(11) << "points" << std::setw(13) << "length [mm]"
+              << std::setw(11) << "time [ms]" << std::setw(14) << "polylines/s" << std::setw(13) << "allocations" << std::endl;
+    auto run = [&](const Sample &sample, InfillPattern pattern, float density, bool solid) {
+        // The octrees and the Lightning trees are built once per density, the same way as per print object.
+        auto   t0 = std::chrono::high_resolution_clock::now();
+        std::pair<FillAdaptive::OctreePtr, FillAdaptive::OctreePtr> octrees;
+        FillLightning::GeneratorPtr                                 lightning;
+        if (pattern == ipAdaptiveCubic || pattern == ipSupportCubic)
+            octrees = build_octrees(sample, density);
+        else if (pattern == ipLightning)
+            lightning = build_lightning(sample, density);
+        double setup_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - t0).count();
+
+        FillResult result;
+        for (size_t i = 0; i < repeats; ++ i) {
+            FillResult r = fill_sample(sample, pattern, density, solid, octrees.first.get(), octrees.second.get(), lightning.get());
+            if (i == 0 || r.time_ms < result.time_ms)
+                result = r;
+        }
+        double polylines_per_s = result.time_ms > 0. ? 1000. * double(result.polylines) / result.time_ms : 0.;
+        total_polylines += result.polylines;
+        std::cout << std::left << std::setw(16) << sample.name << std::setw(20) << pattern_name(pattern) << std::right << std::setw(8) << density
+                  << std::setw(10) << result.surfaces << std::setw(11) << result.polylines << std::setw(11) << result.points
+                  << std::setw(13) << std::fixed << std::setprecision(1) << result.length << std::setw(11) << result.time_ms
+                  << std::setw(14) << std::setprecision(0) << polylines_per_s << std::setw(13) << result.allocations
+                  << std::defaultfloat << std::setprecision(6) << std::endl;
+        rows.push_back({
+            { "sample",          sample.name },
+            { "pattern",         pattern_name(pattern) },
+            { "density",         density },
+            { "solid",           solid },
+            { "surfaces",        result.surfaces },
+            { "polylines",       result.polylines },
+            { "points",          result.points },
+            { "length_mm",       result.length },
+            { "time_ms",         result.time_ms },
+            { "polylines_per_s", polylines_per_s },
+            { "allocations",     result.allocations },
+            { "setup_ms",        setup_ms }
+        });
+    };
+
+    for (const std::unique_ptr<Sample> &sample : samples) {
+        for (int pattern = 0; pattern < int(ipCount); ++ pattern)
+            if (pattern != ipSupportBase && pattern != ipConcentricInternal)
+                for (float density : sparse_densities)
+                    run(*sample, InfillPattern(pattern), density, false);
+        for (InfillPattern pattern : solid_patterns)
+            run(*sample, pattern, 1.f, true);
+    }
+
+    nlohmann::json out;
+    out["repeats"] = repeats;
+    out["results"] = std::move(rows);
+    std::ofstream(json_path) << out.dump(2) << std::endl;
+    std::cout << "Results written to " << json_path << std::endl;
+
+    REQUIRE(total_polylines > 0);
+}
@@ -0,0 +1,196 @@
+// Support generation benchmark, built into the separate executable fff_print_benchmarks, which replaces the global
+// operator new to track the allocated memory (see benchmark_allocations.cpp). Not run by default, execute with "[SupportBenchmark]":
+//
+//     fff_print_benchmarks "[SupportBenchmark]"
+//
+// Each support style generates the supports of a set of overhang heavy sample objects. The objects are sliced first
+// with the supports disabled, then the supports are enabled and only the support generation is repeated and measured:
+// the wall time of each of its phases (see SupportPhase), the peak of the memory allocated on top of the sliced object
+// and the length of the support extrusions. A table is printed to stdout and the results are written as JSON for regression
+// tracking to the file named by SLIC3R_SUPPORT_BENCHMARK_JSON (support_benchmark.json by default).
+// SLIC3R_SUPPORT_BENCHMARK_REPEATS sets the number of runs of each style, each over a newly sliced object, the fastest one is reported.
+
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#include "nlohmann/json.hpp"
+
+#include "libslic3r/ExtrusionEntityCollection.hpp"
+#include "libslic3r/Format/OBJ.hpp"
+#include "libslic3r/Layer.hpp"
+#include "libslic3r/Model.hpp"
+#include "libslic3r/Print.hpp"
+#include "libslic3r/Support/SupportCommon.hpp"
+#include "libslic3r/libslic3r.h"
+
+#include "benchmark_allocations.hpp"
+#include "test_data.hpp"
+
+using namespace Slic3r;
+
+namespace {
+
+struct SupportStyle {
+    const char *name;
+    const char *support_type;
+    const char *support_style;
+};
+
+struct SupportResult {
+    double time_ms      { 0. };
+    double phase_ms[size_t(SupportPhase::Count)] { 0. };
+    size_t peak_bytes   { 0 };
+    size_t layers       { 0 };
+    size_t polylines    { 0 };
+    double length       { 0. };
+};
+
+const char* phase_name(SupportPhase phase)
+{
+    switch (phase) {
+    case SupportPhase::ContactDetection: return "contact_detection";
+    case SupportPhase::Avoidance:        return "avoidance";
+    case SupportPhase::Drop:             return "drop";
+    case SupportPhase::Draw:             return "draw";
+    case SupportPhase::Toolpaths:        return "toolpaths";
+    default:                             return "";
+    }
+}
+
+TriangleMesh load_sample_mesh(const std::string &obj_filename)
+{
+    TriangleMesh mesh;
+    ObjInfo      obj_info;
+    std::string  message;
+    std::string  path = std::string(TEST_DATA_DIR) + "/" + obj_filename;
+    REQUIRE(load_obj(path.c_str(), &mesh, obj_info, message));
+    return mesh;
+}
+
+// Slice the mesh with the supports disabled, then enable them and generate just the supports.
+SupportResult generate_support(const TriangleMesh &mesh, const SupportStyle &style)
+{
+    DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+    config.set_deserialize_strict({
+        { "layer_height",   0.2 },
+        { "enable_support", 0 },
+        { "support_type",   style.support_type },
+        { "support_style",  style.support_style }
+    });
+    Model model;
+    Print print;
+    Test::init_print({ mesh }, print, model, config);
+    print.process();
+
+    config.set_deserialize_strict({ { "enable_support", 1 } });
+    print.apply(model, config);
+
+    SupportResult     result;
+    SupportPhaseTimes times;
+    Benchmark::reset_peak_allocated_bytes();
+    const size_t bytes_before = Benchmark::allocated_bytes();
+    set_support_phase_times(&times);
+    auto t0 = std::chrono::high_resolution_clock::now();
+    print.process();
+    auto t1 = std::chrono::high_resolution_clock::now();
+    set_support_phase_times(nullptr);
+    result.time_ms    = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    result.peak_bytes = Benchmark::peak_allocated_bytes() - bytes_before;
+    for (size_t phase = 0; phase < size_t(SupportPhase::Count); ++ phase)
+        result.phase_ms[phase] = times.milliseconds(SupportPhase(phase));
+
+    for (const SupportLayer *layer : print.objects().front()->support_layers()) {
+        Polylines polylines;
+        layer->support_fills.collect_polylines(polylines);
+        result.layers    += ! polylines.empty();
+        result.polylines += polylines.size();
+        for (const Polyline &polyline : polylines)
+            result.length += unscaled<double>(polyline.length());
+    }
+    return result;
+}
+
+size_t env_size_t(const char *name, size_t default_value)
+{
+    const char *v = std::getenv(name);
+    return v == nullptr ? default_value : size_t(std::max(1, std::atoi(v)));
+}
+
+} // anonymous namespace
+
+TEST_CASE("SupportMaterial: Support generation benchmark over overhang heavy objects", "[SupportBenchmark][.]") {
+    const size_t      repeats   = env_size_t("SLIC3R_SUPPORT_BENCHMARK_REPEATS", 1);
+    const char       *json_env  = std::getenv("SLIC3R_SUPPORT_BENCHMARK_JSON");
+    const std::string json_path = json_env == nullptr ? "support_benchmark.json" : json_env;
+
+    // Box with a horizontal hole, thus with a bridge over the hole.
+    TriangleMesh cube_with_hole = Test::mesh(Test::TestMesh::cube_with_hole);
+    cube_with_hole.rotate_x(float(M_PI / 2));
+    const std::vector<std::pair<std::string, TriangleMesh>> samples {
+        { "overhang",       Test::mesh(Test::TestMesh::overhang) },
+        { "cube_with_hole", cube_with_hole },
+        { "sphere_50mm",    Test::mesh(Test::TestMesh::sphere_50mm) },
+        { "A_upsidedown",   load_sample_mesh("A_upsidedown.obj") },
+        { "frog_legs",      load_sample_mesh("frog_legs.obj") }
+    };
+    const std::vector<SupportStyle> styles {
+        { "normal",  "normal(auto)", "default" },
+        { "snug",    "normal(auto)", "snug" },
+        { "tree",    "tree(auto)",   "tree_slim" },
+        { "strong",  "tree(auto)",   "tree_strong" },
+        { "hybrid",  "tree(auto)",   "tree_hybrid" },
+        { "organic", "tree(auto)",   "organic" }
+    };
+
+    nlohmann::json rows = nlohmann::json::array();
+    double         total_length = 0.;
+    std::cout << std::left << std::setw(16) << "sample" << std::setw(9) << "style" << std::right << std::setw(11) << "time [ms]";
+    for (size_t phase = 0; phase < size_t(SupportPhase::Count); ++ phase)
+        std::cout << std::setw(19) << phase_name(SupportPhase(phase));
+    std::cout << std::setw(11) << "peak [MB]" << std::setw(8) << "layers" << std::setw(11) << "polylines" << std::setw(13) << "length [mm]" << std::endl;
+    for (const auto &[sample_name, mesh] : samples)
+        for (const SupportStyle &style : styles) {
+            SupportResult result;
+            for (size_t i = 0; i < repeats; ++ i) {
+                SupportResult r = generate_support(mesh, style);
+                if (i == 0 || r.time_ms < result.time_ms)
+                    result = r;
+            }
+            total_length += result.length;
+            const double peak_mb = double(result.peak_bytes) / (1024. * 1024.);
+            std::cout << std::left << std::setw(16) << sample_name << std::setw(9) << style.name << std::right
+                      << std::fixed << std::setprecision(1) << std::setw(11) << result.time_ms;
+            for (double ms : result.phase_ms)
+                std::cout << std::setw(19) << ms;
+            std::cout << std::setw(11) << peak_mb << std::setw(8) << result.layers << std::setw(11) << result.polylines
+                      << std::setw(13) << result.length << std::defaultfloat << std::setprecision(6) << std::endl;
+            nlohmann::json phases;
+            for (size_t phase = 0; phase < size_t(SupportPhase::Count); ++ phase)
+                phases[phase_name(SupportPhase(phase))] = result.phase_ms[phase];
+            rows.push_back({
+                { "sample",        sample_name },
+                { "style",         style.name },
+                { "support_type",  style.support_type },
+                { "support_style", style.support_style },
+                { "time_ms",       result.time_ms },
+                { "phases_ms",     std::move(phases) },
+                { "peak_bytes",    result.peak_bytes },
+                { "layers",        result.layers },
+                { "polylines",     result.polylines },
+                { "length_mm",     result.length }
+            });
+        }
+
+    nlohmann::json out;
+    out["repeats"] = repeats;
+    out["results"] = std::move(rows);
+    std::ofstream(json_path) << out.dump(2) << std::endl;
+    std::cout << "Results written to " << json_path << std::endl;
+
+    REQUIRE(total_length > 0.);
+}
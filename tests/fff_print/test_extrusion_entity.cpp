@@ -1,10 +1,14 @@
 #include <catch2/catch.hpp>
 
+#include <chrono>
 #include <cstdlib>
+#include <iostream>
 
 #include "libslic3r/ExtrusionEntityCollection.hpp"
 #include "libslic3r/ExtrusionEntity.hpp"
+#include "libslic3r/ExtrusionEntityFlat.hpp"
 #include "libslic3r/Point.hpp"
+#include "libslic3r/ShortestPath.hpp"
 #include "libslic3r/libslic3r.h"
 
 #include "test_data.hpp"
@@ -83,3 +87,223 @@ SCENARIO("ExtrusionEntityCollection: Polygon flattening", "[ExtrusionEntity]") {
         }
     }
 }
+
+// Sample of a layer: a collection of perimeter loops, a no-sort collection of infill paths and a multi-path.
+static ExtrusionEntityCollection sample_layer_collection(size_t num_infill_paths)
+{
+    ExtrusionEntityCollection out;
+    ExtrusionEntityCollection perimeters;
+    for (size_t i = 0; i < 3; ++ i) {
+        ExtrusionPath path = random_path(30);
+        path.polyline.points.push_back(path.polyline.points.front());
+        ExtrusionLoop loop(std::move(path), i == 0 ? elrHole : elrDefault);
+        loop.inset_idx = int(i);
+        perimeters.append(std::move(loop));
+    }
+    out.append(std::move(perimeters));
+    ExtrusionEntityCollection infill;
+    infill.no_sort = true;
+    for (size_t i = 0; i < num_infill_paths; ++ i) {
+        ExtrusionPath path = random_path(10);
+        path.set_extrusion_role(erInternalInfill);
+        path.mm3_per_mm = 0.01 * double(i + 1);
+        if (i % 3 == 0)
+            path.set_reverse();
+        infill.append(std::move(path));
+    }
+    out.append(std::move(infill));
+    ExtrusionMultiPath multipath;
+    multipath.paths = random_paths(3, 5);
+    for (size_t i = 1; i < multipath.paths.size(); ++ i)
+        multipath.paths[i].polyline.points.front() = multipath.paths[i - 1].polyline.points.back();
+    multipath.paths.back().set_force_no_extrusion(true);
+    out.append(std::move(multipath));
+    return out;
+}
+
+static void check_equal(const ExtrusionEntity &a, const ExtrusionEntity &b)
+{
+    REQUIRE(a.is_collection() == b.is_collection());
+    REQUIRE(a.is_loop() == b.is_loop());
+    REQUIRE(a.role() == b.role());
+    REQUIRE(a.can_reverse() == b.can_reverse());
+    REQUIRE(a.inset_idx == b.inset_idx);
+    if (a.is_collection()) {
+        const auto &ca = static_cast<const ExtrusionEntityCollection&>(a);
+        const auto &cb = static_cast<const ExtrusionEntityCollection&>(b);
+        REQUIRE(ca.no_sort == cb.no_sort);
+        REQUIRE(ca.entities.size() == cb.entities.size());
+        for (size_t i = 0; i < ca.entities.size(); ++ i)
+            check_equal(*ca.entities[i], *cb.entities[i]);
+    } else {
+        Points pa, pb;
+        a.collect_points(pa);
+        b.collect_points(pb);
+        REQUIRE(pa == pb);
+        REQUIRE(a.min_mm3_per_mm() == b.min_mm3_per_mm());
+        if (a.is_loop())
+            REQUIRE(static_cast<const ExtrusionLoop&>(a).loop_role() == static_cast<const ExtrusionLoop&>(b).loop_role());
+    }
+}
+
+SCENARIO("ExtrusionEntityCollectionFlat", "[ExtrusionEntity]") {
+    srand(0xDEADBEEF);
+    GIVEN("A nested collection of loops, paths and a multi-path") {
+        ExtrusionEntityCollection      collection = sample_layer_collection(20);
+        ExtrusionEntityCollectionFlat  flat(collection);
+        THEN("The flat collection holds all entities, paths and points") {
+            REQUIRE(flat.size() == collection.entities.size());
+            REQUIRE(flat.items_count() == collection.items_count());
+            REQUIRE(flat.num_paths() == 3 + 20 + 3);
+            Points points;
+            collection.collect_points(points);
+            Points flat_points;
+            flat.collect_points(flat_points);
+            REQUIRE(flat_points == points);
+        }
+        THEN("The adapters match the source collection") {
+            REQUIRE(flat.role() == collection.role());
+            REQUIRE(flat.total_volume() == Approx(collection.total_volume()));
+            REQUIRE(flat.min_mm3_per_mm() == collection.min_mm3_per_mm());
+            double length = 0.;
+            for (const ExtrusionEntity *ee : collection.flatten().entities)
+                length += ee->length();
+            REQUIRE(flat.length() == Approx(length));
+        }
+        THEN("The round trip reproduces the source collection") {
+            ExtrusionEntityCollection out = flat.to_collection();
+            check_equal(out, collection);
+        }
+        THEN("A single entity is materialized") {
+            std::unique_ptr<ExtrusionEntity> infill = flat.materialize(flat.root(1));
+            check_equal(*infill, *collection.entities[1]);
+        }
+        THEN("The flat collection uses less memory") {
+            REQUIRE(flat.memory_used() < ExtrusionEntityCollectionFlat::memory_used(collection));
+        }
+    }
+}
+
+// Sample of a fill as chained by the G-code export: paths, some of them not reversible, a multi-path and a loop,
+// spread over a 200 x 200 mm area.
+static ExtrusionEntityCollection sample_fill_collection(size_t num_paths)
+{
+    const float lo = -scaled<float>(100.);
+    const float hi =  scaled<float>(100.);
+    ExtrusionEntityCollection out;
+    for (size_t i = 0; i < num_paths; ++ i) {
+        ExtrusionPath path = random_path(5, lo, hi);
+        path.set_extrusion_role(erSolidInfill);
+        if (i % 4 == 0)
+            path.set_reverse();
+        out.append(std::move(path));
+    }
+    ExtrusionMultiPath multipath;
+    multipath.paths = random_paths(3, 5, lo, hi);
+    for (size_t i = 1; i < multipath.paths.size(); ++ i)
+        multipath.paths[i].polyline.points.front() = multipath.paths[i - 1].polyline.points.back();
+    out.append(std::move(multipath));
+    ExtrusionPath loop_path = random_path(10, lo, hi);
+    loop_path.polyline.points.push_back(loop_path.polyline.points.front());
+    out.append(ExtrusionLoop(std::move(loop_path)));
+    return out;
+}
+
+SCENARIO("ExtrusionEntityCollectionFlat chaining", "[ExtrusionEntity]") {
+    srand(0xDEADBEEF);
+    GIVEN("A fill of paths, a multi-path and a loop") {
+        ExtrusionEntityCollection     fill = sample_fill_collection(100);
+        ExtrusionEntityCollectionFlat flat(fill);
+        const Point                   start_near = random_point(-scaled<float>(100.), scaled<float>(100.));
+        THEN("Chaining the flat collection matches chaining the cloned entities") {
+            const ExtrusionEntityCollection       expected = fill.chained_path_from(start_near);
+            std::vector<std::pair<size_t, bool>>  chain    = chain_extrusion_entities(flat, &start_near);
+            REQUIRE(chain.size() == expected.entities.size());
+            for (size_t i = 0; i < chain.size(); ++ i) {
+                std::unique_ptr<ExtrusionEntity> entity = flat.materialize(flat.root(chain[i].first));
+                if (chain[i].second)
+                    entity->reverse();
+                check_equal(*entity, *expected.entities[i]);
+            }
+        }
+    }
+}
+
+// Not run by default, execute with "[ExtrusionEntityFlatBenchmark]".
+TEST_CASE("ExtrusionEntityCollectionFlat memory and copy time", "[ExtrusionEntityFlatBenchmark][.]") {
+    srand(0xDEADBEEF);
+    ExtrusionEntityCollection collection = sample_layer_collection(200000);
+    auto t0 = std::chrono::high_resolution_clock::now();
+    ExtrusionEntityCollection copy = collection;
+    auto t1 = std::chrono::high_resolution_clock::now();
+    ExtrusionEntityCollectionFlat flat(collection);
+    auto t2 = std::chrono::high_resolution_clock::now();
+    ExtrusionEntityCollectionFlat flat_copy = flat;
+    auto t3 = std::chrono::high_resolution_clock::now();
+    double length_flat = flat_copy.length();
+    auto t4 = std::chrono::high_resolution_clock::now();
+    double length = 0.;
+    for (const ExtrusionEntity *ee : copy.flatten().entities)
+        length += ee->length();
+    auto t5 = std::chrono::high_resolution_clock::now();
+    auto ms = [](auto a, auto b) { return std::chrono::duration<double, std::milli>(b - a).count(); };
+    std::cout << "pointer based: " << ExtrusionEntityCollectionFlat::memory_used(collection) / 1024 << " kB, copy " << ms(t0, t1) << " ms, flatten and measure " << ms(t4, t5) << " ms" << std::endl;
+    std::cout << "flat: " << flat.memory_used() / 1024 << " kB, build " << ms(t1, t2) << " ms, copy " << ms(t2, t3) << " ms, measure " << ms(t3, t4) << " ms" << std::endl;
+    REQUIRE(length_flat == Approx(length));
+}
+
+// Not run by default, execute with "[ExtrusionEntityFlatBenchmark]".
+// Preparing a fill for the G-code export: the chaining is timed on its own, the rest is the cost of the container.
+// The pointer based export clones the collection to chain it and copies each path as GCode::extrude_path() takes it by value,
+// the flat export builds the flat collection and instantiates each path once.
+TEST_CASE("ExtrusionEntityCollectionFlat export ordering time", "[ExtrusionEntityFlatBenchmark][.]") {
+    // A grid of 2000 infill lines of 50 points each.
+    ExtrusionEntityCollection fill;
+    for (int row = 0; row < 40; ++ row)
+        for (int column = 0; column < 50; ++ column) {
+            ExtrusionPath path(erInternalInfill, 0.02, 0.45f, 0.2f);
+            for (int i = 0; i < 50; ++ i)
+                path.polyline.append(Point(scaled<coord_t>(2. * column + 0.035 * i), scaled<coord_t>(0.5 * row + 0.01 * (i % 2))));
+            fill.entities.emplace_back(new ExtrusionPath(std::move(path)));
+        }
+    const Point start_near(0, 0);
+    auto ms = [](auto a, auto b) { return std::chrono::duration<double, std::milli>(b - a).count(); };
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    ExtrusionEntityCollectionFlat flat;
+    flat.append(fill);
+    auto t1 = std::chrono::high_resolution_clock::now();
+    const std::vector<std::pair<size_t, bool>> chain = chain_extrusion_entities(flat, &start_near);
+    auto t2 = std::chrono::high_resolution_clock::now();
+    size_t num_points_flat = 0;
+    for (const std::pair<size_t, bool> &idx : chain) {
+        ExtrusionPath path;
+        flat.make_path(flat.entity(flat.root(idx.first)).begin, path);
+        if (idx.second)
+            path.reverse();
+        num_points_flat += path.size();
+    }
+    auto t3 = std::chrono::high_resolution_clock::now();
+
+    size_t num_points = 0;
+    {
+        ExtrusionEntityCollection ordered(fill);
+        std::vector<ExtrusionEntity*> entities;
+        entities.reserve(chain.size());
+        for (const std::pair<size_t, bool> &idx : chain) {
+            entities.emplace_back(ordered.entities[idx.first]);
+            if (idx.second)
+                entities.back()->reverse();
+        }
+        for (const ExtrusionEntity *ee : entities) {
+            ExtrusionPath copy(*static_cast<const ExtrusionPath*>(ee));
+            num_points += copy.size();
+        }
+    }
+    auto t4 = std::chrono::high_resolution_clock::now();
+
+    std::cout << "chaining " << ms(t1, t2) << " ms" << std::endl;
+    std::cout << "pointer based: clone and copy " << ms(t3, t4) << " ms" << std::endl;
+    std::cout << "flat: build and instantiate " << ms(t0, t1) + ms(t2, t3) << " ms, " << flat.memory_used() / 1024 << " kB" << std::endl;
+    REQUIRE(num_points_flat == num_points);
+}
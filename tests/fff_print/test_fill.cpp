@@ -1,14 +1,19 @@
 #include <catch2/catch.hpp>
 
+#include <chrono>
+#include <iostream>
 #include <numeric>
 #include <sstream>
 
 #include "libslic3r/ClipperUtils.hpp"
 #include "libslic3r/Fill/Fill.hpp"
+#include "libslic3r/Fill/FillAdaptive.hpp"
+#include "libslic3r/Fill/Lightning/Generator.hpp"
 #include "libslic3r/Flow.hpp"
 #include "libslic3r/Geometry.hpp"
 #include "libslic3r/Print.hpp"
 #include "libslic3r/SVG.hpp"
+#include "libslic3r/TriangleMesh.hpp"
 #include "libslic3r/libslic3r.h"
 
 #include "test_data.hpp"
@@ -429,6 +434,466 @@ for my $pattern (qw(rectilinear honeycomb hilbertcurve concentric)) {
 }
 */
 
+// Wavy lines over the bounding box of a surface, resembling a sparse gyroid pattern of the given density.
+static Slic3r::Polylines wavy_infill_pattern(const BoundingBox &bbox, double density)
+{
+    const double line_spacing = 0.45 / density;
+    Slic3r::Polylines out;
+    for (double y = unscale<double>(bbox.min.y()); y < unscale<double>(bbox.max.y()); y += line_spacing) {
+        Slic3r::Polyline pl;
+        for (double x = unscale<double>(bbox.min.x()); x < unscale<double>(bbox.max.x()); x += 0.1)
+            pl.points.emplace_back(Point::new_scale(x, y + 0.3 * line_spacing * std::sin(2. * PI * x / line_spacing)));
+        out.emplace_back(std::move(pl));
+    }
+    return out;
+}
+
+static Slic3r::ExPolygon ring_with_holes(double radius, int num_holes)
+{
+    Slic3r::Polygon contour;
+    for (int i = 0; i < 72; ++ i) {
+        double a = 2. * PI * i / 72., r = radius * (1. + 0.2 * std::sin(5. * a));
+        contour.points.emplace_back(Point::new_scale(r * std::cos(a), r * std::sin(a)));
+    }
+    Slic3r::ExPolygon out(contour);
+    for (int j = 0; j < num_holes; ++ j) {
+        Slic3r::Polygon hole;
+        double cx = 0.5 * radius * std::cos(2. * PI * j / num_holes), cy = 0.5 * radius * std::sin(2. * PI * j / num_holes);
+        for (int i = 0; i < 24; ++ i) {
+            double a = - 2. * PI * i / 24.;
+            hole.points.emplace_back(Point::new_scale(cx + 0.15 * radius * std::cos(a), cy + 0.15 * radius * std::sin(a)));
+        }
+        out.holes.emplace_back(std::move(hole));
+    }
+    return out;
+}
+
+// Comb with its teeth along the y axis, each horizontal infill line crosses all the teeth.
+static Slic3r::ExPolygon comb(double width, double height, int num_teeth)
+{
+    const double pitch = width / num_teeth;
+    Slic3r::Polygon contour { Point::new_scale(0., height), Point::new_scale(0., 0.) };
+    for (int i = 0; i < num_teeth; ++ i) {
+        contour.points.emplace_back(Point::new_scale((i + 0.6) * pitch, 0.));
+        contour.points.emplace_back(Point::new_scale((i + 0.6) * pitch, 0.9 * height));
+        contour.points.emplace_back(Point::new_scale((i + 1.) * pitch, 0.9 * height));
+        contour.points.emplace_back(Point::new_scale((i + 1.) * pitch, 0.));
+    }
+    contour.points.emplace_back(Point::new_scale(width, height));
+    return Slic3r::ExPolygon(std::move(contour));
+}
+
+// Zig-zag lines with their vertices on a grid, resembling the honeycomb patterns.
+static Slic3r::Polylines zigzag_infill_pattern(const BoundingBox &bbox, double pitch)
+{
+    Slic3r::Polylines out;
+    for (double y = unscale<double>(bbox.min.y()) - pitch; y < unscale<double>(bbox.max.y()) + pitch; y += 2. * pitch) {
+        Slic3r::Polyline pl;
+        int i = 0;
+        for (double x = unscale<double>(bbox.min.x()) - pitch; x < unscale<double>(bbox.max.x()) + pitch; x += pitch)
+            pl.points.emplace_back(Point::new_scale(x, (i ++ % 2) ? y + pitch : y));
+        out.emplace_back(std::move(pl));
+    }
+    return out;
+}
+
+// Straight lines at an angle, resembling the cross hatch pattern.
+static Slic3r::Polylines hatch_infill_pattern(const BoundingBox &bbox, double spacing, double angle)
+{
+    const Vec2d  center = unscaled(bbox.center());
+    const double radius = 0.5 * unscaled(bbox.size()).norm() + spacing;
+    const Vec2d  dir(std::cos(angle), std::sin(angle));
+    const Vec2d  normal(- dir.y(), dir.x());
+    Slic3r::Polylines out;
+    for (double d = - radius; d < radius; d += spacing)
+        out.push_back({ Point::new_scale(center + d * normal - radius * dir), Point::new_scale(center + d * normal + radius * dir) });
+    return out;
+}
+
+// A single serpentine polyline on a grid, resembling the plane path patterns.
+static Slic3r::Polylines serpentine_infill_pattern(const BoundingBox &bbox, double spacing)
+{
+    Slic3r::Polyline pl;
+    bool forward = true;
+    for (double y = unscale<double>(bbox.min.y()) - spacing; y < unscale<double>(bbox.max.y()) + spacing; y += spacing, forward = ! forward)
+        for (double x : { unscale<double>(bbox.min.x()) - spacing, unscale<double>(bbox.max.x()) + spacing })
+            pl.points.emplace_back(Point::new_scale(forward ? x : unscale<double>(bbox.min.x() + bbox.max.x()) - x, y));
+    return { pl };
+}
+
+// The pieces sorted and oriented from their lexicographically smaller end point, Clipper neither keeps their order nor their direction.
+static Slic3r::Polylines normalized_pieces(Slic3r::Polylines pieces)
+{
+    auto lower = [](const Point &a, const Point &b) { return a.x() < b.x() || (a.x() == b.x() && a.y() < b.y()); };
+    for (Slic3r::Polyline &pl : pieces)
+        if (lower(pl.points.back(), pl.points.front()))
+            pl.reverse();
+    std::sort(pieces.begin(), pieces.end(), [&lower](const Slic3r::Polyline &a, const Slic3r::Polyline &b) { return lower(a.points.front(), b.points.front()); });
+    return pieces;
+}
+
+// The pieces are the same up to the rounding of the crossing points.
+static bool same_pieces(const Slic3r::Polylines &pieces1, const Slic3r::Polylines &pieces2)
+{
+    const Slic3r::Polylines a = normalized_pieces(pieces1);
+    const Slic3r::Polylines b = normalized_pieces(pieces2);
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); ++ i) {
+        if (a[i].size() != b[i].size())
+            return false;
+        for (size_t j = 0; j < a[i].size(); ++ j)
+            if ((a[i].points[j] - b[i].points[j]).cwiseAbs().maxCoeff() > 2)
+                return false;
+    }
+    return true;
+}
+
+TEST_CASE("Fill: Scanline clipper", "[Fill]") {
+    SECTION("Matches intersection_pl on a sparse pattern") {
+        Slic3r::ExPolygon expolygon = ring_with_holes(40., 5);
+        for (double density : { 0.05, 0.15, 0.4 }) {
+            Slic3r::Polylines pattern  = wavy_infill_pattern(get_extents(expolygon), density);
+            Slic3r::Polylines clipper  = intersection_pl(pattern, expolygon);
+            Slic3r::Polylines scanline = clip_infill_polylines(pattern, expolygon);
+            REQUIRE(scanline.size() == clipper.size());
+            REQUIRE(std::abs(total_length(scanline) - total_length(clipper)) < 2. * clipper.size());
+            // The pieces stay inside the boundary.
+            REQUIRE(diff_pl(scanline, offset(expolygon, float(SCALED_EPSILON))).empty());
+        }
+    }
+    SECTION("Matches intersection_pl on a comb with many tall edges") {
+        Slic3r::ExPolygon expolygon = comb(200., 250., 400);
+        Slic3r::Polylines pattern   = wavy_infill_pattern(get_extents(expolygon), 0.15);
+        Slic3r::Polylines clipper   = intersection_pl(pattern, expolygon);
+        Slic3r::Polylines scanline  = clip_infill_polylines(pattern, expolygon);
+        REQUIRE(scanline.size() == clipper.size());
+        REQUIRE(std::abs(total_length(scanline) - total_length(clipper)) < 2. * clipper.size());
+        REQUIRE(diff_pl(scanline, offset(expolygon, float(SCALED_EPSILON))).empty());
+    }
+    SECTION("Matches intersection_pl on the infill patterns") {
+        // A square with a hole on the grid of the grid aligned patterns, thus with the patterns running along the boundary and through its vertices.
+        Slic3r::ExPolygon square(Slic3r::Polygon{ Point::new_scale(0, 0), Point::new_scale(40, 0), Point::new_scale(40, 40), Point::new_scale(0, 40) });
+        square.holes.push_back(Slic3r::Polygon{ Point::new_scale(10, 10), Point::new_scale(10, 30), Point::new_scale(30, 30), Point::new_scale(30, 10) });
+        for (const Slic3r::ExPolygon &expolygon : { ring_with_holes(40., 5), square }) {
+            const BoundingBox bbox = get_extents(expolygon);
+            for (const Slic3r::Polylines &pattern : {
+                    // Gyroid, TPMS-D
+                    wavy_infill_pattern(bbox, 0.15),
+                    // Honeycomb, 3D honeycomb
+                    zigzag_infill_pattern(bbox, 2.),
+                    // Cross hatch
+                    hatch_infill_pattern(bbox, 1.5, PI / 4.), hatch_infill_pattern(bbox, 2., 0.),
+                    // Plane path
+                    serpentine_infill_pattern(bbox, 2.) })
+                REQUIRE(same_pieces(clip_infill_polylines(pattern, expolygon), intersection_pl(pattern, expolygon)));
+        }
+    }
+    SECTION("Degenerate configurations") {
+        Slic3r::ExPolygon square(Slic3r::Polygon{ { 0, 0 }, { 10000, 0 }, { 10000, 10000 }, { 5000, 15000 }, { 0, 10000 } });
+        InfillScanlineClipper clipper(square);
+        REQUIRE(clipper.contains({ 5000, 5000 }));
+        REQUIRE(! clipper.contains({ 5000, 0 }));
+        REQUIRE(! clipper.contains({ 20000, 5000 }));
+        for (const Slic3r::Polyline &polyline : {
+                // Running along an edge.
+                Slic3r::Polyline({ -5000, 0 }, { 15000, 0 }), Slic3r::Polyline({ 10000, -5000 }, { 10000, 20000 }),
+                Slic3r::Polyline(Points{ { -5000, 5000 }, { 0, 5000 }, { 0, 8000 }, { 5000, 8000 } }),
+                // Passing through a vertex.
+                Slic3r::Polyline({ -5000, 10000 }, { 15000, 10000 }),
+                // Touching a vertex from outside.
+                Slic3r::Polyline(Points{ { 0, 20000 }, { 5000, 15000 }, { 10000, 20000 } }),
+                // Touching a vertex from inside.
+                Slic3r::Polyline(Points{ { 2000, 5000 }, { 5000, 15000 }, { 8000, 5000 } }),
+                // Starting on the boundary.
+                Slic3r::Polyline({ 2000, 0 }, { 2000, 5000 }) })
+            REQUIRE(same_pieces(clipper.clip({ polyline }), intersection_pl({ polyline }, square)));
+        // Starting on the boundary.
+        Slic3r::Polylines from_boundary = clipper.clip({ Slic3r::Polyline({ 2000, 0 }, { 2000, 5000 }) });
+        REQUIRE(from_boundary.size() == 1);
+        REQUIRE(from_boundary.front().length() == Approx(5000.));
+    }
+}
+
+// Not run by default, execute with "[FillClipBenchmark]".
+TEST_CASE("Fill: Scanline clipper vs. intersection_pl", "[FillClipBenchmark][.]") {
+    Slic3r::ExPolygon expolygon = ring_with_holes(100., 12);
+    for (double density : { 0.05, 0.1, 0.2, 0.4 }) {
+        Slic3r::Polylines pattern = wavy_infill_pattern(get_extents(expolygon), density);
+        auto t0 = std::chrono::high_resolution_clock::now();
+        Slic3r::Polylines clipper = intersection_pl(pattern, expolygon);
+        auto t1 = std::chrono::high_resolution_clock::now();
+        Slic3r::Polylines scanline = clip_infill_polylines(pattern, expolygon);
+        auto t2 = std::chrono::high_resolution_clock::now();
+        std::cout << "density " << density << ": intersection_pl " << std::chrono::duration<double, std::milli>(t1 - t0).count()
+                  << " ms, scanline clipper " << std::chrono::duration<double, std::milli>(t2 - t1).count() << " ms" << std::endl;
+        REQUIRE(scanline.size() == clipper.size());
+    }
+}
+
+TEST_CASE("Fill: Rectilinear infill of large surfaces", "[Fill]") {
+    // Large enough for the vertical lines to be sliced in parallel.
+    const Slic3r::ExPolygon large_comb = comb(200., 250., 40);
+    SECTION("Solid infill covers the surface") {
+        for (double angle : { 0., 0.3 })
+            REQUIRE(test_if_solid_surface_filled(large_comb, 0.5, angle) == true);
+    }
+    SECTION("The infill is deterministic and stays inside the surface") {
+        for (InfillPattern pattern : { ipRectilinear, ipMonotonic, ipAlignedRectilinear, ipGrid, ipTriangles })
+            for (float density : { 1.f, 0.2f }) {
+                if (density == 1.f && (pattern == ipGrid || pattern == ipTriangles))
+                    // Solid infill is always rectilinear.
+                    continue;
+                std::unique_ptr<Slic3r::Fill> filler(Slic3r::Fill::new_from_type(pattern));
+                filler->angle        = 0.3f;
+                filler->spacing      = 0.45;
+                filler->bounding_box = get_extents(large_comb);
+                FillParams fill_params;
+                fill_params.density = density;
+                Slic3r::Surface   surface(stInternalSolid, large_comb);
+                Slic3r::Polylines paths = filler->fill_surface(&surface, fill_params);
+                REQUIRE(! paths.empty());
+                REQUIRE(filler->fill_surface(&surface, fill_params) == paths);
+                REQUIRE(diff_pl(paths, offset(large_comb, float(SCALED_EPSILON))).empty());
+            }
+    }
+}
+
+TEST_CASE("Fill: Adaptive cubic octree built in parallel", "[Fill]") {
+    // Sphere in the coordinate system of the octree, fine enough for the parallel builder to split the triangles among threads.
+    indexed_triangle_set mesh = its_make_sphere(20., PI / 90.);
+    its_transform(mesh, Transform3d(FillAdaptive::transform_to_octree()), true);
+    REQUIRE(mesh.indices.size() > 10000);
+
+    // Internal bridge 10mm above the sphere center, in the coordinate system of the octree.
+    std::vector<Vec3d> overhangs { Vec3d(-5., -5., 10.), Vec3d(5., -5., 10.), Vec3d(5., 5., 10.) };
+    for (Vec3d &p : overhangs)
+        p = FillAdaptive::transform_to_octree() * p;
+
+    auto fill = [](FillAdaptive::Octree *octree, double z) {
+        std::unique_ptr<Slic3r::Fill> filler(Slic3r::Fill::new_from_type(ipAdaptiveCubic));
+        filler->adapt_fill_octree = octree;
+        filler->angle   = 0.f;
+        filler->spacing = 0.45;
+        filler->z       = z;
+        FillParams fill_params;
+        fill_params.density     = 0.2f;
+        fill_params.dont_adjust = true;
+        Slic3r::Polygon circle;
+        for (int i = 0; i < 64; ++ i)
+            circle.points.emplace_back(Point::new_scale(18. * std::cos(2. * PI * i / 64.), 18. * std::sin(2. * PI * i / 64.)));
+        Slic3r::Surface surface(stInternal, ExPolygon(circle));
+        return filler->fill_surface(&surface, fill_params);
+    };
+    auto same_fill = [&fill](FillAdaptive::Octree *a, FillAdaptive::Octree *b) {
+        for (double z : { -15., -4.2, 0.1, 7.7, 15. }) {
+            Slic3r::Polylines pa = fill(a, z);
+            REQUIRE(! pa.empty());
+            REQUIRE(pa == fill(b, z));
+        }
+    };
+
+    for (bool support_overhangs_only : { false, true }) {
+        const double line_spacing = 0.45 / 0.2;
+        FillAdaptive::OctreePtr serial   = FillAdaptive::build_octree(mesh, overhangs, line_spacing, support_overhangs_only, false);
+        FillAdaptive::OctreePtr parallel = FillAdaptive::build_octree(mesh, overhangs, line_spacing, support_overhangs_only, true);
+        same_fill(serial.get(), parallel.get());
+    }
+    SECTION("Both octrees built at once") {
+        auto [adaptive, support] = FillAdaptive::build_octrees(mesh, overhangs, 2.25, 1.5);
+        same_fill(adaptive.get(), FillAdaptive::build_octree(mesh, overhangs, 2.25, false, false).get());
+        same_fill(support.get(),  FillAdaptive::build_octree(mesh, overhangs, 1.5,  true,  false).get());
+        auto [adaptive_only, no_support] = FillAdaptive::build_octrees(mesh, overhangs, 2.25, 0.);
+        REQUIRE(adaptive_only);
+        REQUIRE(! no_support);
+    }
+}
+
+TEST_CASE("Fill: Lightning trees", "[Fill]") {
+    // A wavy column with a lid on top, a hole through the lower part and a pillar next to it starting mid height.
+    auto blob = [](double r, double cx, double cy, double phase, bool hole) {
+        Slic3r::Polygon out;
+        for (int i = 0; i < 90; ++ i) {
+            double a = (hole ? -2. : 2.) * PI * i / 90., rr = r * (1. + 0.15 * std::sin(3. * a + phase));
+            out.points.emplace_back(Point::new_scale(cx + rr * std::cos(a), cy + rr * std::sin(a)));
+        }
+        return out;
+    };
+    const int     num_layers      = 80;
+    const coord_t layer_thickness = scaled<coord_t>(0.2);
+    std::vector<Polygons> outlines(num_layers);
+    std::vector<Polygons> overhangs(num_layers);
+    for (int layer_id = 0; layer_id < num_layers; ++ layer_id) {
+        double   z = 0.2 * layer_id;
+        Polygons polygons { blob(20. + 4. * std::sin(0.3 * z), 0., 0., 0.1 * z, false) };
+        if (layer_id < num_layers / 2)
+            polygons.emplace_back(blob(4., 8., 0., z, true));
+        if (layer_id > num_layers / 3)
+            polygons.emplace_back(blob(5., 40., 5., 0., false));
+        outlines[layer_id] = union_(polygons);
+    }
+    // Infill areas not supported by the infill areas above, see Generator::generateInitialInternalOverhangs().
+    for (int layer_id = 0; layer_id < num_layers; ++ layer_id)
+        overhangs[layer_id] = diff(offset(outlines[layer_id], - float(layer_thickness)), layer_id + 1 < num_layers ? outlines[layer_id + 1] : Polygons());
+
+    FillLightning::Generator generator(outlines, overhangs, scaled<coord_t>(0.45), layer_thickness, 0.15f, []{});
+    auto lines = [&outlines](const FillLightning::Generator &generator, int layer_id) {
+        // The branches are chained starting with a random child at each junction.
+        srand(layer_id);
+        return generator.getTreesForLayer(layer_id).convertToLines(outlines[layer_id], scaled<coord_t>(0.1));
+    };
+
+    SECTION("Trees propagate down from the lid") {
+        for (int layer_id = 0; layer_id < num_layers; ++ layer_id) {
+            Polylines polylines = lines(generator, layer_id);
+            REQUIRE(! polylines.empty());
+            REQUIRE(diff_pl(polylines, offset(outlines[layer_id], float(SCALED_EPSILON))).empty());
+        }
+    }
+    SECTION("The trees do not depend on the order of the parallel propagation") {
+        FillLightning::Generator generator2(outlines, overhangs, scaled<coord_t>(0.45), layer_thickness, 0.15f, []{});
+        for (int layer_id = 0; layer_id < num_layers; ++ layer_id)
+            REQUIRE(lines(generator, layer_id) == lines(generator2, layer_id));
+    }
+}
+
+// Not run by default, execute with "[FillLightningBenchmark]".
+TEST_CASE("Fill: Lightning trees of wide, shallow parts", "[FillLightningBenchmark][.]") {
+    const int     num_layers      = 10;
+    const coord_t layer_thickness = scaled<coord_t>(0.2);
+    for (double size : { 50., 100., 200., 300. })
+        for (float density : { 0.15f, 0.3f }) {
+            // A plate with a lid on top and an internal overhang half way up.
+            Slic3r::Polygon plate { Point::new_scale(0, 0), Point::new_scale(size, 0), Point::new_scale(size, 0.7 * size), Point::new_scale(0, 0.7 * size) };
+            std::vector<Polygons> outlines(num_layers, Polygons{ plate });
+            std::vector<Polygons> overhangs(num_layers);
+            overhangs.back()          = offset(outlines.back(), - float(layer_thickness));
+            overhangs[num_layers / 2] = offset(outlines.back(), - float(scaled<double>(0.2 * size)));
+            auto t0 = std::chrono::high_resolution_clock::now();
+            FillLightning::Generator generator(outlines, overhangs, scaled<coord_t>(0.45), layer_thickness, density, []{});
+            auto t1 = std::chrono::high_resolution_clock::now();
+            size_t num_lines = 0;
+            for (int layer_id = 0; layer_id < num_layers; ++ layer_id)
+                num_lines += generator.getTreesForLayer(layer_id).convertToLines(outlines[layer_id], 0).size();
+            std::cout << "plate " << size << "mm, density " << density << ": " << num_lines << " lines, "
+                      << std::chrono::duration<double, std::milli>(t1 - t0).count() << " ms" << std::endl;
+            REQUIRE(num_lines > 0);
+        }
+}
+
+TEST_CASE("Fill: Surface fills of a layer filled in parallel", "[Fill]") {
+    // The layers just above the lower step mix the solid top of the step with the sparse infill of the upper part.
+    Slic3r::Print print;
+    Slic3r::Test::init_and_process_print({ Slic3r::Test::TestMesh::step }, print, {
+        { "layer_height",          0.2 },
+        { "wall_loops",            1 },
+        { "top_shell_layers",      3 },
+        { "bottom_shell_layers",   3 },
+        { "sparse_infill_density", "20%" },
+        { "sparse_infill_pattern", "rectilinear" }
+    });
+    auto fills = [](const Layer &layer) {
+        std::vector<Polylines> out;
+        for (const LayerRegion *layerm : layer.regions()) {
+            out.emplace_back();
+            layerm->fills.collect_polylines(out.back());
+        }
+        return out;
+    };
+    bool mixed = false;
+    for (Layer *layer : print.objects().front()->layers()) {
+        std::vector<Polylines> first = fills(*layer);
+        bool solid = false, sparse = false;
+        for (const LayerRegion *layerm : layer->regions())
+            for (const ExtrusionEntity *ee : layerm->fills.entities) {
+                solid  |= is_solid_infill(ee->role());
+                sparse |= ee->role() == erInternalInfill;
+            }
+        mixed |= solid && sparse;
+        // Filling the layer again has to produce the same extrusions in the same order.
+        layer->make_fills();
+        REQUIRE(fills(*layer) == first);
+    }
+    REQUIRE(mixed);
+}
+
+TEST_CASE("Fill: Narrow solid infill classification cache", "[Fill]") {
+    // Solid cube, all the layers between the top and bottom shells share the same internal solid surface.
+    Slic3r::Print print;
+    Slic3r::Test::init_and_process_print({ Slic3r::Test::TestMesh::cube_20x20x20 }, print, {
+        { "layer_height",                        0.2 },
+        { "sparse_infill_density",               "100%" },
+        { "internal_solid_infill_pattern",       "rectilinear" },
+        { "detect_narrow_internal_solid_infill", true }
+    });
+    const PrintObject      *object = print.objects().front();
+    SolidSurfaceSplitCache &cache  = object->solid_surface_split_cache();
+    SolidSurfaceSplitCache::Stats stats = cache.stats();
+    REQUIRE(stats.misses > 0);
+    REQUIRE(stats.hits > stats.misses);
+
+    auto fills = [](const Layer &layer) {
+        Polylines out;
+        for (const LayerRegion *layerm : layer.regions())
+            layerm->fills.collect_polylines(out);
+        return out;
+    };
+    for (Layer *layer : print.objects().front()->layers()) {
+        Polylines cached = fills(*layer);
+        cache.clear();
+        layer->make_fills();
+        REQUIRE(fills(*layer) == cached);
+        // Again with the classification of this layer cached.
+        layer->make_fills();
+        REQUIRE(fills(*layer) == cached);
+    }
+}
+
+TEST_CASE("Fill: Ironing regenerated without the infill", "[Fill]") {
+    Slic3r::DynamicPrintConfig config = Slic3r::DynamicPrintConfig::full_print_config();
+    config.set_deserialize_strict({
+        { "layer_height",    0.2 },
+        { "ironing_type",    "top" },
+        { "ironing_spacing", 0.1 }
+    });
+    Slic3r::Print print;
+    Slic3r::Test::init_and_process_print({ Slic3r::Test::TestMesh::cube_20x20x20 }, print, config);
+    auto extrusions = [&print](bool ironing) {
+        Polylines out;
+        for (const Layer *layer : print.objects().front()->layers())
+            for (const LayerRegion *layerm : layer->regions())
+                for (const ExtrusionEntity *ee : layerm->fills.entities)
+                    if ((ee->role() == erIroning) == ironing)
+                        ee->collect_polylines(out);
+        return out;
+    };
+    const Polylines infill  = extrusions(false);
+    const Polylines ironing = extrusions(true);
+    REQUIRE(! ironing.empty());
+
+    auto change_ironing_spacing = [&print, &config](double spacing) {
+        config.set_deserialize_strict({ { "ironing_spacing", spacing } });
+        Slic3r::Model model = print.model();
+        print.apply(model, config);
+        const PrintObject *object = print.objects().front();
+        REQUIRE(object->is_step_done(posInfill));
+        REQUIRE(! object->is_step_done(posIroning));
+        print.process();
+    };
+    change_ironing_spacing(0.2);
+    REQUIRE(extrusions(false) == infill);
+    Polylines sparse_ironing = extrusions(true);
+    REQUIRE(! sparse_ironing.empty());
+    auto length = [](const Polylines &polylines) {
+        return std::accumulate(polylines.begin(), polylines.end(), 0., [](double acc, const Polyline &pl) { return acc + pl.length(); });
+    };
+    REQUIRE(length(sparse_ironing) < 0.75 * length(ironing));
+    // The ironing of the previous run is replaced, not appended to.
+    change_ironing_spacing(0.1);
+    REQUIRE(extrusions(false) == infill);
+    REQUIRE(extrusions(true) == ironing);
+}
+
 bool test_if_solid_surface_filled(const ExPolygon& expolygon, double flow_spacing, double angle, double density)
 {
     std::unique_ptr<Slic3r::Fill> filler(Slic3r::Fill::new_from_type("rectilinear"));
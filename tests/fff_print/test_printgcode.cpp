@@ -6,6 +6,8 @@
 #include "test_data.hpp"
 
 #include <algorithm>
+#include <array>
+#include <cmath>
 #include <boost/regex.hpp>
 
 using namespace Slic3r;
@@ -269,3 +271,54 @@ SCENARIO( "PrintGCode basic functionality", "[PrintGCode]") {
         }
     }
 }
+
+SCENARIO("PrintGCode island order optimization", "[PrintGCode]") {
+    GIVEN("Several objects, one of them with two islands per layer") {
+        TriangleMesh two_islands = mesh(TestMesh::cube_20x20x20);
+        two_islands.merge(mesh(TestMesh::cube_20x20x20, Vec3d(30., 0., 0.), Vec3d(1., 1., 1.)));
+        auto export_gcode = [&two_islands](bool optimize_island_order, Print &print) {
+            Model model;
+            init_print({ mesh(TestMesh::cube_20x20x20), two_islands, mesh(TestMesh::pyramid), mesh(TestMesh::cube_with_hole), mesh(TestMesh::small_dorito) },
+                print, model, {
+                { "layer_height",           0.2 },
+                { "first_layer_height",     0.2 },
+                { "optimize_island_order",  optimize_island_order }
+                });
+            return gcode(print);
+        };
+        // Travel length and the extrusions as undirected segments in micrometers, the chaining inside an island
+        // may reverse the open paths when the island is entered from another side.
+        struct Emitted {
+            double                                   travel { 0. };
+            std::vector<std::array<long long, 5>>    extrusions;
+        };
+        auto parse = [](const Print &print, const std::string &gcode) {
+            Emitted out;
+            GCodeReader reader;
+            reader.apply_config(print.config());
+            reader.parse_buffer(gcode, [&out](GCodeReader &self, const GCodeReader::GCodeLine &line) {
+                if (line.travel())
+                    out.travel += line.dist_XY(self);
+                else if (line.extruding(self) && line.dist_XY(self) > 0.) {
+                    std::array<long long, 2> a { std::llround(self.x() * 1000.), std::llround(self.y() * 1000.) };
+                    std::array<long long, 2> b { std::llround(line.new_X(self) * 1000.), std::llround(line.new_Y(self) * 1000.) };
+                    if (b < a)
+                        std::swap(a, b);
+                    out.extrusions.push_back({ std::llround(self.z() * 1000.), a[0], a[1], b[0], b[1] });
+                }
+            });
+            std::sort(out.extrusions.begin(), out.extrusions.end());
+            return out;
+        };
+        Print  print_off, print_on;
+        Emitted off = parse(print_off, export_gcode(false, print_off));
+        Emitted on  = parse(print_on,  export_gcode(true,  print_on));
+        THEN("Every extrusion is emitted exactly once") {
+            REQUIRE(! off.extrusions.empty());
+            REQUIRE(on.extrusions == off.extrusions);
+        }
+        THEN("Travel length does not increase") {
+            REQUIRE(on.travel <= off.travel + EPSILON);
+        }
+    }
+}
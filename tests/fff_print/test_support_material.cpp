@@ -1,7 +1,21 @@
 #include <catch2/catch.hpp>
 
+#include "libslic3r/BuildVolume.hpp"
+#include "libslic3r/ClipperUtils.hpp"
+#include "libslic3r/Fill/FillBase.hpp"
 #include "libslic3r/GCodeReader.hpp"
 #include "libslic3r/Layer.hpp"
+#include "libslic3r/Print.hpp"
+#include "libslic3r/TriangleMesh.hpp"
+#include "libslic3r/TriangleMeshSlicer.hpp"
+#include "libslic3r/Support/SupportFillCache.hpp"
+#include "libslic3r/Support/SupportMaterial.hpp"
+#include "libslic3r/Support/TreeModelVolumes.hpp"
+#include "libslic3r/Support/TreeSupport3D.hpp"
+
+#include <random>
+
+#include <tbb/task_arena.h>
 
 #include "test_data.hpp" // get access to init_print, etc
 
@@ -18,6 +32,349 @@ TEST_CASE("SupportMaterial: Three raft layers created", "[SupportMaterial]")
     REQUIRE(print.objects().front()->support_layers().size() == 3);
 }
 
+TEST_CASE("SupportMaterial: support infill cache reuses the infill of identical support areas", "[SupportMaterial]")
+{
+    Slic3r::Polygon square { Point::new_scale(0, 0), Point::new_scale(20, 0), Point::new_scale(20, 20), Point::new_scale(0, 20) };
+    Slic3r::Polygon hole   { Point::new_scale(5, 5), Point::new_scale(5, 15), Point::new_scale(15, 15), Point::new_scale(15, 5) };
+    Slic3r::Surface surface(stInternal, ExPolygon(square, hole));
+    FillParams fill_params;
+    fill_params.density     = 0.25f;
+    fill_params.dont_adjust = true;
+
+    for (InfillPattern pattern : { ipSupportBase, ipRectilinear }) {
+        std::unique_ptr<Slic3r::Fill> filler(Slic3r::Fill::new_from_type(pattern));
+        filler->set_bounding_box(BoundingBox(Point::new_scale(-1, -1), Point::new_scale(1, 1)));
+        filler->angle   = float(PI / 4.);
+        filler->spacing = 0.4;
+        const Slic3r::Polylines expected = filler->fill_surface(&surface, fill_params);
+        REQUIRE(! expected.empty());
+
+        SupportFillCache cache;
+        REQUIRE(cache.fill_surface(filler.get(), surface, fill_params) == expected);
+        REQUIRE(cache.fill_surface(filler.get(), surface, fill_params) == expected);
+        REQUIRE(cache.stats().misses == 1);
+        REQUIRE(cache.stats().hits == 1);
+
+        // A different angle fills the same area with other lines.
+        filler->angle = 0.f;
+        REQUIRE(cache.fill_surface(filler.get(), surface, fill_params) == filler->fill_surface(&surface, fill_params));
+        REQUIRE(cache.stats().misses == 2);
+        REQUIRE(cache.stats().size == 2);
+
+        // The layer angle is added to the infill angle only if the layer index is set.
+        filler->layer_id = 3;
+        REQUIRE(cache.fill_surface(filler.get(), surface, fill_params) == filler->fill_surface(&surface, fill_params));
+        filler->rotate_angle = float(PI / 2.);
+        REQUIRE(cache.fill_surface(filler.get(), surface, fill_params) == filler->fill_surface(&surface, fill_params));
+        REQUIRE(cache.stats().misses == 4);
+        REQUIRE(cache.stats().size == 4);
+    }
+
+    // Other than the rectilinear fills are not cached.
+    SupportFillCache cache;
+    std::unique_ptr<Slic3r::Fill> filler(Slic3r::Fill::new_from_type(ipConcentric));
+    filler->angle   = 0.f;
+    filler->spacing = 0.4;
+    REQUIRE(cache.fill_surface(filler.get(), surface, fill_params) == filler->fill_surface(&surface, fill_params));
+    REQUIRE(cache.stats().misses == 0);
+    REQUIRE(cache.stats().size == 0);
+}
+
+TEST_CASE("SupportMaterial: organic tree collisions from distance fields match polygon offsets", "[SupportMaterial]")
+{
+    // Box with a horizontal hole, thus with overhangs and holes in the outlines.
+    TriangleMesh mesh = Slic3r::Test::mesh(Slic3r::Test::TestMesh::cube_with_hole);
+    mesh.rotate_x(float(M_PI / 2));
+
+    // With a support blocker next to the object reaching half of its height, which the supports collide with as with the object.
+    const auto process = [&mesh](const char *backend, Print &print, Model &model) {
+        DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+        config.set_deserialize_strict({ { "tree_support_collision_backend", backend } });
+        Slic3r::Test::init_print({ mesh }, print, model, config);
+        ModelObject        *object  = model.objects.front();
+        const BoundingBoxf3 bbox    = object->raw_mesh_bounding_box();
+        TriangleMesh        blocker = make_cube(6., bbox.size().y(), 0.5 * bbox.size().z());
+        blocker.translate(float(bbox.max.x() + 2.), float(bbox.min.y()), float(bbox.min.z()));
+        object->add_volume(std::move(blocker), ModelVolumeType::SUPPORT_BLOCKER, false);
+        print.apply(model, config);
+        print.process();
+    };
+    Slic3r::Print print_polygons;
+    Slic3r::Print print_distance_field;
+    Slic3r::Model model_polygons;
+    Slic3r::Model model_distance_field;
+    process("polygons", print_polygons, model_polygons);
+    process("distance_field", print_distance_field, model_distance_field);
+    const PrintObject &object_polygons       = *print_polygons.objects().front();
+    const PrintObject &object_distance_field = *print_distance_field.objects().front();
+    const BuildVolume  build_volume{ print_polygons.config().printable_area.values, print_polygons.config().printable_height };
+    TreeSupport3D::TreeModelVolumes volumes_polygons      { object_polygons,       build_volume, scaled<coord_t>(1.), scaled<coord_t>(0.5), 0 };
+    TreeSupport3D::TreeModelVolumes volumes_distance_field{ object_distance_field, build_volume, scaled<coord_t>(1.), scaled<coord_t>(0.5), 0 };
+
+    const auto area = [](const Polygons &polygons) {
+        double out = 0;
+        for (const Polygon &polygon : polygons)
+            out += polygon.area();
+        return out;
+    };
+    const coord_t               xy_distance = scaled<coord_t>(object_polygons.config().support_object_xy_distance.value);
+    const std::vector<Polygons> blockers    = object_polygons.slice_support_blockers();
+    REQUIRE(blockers.size() == object_polygons.layer_count());
+    size_t                      num_blocked = 0;
+    for (double radius : { 0.5, 1., 2., 4. })
+        for (TreeSupport3D::LayerIndex layer_idx = 0; layer_idx < TreeSupport3D::LayerIndex(object_polygons.layer_count()); layer_idx += 7) {
+            const Polygons &expected = volumes_polygons.getCollision(scaled<coord_t>(radius), layer_idx, true);
+            const Polygons &collision = volumes_distance_field.getCollision(scaled<coord_t>(radius), layer_idx, true);
+            INFO("Radius " << radius << ", layer " << layer_idx);
+            REQUIRE(collision.empty() == expected.empty());
+            if (! blockers[layer_idx].empty()) {
+                // Both collide with the blocker offsetted by the radius.
+                const Polygons blocked = offset(blockers[layer_idx], scaled<float>(radius) - scaled<float>(0.15));
+                CHECK(diff(blocked, expected).empty());
+                CHECK(diff(blocked, collision).empty());
+                ++ num_blocked;
+            }
+            // Rounded at the corners, where the polygon offsets are mitered: A right angle sticks out by (sqrt(2) - 1) of the offset.
+            const coord_t corners = coord_t(0.45 * double(scaled<coord_t>(radius) + xy_distance));
+            CHECK(diff(collision, offset(expected, scaled<float>(0.15))).empty());
+            CHECK(diff(expected, offset(collision, float(corners + scaled<coord_t>(0.15)))).empty());
+            CHECK(std::abs(area(collision) - area(expected)) < 0.05 * area(expected));
+        }
+    REQUIRE(num_blocked > 0);
+}
+
+TEST_CASE("SupportMaterial: organic branch slices match the sliced branch mesh", "[SupportMaterial]")
+{
+    TreeSupport3D::TreeSupportMeshGroupSettings mesh_group_settings;
+    mesh_group_settings.layer_height = scaled<coord_t>(0.2);
+    SlicingParameters slicing_params;
+    slicing_params.layer_height              = 0.2;
+    slicing_params.first_object_layer_height = 0.2;
+    const TreeSupport3D::TreeSupportSettings config{ mesh_group_settings, slicing_params };
+
+    // Curved branch from the bed to its tip, the radius growing downwards.
+    const int num_layers = 150;
+    TreeSupport3D::SupportElements elements;
+    for (int layer_idx = 0; layer_idx < num_layers; ++ layer_idx) {
+        TreeSupport3D::SupportElementState state{};
+        state.layer_idx               = layer_idx;
+        state.distance_to_top         = num_layers - 1 - layer_idx;
+        state.effective_radius_height = state.distance_to_top;
+        state.result_on_layer         = Point(scaled<coord_t>(30. * sin(layer_idx * 0.01)), scaled<coord_t>(20. * (1. - cos(layer_idx * 0.015))));
+        elements.emplace_back(state, Polygons{});
+    }
+    std::vector<const TreeSupport3D::SupportElement*> path;
+    for (const TreeSupport3D::SupportElement &element : elements)
+        path.emplace_back(&element);
+
+    indexed_triangle_set mesh;
+    std::pair<float, float> zspan = TreeSupport3D::extrude_branch(path, config, slicing_params, {}, mesh);
+    const TreeSupport3D::LayerIndex layer_begin = TreeSupport3D::layer_idx_ceil(slicing_params, config, zspan.first);
+    const TreeSupport3D::LayerIndex layer_end   = TreeSupport3D::layer_idx_floor(slicing_params, config, zspan.second) + 1;
+    std::vector<float> slice_z;
+    for (TreeSupport3D::LayerIndex layer_idx = layer_begin; layer_idx < layer_end; ++ layer_idx)
+        slice_z.emplace_back(float(0.5 * (TreeSupport3D::layer_z(slicing_params, config, layer_idx) +
+            (layer_idx > 0 ? TreeSupport3D::layer_z(slicing_params, config, layer_idx - 1) : 0.))));
+    MeshSlicingParams mesh_slicing_params;
+    mesh_slicing_params.mode = MeshSlicingParams::SlicingMode::Positive;
+    const std::vector<Polygons> expected = slice_mesh(mesh, slice_z, mesh_slicing_params);
+    const std::vector<Polygons> slices   = TreeSupport3D::slice_branch(path, config, slicing_params, layer_begin, layer_end);
+    REQUIRE(slices.size() == expected.size());
+
+    const auto area = [](const Polygons &polygons) {
+        double out = 0;
+        for (const Polygon &polygon : polygons)
+            out += polygon.area();
+        return out;
+    };
+    for (size_t i = 0; i < slices.size(); ++ i) {
+        const TreeSupport3D::LayerIndex layer_idx = layer_begin + TreeSupport3D::LayerIndex(i);
+        const Polygons                  slice     = union_(slices[i]);
+        INFO("Layer " << layer_idx);
+        REQUIRE(slice.empty() == expected[i].empty());
+        // The bends of the swept spheres are rounded.
+        CHECK(diff(expected[i], offset(slice, scaled<float>(0.1))).empty());
+        // The half sphere closing the tip of the mesh is coarse.
+        CHECK(diff(slice, offset(expected[i], scaled<float>(layer_idx + 3 < num_layers ? 0.1 : 0.25))).empty());
+        if (layer_idx + config.tip_layers + 2 < num_layers)
+            // Below the tip and below the kink at its bottom.
+            CHECK(std::abs(area(slice) - area(expected[i])) < 0.02 * area(expected[i]));
+    }
+}
+
+TEST_CASE("SupportMaterial: organic tree influence areas are merged deterministically and completely", "[SupportMaterial]")
+{
+    Slic3r::Print print;
+    Slic3r::Test::init_and_process_print({ TestMesh::cube_20x20x20 }, print, {});
+    const PrintObject &object = *print.objects().front();
+    const BuildVolume  build_volume{ print.config().printable_area.values, print.config().printable_height };
+    TreeSupport3D::TreeModelVolumes volumes{ object, build_volume, scaled<coord_t>(1.), scaled<coord_t>(0.5), 0 };
+    TreeSupport3D::TreeSupportMeshGroupSettings mesh_group_settings;
+    mesh_group_settings.layer_height = scaled<coord_t>(0.2);
+    SlicingParameters slicing_params;
+    slicing_params.layer_height              = 0.2;
+    slicing_params.first_object_layer_height = 0.2;
+    const TreeSupport3D::TreeSupportSettings config{ mesh_group_settings, slicing_params };
+    const TreeSupport3D::LayerIndex          layer_idx = 50;
+
+    // Circular influence areas of branches of various radii around the cube, many of them overlapping.
+    std::vector<TreeSupport3D::SupportElementMerging> influence_areas;
+    std::mt19937 rng(0);
+    while (influence_areas.size() < 400) {
+        const Point center(scaled<coord_t>(std::uniform_real_distribution<double>(-60., 60.)(rng)),
+                           scaled<coord_t>(std::uniform_real_distribution<double>(-60., 60.)(rng)));
+        if (std::abs(center.x()) < scaled<coord_t>(15.) && std::abs(center.y()) < scaled<coord_t>(15.))
+            continue;
+        TreeSupport3D::SupportElementMerging element;
+        element.state.to_buildplate           = true;
+        element.state.can_use_safe_radius     = true;
+        element.state.layer_idx               = layer_idx;
+        element.state.distance_to_top         = std::uniform_int_distribution<uint32_t>(0, 60)(rng);
+        element.state.effective_radius_height = element.state.distance_to_top;
+        element.state.target_position         = center;
+        element.state.next_position           = center;
+        element.parents.emplace_back(int32_t(influence_areas.size()));
+        Polygon circle = make_circle_num_segments(scaled<double>(std::uniform_real_distribution<double>(1., 4.)(rng)), 32);
+        circle.translate(center);
+        element.areas.influence_areas = { circle };
+        element.areas.to_bp_areas     = { circle };
+        element.set_bbox(get_extents(element.areas.influence_areas));
+        influence_areas.emplace_back(std::move(element));
+    }
+
+    std::vector<TreeSupport3D::SupportElementMerging> merged = influence_areas;
+    TreeSupport3D::merge_influence_areas(volumes, config, layer_idx, merged, []{});
+    REQUIRE(merged.size() < influence_areas.size());
+
+    SECTION("Repeated runs give the same result, independent of the number of threads") {
+        std::vector<TreeSupport3D::SupportElementMerging> merged_serial = influence_areas;
+        tbb::task_arena arena(1);
+        arena.execute([&]() { TreeSupport3D::merge_influence_areas(volumes, config, layer_idx, merged_serial, []{}); });
+        std::vector<TreeSupport3D::SupportElementMerging> merged_again = influence_areas;
+        TreeSupport3D::merge_influence_areas(volumes, config, layer_idx, merged_again, []{});
+        for (const std::vector<TreeSupport3D::SupportElementMerging> *other : { &merged_serial, &merged_again }) {
+            REQUIRE(other->size() == merged.size());
+            for (size_t i = 0; i < merged.size(); ++ i) {
+                REQUIRE((*other)[i].parents == merged[i].parents);
+                REQUIRE((*other)[i].state.next_position == merged[i].state.next_position);
+                REQUIRE((*other)[i].areas.influence_areas == merged[i].areas.influence_areas);
+            }
+        }
+    }
+
+    SECTION("No mergeable pair is left unmerged") {
+        for (size_t i = 0; i < merged.size(); ++ i)
+            for (size_t j = i + 1; j < merged.size(); ++ j) {
+                TreeSupport3D::SupportElementMerging dst = merged[i];
+                TreeSupport3D::SupportElementMerging src = merged[j];
+                INFO("Elements " << i << " and " << j);
+                REQUIRE(! TreeSupport3D::merge_influence_areas_two_elements(volumes, config, layer_idx, dst, src));
+            }
+    }
+}
+
+TEST_CASE("SupportMaterial: build plate covered areas match the serial union of the layers below", "[SupportMaterial]")
+{
+    DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+    config.set_deserialize_strict({
+        { "layer_height",                0.2 },
+        { "enable_support",              1 },
+        { "support_type",                "normal(auto)" },
+        { "support_on_build_plate_only", 1 }
+    });
+    Model model;
+    Print print;
+    Slic3r::Test::init_print({ TestMesh::overhang }, print, model, config);
+    // Enforce the support over the whole object, the support on top of the object is removed by the build plate only option.
+    ModelObject *object   = model.objects.front();
+    ModelVolume *enforcer = object->add_volume(TriangleMesh(object->volumes.front()->mesh()), ModelVolumeType::SUPPORT_ENFORCER);
+    enforcer->set_transformation(object->volumes.front()->get_transformation());
+    print.apply(model, config);
+    print.process();
+
+    const PrintObject &print_object = *print.objects().front();
+    REQUIRE(! print_object.support_layers().empty());
+    const std::vector<Polygons> covered = PrintObjectSupportMaterial(&print_object, print_object.slicing_parameters()).buildplate_covered(print_object);
+    REQUIRE(covered.size() == print_object.layers().size());
+    Polygons serial;
+    for (size_t layer_id = 0; layer_id < covered.size(); ++ layer_id) {
+        REQUIRE(covered[layer_id] == serial);
+        polygons_append(serial, offset(print_object.layers()[layer_id]->lslices, scale_(0.01)));
+        serial = union_(serial);
+    }
+}
+
+TEST_CASE("SupportMaterial: organic tree supports reuse the volumes of the previous support generation", "[SupportMaterial]")
+{
+    DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+    config.set_deserialize_strict({
+        { "layer_height",                 0.2 },
+        { "enable_support",               1 },
+        { "support_type",                 "tree(auto)" },
+        { "support_style",                "organic" },
+        { "support_base_pattern_spacing", 2.5 }
+    });
+    Model model;
+    Print print;
+    Slic3r::Test::init_print({ TestMesh::overhang }, print, model, config);
+    print.process();
+
+    // Regions of the collision and avoidance caches the support generation calculated. Being owned by the caches,
+    // their addresses stay the same as long as the caches are handed over to the next support generation.
+    PrintObject &object   = *print.get_object(0);
+    const TreeSupport3D::TreeSupportSettings settings{ TreeSupport3D::TreeSupportMeshGroupSettings(object), object.slicing_parameters() };
+    const coord_t                            radius   = settings.getRadius(0);
+    const TreeSupport3D::LayerIndex          layer_idx = 5;
+    const auto collision = [&object, radius, layer_idx]() {
+        return &object.tree_model_volumes()->getCollision(radius, layer_idx, false);
+    };
+    const auto avoidance = [&object, radius, layer_idx]() {
+        return &object.tree_model_volumes()->getAvoidance(radius, layer_idx, TreeSupport3D::TreeModelVolumes::AvoidanceType::Fast, false, false);
+    };
+    const auto support_extrusions = [](const PrintObject &object) {
+        std::vector<Polylines> out;
+        for (const SupportLayer *layer : object.support_layers())
+            out.emplace_back(layer->support_fills.as_polylines());
+        return out;
+    };
+    REQUIRE(object.tree_model_volumes());
+    const Polygons *collision_first = collision();
+    const Polygons *avoidance_first = avoidance();
+    REQUIRE(! collision_first->empty());
+
+    // Changing a support only option regenerates the supports from the same volumes,
+    // the result being the same as if the supports were generated from scratch.
+    auto regenerate = [&](std::initializer_list<ConfigBase::SetDeserializeItem> items) {
+        config.set_deserialize_strict(items);
+        print.apply(model, config);
+        print.process();
+        Model model_cold;
+        Print print_cold;
+        Slic3r::Test::init_print({ TestMesh::overhang }, print_cold, model_cold, config);
+        print_cold.process();
+        REQUIRE(! object.support_layers().empty());
+        REQUIRE(support_extrusions(object) == support_extrusions(*print_cold.objects().front()));
+    };
+
+    SECTION("Changing the support density reuses both the collisions and the avoidances") {
+        regenerate({ { "support_base_pattern_spacing", 1.5 } });
+        REQUIRE(object.tree_model_volumes());
+        REQUIRE(collision() == collision_first);
+        REQUIRE(avoidance() == avoidance_first);
+    }
+    SECTION("Changing the branch angle reuses the collisions") {
+        regenerate({ { "tree_support_branch_angle_organic", 30 } });
+        REQUIRE(object.tree_model_volumes());
+        REQUIRE(collision() == collision_first);
+    }
+    SECTION("Disabling the supports releases the volumes") {
+        config.set_deserialize_strict({ { "enable_support", 0 } });
+        print.apply(model, config);
+        print.process();
+        REQUIRE(! object.tree_model_volumes());
+    }
+}
+
 SCENARIO("SupportMaterial: support_layers_z and contact_distance", "[SupportMaterial]")
 {
     // Box h = 20mm, hole bottom at 5mm, hole height 10mm (top edge at 15mm).
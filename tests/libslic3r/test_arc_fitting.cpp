@@ -0,0 +1,196 @@
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <iostream>
+
+#include <tbb/parallel_for.h>
+
+#include "libslic3r/ArcFitter.hpp"
+#include "libslic3r/ExtrusionEntity.hpp"
+#include "libslic3r/ExtrusionEntityCollection.hpp"
+#include "libslic3r/Line.hpp"
+#include "libslic3r/Polyline.hpp"
+
+using namespace Slic3r;
+
+// Wavy line resembling a single gyroid infill path: a sine wave sampled along x.
+static Points sample_wave(double x0, double y0, double length, double amplitude, double period, double step)
+{
+    Points out;
+    for (double x = 0.; x <= length; x += step)
+        out.emplace_back(Point::new_scale(x0 + x, y0 + amplitude * std::sin(2. * PI * x / period)));
+    return out;
+}
+
+static Points sample_circle(double radius, double step)
+{
+    Points out;
+    size_t n = size_t(2. * PI * radius / step);
+    for (size_t i = 0; i <= n; ++ i) {
+        double a = 2. * PI * double(i) / double(n);
+        out.emplace_back(Point::new_scale(radius * std::cos(a), radius * std::sin(a)));
+    }
+    return out;
+}
+
+// Verify that the fitting result covers all the points without gaps and that the points
+// spanned by each arc are within tolerance of it.
+static void check_fitting_result(const Points &points, const std::vector<PathFittingData> &result, double tolerance)
+{
+    REQUIRE(! result.empty());
+    REQUIRE(result.front().start_point_index == 0);
+    REQUIRE(result.back().end_point_index == points.size() - 1);
+    for (size_t i = 1; i < result.size(); ++ i)
+        REQUIRE(result[i].start_point_index == result[i - 1].end_point_index);
+    for (PathFittingData data : result) {
+        REQUIRE(data.start_point_index < data.end_point_index);
+        if (data.is_arc_move()) {
+            // The arc center is rounded to integer coordinates.
+            for (size_t i = data.start_point_index; i <= data.end_point_index; ++ i)
+                REQUIRE(std::abs((points[i] - data.arc_data.center).cast<double>().norm() - data.arc_data.radius) <= tolerance + 2.);
+            REQUIRE(data.arc_data.start_point == points[data.start_point_index]);
+            REQUIRE(data.arc_data.end_point == points[data.end_point_index]);
+        }
+    }
+}
+
+static double distance_to_polyline(const Points &polyline, const Point &pt)
+{
+    double dist = std::numeric_limits<double>::max();
+    for (size_t i = 1; i < polyline.size(); ++ i)
+        dist = std::min(dist, Line(polyline[i - 1], polyline[i]).distance_to(pt));
+    return dist;
+}
+
+SCENARIO("Arc fitting", "[ArcFitting]") {
+    const double tolerance = scaled<double>(0.0125);
+    GIVEN("A densely sampled circle") {
+        Points points = sample_circle(10., 0.2);
+        WHEN("arcs are fitted") {
+            std::vector<PathFittingData> result;
+            ArcFitter::do_arc_fitting(points, result, tolerance);
+            THEN("the result is valid and contains arcs") {
+                check_fitting_result(points, result, tolerance);
+                REQUIRE(std::any_of(result.begin(), result.end(), [](PathFittingData &d) { return d.is_arc_move(); }));
+            }
+        }
+    }
+    GIVEN("Wavy lines of varying curvature") {
+        for (double amplitude : { 0.5, 2., 5. }) {
+            Points points = sample_wave(0., 0., 100., amplitude, 10., 0.1);
+            std::vector<PathFittingData> result;
+            ArcFitter::do_arc_fitting(points, result, tolerance);
+            check_fitting_result(points, result, tolerance);
+        }
+    }
+    GIVEN("A wavy line fitted and simplified") {
+        Points points = sample_wave(0., 0., 100., 2., 10., 0.05);
+        Points simplified = points;
+        std::vector<PathFittingData> result;
+        ArcFitter::do_arc_fitting_and_simplify(simplified, result, tolerance);
+        THEN("the fitting result refers to the simplified points") {
+            REQUIRE(simplified.size() < points.size());
+            REQUIRE(simplified.front() == points.front());
+            REQUIRE(simplified.back() == points.back());
+            check_fitting_result(simplified, result, tolerance);
+        }
+        THEN("the original points are within tolerance of the simplified polyline") {
+            for (const Point &pt : points)
+                REQUIRE(distance_to_polyline(simplified, pt) <= tolerance + 2.);
+        }
+    }
+    GIVEN("A collection of paths, multi-paths and loops") {
+        ExtrusionEntityCollection collection;
+        {
+            ExtrusionPath path(erInternalInfill, 0.05, 0.45f, 0.2f);
+            path.polyline.points = sample_wave(0., 0., 50., 2., 10., 0.1);
+            collection.append(path);
+            ExtrusionMultiPath multipath;
+            for (int i = 0; i < 3; ++ i) {
+                multipath.paths.emplace_back(erSolidInfill, 0.05, 0.45f, 0.2f);
+                multipath.paths.back().polyline.points = sample_wave(50. * i, 10., 50., 1., 8., 0.1);
+            }
+            collection.append(multipath);
+            ExtrusionLoop loop;
+            loop.paths.emplace_back(erExternalPerimeter, 0.05, 0.45f, 0.2f);
+            loop.paths.back().polyline.points = sample_circle(10., 0.2);
+            ExtrusionEntityCollection nested;
+            nested.append(loop);
+            collection.append(std::move(nested));
+        }
+        WHEN("the paths are collected") {
+            std::vector<ExtrusionPath*> paths;
+            collection.collect_paths(paths);
+            THEN("all paths are found") {
+                REQUIRE(paths.size() == 5);
+            }
+        }
+        WHEN("the paths are fitted in parallel") {
+            ExtrusionEntityCollection serial = collection;
+            std::vector<ExtrusionPath*> serial_paths;
+            serial.collect_paths(serial_paths);
+            for (ExtrusionPath *path : serial_paths)
+                path->simplify_by_fitting_arc(tolerance);
+            std::vector<ExtrusionPath*> paths;
+            collection.collect_paths(paths);
+            tbb::parallel_for(tbb::blocked_range<size_t>(0, paths.size(), 1), [&paths, tolerance](const tbb::blocked_range<size_t> &range) {
+                for (size_t i = range.begin(); i < range.end(); ++ i)
+                    paths[i]->simplify_by_fitting_arc(tolerance);
+            });
+            THEN("the result matches the serial fitting") {
+                REQUIRE(paths.size() == serial_paths.size());
+                for (size_t i = 0; i < paths.size(); ++ i) {
+                    REQUIRE(paths[i]->polyline.points == serial_paths[i]->polyline.points);
+                    REQUIRE(paths[i]->polyline.fitting_result.size() == serial_paths[i]->polyline.fitting_result.size());
+                    for (size_t j = 0; j < paths[i]->polyline.fitting_result.size(); ++ j) {
+                        const PathFittingData &a = paths[i]->polyline.fitting_result[j];
+                        const PathFittingData &b = serial_paths[i]->polyline.fitting_result[j];
+                        REQUIRE(a.start_point_index == b.start_point_index);
+                        REQUIRE(a.end_point_index == b.end_point_index);
+                        REQUIRE(a.path_type == b.path_type);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Not run by default, execute with "[ArcFittingBenchmark]".
+TEST_CASE("Arc fitting throughput on gyroid like paths", "[ArcFittingBenchmark][.]") {
+    const double tolerance = scaled<double>(0.0125);
+    // 50 layers of 100 wavy paths, 200mm long each.
+    std::vector<Points> input;
+    for (int layer = 0; layer < 50; ++ layer)
+        for (int i = 0; i < 100; ++ i)
+            input.emplace_back(sample_wave(0., 2. * i, 200., 1.5 + 0.01 * layer, 12., 0.1));
+    size_t num_points = 0;
+    for (const Points &pts : input)
+        num_points += pts.size();
+
+    auto run = [&](bool parallel) {
+        std::vector<Polyline> polylines;
+        for (const Points &pts : input)
+            polylines.emplace_back(pts);
+        auto t0 = std::chrono::high_resolution_clock::now();
+        if (parallel)
+            tbb::parallel_for(tbb::blocked_range<size_t>(0, polylines.size(), 16), [&polylines, tolerance](const tbb::blocked_range<size_t> &range) {
+                for (size_t i = range.begin(); i < range.end(); ++ i)
+                    polylines[i].simplify_by_fitting_arc(tolerance);
+            });
+        else
+            for (Polyline &pl : polylines)
+                pl.simplify_by_fitting_arc(tolerance);
+        double s = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t0).count();
+        size_t num_arcs = 0;
+        for (const Polyline &pl : polylines)
+            num_arcs += std::count_if(pl.fitting_result.begin(), pl.fitting_result.end(), [](PathFittingData d) { return d.is_arc_move(); });
+        std::cout << (parallel ? "parallel" : "serial") << " arc fitting: " << num_points << " points, " << num_arcs << " arcs, "
+                  << s << " s, " << double(num_points) / s * 1e-6 << " Mpts/s" << std::endl;
+        return polylines;
+    };
+    std::vector<Polyline> serial   = run(false);
+    std::vector<Polyline> parallel = run(true);
+    REQUIRE(serial.size() == parallel.size());
+    for (size_t i = 0; i < serial.size(); ++ i)
+        REQUIRE(serial[i].points == parallel[i].points);
+}
@@ -10,6 +10,7 @@
 #include "libslic3r/Geometry/ConvexHull.hpp"
 #include "libslic3r/ClipperUtils.hpp"
 #include "libslic3r/ShortestPath.hpp"
+#include "libslic3r/MinimumSpanningTree.hpp"
 
 //#include <random>
 //#include "libnest2d/tools/benchmark.h"
@@ -17,6 +18,7 @@
 
 #include "../libnest2d/printer_parts.hpp"
 
+#include <random>
 #include <unordered_set>
 
 using namespace Slic3r;
@@ -355,6 +357,88 @@ SCENARIO("Path chaining", "[Geometry]") {
 			}
 		}
 	}
+	GIVEN("Many short infill segments") {
+		// Deterministic pseudo random short segments over a 200mm x 200mm area.
+		Polylines polylines;
+		uint32_t seed = 1;
+		auto rnd = [&seed](int range) { seed = seed * 1103515245 + 12345; return int((seed >> 8) % uint32_t(range)); };
+		for (size_t i = 0; i < 3000; ++ i) {
+			Point p1(rnd(200000000), rnd(200000000));
+			polylines.push_back({ p1, p1 + Point(rnd(2000000) - 1000000, rnd(2000000) - 1000000) });
+		}
+		ChainingParams params_serial;
+		params_serial.improve = false;
+		ChainingStats  stats_serial;
+		Polylines      chained_serial = chain_polylines(Polylines(polylines), nullptr, params_serial, &stats_serial);
+		ChainingParams params_tiled = params_serial;
+		params_tiled.parallel_threshold = 500;
+		params_tiled.segments_per_tile  = 200;
+		ChainingStats  stats_tiled;
+		Polylines      chained_tiled = chain_polylines(Polylines(polylines), nullptr, params_tiled, &stats_tiled);
+		THEN("Tiled chaining returns every segment exactly once") {
+			auto key = [](const Polyline &pl) {
+				return pl.first_point() < pl.last_point() ? std::make_pair(pl.first_point(), pl.last_point()) : std::make_pair(pl.last_point(), pl.first_point());
+			};
+			auto keys = [&key](const Polylines &pls) {
+				std::vector<std::pair<Point, Point>> out;
+				for (const Polyline &pl : pls)
+					out.emplace_back(key(pl));
+				std::sort(out.begin(), out.end());
+				return out;
+			};
+			REQUIRE(stats_serial.num_tiles == 1);
+			REQUIRE(stats_tiled.num_tiles > 1);
+			REQUIRE(keys(chained_tiled) == keys(polylines));
+		}
+		THEN("Reported travel length matches the chain") {
+			double travel_length = 0.;
+			for (size_t i = 1; i < chained_tiled.size(); ++ i)
+				travel_length += (chained_tiled[i].first_point() - chained_tiled[i - 1].last_point()).cast<double>().norm();
+			REQUIRE(stats_tiled.travel_length == Approx(travel_length));
+		}
+		THEN("Tiled chaining is not much longer than the serial one") {
+			REQUIRE(stats_tiled.travel_length < 1.2 * stats_serial.travel_length);
+		}
+	}
+	GIVEN("Infill segments chained by the callers without ChainingParams") {
+		Polylines polylines;
+		uint32_t seed = 1;
+		auto rnd = [&seed](int range) { seed = seed * 1103515245 + 12345; return int((seed >> 8) % uint32_t(range)); };
+		for (size_t i = 0; i < 1000; ++ i) {
+			Point p1(rnd(200000000), rnd(200000000));
+			polylines.push_back({ p1, p1 + Point(rnd(2000000) - 1000000, rnd(2000000) - 1000000) });
+		}
+		ChainingParams params_tiled;
+		params_tiled.parallel_threshold = 500;
+		params_tiled.segments_per_tile  = 200;
+		THEN("Tiling is off by default, whatever the number of segments") {
+			REQUIRE(ChainingParams().parallel_threshold == std::numeric_limits<size_t>::max());
+		}
+		THEN("The polylines are chained serially") {
+			Point     start_near(0, 0);
+			Polylines chained = chain_polylines(Polylines(polylines), &start_near);
+			ChainingStats stats;
+			REQUIRE(chain_polylines(Polylines(polylines), &start_near, ChainingParams(), &stats) == chained);
+			REQUIRE(stats.num_tiles == 1);
+			REQUIRE(chain_polylines(Polylines(polylines), &start_near, params_tiled) != chained);
+		}
+		THEN("The extrusion entities are chained serially") {
+			std::vector<ExtrusionPath> paths;
+			for (const Polyline &polyline : polylines) {
+				paths.emplace_back(erInternalInfill, 0.05, 0.4f, 0.2f);
+				paths.back().polyline = polyline;
+			}
+			std::vector<ExtrusionEntity*> entities;
+			for (ExtrusionPath &path : paths)
+				entities.emplace_back(&path);
+			Point         start_near(0, 0);
+			ChainingStats stats;
+			std::vector<std::pair<size_t, bool>> chain = chain_extrusion_entities(entities, &start_near);
+			REQUIRE(chain_extrusion_entities(entities, &start_near, ChainingParams(), &stats) == chain);
+			REQUIRE(stats.num_tiles == 1);
+			REQUIRE(chain_extrusion_entities(entities, &start_near, params_tiled) != chain);
+		}
+	}
 }
 
 SCENARIO("Line distances", "[Geometry]"){
@@ -708,3 +792,59 @@ TEST_CASE("Convex polygon intersection test prusa polygons", "[Geometry][Rotcali
         REQUIRE(res == ref);
     }
 }
+
+TEST_CASE("Minimum spanning tree matches the one of the complete graph", "[Geometry]") {
+    auto tree_length = [](const MinimumSpanningTree &mst, size_t &num_edges) {
+        double length = 0.;
+        num_edges = 0;
+        for (const Point &pt : mst.vertices())
+            for (const Point &neighbour : mst.adjacent_nodes(pt)) {
+                length += (neighbour - pt).cast<double>().norm();
+                ++ num_edges;
+            }
+        num_edges /= 2;
+        return 0.5 * length;
+    };
+    // Prim's algorithm over all the pairs of points.
+    auto brute_force_length = [](const std::vector<Point> &points) {
+        std::vector<double> dist(points.size(), std::numeric_limits<double>::max());
+        std::vector<bool>   done(points.size(), false);
+        double              length = 0.;
+        dist[0] = 0.;
+        for (size_t iter = 0; iter < points.size(); ++ iter) {
+            size_t next = std::numeric_limits<size_t>::max();
+            for (size_t i = 0; i < points.size(); ++ i)
+                if (! done[i] && (next == std::numeric_limits<size_t>::max() || dist[i] < dist[next]))
+                    next = i;
+            done[next] = true;
+            length += dist[next];
+            for (size_t i = 0; i < points.size(); ++ i)
+                if (! done[i])
+                    dist[i] = std::min(dist[i], (points[i] - points[next]).cast<double>().norm());
+        }
+        return length;
+    };
+
+    std::mt19937 rng(1234);
+    for (size_t num_points : { 2, 3, 10, 100, 1000 }) {
+        std::uniform_int_distribution<coord_t> coord(0, scaled<coord_t>(100.));
+        std::vector<Point> points;
+        for (size_t i = 0; i < num_points; ++ i)
+            points.emplace_back(coord(rng), coord(rng));
+        size_t num_edges;
+        double length = tree_length(MinimumSpanningTree(points), num_edges);
+        REQUIRE(num_edges == num_points - 1);
+        REQUIRE(length == Approx(brute_force_length(points)));
+    }
+
+    SECTION("Regular grid with equally long edges") {
+        std::vector<Point> points;
+        for (coord_t x = 0; x < 20; ++ x)
+            for (coord_t y = 0; y < 20; ++ y)
+                points.emplace_back(x * scaled<coord_t>(1.), y * scaled<coord_t>(1.));
+        size_t num_edges;
+        double length = tree_length(MinimumSpanningTree(points), num_edges);
+        REQUIRE(num_edges == points.size() - 1);
+        REQUIRE(length == Approx(scaled<double>(1.) * double(points.size() - 1)));
+    }
+}